@@ -0,0 +1,50 @@
+# Build those of Kelpo's renderers that don't need Win32 (the software, null and
+# recording renderers) as shared objects for Linux using the system's GCC. The
+# software renderer renders offscreen (see surface_offscreen.h).
+
+BUILD_OPTIONS="
+-shared
+-fPIC
+-g
+-O2
+-std=c89
+-pedantic
+-Wall
+-I ./src/
+-Wl,-Bsymbolic
+"
+
+# Set KELPO_PROFILE to build with profiler zones (see src/kelpo_auxiliary/profiler.h).
+if [ -n "$KELPO_PROFILE" ]; then
+    PROFILER_SRC_FILES="src/kelpo_auxiliary/profiler.c src/kelpo_auxiliary/clock.c"
+    BUILD_OPTIONS="$BUILD_OPTIONS -DKELPOA_PROFILE"
+fi
+
+gcc $BUILD_OPTIONS -o bin/kelpo_renderer_software.so \
+    src/kelpo_renderer/renderer_software.c \
+    src/kelpo_renderer/rasterizer/software/rasterizer_software.c \
+    src/kelpo_renderer/rasterizer/software/rasterizer_software_sse2.c \
+    src/kelpo_renderer/surface/offscreen/surface_offscreen.c \
+    src/kelpo_renderer/window/offscreen/window_offscreen.c \
+    src/kelpo_auxiliary/generic_stack.c \
+    src/kelpo_auxiliary/thread_pool.c \
+    src/kelpo_interface/interface.c \
+    src/kelpo_interface/error.c \
+    $PROFILER_SRC_FILES -lm -lpthread -ldl
+
+gcc $BUILD_OPTIONS -o bin/kelpo_renderer_null.so \
+    src/kelpo_renderer/renderer_null.c \
+    src/kelpo_renderer/rasterizer/null/rasterizer_null.c \
+    src/kelpo_renderer/window/offscreen/window_offscreen.c \
+    src/kelpo_auxiliary/generic_stack.c \
+    src/kelpo_interface/interface.c \
+    src/kelpo_interface/error.c \
+    $PROFILER_SRC_FILES -ldl
+
+gcc $BUILD_OPTIONS -o bin/kelpo_renderer_recording.so \
+    src/kelpo_renderer/renderer_recording.c \
+    src/kelpo_renderer/rasterizer/recording/rasterizer_recording.c \
+    src/kelpo_auxiliary/generic_stack.c \
+    src/kelpo_interface/interface.c \
+    src/kelpo_interface/error.c \
+    $PROFILER_SRC_FILES -ldl
@@ -39,4 +39,10 @@ BUILD_OPTIONS="
 -L $DX5_BASE_PATH/lib
 "
 
+# Set KELPO_PROFILE to build with profiler zones (see src/kelpo_auxiliary/profiler.h).
+if [ -n "$KELPO_PROFILE" ]; then
+    SRC_FILES="$SRC_FILES src/kelpo_auxiliary/profiler.c src/kelpo_auxiliary/clock.c"
+    BUILD_OPTIONS="$BUILD_OPTIONS -DKELPOA_PROFILE"
+fi
+
 wine "$MINGW441_BASE_PATH/bin/g++.exe" $BUILD_OPTIONS -o $OUTPUT_FILE $SRC_FILES -lm -lgdi32 -lddraw -ld3dim -ldxguid
@@ -0,0 +1,36 @@
+# Build Kelpo's null renderer for Win32 using TDM-GCC (MinGW) 4.4.1 via Wine from Linux.
+
+OUTPUT_FILE="bin/kelpo_renderer_null.dll"
+
+MINGW441_BASE_PATH=~/compi/mingw441
+
+SRC_FILES="
+src/kelpo_renderer/renderer_null.c
+src/kelpo_renderer/rasterizer/null/rasterizer_null.c
+src/kelpo_renderer/window/offscreen/window_offscreen.c
+src/kelpo_auxiliary/generic_stack.c
+src/kelpo_interface/interface.c
+src/kelpo_interface/error.c
+"
+
+BUILD_OPTIONS="
+-shared
+-nostdinc
+-g
+-O2
+-std=c89
+-pedantic
+-Wall
+-march=pentium
+-I ./src/
+-isystem $MINGW441_BASE_PATH/lib/gcc/mingw32/4.4.1/include
+-isystem $MINGW441_BASE_PATH/include
+"
+
+# Set KELPO_PROFILE to build with profiler zones (see src/kelpo_auxiliary/profiler.h).
+if [ -n "$KELPO_PROFILE" ]; then
+    SRC_FILES="$SRC_FILES src/kelpo_auxiliary/profiler.c src/kelpo_auxiliary/clock.c"
+    BUILD_OPTIONS="$BUILD_OPTIONS -DKELPOA_PROFILE"
+fi
+
+wine "$MINGW441_BASE_PATH/bin/gcc.exe" $BUILD_OPTIONS -o $OUTPUT_FILE $SRC_FILES
@@ -0,0 +1,46 @@
+# Build Kelpo's software renderer for Win32 using TDM-GCC (MinGW) 4.4.1 via Wine from Linux.
+
+OUTPUT_FILE="bin/kelpo_renderer_software.dll"
+
+# The SIMD kernel is compiled separately with SSE2 code generation enabled, and
+# is only called on CPUs that support it. Win32 only guarantees 4-byte stack
+# alignment, so the SSE2 code realigns its stack.
+SSE2_SRC_FILE="src/kelpo_renderer/rasterizer/software/rasterizer_software_sse2.c"
+SSE2_OBJECT_FILE="bin/rasterizer_software_sse2.o"
+
+MINGW441_BASE_PATH=~/compi/mingw441
+
+SRC_FILES="
+src/kelpo_renderer/renderer_software.c
+src/kelpo_renderer/rasterizer/software/rasterizer_software.c
+src/kelpo_renderer/surface/software/surface_software.c
+src/kelpo_renderer/window/win32/window_win32.c
+src/kelpo_auxiliary/generic_stack.c
+src/kelpo_auxiliary/thread_pool.c
+src/kelpo_interface/interface.c
+src/kelpo_interface/error.c
+"
+
+BUILD_OPTIONS="
+-shared
+-nostdinc
+-g
+-O2
+-std=c89
+-pedantic
+-Wall
+-march=pentium
+-I ./src/
+-isystem $MINGW441_BASE_PATH/lib/gcc/mingw32/4.4.1/include
+-isystem $MINGW441_BASE_PATH/include
+"
+
+# Set KELPO_PROFILE to build with profiler zones (see src/kelpo_auxiliary/profiler.h).
+if [ -n "$KELPO_PROFILE" ]; then
+    SRC_FILES="$SRC_FILES src/kelpo_auxiliary/profiler.c src/kelpo_auxiliary/clock.c"
+    BUILD_OPTIONS="$BUILD_OPTIONS -DKELPOA_PROFILE"
+fi
+
+wine "$MINGW441_BASE_PATH/bin/gcc.exe" $BUILD_OPTIONS -msse2 -mstackrealign -c -o $SSE2_OBJECT_FILE $SSE2_SRC_FILE
+wine "$MINGW441_BASE_PATH/bin/gcc.exe" $BUILD_OPTIONS -o $OUTPUT_FILE $SRC_FILES $SSE2_OBJECT_FILE -lm -lgdi32
+rm -f $SSE2_OBJECT_FILE
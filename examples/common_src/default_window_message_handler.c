@@ -6,6 +6,9 @@
  */
 
 #include "default_window_message_handler.h"
+
+#if defined(_WIN32)
+
 #include <windows.h>
 
 LRESULT default_window_message_handler(HWND windowHandle, UINT message, WPARAM wParam, LPARAM lParam)
@@ -41,3 +44,13 @@ LRESULT default_window_message_handler(HWND windowHandle, UINT message, WPARAM w
 
     return 1;
 }
+
+#else
+
+/* Kelpo's window doesn't send messages on platforms other than Win32.*/
+LRESULT default_window_message_handler(HWND windowHandle, UINT message, WPARAM wParam, LPARAM lParam)
+{
+    return 0;
+}
+
+#endif
@@ -19,7 +19,7 @@
 #ifndef KELPO_EXAMPLES_COMMON_SRC_DEFAULT_WINDOW_MESSAGE_HANDLER_H
 #define KELPO_EXAMPLES_COMMON_SRC_DEFAULT_WINDOW_MESSAGE_HANDLER_H
 
-#include <windef.h>
+#include <kelpo_interface/interface.h>
 
 /* Default handling of window messages from the Kelpo render example window.
  * Returns 1 if the message was handled; 0 otherwise. Expected to have the
@@ -13,6 +13,7 @@
 #include <kelpo_auxiliary/load_kac_1_0_mesh.h>
 #include <kelpo_auxiliary/triangle_preparer.h>
 #include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/indexed_mesh.h>
 #include <kelpo_auxiliary/matrix_44.h>
 #include <kelpo_auxiliary/text_mesh.h>
 #include <kelpo_auxiliary/misc.h>
@@ -29,10 +30,10 @@ int main(int argc, char *argv[])
     uint32_t numTextures = 0;
     struct kelpo_polygon_texture_s *textures = NULL;
     struct kelpo_polygon_texture_s *fontTexture = NULL;
-    struct kelpoa_generic_stack_s *triangles = kelpoa_generic_stack__create(1, sizeof(struct kelpo_polygon_triangle_s));
-    struct kelpoa_generic_stack_s *worldSpaceTriangles = kelpoa_generic_stack__create(1, sizeof(struct kelpo_polygon_triangle_s));
+    struct kelpoa_indexed_mesh_s *mesh = kelpoa_indexed_mesh__create();
     struct kelpoa_generic_stack_s *screenSpaceTriangles = kelpoa_generic_stack__create(1, sizeof(struct kelpo_polygon_triangle_s));
 
+    struct kelpoa_matrix44_s modelMatrix;
     struct kelpoa_matrix44_s clipSpaceMatrix;
     struct kelpoa_matrix44_s screenSpaceMatrix;   
     
@@ -61,10 +62,12 @@ int main(int argc, char *argv[])
     {
         uint32_t i = 0, m = 0;
 
-        /* The apricot model.*/
+        /* The apricot model. It's loaded as an indexed mesh, so that each of
+         * its vertices gets transformed only once per frame, rather than once
+         * for each triangle that shares it.*/
         {
-            if (!kelpoa_load_kac10_mesh("apricot.kac", triangles, &textures, &numTextures) ||
-                !triangles->count)
+            if (!kelpoa_load_kac10_indexed_mesh("apricot.kac", mesh, &textures, &numTextures) ||
+                !mesh->triangles->count)
             {
                 fprintf(stderr, "Failed to load the model's data.\n");
                 goto cleanup;
@@ -121,16 +124,14 @@ int main(int argc, char *argv[])
         static float rotY = 0;
 
         /* Rotate the model and transform its vertices into screen space.*/
-        kelpoa_generic_stack__clear(worldSpaceTriangles);
         kelpoa_generic_stack__clear(screenSpaceTriangles);
-        kelpoa_triprepr__duplicate_triangles(triangles, worldSpaceTriangles);
-        kelpoa_triprepr__rotate_triangles(worldSpaceTriangles, 0, (rotY += 0.01), 0);
-        kelpoa_triprepr__translate_triangles(worldSpaceTriangles, 0, -2.5, 8.5);
-        kelpoa_triprepr__project_triangles_to_screen(worldSpaceTriangles,
-                                                     screenSpaceTriangles,
-                                                     &clipSpaceMatrix,
-                                                     &screenSpaceMatrix,
-                                                     0.1, 100, 1);
+        kelpoa_matrix44__make_model_matrix(&modelMatrix, 0, (rotY += 0.01), 0, 0, -2.5, 8.5);
+        kelpoa_triprepr__transform_and_project_indexed_mesh(mesh,
+                                                            screenSpaceTriangles,
+                                                            &modelMatrix,
+                                                            &clipSpaceMatrix,
+                                                            &screenSpaceMatrix,
+                                                            0.1, 100, 1);
 
         /* Print the UI text.*/
         {
@@ -138,7 +139,7 @@ int main(int argc, char *argv[])
             char polyString[50];
             const unsigned fps = framerate_estimate();
             const unsigned numScreenPolys = screenSpaceTriangles->count;
-            const unsigned numWorldPolys = worldSpaceTriangles->count;
+            const unsigned numWorldPolys = mesh->triangles->count;
 
             sprintf(fpsString, "FPS: %d", ((fps > 999)? 999 : fps));
             sprintf(polyString, "Polygons: %d/%d", ((numScreenPolys > 9999999)? 9999999 : numScreenPolys),
@@ -165,8 +166,7 @@ int main(int argc, char *argv[])
 
     free(textures);
     free(fontTexture);
-    kelpoa_generic_stack__free(triangles);
-    kelpoa_generic_stack__free(worldSpaceTriangles);
+    kelpoa_indexed_mesh__free(mesh);
     kelpoa_generic_stack__free(screenSpaceTriangles);
 
     if (!kelpo_release_interface(kelpo))
@@ -11,9 +11,14 @@ src/main.c
 ../common_src/default_window_message_handler.c
 ../common_src/framerate_estimate.c
 ../../src/kelpo_auxiliary/triangle_preparer.c
+../../src/kelpo_auxiliary/bounding_volume.c
+../../src/kelpo_auxiliary/triangle_bvh.c
+../../src/kelpo_auxiliary/thread_pool.c
 ../../src/kelpo_auxiliary/generic_stack.c
 ../../src/kelpo_auxiliary/matrix_44.c
 ../../src/kelpo_auxiliary/vector_3.c
+../../src/kelpo_auxiliary/vertex_stream.c
+../../src/kelpo_auxiliary/vertex_stream_sse.c
 ../../src/kelpo_auxiliary/triangle_clipper.c
 ../../src/kelpo_auxiliary/load_kac_1_0_mesh.c
 ../../src/kelpo_auxiliary/import_kac_1_0.c
@@ -13,6 +13,7 @@
 #include <kelpo_auxiliary/triangle_preparer.h>
 #include <kelpo_auxiliary/load_kac_1_0_mesh.h>
 #include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/bounding_volume.h>
 #include <kelpo_auxiliary/text_mesh.h>
 #include <kelpo_auxiliary/matrix_44.h>
 #include <kelpo_auxiliary/misc.h>
@@ -88,9 +89,10 @@ int main(int argc, char *argv[])
     struct kelpo_polygon_texture_s *textures = NULL;
     struct kelpo_polygon_texture_s *fontTexture = NULL;
     struct kelpoa_generic_stack_s *triangles = kelpoa_generic_stack__create(1, sizeof(struct kelpo_polygon_triangle_s));
-    struct kelpoa_generic_stack_s *worldSpaceTriangles = kelpoa_generic_stack__create(1, sizeof(struct kelpo_polygon_triangle_s));
+    struct kelpoa_bounding_volume_s meshBounds;
     struct kelpoa_generic_stack_s *screenSpaceTriangles = kelpoa_generic_stack__create(1, sizeof(struct kelpo_polygon_triangle_s));
 
+    struct kelpoa_matrix44_s modelMatrix;
     struct kelpoa_matrix44_s clipSpaceMatrix;
     struct kelpoa_matrix44_s screenSpaceMatrix;
 
@@ -127,6 +129,8 @@ int main(int argc, char *argv[])
                 goto cleanup;
             }
 
+            kelpoa_bounding_volume__of_triangles(&meshBounds, triangles);
+
             /* Transfer the textures to Kelpo.*/
             for (i = 0; i < numTextures; i++)
             {
@@ -176,16 +180,15 @@ int main(int argc, char *argv[])
            !kelpo->window.is_closing())
     {
         /* Rotate the cube and transform its vertices into screen space.*/
-        kelpoa_generic_stack__clear(worldSpaceTriangles);
         kelpoa_generic_stack__clear(screenSpaceTriangles);
-        kelpoa_triprepr__duplicate_triangles(triangles, worldSpaceTriangles);
-        kelpoa_triprepr__rotate_triangles(worldSpaceTriangles, CAMERA.rotX, CAMERA.rotY, CAMERA.rotZ);
-        kelpoa_triprepr__translate_triangles(worldSpaceTriangles, 0, 0, CAMERA.zoom);
-        kelpoa_triprepr__project_triangles_to_screen(worldSpaceTriangles,
-                                                     screenSpaceTriangles,
-                                                     &clipSpaceMatrix,
-                                                     &screenSpaceMatrix,
-                                                     0.1, 100, 1);
+        kelpoa_matrix44__make_model_matrix(&modelMatrix, CAMERA.rotX, CAMERA.rotY, CAMERA.rotZ, 0, 0, CAMERA.zoom);
+        kelpoa_triprepr__transform_and_project_triangles(triangles,
+                                                         screenSpaceTriangles,
+                                                         &meshBounds,
+                                                         &modelMatrix,
+                                                         &clipSpaceMatrix,
+                                                         &screenSpaceMatrix,
+                                                         0.1, 100, 1);
 
         /* Print the UI text.*/
         {
@@ -194,7 +197,7 @@ int main(int argc, char *argv[])
                 char fpsString[10];
                 char polyString[50];
                 const unsigned numScreenPolys = screenSpaceTriangles->count;
-                const unsigned numWorldPolys = worldSpaceTriangles->count;
+                const unsigned numWorldPolys = triangles->count;
                 const unsigned fps = framerate_estimate();
 
                 sprintf(fpsString, "FPS: %d", ((fps > 999)? 999 : fps));
@@ -245,7 +248,6 @@ int main(int argc, char *argv[])
     free(textures);
     free(fontTexture);
     kelpoa_generic_stack__free(triangles);
-    kelpoa_generic_stack__free(worldSpaceTriangles);
     kelpoa_generic_stack__free(screenSpaceTriangles);
 
     if (!kelpo_release_interface(kelpo))
@@ -13,6 +13,7 @@
 #include <kelpo_auxiliary/load_kac_1_0_mesh.h>
 #include <kelpo_auxiliary/triangle_preparer.h>
 #include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/bounding_volume.h>
 #include <kelpo_auxiliary/text_mesh.h>
 #include <kelpo_auxiliary/matrix_44.h>
 #include <kelpo_auxiliary/misc.h>
@@ -116,6 +117,7 @@ static LRESULT window_message_handler(HWND windowHandle, UINT message, WPARAM wP
                     case 0x33: case VK_NUMPAD3: SELECTED_RENDERER_NAME = "direct3d_5"; USER_WANTS_RENDERER_CHANGE = 1; break;
                     case 0x34: case VK_NUMPAD4: SELECTED_RENDERER_NAME = "direct3d_7"; USER_WANTS_RENDERER_CHANGE = 1; break;
                     case 0x35: case VK_NUMPAD5: SELECTED_RENDERER_NAME = "glide_3"; USER_WANTS_RENDERER_CHANGE = 1; break;
+                    case 0x36: case VK_NUMPAD6: SELECTED_RENDERER_NAME = "software"; USER_WANTS_RENDERER_CHANGE = 1; break;
                     default: break;
                 }
             }
@@ -144,9 +146,10 @@ int main(int argc, char *argv[])
     const struct kelpo_interface_s *kelpo = NULL;
 
     struct kelpoa_generic_stack_s *triangles = kelpoa_generic_stack__create(1, sizeof(struct kelpo_polygon_triangle_s));
-    struct kelpoa_generic_stack_s *worldSpaceTriangles = kelpoa_generic_stack__create(1, sizeof(struct kelpo_polygon_triangle_s));
+    struct kelpoa_bounding_volume_s meshBounds;
     struct kelpoa_generic_stack_s *screenSpaceTriangles = kelpoa_generic_stack__create(1, sizeof(struct kelpo_polygon_triangle_s));
 
+    struct kelpoa_matrix44_s modelMatrix;
     struct kelpoa_matrix44_s clipSpaceMatrix;
     struct kelpoa_matrix44_s screenSpaceMatrix;
 
@@ -187,6 +190,8 @@ int main(int argc, char *argv[])
                 goto cleanup;
             }
 
+            kelpoa_bounding_volume__of_triangles(&meshBounds, triangles);
+
             for (i = 0; i < NUM_TEXTURES; i++)
             {
                 kelpo->rasterizer.upload_texture(&TEXTURES[i]);
@@ -248,23 +253,22 @@ int main(int argc, char *argv[])
         }
 
         /* Transform the scene's triangles into screen space.*/
-        kelpoa_generic_stack__clear(worldSpaceTriangles);
         kelpoa_generic_stack__clear(screenSpaceTriangles);
-        kelpoa_triprepr__duplicate_triangles(triangles, worldSpaceTriangles);
-        kelpoa_triprepr__rotate_triangles(worldSpaceTriangles, (rotX += 0.0035), (rotY += 0.006), (rotZ += 0.0035));
-        kelpoa_triprepr__translate_triangles(worldSpaceTriangles, 0, 0, 4.7);
-        kelpoa_triprepr__project_triangles_to_screen(worldSpaceTriangles,
-                                                     screenSpaceTriangles,
-                                                     &clipSpaceMatrix,
-                                                     &screenSpaceMatrix,
-                                                     0.1, 100, 1);
+        kelpoa_matrix44__make_model_matrix(&modelMatrix, (rotX += 0.0035), (rotY += 0.006), (rotZ += 0.0035), 0, 0, 4.7);
+        kelpoa_triprepr__transform_and_project_triangles(triangles,
+                                                         screenSpaceTriangles,
+                                                         &meshBounds,
+                                                         &modelMatrix,
+                                                         &clipSpaceMatrix,
+                                                         &screenSpaceMatrix,
+                                                         0.1, 100, 1);
 
         /* Print the UI text.*/
         {
             char fpsString[10];
             char polyString[50];
             const unsigned numScreenPolys = screenSpaceTriangles->count;
-            const unsigned numWorldPolys = worldSpaceTriangles->count;
+            const unsigned numWorldPolys = triangles->count;
             const unsigned fps = framerate_estimate();
 
             sprintf(fpsString, "FPS: %d", ((fps > 999)? 999 : fps));
@@ -274,7 +278,7 @@ int main(int argc, char *argv[])
             kelpoa_text_mesh__print(screenSpaceTriangles, kelpo->metadata.rendererName, 25, 30, 255, 255, 255, 1);
             kelpoa_text_mesh__print(screenSpaceTriangles, polyString, 25, 60, 200, 200, 200, 1);
             kelpoa_text_mesh__print(screenSpaceTriangles, fpsString, 25, 90, 200, 200, 200, 1);
-            kelpoa_text_mesh__print(screenSpaceTriangles, "Press 1-5 to set renderer", 25, 120, 255, 255, 255, 1);
+            kelpoa_text_mesh__print(screenSpaceTriangles, "Press 1-6 to set renderer", 25, 120, 255, 255, 255, 1);
 
             if (strlen(ERROR_STRING))
             {
@@ -295,7 +299,6 @@ int main(int argc, char *argv[])
     free(TEXTURES);
     free(FONT_TEXTURE);
     kelpoa_generic_stack__free(triangles);
-    kelpoa_generic_stack__free(worldSpaceTriangles);
     kelpoa_generic_stack__free(screenSpaceTriangles);
 
     if (!kelpo_release_interface(kelpo))
@@ -10,10 +10,15 @@ src/main.c
 ../common_src/default_window_message_handler.c
 ../common_src/parse_command_line.c
 ../../src/kelpo_auxiliary/triangle_preparer.c
+../../src/kelpo_auxiliary/bounding_volume.c
+../../src/kelpo_auxiliary/triangle_bvh.c
+../../src/kelpo_auxiliary/thread_pool.c
 ../../src/kelpo_auxiliary/matrix_44.c
 ../../src/kelpo_auxiliary/vector_3.c
 ../../src/kelpo_interface/interface.c
 ../../src/kelpo_auxiliary/generic_stack.c
+../../src/kelpo_auxiliary/vertex_stream.c
+../../src/kelpo_auxiliary/vertex_stream_sse.c
 ../../src/kelpo_auxiliary/triangle_clipper.c
 ../../src/kelpo_interface/error.c
 "
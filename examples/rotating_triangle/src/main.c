@@ -23,9 +23,9 @@ int main(int argc, char *argv[])
     const struct kelpo_interface_s *kelpo = NULL;
 
     struct kelpoa_generic_stack_s *triangles = kelpoa_generic_stack__create(1, sizeof(struct kelpo_polygon_triangle_s));
-    struct kelpoa_generic_stack_s *worldSpaceTriangles = kelpoa_generic_stack__create(1, sizeof(struct kelpo_polygon_triangle_s));
     struct kelpoa_generic_stack_s *screenSpaceTriangles = kelpoa_generic_stack__create(1, sizeof(struct kelpo_polygon_triangle_s));
 
+    struct kelpoa_matrix44_s modelMatrix;
     struct kelpoa_matrix44_s clipSpaceMatrix;
     struct kelpoa_matrix44_s screenSpaceMatrix;
 
@@ -95,16 +95,15 @@ int main(int argc, char *argv[])
         static float rotY = 0;
 
         /* Rotate the triangle and transform its vertices into screen space.*/
-        kelpoa_generic_stack__clear(worldSpaceTriangles);
         kelpoa_generic_stack__clear(screenSpaceTriangles);
-        kelpoa_triprepr__duplicate_triangles(triangles, worldSpaceTriangles);
-        kelpoa_triprepr__rotate_triangles(worldSpaceTriangles, 0, (rotY += 0.01), 0);
-        kelpoa_triprepr__translate_triangles(worldSpaceTriangles, 0, 0, 3);
-        kelpoa_triprepr__project_triangles_to_screen(worldSpaceTriangles,
-                                                     screenSpaceTriangles,
-                                                     &clipSpaceMatrix,
-                                                     &screenSpaceMatrix,
-                                                     0.1, 100, 1);
+        kelpoa_matrix44__make_model_matrix(&modelMatrix, 0, (rotY += 0.01), 0, 0, 0, 3);
+        kelpoa_triprepr__transform_and_project_triangles(triangles,
+                                                         screenSpaceTriangles,
+                                                         NULL,
+                                                         &modelMatrix,
+                                                         &clipSpaceMatrix,
+                                                         &screenSpaceMatrix,
+                                                         0.1, 100, 1);
 
         /* Render the triangle.*/
         kelpo->rasterizer.clear_frame();
@@ -121,7 +120,6 @@ int main(int argc, char *argv[])
     cleanup:
 
     kelpoa_generic_stack__free(triangles);
-    kelpoa_generic_stack__free(worldSpaceTriangles);
     kelpoa_generic_stack__free(screenSpaceTriangles);
 
     if (!kelpo_release_interface(kelpo))
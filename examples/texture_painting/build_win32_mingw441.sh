@@ -14,8 +14,13 @@ src/main.c
 ../../src/kelpo_auxiliary/load_kac_1_0_mesh.c
 ../../src/kelpo_auxiliary/import_kac_1_0.c
 ../../src/kelpo_auxiliary/triangle_preparer.c
+../../src/kelpo_auxiliary/bounding_volume.c
+../../src/kelpo_auxiliary/triangle_bvh.c
+../../src/kelpo_auxiliary/thread_pool.c
 ../../src/kelpo_auxiliary/matrix_44.c
 ../../src/kelpo_auxiliary/vector_3.c
+../../src/kelpo_auxiliary/vertex_stream.c
+../../src/kelpo_auxiliary/vertex_stream_sse.c
 ../../src/kelpo_auxiliary/triangle_clipper.c
 ../../src/kelpo_auxiliary/text_mesh.c
 ../../src/kelpo_interface/interface.c
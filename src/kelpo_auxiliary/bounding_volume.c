@@ -0,0 +1,247 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * A bounding sphere and AABB enclosing a mesh's vertices.
+ *
+ */
+
+#include <math.h>
+#include <kelpo_interface/polygon/triangle/triangle.h>
+#include <kelpo_auxiliary/bounding_volume.h>
+#include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/matrix_44.h>
+
+/* Grows the volume's AABB to enclose the given point.*/
+static void grow_aabb(struct kelpoa_bounding_volume_s *const volume,
+                      const struct kelpo_polygon_vertex_s *const v)
+{
+    if (volume->radius < 0)
+    {
+        volume->min = volume->max = kelpoa_vector3(v->x, v->y, v->z);
+        volume->radius = 0;
+    }
+    else
+    {
+        if (v->x < volume->min.x) volume->min.x = v->x;
+        if (v->y < volume->min.y) volume->min.y = v->y;
+        if (v->z < volume->min.z) volume->min.z = v->z;
+        if (v->x > volume->max.x) volume->max.x = v->x;
+        if (v->y > volume->max.y) volume->max.y = v->y;
+        if (v->z > volume->max.z) volume->max.z = v->z;
+    }
+
+    return;
+}
+
+/* Grows the volume's sphere, which is centered on the AABB, to enclose the
+ * given point.*/
+static void grow_sphere(struct kelpoa_bounding_volume_s *const volume,
+                        const struct kelpo_polygon_vertex_s *const v)
+{
+    const float dx = (v->x - volume->center.x);
+    const float dy = (v->y - volume->center.y);
+    const float dz = (v->z - volume->center.z);
+    const float distance = sqrt((dx * dx) + (dy * dy) + (dz * dz));
+
+    if (distance > volume->radius)
+    {
+        volume->radius = distance;
+    }
+
+    return;
+}
+
+static void center_sphere_on_aabb(struct kelpoa_bounding_volume_s *const volume)
+{
+    volume->center = kelpoa_vector3(((volume->min.x + volume->max.x) / 2),
+                                    ((volume->min.y + volume->max.y) / 2),
+                                    ((volume->min.z + volume->max.z) / 2));
+
+    return;
+}
+
+void kelpoa_bounding_volume__clear(struct kelpoa_bounding_volume_s *const volume)
+{
+    volume->min = volume->max = volume->center = kelpoa_vector3(0, 0, 0);
+    volume->radius = -1;
+
+    return;
+}
+
+void kelpoa_bounding_volume__of_vertices(struct kelpoa_bounding_volume_s *const volume,
+                                         const struct kelpo_polygon_vertex_s *const vertices,
+                                         const unsigned numVertices)
+{
+    unsigned i = 0;
+
+    kelpoa_bounding_volume__clear(volume);
+
+    if (!numVertices)
+    {
+        return;
+    }
+
+    for (i = 0; i < numVertices; i++)
+    {
+        grow_aabb(volume, &vertices[i]);
+    }
+
+    center_sphere_on_aabb(volume);
+
+    for (i = 0; i < numVertices; i++)
+    {
+        grow_sphere(volume, &vertices[i]);
+    }
+
+    return;
+}
+
+void kelpoa_bounding_volume__of_triangles(struct kelpoa_bounding_volume_s *const volume,
+                                          const struct kelpoa_generic_stack_s *const triangles)
+{
+    unsigned i = 0;
+    const struct kelpo_polygon_triangle_s *const tris = (const struct kelpo_polygon_triangle_s*)triangles->data;
+
+    kelpoa_bounding_volume__clear(volume);
+
+    if (!triangles->count)
+    {
+        return;
+    }
+
+    for (i = 0; i < triangles->count; i++)
+    {
+        grow_aabb(volume, &tris[i].vertex[0]);
+        grow_aabb(volume, &tris[i].vertex[1]);
+        grow_aabb(volume, &tris[i].vertex[2]);
+    }
+
+    center_sphere_on_aabb(volume);
+
+    for (i = 0; i < triangles->count; i++)
+    {
+        grow_sphere(volume, &tris[i].vertex[0]);
+        grow_sphere(volume, &tris[i].vertex[1]);
+        grow_sphere(volume, &tris[i].vertex[2]);
+    }
+
+    return;
+}
+
+void kelpoa_bounding_volume__transform(struct kelpoa_bounding_volume_s *const volume,
+                                       const struct kelpoa_matrix44_s *const matrix)
+{
+    const float *const m = matrix->elements;
+    unsigned row = 0;
+    float maxScale = 0;
+    float aabbCenter[3];
+    float aabbExtent[3];
+    float newMin[3];
+    float newMax[3];
+
+    if (volume->radius < 0)
+    {
+        return;
+    }
+
+    aabbCenter[0] = ((volume->min.x + volume->max.x) / 2);
+    aabbCenter[1] = ((volume->min.y + volume->max.y) / 2);
+    aabbCenter[2] = ((volume->min.z + volume->max.z) / 2);
+    aabbExtent[0] = ((volume->max.x - volume->min.x) / 2);
+    aabbExtent[1] = ((volume->max.y - volume->min.y) / 2);
+    aabbExtent[2] = ((volume->max.z - volume->min.z) / 2);
+
+    /* Transform the AABB's center, and project its extents onto each axis.
+     * The matrix is column-major.*/
+    for (row = 0; row < 3; row++)
+    {
+        const float center = ((m[row] * aabbCenter[0]) + (m[4 + row] * aabbCenter[1]) + (m[8 + row] * aabbCenter[2]) + m[12 + row]);
+        const float extent = ((fabs(m[row]) * aabbExtent[0]) + (fabs(m[4 + row]) * aabbExtent[1]) + (fabs(m[8 + row]) * aabbExtent[2]));
+
+        newMin[row] = (center - extent);
+        newMax[row] = (center + extent);
+    }
+
+    volume->min = kelpoa_vector3(newMin[0], newMin[1], newMin[2]);
+    volume->max = kelpoa_vector3(newMax[0], newMax[1], newMax[2]);
+
+    /* The sphere's radius scales by at most the length of the longest of the
+     * matrix's basis vectors.*/
+    {
+        unsigned col = 0;
+
+        for (col = 0; col < 3; col++)
+        {
+            const float scale = sqrt((m[col * 4] * m[col * 4]) + (m[col * 4 + 1] * m[col * 4 + 1]) + (m[col * 4 + 2] * m[col * 4 + 2]));
+
+            if (scale > maxScale)
+            {
+                maxScale = scale;
+            }
+        }
+    }
+
+    volume->center = kelpoa_vector3(((m[0] * volume->center.x) + (m[4] * volume->center.y) + (m[ 8] * volume->center.z) + m[12]),
+                                    ((m[1] * volume->center.x) + (m[5] * volume->center.y) + (m[ 9] * volume->center.z) + m[13]),
+                                    ((m[2] * volume->center.x) + (m[6] * volume->center.y) + (m[10] * volume->center.z) + m[14]));
+    volume->radius *= maxScale;
+
+    return;
+}
+
+enum kelpoa_bounding_volume_frustum_test_e kelpoa_bounding_volume__test_frustum(const struct kelpoa_bounding_volume_s *const volume,
+                                                                                const struct kelpoa_matrix44_s *const clipSpaceMatrix)
+{
+    const float *const m = clipSpaceMatrix->elements;
+    unsigned p = 0;
+    int intersects = 0;
+
+    if (volume->radius < 0)
+    {
+        return KELPOA_BOUNDING_VOLUME_OUTSIDE_FRUSTUM;
+    }
+
+    /* A point is inside the frustum if its clip space coordinates satisfy
+     * -w <= x,y,z <= w. Each of these inequalities is a plane in the volume's
+     * space, given by the sum or difference of the matrix's W row and its X, Y
+     * or Z row (the matrix is column-major).*/
+    for (p = 0; p < 6; p++)
+    {
+        const unsigned row = (p / 2);
+        const float sign = ((p % 2)? -1 : 1);
+        const float a = (m[3] + (sign * m[row]));
+        const float b = (m[7] + (sign * m[4 + row]));
+        const float c = (m[11] + (sign * m[8 + row]));
+        const float d = (m[15] + (sign * m[12 + row]));
+        const float sphereDistance = ((a * volume->center.x) + (b * volume->center.y) + (c * volume->center.z) + d);
+        const float scaledRadius = (volume->radius * sqrt((a * a) + (b * b) + (c * c)));
+
+        if (sphereDistance < -scaledRadius)
+        {
+            return KELPOA_BOUNDING_VOLUME_OUTSIDE_FRUSTUM;
+        }
+        else if (sphereDistance < scaledRadius)
+        {
+            /* The sphere straddles the plane; see whether the AABB does. Of
+             * its corners, test the one furthest along the plane's normal
+             * and the one furthest against it.*/
+            const float farthestIn = ((a * ((a >= 0)? volume->max.x : volume->min.x)) +
+                                      (b * ((b >= 0)? volume->max.y : volume->min.y)) +
+                                      (c * ((c >= 0)? volume->max.z : volume->min.z)) + d);
+            const float farthestOut = ((a * ((a >= 0)? volume->min.x : volume->max.x)) +
+                                       (b * ((b >= 0)? volume->min.y : volume->max.y)) +
+                                       (c * ((c >= 0)? volume->min.z : volume->max.z)) + d);
+
+            if (farthestIn < 0)
+            {
+                return KELPOA_BOUNDING_VOLUME_OUTSIDE_FRUSTUM;
+            }
+            else if (farthestOut < 0)
+            {
+                intersects = 1;
+            }
+        }
+    }
+
+    return (intersects? KELPOA_BOUNDING_VOLUME_INTERSECTS_FRUSTUM : KELPOA_BOUNDING_VOLUME_INSIDE_FRUSTUM);
+}
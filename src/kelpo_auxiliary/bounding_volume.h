@@ -0,0 +1,81 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * A bounding sphere and axis-aligned bounding box (AABB) enclosing a mesh's
+ * vertices, for testing whole meshes against the view frustum.
+ *
+ * Usage:
+ *
+ *   1. Compute the volume of a mesh's vertices when the mesh is loaded, e.g.
+ *      with __of_triangles() on the triangles from kelpoa_load_kac10_mesh().
+ *      Indexed meshes compute and maintain their own (see indexed_mesh.h).
+ *
+ *   2. Each frame, call __test_frustum() with the matrix that takes the mesh's
+ *      vertices into clip space (e.g. the clip space matrix multiplied by the
+ *      mesh's model matrix). A mesh outside the frustum needn't be duplicated,
+ *      transformed or projected; and one inside it needn't have its triangles
+ *      clipped.
+ *
+ */
+
+#ifndef KELPO_AUXILIARY_BOUNDING_VOLUME_H
+#define KELPO_AUXILIARY_BOUNDING_VOLUME_H
+
+#include <kelpo_interface/polygon/vertex.h>
+#include <kelpo_auxiliary/vector_3.h>
+
+struct kelpoa_generic_stack_s;
+struct kelpoa_matrix44_s;
+
+struct kelpoa_bounding_volume_s
+{
+    /* The corners of the AABB.*/
+    struct kelpoa_vector3_s min;
+    struct kelpoa_vector3_s max;
+
+    /* The bounding sphere. The radius is negative if the volume is empty,
+     * i.e. encloses no vertices.*/
+    struct kelpoa_vector3_s center;
+    float radius;
+};
+
+/* How a bounding volume relates to the view frustum.*/
+enum kelpoa_bounding_volume_frustum_test_e
+{
+    KELPOA_BOUNDING_VOLUME_OUTSIDE_FRUSTUM,   /* The volume is wholly outside the frustum.*/
+    KELPOA_BOUNDING_VOLUME_INSIDE_FRUSTUM,    /* The volume is wholly inside the frustum.*/
+    KELPOA_BOUNDING_VOLUME_INTERSECTS_FRUSTUM /* The volume may be partially inside the frustum.*/
+};
+
+/* Initializes the given volume as empty.*/
+void kelpoa_bounding_volume__clear(struct kelpoa_bounding_volume_s *const volume);
+
+/* Computes the volume enclosing the given vertices' XYZ coordinates. The AABB
+ * is tight, and the sphere is centered on it.*/
+void kelpoa_bounding_volume__of_vertices(struct kelpoa_bounding_volume_s *const volume,
+                                         const struct kelpo_polygon_vertex_s *const vertices,
+                                         const unsigned numVertices);
+
+/* Computes the volume enclosing the vertices of the given triangles (struct
+ * kelpo_polygon_triangle_s).*/
+void kelpoa_bounding_volume__of_triangles(struct kelpoa_bounding_volume_s *const volume,
+                                          const struct kelpoa_generic_stack_s *const triangles);
+
+/* Transforms the volume by the given affine matrix, so that it encloses the
+ * vertices it enclosed, transformed by the same matrix. The result is
+ * conservative: the new AABB encloses the transformed AABB, and the sphere's
+ * radius is scaled by the matrix's largest axis scale.*/
+void kelpoa_bounding_volume__transform(struct kelpoa_bounding_volume_s *const volume,
+                                       const struct kelpoa_matrix44_s *const matrix);
+
+/* Tests the volume against the view frustum of the given matrix, which takes
+ * the volume's space into clip space; e.g. one made with
+ * kelpoa_matrix44__make_clip_space_matrix(), multiplied by a model matrix if
+ * the volume is in model space. The frustum's planes are extracted from the
+ * matrix, and the sphere and then the AABB are tested against them. Errs on
+ * the side of KELPOA_BOUNDING_VOLUME_INTERSECTS_FRUSTUM. An empty volume is
+ * outside the frustum.*/
+enum kelpoa_bounding_volume_frustum_test_e kelpoa_bounding_volume__test_frustum(const struct kelpoa_bounding_volume_s *const volume,
+                                                                                const struct kelpoa_matrix44_s *const clipSpaceMatrix);
+
+#endif
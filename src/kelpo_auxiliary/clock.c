@@ -0,0 +1,53 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * A monotonic high-resolution clock, for timing code.
+ *
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <kelpo_auxiliary/clock.h>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+#if defined(_WIN32)
+    static double large_integer_to_double(const LARGE_INTEGER value)
+    {
+        return ((value.HighPart * 4294967296.0) + value.LowPart);
+    }
+
+    double kelpoa_clock__nanoseconds(void)
+    {
+        LARGE_INTEGER frequency;
+        LARGE_INTEGER ticks;
+
+        /* The frequency is fixed at system boot, but querying it is cheap, and
+         * not caching it keeps the function thread-safe.*/
+        if (!QueryPerformanceFrequency(&frequency) ||
+            !QueryPerformanceCounter(&ticks))
+        {
+            return 0;
+        }
+
+        return ((large_integer_to_double(ticks) / large_integer_to_double(frequency)) * 1000000000.0);
+    }
+#else
+    double kelpoa_clock__nanoseconds(void)
+    {
+        struct timespec now;
+
+        if (clock_gettime(CLOCK_MONOTONIC, &now) != 0)
+        {
+            return 0;
+        }
+
+        return ((now.tv_sec * 1000000000.0) + now.tv_nsec);
+    }
+#endif
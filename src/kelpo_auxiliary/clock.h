@@ -0,0 +1,24 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * A monotonic high-resolution clock, for timing code.
+ *
+ * Uses QueryPerformanceCounter() on Windows and clock_gettime() elsewhere.
+ *
+ */
+
+#ifndef KELPO_AUXILIARY_CLOCK_H
+#define KELPO_AUXILIARY_CLOCK_H
+
+/* Returns the time, in nanoseconds, elapsed since an arbitrary point in the
+ * past (typically system startup). The value never decreases, so the difference
+ * of two calls gives the time elapsed between them. The point of reference is
+ * the same for all modules of a program, so e.g. times taken in a renderer DLL
+ * can be compared with those taken in the program that loaded it.
+ *
+ * Note: The value is a double, since C89 lacks a 64-bit integer type. A double
+ * holds whole nanoseconds exactly for about 100 days' worth of time, after
+ * which values are rounded to a few nanoseconds.*/
+double kelpoa_clock__nanoseconds(void);
+
+#endif
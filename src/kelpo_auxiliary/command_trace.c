@@ -0,0 +1,509 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * Loads and replays command traces.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+#include <kelpo_auxiliary/command_trace.h>
+#include <kelpo_interface/polygon/triangle/triangle.h>
+#include <kelpo_interface/interface.h>
+
+static uint32_t read_uint32(const uint8_t *const src)
+{
+    return ((uint32_t)src[0] |
+            ((uint32_t)src[1] << 8) |
+            ((uint32_t)src[2] << 16) |
+            ((uint32_t)src[3] << 24));
+}
+
+static float read_float(const uint8_t *const src)
+{
+    const uint32_t bits = read_uint32(src);
+    float value = 0;
+
+    memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+/* Returns the size, in bytes, of the pixel data of a texture of the given
+ * side length and number of mip levels.*/
+static unsigned long texture_byte_size(const unsigned width,
+                                       const unsigned numMipLevels)
+{
+    unsigned m = 0;
+    unsigned long byteSize = 0;
+
+    for (m = 0; m < (numMipLevels? numMipLevels : 1); m++)
+    {
+        const unsigned long mipLevelSideLength = (width >> m);
+
+        byteSize += (mipLevelSideLength * mipLevelSideLength * sizeof(uint16_t));
+    }
+
+    return byteSize;
+}
+
+static void decode_triangle(const uint8_t *src,
+                            struct kelpo_polygon_triangle_s *const dst,
+                            struct kelpo_polygon_texture_s *const textures)
+{
+    unsigned v = 0;
+    const uint32_t textureId = read_uint32(src);
+    const uint32_t flags = read_uint32(src + 4);
+
+    memset(dst, 0, sizeof(*dst));
+
+    dst->texture = (textureId? &textures[textureId - 1] : NULL);
+    dst->flags.wireframe = !!(flags & KELPOA_CMDTRACE_TRIANGLE_FLAG_WIREFRAME);
+    dst->flags.ignore = !!(flags & KELPOA_CMDTRACE_TRIANGLE_FLAG_IGNORE);
+    dst->flags.twoSided = !!(flags & KELPOA_CMDTRACE_TRIANGLE_FLAG_TWO_SIDED);
+
+    src += 8;
+
+    for (v = 0; v < 3; v++)
+    {
+        struct kelpo_polygon_vertex_s *const vertex = &dst->vertex[v];
+
+        vertex->x = read_float(src + 0);
+        vertex->y = read_float(src + 4);
+        vertex->z = read_float(src + 8);
+        vertex->w = read_float(src + 12);
+        vertex->nx = read_float(src + 16);
+        vertex->ny = read_float(src + 20);
+        vertex->nz = read_float(src + 24);
+        vertex->u = read_float(src + 28);
+        vertex->v = read_float(src + 32);
+        vertex->r = src[36];
+        vertex->g = src[37];
+        vertex->b = src[38];
+        vertex->a = src[39];
+
+        src += 40;
+    }
+
+    return;
+}
+
+/* The location of a texture payload in the trace's file data.*/
+struct payload_s
+{
+    const uint8_t *pixels;
+    uint32_t byteSize;
+};
+
+/* Walks through the commands in the trace's file data. If 'payloads' is NULL,
+ * only validates the commands and counts them into the trace's 'numXxxx'
+ * members and 'numPayloads'. Otherwise, also decodes them into the trace's
+ * arrays and 'payloads', which the caller must have allocated according to the
+ * counts. Returns 1 on success; 0 if the file data are malformed.*/
+static int parse_commands(struct kelpoa_cmdtrace_s *const trace,
+                          struct payload_s *const payloads,
+                          uint32_t *const numPayloads)
+{
+    const uint8_t *const fileEnd = (trace->fileData + trace->fileByteSize);
+    const uint8_t *src = (trace->fileData + KELPOA_CMDTRACE_HEADER_SIZE);
+    const int decode = (payloads != NULL);
+    int isNewFrame = 1;
+    uint32_t payloadCount = 0;
+    uint32_t numTextures = 0;
+    uint32_t numTriangles = 0;
+    uint32_t numCommands = 0;
+    uint32_t numFrames = 0;
+
+    #define REQUIRE_BYTES(numBytes) if ((unsigned long)(fileEnd - src) < (unsigned long)(numBytes))\
+                                    {\
+                                        goto malformed;\
+                                    }
+
+    while (src < fileEnd)
+    {
+        uint32_t commandType = 0;
+
+        REQUIRE_BYTES(4);
+        commandType = read_uint32(src);
+        src += 4;
+
+        switch (commandType)
+        {
+            case KELPOA_CMDTRACE_TEXTURE_DATA:
+            {
+                uint32_t payloadId = 0;
+                uint32_t byteSize = 0;
+
+                REQUIRE_BYTES(8);
+                payloadId = read_uint32(src);
+                byteSize = read_uint32(src + 4);
+                src += 8;
+
+                if (payloadId != (payloadCount + 1))
+                {
+                    goto malformed;
+                }
+
+                REQUIRE_BYTES((byteSize + 3) & ~3u);
+
+                if (decode)
+                {
+                    payloads[payloadCount].pixels = src;
+                    payloads[payloadCount].byteSize = byteSize;
+                }
+
+                payloadCount++;
+                src += ((byteSize + 3) & ~3u);
+
+                /* Payload data don't count as a replayable command.*/
+                continue;
+            }
+            case KELPOA_CMDTRACE_UPLOAD_TEXTURE:
+            case KELPOA_CMDTRACE_UPDATE_TEXTURE:
+            {
+                uint32_t textureId = 0;
+                uint32_t payloadId = 0;
+                uint32_t width = 0;
+                uint32_t height = 0;
+                uint32_t numMipLevels = 0;
+                uint32_t flags = 0;
+
+                REQUIRE_BYTES(24);
+                textureId = read_uint32(src);
+                payloadId = read_uint32(src + 4);
+                width = read_uint32(src + 8);
+                height = read_uint32(src + 12);
+                numMipLevels = read_uint32(src + 16);
+                flags = read_uint32(src + 20);
+                src += 24;
+
+                if (commandType == KELPOA_CMDTRACE_UPLOAD_TEXTURE)
+                {
+                    if (textureId != (numTextures + 1))
+                    {
+                        goto malformed;
+                    }
+
+                    numTextures++;
+                }
+
+                if (!textureId ||
+                    (textureId > numTextures) ||
+                    !payloadId ||
+                    (payloadId > payloadCount) ||
+                    (width > KELPO_TEXTURE_MAX_SIDE_LENGTH) ||
+                    (numMipLevels > 9))
+                {
+                    goto malformed;
+                }
+
+                if (decode)
+                {
+                    struct kelpoa_cmdtrace_command_s *const command = &trace->commands[numCommands];
+                    const uint8_t *pixels = payloads[payloadId - 1].pixels;
+                    unsigned m = 0;
+
+                    if (payloads[payloadId - 1].byteSize < texture_byte_size(width, numMipLevels))
+                    {
+                        goto malformed;
+                    }
+
+                    memset(command, 0, sizeof(*command));
+                    command->type = (enum kelpoa_cmdtrace_command_type_e)commandType;
+                    command->textureIdx = (textureId - 1);
+                    command->textureState.width = width;
+                    command->textureState.height = height;
+                    command->textureState.numMipLevels = numMipLevels;
+                    command->textureState.flags.noFiltering = !!(flags & KELPOA_CMDTRACE_TEXTURE_FLAG_NO_FILTERING);
+                    command->textureState.flags.clamped = !!(flags & KELPOA_CMDTRACE_TEXTURE_FLAG_CLAMPED);
+                    command->textureState.flags.noMipmapping = !!(flags & KELPOA_CMDTRACE_TEXTURE_FLAG_NO_MIPMAPPING);
+
+                    for (m = 0; m < (numMipLevels? numMipLevels : 1); m++)
+                    {
+                        command->textureState.mipLevel[m] = (uint16_t*)pixels;
+                        pixels += ((width >> m) * (width >> m) * sizeof(uint16_t));
+                    }
+                }
+
+                break;
+            }
+            case KELPOA_CMDTRACE_DRAW_TRIANGLES:
+            {
+                uint32_t count = 0;
+                uint32_t i = 0;
+
+                REQUIRE_BYTES(4);
+                count = read_uint32(src);
+                src += 4;
+
+                if (count > ((unsigned long)(fileEnd - src) / KELPOA_CMDTRACE_TRIANGLE_SIZE))
+                {
+                    goto malformed;
+                }
+
+                for (i = 0; i < count; i++)
+                {
+                    const uint32_t textureId = read_uint32(src + (i * KELPOA_CMDTRACE_TRIANGLE_SIZE));
+
+                    if (textureId > numTextures)
+                    {
+                        goto malformed;
+                    }
+
+                    if (decode)
+                    {
+                        decode_triangle((src + (i * KELPOA_CMDTRACE_TRIANGLE_SIZE)),
+                                        &trace->triangles[numTriangles + i],
+                                        trace->textures);
+                    }
+                }
+
+                if (decode)
+                {
+                    struct kelpoa_cmdtrace_command_s *const command = &trace->commands[numCommands];
+
+                    memset(command, 0, sizeof(*command));
+                    command->type = KELPOA_CMDTRACE_DRAW_TRIANGLES;
+                    command->firstTriangleIdx = numTriangles;
+                    command->numTriangles = count;
+                }
+
+                numTriangles += count;
+                src += (count * KELPOA_CMDTRACE_TRIANGLE_SIZE);
+
+                break;
+            }
+            case KELPOA_CMDTRACE_CLEAR_FRAME:
+            case KELPOA_CMDTRACE_FLIP_SURFACE:
+            case KELPOA_CMDTRACE_UNLOAD_TEXTURES:
+            {
+                if (decode)
+                {
+                    struct kelpoa_cmdtrace_command_s *const command = &trace->commands[numCommands];
+
+                    memset(command, 0, sizeof(*command));
+                    command->type = (enum kelpoa_cmdtrace_command_type_e)commandType;
+                }
+
+                break;
+            }
+            default: goto malformed;
+        }
+
+        /* Each flip ends a frame, and the next command begins a new one.*/
+        if (isNewFrame)
+        {
+            if (decode)
+            {
+                trace->frameStartIdx[numFrames] = numCommands;
+            }
+
+            numFrames++;
+        }
+
+        isNewFrame = (commandType == KELPOA_CMDTRACE_FLIP_SURFACE);
+        numCommands++;
+    }
+
+    #undef REQUIRE_BYTES
+
+    if (decode)
+    {
+        trace->frameStartIdx[trace->numFrames] = numCommands;
+    }
+    else
+    {
+        trace->numCommands = numCommands;
+        trace->numTextures = numTextures;
+        trace->numTriangles = numTriangles;
+        trace->numFrames = numFrames;
+        *numPayloads = payloadCount;
+    }
+
+    return 1;
+
+    malformed:
+    fprintf(stderr, "ERROR: The trace file is malformed\n");
+    return 0;
+}
+
+struct kelpoa_cmdtrace_s* kelpoa_cmdtrace__load(const char *const filename)
+{
+    struct kelpoa_cmdtrace_s *trace = NULL;
+    struct payload_s *payloads = NULL;
+    uint32_t numPayloads = 0;
+    FILE *file = NULL;
+    long fileByteSize = 0;
+    uint32_t i = 0;
+
+    if (!(file = fopen(filename, "rb")) ||
+        (fseek(file, 0, SEEK_END) != 0) ||
+        ((fileByteSize = ftell(file)) < KELPOA_CMDTRACE_HEADER_SIZE) ||
+        (fseek(file, 0, SEEK_SET) != 0))
+    {
+        fprintf(stderr, "ERROR: Could not open the trace file \"%s\"\n", filename);
+        goto fail;
+    }
+
+    if (!(trace = (struct kelpoa_cmdtrace_s*)calloc(1, sizeof(*trace))) ||
+        !(trace->fileData = (uint8_t*)malloc(fileByteSize)))
+    {
+        fprintf(stderr, "ERROR: Failed to allocate memory for the trace\n");
+        goto fail;
+    }
+
+    trace->fileByteSize = fileByteSize;
+
+    if (fread(trace->fileData, 1, fileByteSize, file) != (unsigned long)fileByteSize)
+    {
+        fprintf(stderr, "ERROR: Could not read the trace file \"%s\"\n", filename);
+        goto fail;
+    }
+
+    fclose(file);
+    file = NULL;
+
+    if (memcmp(trace->fileData, KELPOA_CMDTRACE_MAGIC, 8) != 0)
+    {
+        fprintf(stderr, "ERROR: \"%s\" is not a Kelpo trace file\n", filename);
+        goto fail;
+    }
+
+    if (read_uint32(trace->fileData + 8) != KELPOA_CMDTRACE_FORMAT_VERSION)
+    {
+        fprintf(stderr, "ERROR: The trace file is of version %u, but only version %d "
+                        "is supported\n", read_uint32(trace->fileData + 8), KELPOA_CMDTRACE_FORMAT_VERSION);
+        goto fail;
+    }
+
+    trace->screenWidth = read_uint32(trace->fileData + 12);
+    trace->screenHeight = read_uint32(trace->fileData + 16);
+    trace->screenBPP = read_uint32(trace->fileData + 20);
+
+    if (!parse_commands(trace, NULL, &numPayloads))
+    {
+        goto fail;
+    }
+
+    /* Note: the +1s avoid zero-sized allocations for empty traces.*/
+    if (!(trace->commands = (struct kelpoa_cmdtrace_command_s*)malloc((trace->numCommands + 1) * sizeof(*trace->commands))) ||
+        !(trace->frameStartIdx = (uint32_t*)malloc((trace->numFrames + 1) * sizeof(*trace->frameStartIdx))) ||
+        !(trace->textures = (struct kelpo_polygon_texture_s*)calloc((trace->numTextures + 1), sizeof(*trace->textures))) ||
+        !(trace->triangles = (struct kelpo_polygon_triangle_s*)malloc((trace->numTriangles + 1) * sizeof(*trace->triangles))) ||
+        !(payloads = (struct payload_s*)malloc((numPayloads + 1) * sizeof(*payloads))))
+    {
+        fprintf(stderr, "ERROR: Failed to allocate memory for the trace\n");
+        goto fail;
+    }
+
+    if (!parse_commands(trace, payloads, &numPayloads))
+    {
+        goto fail;
+    }
+
+    free(payloads);
+
+    for (i = 0; i < trace->numCommands; i++)
+    {
+        trace->numTrianglesDrawn += trace->commands[i].numTriangles;
+    }
+
+    return trace;
+
+    fail:
+    if (file) fclose(file);
+    free(payloads);
+    kelpoa_cmdtrace__free(trace);
+    return NULL;
+}
+
+int kelpoa_cmdtrace__replay_frame(struct kelpoa_cmdtrace_s *const trace,
+                                  const struct kelpo_interface_s *const kelpo,
+                                  const uint32_t frameIdx)
+{
+    uint32_t i = 0;
+
+    assert(trace && kelpo && "Invalid arguments.");
+    assert((frameIdx < trace->numFrames) && "Frame index out of bounds.");
+
+    for (i = trace->frameStartIdx[frameIdx]; i < trace->frameStartIdx[frameIdx + 1]; i++)
+    {
+        const struct kelpoa_cmdtrace_command_s *const command = &trace->commands[i];
+        int success = 1;
+
+        switch (command->type)
+        {
+            case KELPOA_CMDTRACE_CLEAR_FRAME:
+            {
+                success = kelpo->rasterizer.clear_frame();
+                break;
+            }
+            case KELPOA_CMDTRACE_FLIP_SURFACE:
+            {
+                success = kelpo->window.flip_surface();
+                break;
+            }
+            case KELPOA_CMDTRACE_UNLOAD_TEXTURES:
+            {
+                success = kelpo->rasterizer.unload_textures();
+                break;
+            }
+            case KELPOA_CMDTRACE_UPLOAD_TEXTURE:
+            {
+                /* Each upload in the trace is of a new texture as far as the
+                 * renderer is concerned, including when the trace is replayed
+                 * again after its textures have been unloaded.*/
+                struct kelpo_polygon_texture_s *const texture = &trace->textures[command->textureIdx];
+                *texture = command->textureState;
+                success = kelpo->rasterizer.upload_texture(texture);
+                break;
+            }
+            case KELPOA_CMDTRACE_UPDATE_TEXTURE:
+            {
+                /* Retain the renderer's identifiers for the texture.*/
+                struct kelpo_polygon_texture_s *const texture = &trace->textures[command->textureIdx];
+                const uint32_t apiId = texture->apiId;
+                void *const apiAuxData = texture->apiAuxData;
+
+                *texture = command->textureState;
+                texture->apiId = apiId;
+                texture->apiAuxData = apiAuxData;
+                success = kelpo->rasterizer.update_texture(texture);
+                break;
+            }
+            case KELPOA_CMDTRACE_DRAW_TRIANGLES:
+            {
+                success = kelpo->rasterizer.draw_triangles((trace->triangles + command->firstTriangleIdx),
+                                                           command->numTriangles);
+                break;
+            }
+            default: assert(0 && "Unrecognized trace command."); break;
+        }
+
+        if (!success)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+void kelpoa_cmdtrace__free(struct kelpoa_cmdtrace_s *const trace)
+{
+    if (!trace)
+    {
+        return;
+    }
+
+    free(trace->commands);
+    free(trace->frameStartIdx);
+    free(trace->textures);
+    free(trace->triangles);
+    free(trace->fileData);
+    free(trace);
+
+    return;
+}
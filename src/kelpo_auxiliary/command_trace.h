@@ -0,0 +1,160 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * Loads and replays command traces: files holding the calls that a program made
+ * to a Kelpo renderer's rasterizer and window, as recorded by Kelpo's recording
+ * renderer. A replayed trace reproduces the program's rendering without the
+ * program itself, so it can be used e.g. as a repeatable benchmark of a renderer.
+ *
+ * Usage:
+ *
+ *   1. Call __load() to read a trace file into memory.
+ *
+ *   2. Call __replay_frame() for each of the trace's frames, in order, passing
+ *      in the interface of the renderer to replay on. The renderer's window must
+ *      be open.
+ *
+ *   3. To replay the trace again from the beginning, first unload the
+ *      renderer's textures via the interface's unload_textures().
+ *
+ *   4. Call __free() to release the trace's memory.
+ *
+ * File format (version 1). Values are little-endian; integers are uint32 and
+ * floats 32-bit IEEE 754, unless otherwise noted.
+ *
+ *   Header:
+ *     char[8]  "KELPOTRC"
+ *     uint32   format version
+ *     uint32   screen width, height and BPP, as passed to window.open()
+ *
+ *   Followed by any number of commands, each beginning with a uint32 command
+ *   type (enum kelpoa_cmdtrace_command_type_e) and followed by its data:
+ *
+ *     CLEAR_FRAME, FLIP_SURFACE, UNLOAD_TEXTURES:
+ *       (no data)
+ *
+ *     TEXTURE_DATA:
+ *       uint32   payload ID; the first payload has ID 1, the second 2, etc.
+ *       uint32   byte size of the pixel data (N)
+ *       uint8[N] the ARGB 1555 pixels of each mip level in turn, in the same
+ *                order as in kelpo_polygon_texture_s, followed by 0-3 bytes of
+ *                padding to keep the file's contents 4-byte aligned
+ *
+ *     UPLOAD_TEXTURE, UPDATE_TEXTURE:
+ *       uint32   texture ID; each upload introduces a new ID, starting from 1
+ *       uint32   ID of the payload holding the texture's pixels, given in an
+ *                earlier TEXTURE_DATA command. Identical pixel data are stored
+ *                only once, in which case several textures share a payload.
+ *       uint32   width, height, number of mip levels
+ *       uint32   texture flags (KELPOA_CMDTRACE_TEXTURE_FLAG_*)
+ *
+ *     DRAW_TRIANGLES:
+ *       uint32   number of triangles, followed by that many of:
+ *         uint32   texture ID, or 0 if untextured
+ *         uint32   triangle flags (KELPOA_CMDTRACE_TRIANGLE_FLAG_*)
+ *         3 x (float x, y, z, w, nx, ny, nz, u, v; uint8 r, g, b, a)
+ *
+ */
+
+#ifndef KELPO_AUXILIARY_COMMAND_TRACE_H
+#define KELPO_AUXILIARY_COMMAND_TRACE_H
+
+#include <kelpo_interface/stdint.h>
+#include <kelpo_interface/polygon/texture.h>
+
+struct kelpo_interface_s;
+struct kelpo_polygon_triangle_s;
+
+#define KELPOA_CMDTRACE_MAGIC "KELPOTRC"
+#define KELPOA_CMDTRACE_FORMAT_VERSION 1
+
+/* The sizes, in bytes, of the file header and of a triangle in a DRAW_TRIANGLES
+ * command.*/
+#define KELPOA_CMDTRACE_HEADER_SIZE 24
+#define KELPOA_CMDTRACE_TRIANGLE_SIZE 128
+
+#define KELPOA_CMDTRACE_TEXTURE_FLAG_NO_FILTERING   0x1
+#define KELPOA_CMDTRACE_TEXTURE_FLAG_CLAMPED        0x2
+#define KELPOA_CMDTRACE_TEXTURE_FLAG_NO_MIPMAPPING  0x4
+
+#define KELPOA_CMDTRACE_TRIANGLE_FLAG_WIREFRAME     0x1
+#define KELPOA_CMDTRACE_TRIANGLE_FLAG_IGNORE        0x2
+#define KELPOA_CMDTRACE_TRIANGLE_FLAG_TWO_SIDED     0x4
+
+enum kelpoa_cmdtrace_command_type_e
+{
+    KELPOA_CMDTRACE_CLEAR_FRAME = 1,
+    KELPOA_CMDTRACE_FLIP_SURFACE,
+    KELPOA_CMDTRACE_TEXTURE_DATA,
+    KELPOA_CMDTRACE_UPLOAD_TEXTURE,
+    KELPOA_CMDTRACE_UPDATE_TEXTURE,
+    KELPOA_CMDTRACE_UNLOAD_TEXTURES,
+    KELPOA_CMDTRACE_DRAW_TRIANGLES
+};
+
+/* A replayable command, decoded from the trace file.*/
+struct kelpoa_cmdtrace_command_s
+{
+    enum kelpoa_cmdtrace_command_type_e type;
+
+    /* For UPLOAD_TEXTURE and UPDATE_TEXTURE: the texture being uploaded or
+     * updated (as an index to the trace's 'textures' array), and the texture
+     * state to apply to it before the call. Its mip levels point to the
+     * trace's in-memory copy of the file.*/
+    uint32_t textureIdx;
+    struct kelpo_polygon_texture_s textureState;
+
+    /* For DRAW_TRIANGLES: the range of the trace's 'triangles' array to draw.*/
+    uint32_t firstTriangleIdx;
+    uint32_t numTriangles;
+};
+
+struct kelpoa_cmdtrace_s
+{
+    /* The screen mode the trace was recorded in.*/
+    unsigned screenWidth;
+    unsigned screenHeight;
+    unsigned screenBPP;
+
+    /* The number of frames in the trace. A frame consists of the commands up to
+     * and including a FLIP_SURFACE command. Any commands following the last flip
+     * form a frame of their own.*/
+    uint32_t numFrames;
+
+    struct kelpoa_cmdtrace_command_s *commands;
+    uint32_t numCommands;
+
+    /* For each frame, the index in 'commands' of the frame's first command. Has
+     * (numFrames + 1) elements, the last being equal to 'numCommands'.*/
+    uint32_t *frameStartIdx;
+
+    /* The textures the trace uploads, which the triangles point to.*/
+    struct kelpo_polygon_texture_s *textures;
+    uint32_t numTextures;
+
+    struct kelpo_polygon_triangle_s *triangles;
+    uint32_t numTriangles;
+
+    /* The number of triangles drawn in total, across all frames.*/
+    unsigned long numTrianglesDrawn;
+
+    /* The trace file's contents, holding the textures' pixel data.*/
+    uint8_t *fileData;
+    unsigned long fileByteSize;
+};
+
+/* Loads the given trace file into memory. Returns a pointer to the loaded trace
+ * on success; NULL on failure.*/
+struct kelpoa_cmdtrace_s* kelpoa_cmdtrace__load(const char *const filename);
+
+/* Issues the commands of the given frame of the trace to the given renderer.
+ * Returns 1 on success; 0 if a call to the renderer failed.*/
+int kelpoa_cmdtrace__replay_frame(struct kelpoa_cmdtrace_s *const trace,
+                                  const struct kelpo_interface_s *const kelpo,
+                                  const uint32_t frameIdx);
+
+/* Deallocates the given trace's memory. The trace pointer will no longer be
+ * valid after this call.*/
+void kelpoa_cmdtrace__free(struct kelpoa_cmdtrace_s *const trace);
+
+#endif
@@ -291,7 +291,7 @@ uint32_t kac10_reader__read_textures(struct kac_1_0_texture_s **textures)
 
                 for (p = 0; p < texturePixelCount; p++)
                 {
-                    const uint16_t packedPixel = 0;
+                    uint16_t packedPixel = 0;
 
                     fread((char*)&packedPixel, sizeof(packedPixel), 1, INPUT_FILE);
 
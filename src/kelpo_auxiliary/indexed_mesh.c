@@ -0,0 +1,57 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * A triangle mesh whose triangles index into an array of unique vertices.
+ *
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/indexed_mesh.h>
+#include <kelpo_auxiliary/triangle_bvh.h>
+
+struct kelpoa_indexed_mesh_s* kelpoa_indexed_mesh__create(void)
+{
+    struct kelpoa_indexed_mesh_s *newMesh = (struct kelpoa_indexed_mesh_s*)calloc(1, sizeof(struct kelpoa_indexed_mesh_s));
+    assert(newMesh && "Failed to allocate memory for a new mesh.");
+
+    newMesh->vertices = kelpoa_generic_stack__create(1, sizeof(struct kelpo_polygon_vertex_s));
+    newMesh->triangles = kelpoa_generic_stack__create(1, sizeof(struct kelpoa_indexed_triangle_s));
+    newMesh->projectedVertices = kelpoa_generic_stack__create(1, sizeof(struct kelpoa_projected_vertex_s));
+    newMesh->facePlanes = kelpoa_generic_stack__create(1, sizeof(struct kelpoa_face_plane_s));
+    newMesh->bvh = kelpoa_generic_stack__create(1, sizeof(struct kelpoa_triangle_bvh_node_s));
+    kelpoa_bounding_volume__clear(&newMesh->bounds);
+
+    return newMesh;
+}
+
+void kelpoa_indexed_mesh__clear(struct kelpoa_indexed_mesh_s *const mesh)
+{
+    assert(mesh && "Attempting to operate on a NULL mesh.");
+
+    kelpoa_generic_stack__clear(mesh->vertices);
+    kelpoa_generic_stack__clear(mesh->triangles);
+    kelpoa_generic_stack__clear(mesh->facePlanes);
+    kelpoa_generic_stack__clear(mesh->bvh);
+    kelpoa_bounding_volume__clear(&mesh->bounds);
+
+    return;
+}
+
+void kelpoa_indexed_mesh__free(struct kelpoa_indexed_mesh_s *const mesh)
+{
+    if (!mesh)
+    {
+        return;
+    }
+
+    kelpoa_generic_stack__free(mesh->vertices);
+    kelpoa_generic_stack__free(mesh->triangles);
+    kelpoa_generic_stack__free(mesh->projectedVertices);
+    kelpoa_generic_stack__free(mesh->facePlanes);
+    kelpoa_generic_stack__free(mesh->bvh);
+    free(mesh);
+
+    return;
+}
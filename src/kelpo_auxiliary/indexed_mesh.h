@@ -0,0 +1,117 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * A triangle mesh whose triangles index into an array of unique vertices,
+ * rather than each storing copies of their own vertices.
+ *
+ * Usage:
+ *
+ *   1. Call __create() to set up a new, empty mesh; and e.g. load data into it
+ *      with kelpoa_load_kac10_indexed_mesh().
+ *
+ *   2. Transform the mesh and project it onto the screen with the triangle
+ *      preparer's indexed mesh functions (kelpoa_triprepr__*_indexed_mesh*()).
+ *      Each of these processes a vertex shared by several triangles only once.
+ *
+ *   3. To deallocate the mesh, call __free(). The mesh pointer obtained in (1)
+ *      will no longer be valid.
+ *
+ */
+
+#ifndef KELPO_AUXILIARY_INDEXED_MESH_H
+#define KELPO_AUXILIARY_INDEXED_MESH_H
+
+#include <kelpo_interface/polygon/triangle/triangle.h>
+#include <kelpo_interface/polygon/vertex.h>
+#include <kelpo_interface/stdint.h>
+#include <kelpo_auxiliary/bounding_volume.h>
+
+struct kelpoa_generic_stack_s;
+
+struct kelpoa_indexed_triangle_s
+{
+    /* Indices into the mesh's vertex array.*/
+    uint32_t vertexIdx[3];
+
+    struct kelpo_polygon_texture_s *texture;
+
+    struct kelpo_polygon_triangle_flags_s flags;
+};
+
+/* The plane of one of a mesh's triangles: the points p for which
+ * dot(n, p) + d = 0, where n (nx, ny, nz) points out of the triangle's front
+ * face. Used by the triangle preparer to cull backfacing triangles.*/
+struct kelpoa_face_plane_s
+{
+    float nx, ny, nz;
+    float d;
+};
+
+/* The state of a vertex during projection. Used internally by the triangle
+ * preparer.*/
+struct kelpoa_projected_vertex_s
+{
+    struct kelpo_polygon_vertex_s clipSpace;
+    struct kelpo_polygon_vertex_s screenSpace;
+
+    /* The clip space vertex's outcodes (KELPOA_TRICLIPR_PLANE_* bits) against
+     * the view frustum and against its guard band.*/
+    unsigned frustumOutcode;
+    unsigned guardBandOutcode;
+
+    /* A combination of the triangle preparer's projection status bits; 0 if
+     * the vertex hasn't been processed yet.*/
+    unsigned status;
+};
+
+struct kelpoa_indexed_mesh_s
+{
+    /* The mesh's unique vertices (struct kelpo_polygon_vertex_s).*/
+    struct kelpoa_generic_stack_s *vertices;
+
+    /* The mesh's triangles (struct kelpoa_indexed_triangle_s).*/
+    struct kelpoa_generic_stack_s *triangles;
+
+    /* The bounding volume of the mesh's vertices. Computed when the mesh is
+     * loaded, and kept up to date by the triangle preparer's functions that
+     * transform the mesh; code that otherwise modifies the vertices should
+     * recompute it, e.g. with kelpoa_bounding_volume__of_vertices(). When
+     * projecting the mesh, the triangle preparer tests the volume against the
+     * view frustum, unless the volume is empty (e.g. for a mesh built by hand).*/
+    struct kelpoa_bounding_volume_s bounds;
+
+    /* Working memory for projecting the mesh (struct kelpoa_projected_vertex_s),
+     * one element per vertex. Its contents are only meaningful during a call
+     * to kelpoa_triprepr__project_indexed_mesh_to_screen().*/
+    struct kelpoa_generic_stack_s *projectedVertices;
+
+    /* The planes of the mesh's triangles (struct kelpoa_face_plane_s), one
+     * element per triangle, in the same space as the vertices. Computed by the
+     * triangle preparer when it first needs them, and recomputed if their
+     * count differs from the triangles'. Code that modifies the mesh's vertices
+     * other than via the triangle preparer should clear this stack.*/
+    struct kelpoa_generic_stack_s *facePlanes;
+
+    /* The bounding volume hierarchy of the mesh's triangles (struct
+     * kelpoa_triangle_bvh_node_s; see triangle_bvh.h), in the same space as
+     * the vertices. Built when the mesh is loaded, and kept up to date by the
+     * triangle preparer's functions that transform the mesh. When projecting
+     * the mesh, the triangle preparer culls its triangles against the view
+     * frustum a cluster at a time, unless the stack is empty. Code that
+     * otherwise modifies the mesh's vertices or triangles should rebuild or
+     * clear it.*/
+    struct kelpoa_generic_stack_s *bvh;
+};
+
+/* Creates a new mesh with no vertices or triangles.*/
+struct kelpoa_indexed_mesh_s* kelpoa_indexed_mesh__create(void);
+
+/* Removes all vertices and triangles from the mesh, but doesn't deallocate
+ * their memory.*/
+void kelpoa_indexed_mesh__clear(struct kelpoa_indexed_mesh_s *const mesh);
+
+/* Deallocates all memory allocated for the mesh, including the mesh pointer
+ * itself. Textures referenced by the mesh's triangles aren't freed.*/
+void kelpoa_indexed_mesh__free(struct kelpoa_indexed_mesh_s *const mesh);
+
+#endif
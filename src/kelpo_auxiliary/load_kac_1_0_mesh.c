@@ -7,158 +7,353 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <assert.h>
 #include <stdio.h>
 #include <math.h>
+#include <kelpo_auxiliary/bounding_volume.h>
 #include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/indexed_mesh.h>
 #include <kelpo_auxiliary/load_kac_1_0_mesh.h>
+#include <kelpo_auxiliary/triangle_bvh.h>
 #include <kelpo_auxiliary/import_kac_1_0.h>
+#include <kelpo_auxiliary/profiler.h>
 #include <kelpo_interface/polygon/triangle/triangle.h>
 
+/* The KAC data of a file being loaded.*/
+struct kac_data_s
+{
+    struct kac_1_0_vertex_coordinates_s *vertexCoords;
+    struct kac_1_0_uv_coordinates_s *uvCoords;
+    struct kac_1_0_material_s *materials;
+    struct kac_1_0_triangle_s *triangles;
+    struct kac_1_0_texture_s *textures;
+    struct kac_1_0_normal_s *normals;
+    uint32_t numTriangles;
+    uint32_t numTextures;
+};
+
+static void free_kac_data(struct kac_data_s *const kac)
+{
+    uint32_t i = 0, m = 0;
+
+    for (i = 0; i < kac->numTextures; i++)
+    {
+        for (m = 0; m < kac->textures[i].numMipLevels; m++)
+        {
+            free(kac->textures[i].mipLevel[m]);
+        }
+    }
+
+    free(kac->vertexCoords);
+    free(kac->uvCoords);
+    free(kac->materials);
+    free(kac->triangles);
+    free(kac->textures);
+    free(kac->normals);
+
+    return;
+}
+
+/* Reads the given KAC file's data, and converts its textures into Kelpo's
+ * format (see kelpoa_load_kac10_mesh() for the semantics of the texture
+ * arguments). Returns 1 on success; else 0. The KAC data should be freed with
+ * free_kac_data() in either case.*/
+static int read_kac_data(const char *const kacFilename,
+                         struct kac_data_s *const kac,
+                         struct kelpo_polygon_texture_s **dstTextures,
+                         uint32_t *numTextures)
+{
+    uint32_t i = 0;
+    int returnValue = 1;
+
+    memset(kac, 0, sizeof(*kac));
+
+    *numTextures = 0;
+
+    if (!kac10_reader__open_file(kacFilename) ||
+        !(kac->numTriangles = kac10_reader__read_triangles(&kac->triangles)) ||
+        !kac10_reader__read_vertex_coordinates(&kac->vertexCoords) ||
+        !kac10_reader__read_uv_coordinates(&kac->uvCoords) ||
+        !kac10_reader__read_materials(&kac->materials) ||
+        !kac10_reader__read_normals(&kac->normals))
+    {
+        /* A file we couldn't read leaves the destination empty, which the
+         * caller is expected to check for.*/
+        kac->numTriangles = 0;
+        goto done;
+    }
+
+    /* Textures are optional (the file might have 0), so we'll load them in here.*/
+    *numTextures = kac->numTextures = kac10_reader__read_textures(&kac->textures);
+    if (*numTextures)
+    {
+        *dstTextures = malloc(*numTextures * sizeof(struct kelpo_polygon_texture_s));
+    }
+
+    /* Convert the KAC textures into Kelpo's internal format.*/
+    for (i = 0; i < *numTextures; i++)
+    {
+        uint32_t p = 0, m = 0;
+
+        /* The code may rely on bit fields or unallocated pointers being 0,
+         * so let's accommodate.*/
+        memset(&(*dstTextures)[i], 0, sizeof(struct kelpo_polygon_texture_s));
+
+        (*dstTextures)[i].width = kac->textures[i].metadata.sideLength;
+        (*dstTextures)[i].height = kac->textures[i].metadata.sideLength;
+        (*dstTextures)[i].numMipLevels = kac->textures[i].numMipLevels;
+        (*dstTextures)[i].flags.clamped = kac->textures[i].metadata.clampUV;
+        (*dstTextures)[i].flags.noFiltering = !kac->textures[i].metadata.sampleLinearly;
+
+        /* Get the pixels for all levels of mipmapping, starting at level 0 and
+         * progressively halving the resolution until we're down to 1 x 1.*/
+        for (m = 0; m < kac->textures[i].numMipLevels; m++)
+        {
+            const uint32_t mipLevelSideLength = ((*dstTextures)[i].width / pow(2, m));
+            const uint32_t mipLevelPixelCount = (mipLevelSideLength * mipLevelSideLength);
+
+            /* We should never end up at a mip level smaller than the minumum.
+             * But if we do, it may indicate an incorrect mip level count for
+             * this texture in the KAC data.*/
+            if (mipLevelSideLength < KAC_1_0_MIN_TEXTURE_SIDE_LENGTH)
+            {
+                returnValue = 0;
+                goto done;
+            }
+
+            (*dstTextures)[i].mipLevel[m] = malloc(mipLevelPixelCount * sizeof((*dstTextures)[i].mipLevel[m][0]));
+            for (p = 0; p < mipLevelPixelCount; p++)
+            {
+                (*dstTextures)[i].mipLevel[m][p] = (kac->textures[i].mipLevel[m][p].a << 15) |
+                                                   (kac->textures[i].mipLevel[m][p].r << 10) |
+                                                   (kac->textures[i].mipLevel[m][p].g << 5)  |
+                                                   (kac->textures[i].mipLevel[m][p].b << 0);
+            }
+
+        }
+    }
+
+    done:
+    kac10_reader__close_file();
+
+    return returnValue;
+}
+
+/* Converts the given vertex of the given KAC triangle into a Kelpo vertex.*/
+static void make_vertex(struct kelpo_polygon_vertex_s *const dstVertex,
+                        const struct kac_data_s *const kac,
+                        const struct kac_1_0_triangle_s *const kacTriangle,
+                        const unsigned v)
+{
+    /* We'll use div/mul instead of a bit shift to upscale KAC's 4-bit
+     * polygon colors into 8-bit, for potentially better dynamic range.*/
+    const float materialColorScale = (255 / 15.0);
+
+    const struct kac_1_0_material_s *material = &kac->materials[kacTriangle->materialIdx];
+    const struct kac_1_0_vertex_coordinates_s *vertex = &kac->vertexCoords[kacTriangle->vertices[v].vertexCoordinatesIdx];
+    const struct kac_1_0_uv_coordinates_s *uv = &kac->uvCoords[kacTriangle->vertices[v].uvIdx];
+    const struct kac_1_0_normal_s *normal = &kac->normals[kacTriangle->vertices[v].normalIdx];
+
+    dstVertex->x = vertex->x;
+    dstVertex->y = vertex->y;
+    dstVertex->z = vertex->z;
+    dstVertex->w = 1;
+
+    dstVertex->nx = normal->x;
+    dstVertex->ny = normal->y;
+    dstVertex->nz = normal->z;
+
+    dstVertex->u = uv->u;
+    dstVertex->v = uv->v;
+
+    dstVertex->r = (material->color.r * materialColorScale);
+    dstVertex->g = (material->color.g * materialColorScale);
+    dstVertex->b = (material->color.b * materialColorScale);
+    dstVertex->a = (material->color.a * materialColorScale);
+
+    return;
+}
+
 int kelpoa_load_kac10_mesh(const char *const kacFilename,
                            struct kelpoa_generic_stack_s *dstTriangles,
                            struct kelpo_polygon_texture_s **dstTextures,
                            uint32_t *numTextures)
 {
-    struct kac_1_0_vertex_coordinates_s *kacVertexCoords = NULL;
-    struct kac_1_0_uv_coordinates_s *kacUVCoords = NULL;
-    struct kac_1_0_material_s *kacMaterials = NULL;
-    struct kac_1_0_triangle_s *kacTriangles = NULL;
-    struct kac_1_0_texture_s *kacTextures = NULL;
-    struct kac_1_0_normal_s *kacNormals = NULL;
-    uint32_t numTriangles = 0;
+    struct kac_data_s kac;
     int returnValue = 1;
+    uint32_t i = 0;
 
-    *numTextures = 0;
+    KELPOA_PROF_BEGIN("kelpoa_load_kac10_mesh");
+
+    if (!(returnValue = read_kac_data(kacFilename, &kac, dstTextures, numTextures)))
+    {
+        goto done;
+    }
 
-    #define FREE_TEMPORARY_KAC_BUFFERS {uint32_t i = 0, m = 0;\
-                                        for (i = 0; i < *numTextures; i++)\
-                                        {\
-                                            for (m = 0; m < kacTextures[i].numMipLevels; m++)\
-                                            {\
-                                                free(kacTextures[i].mipLevel[m]);\
-                                            }\
-                                        }\
-                                        free(kacVertexCoords);\
-                                        free(kacUVCoords);\
-                                        free(kacMaterials);\
-                                        free(kacTriangles);\
-                                        free(kacTextures);\
-                                        free(kacNormals);}
-
-    if (kac10_reader__open_file(kacFilename) &&
-        (numTriangles = kac10_reader__read_triangles(&kacTriangles)) &&
-        kac10_reader__read_vertex_coordinates(&kacVertexCoords) &&
-        kac10_reader__read_uv_coordinates(&kacUVCoords) &&
-        kac10_reader__read_materials(&kacMaterials) &&
-        kac10_reader__read_normals(&kacNormals))
+    /* Allocate memory for the destination buffers.*/
+    kelpoa_generic_stack__grow(dstTriangles, kac.numTriangles);
+
+    for (i = 0; i < kac.numTriangles; i++)
     {
-        uint32_t i = 0;
-
-        /* Allocate memory for the destination buffers.*/
-        kelpoa_generic_stack__grow(dstTriangles, numTriangles);
-        
-        /* Textures are optional (the file might have 0), so we'll load them in here.*/
-        *numTextures = kac10_reader__read_textures(&kacTextures);
-        if (*numTextures)
+        struct kelpo_polygon_triangle_s kelpoTriangle;
+        uint32_t v = 0;
+        const struct kac_1_0_material_s *material = &kac.materials[kac.triangles[i].materialIdx];
+
+        /* The code may rely on bit fields or the like being initialized to 0,
+         * so let's accommodate.*/
+        memset(&kelpoTriangle, 0, sizeof(struct kelpo_polygon_triangle_s));
+
+        for (v = 0; v < 3; v++)
         {
-            *dstTextures = malloc(*numTextures * sizeof(struct kelpo_polygon_texture_s));
+            make_vertex(&kelpoTriangle.vertex[v], &kac, &kac.triangles[i], v);
         }
 
-        /* Convert the KAC textures into Kelpo's internal format.*/
-        for (i = 0; i < *numTextures; i++)
+        if (material->metadata.hasTexture)
         {
-            uint32_t p = 0, m = 0;
+            kelpoTriangle.texture = &(*dstTextures)[material->metadata.textureIdx];
+        }
 
-            /* The code may rely on bit fields or unallocated pointers being 0,
-             * so let's accommodate.*/
-            memset(&(*dstTextures)[i], 0, sizeof(struct kelpo_polygon_texture_s));
+        kelpoa_generic_stack__push_copy(dstTriangles, &kelpoTriangle);
+    }
 
-            (*dstTextures)[i].width = kacTextures[i].metadata.sideLength;
-            (*dstTextures)[i].height = kacTextures[i].metadata.sideLength;
-            (*dstTextures)[i].numMipLevels = kacTextures[i].numMipLevels;
-            (*dstTextures)[i].flags.clamped = kacTextures[i].metadata.clampUV;
-            (*dstTextures)[i].flags.noFiltering = !kacTextures[i].metadata.sampleLinearly;
+    done:
+    free_kac_data(&kac);
 
-            /* Get the pixels for all levels of mipmapping, starting at level 0 and
-             * progressively halving the resolution until we're down to 1 x 1.*/
-            for (m = 0; m < kacTextures[i].numMipLevels; m++)
-            {
-                const uint32_t mipLevelSideLength = ((*dstTextures)[i].width / pow(2, m));
-                const uint32_t mipLevelPixelCount = (mipLevelSideLength * mipLevelSideLength);
+    KELPOA_PROF_END();
 
-                /* We should never end up at a mip level smaller than the minumum.
-                 * But if we do, it may indicate an incorrect mip level count for
-                 * this texture in the KAC data.*/
-                if (mipLevelSideLength < KAC_1_0_MIN_TEXTURE_SIDE_LENGTH)
-                {
-                    returnValue = 0;
-                    goto done;
-                }
+    return returnValue;
+}
 
-                (*dstTextures)[i].mipLevel[m] = malloc(mipLevelPixelCount * sizeof((*dstTextures)[i].mipLevel[m][0]));
-                for (p = 0; p < mipLevelPixelCount; p++)
-                {
-                    (*dstTextures)[i].mipLevel[m][p] = (kacTextures[i].mipLevel[m][p].a << 15) |
-                                                       (kacTextures[i].mipLevel[m][p].r << 10) |
-                                                       (kacTextures[i].mipLevel[m][p].g << 5)  |
-                                                       (kacTextures[i].mipLevel[m][p].b << 0);
-                }
+/* Identifies a unique vertex of an indexed mesh being loaded.*/
+struct vertex_key_s
+{
+    struct kac_1_0_vertex_s vertex;
+    uint16_t materialIdx;
+};
 
-            }
-        }
+/* Returns a hash of the given KAC vertex combined with the given material.*/
+static uint32_t kac_vertex_hash(const struct kac_1_0_vertex_s *const vertex,
+                                const uint16_t materialIdx)
+{
+    uint32_t hash = 2166136261u;
 
-        for (i = 0; i < numTriangles; i++)
-        {
-            struct kelpo_polygon_triangle_s kelpoTriangle;
-            uint32_t v = 0;
-            const struct kac_1_0_material_s *material = &kacMaterials[kacTriangles[i].materialIdx];
+    hash = ((hash ^ vertex->vertexCoordinatesIdx) * 16777619u);
+    hash = ((hash ^ vertex->normalIdx) * 16777619u);
+    hash = ((hash ^ vertex->uvIdx) * 16777619u);
+    hash = ((hash ^ materialIdx) * 16777619u);
+
+    return hash;
+}
+
+int kelpoa_load_kac10_indexed_mesh(const char *const kacFilename,
+                                   struct kelpoa_indexed_mesh_s *dstMesh,
+                                   struct kelpo_polygon_texture_s **dstTextures,
+                                   uint32_t *numTextures)
+{
+    struct kac_data_s kac;
+
+    /* An open-addressing hash table mapping a KAC vertex and its triangle's
+     * material to the index of the corresponding vertex in the destination
+     * mesh. Each slot holds that index plus 1, or 0 if the slot is empty. The
+     * KAC vertex and material that created each mesh vertex are kept, by mesh
+     * vertex index, in a parallel array, for resolving hash collisions.*/
+    uint32_t *vertexMap = NULL;
+    struct vertex_key_s *vertexKeys = NULL;
+    uint32_t vertexMapSize = 1;
+
+    int returnValue = 1;
+    uint32_t i = 0;
+
+    KELPOA_PROF_BEGIN("kelpoa_load_kac10_indexed_mesh");
 
-            /* The code may rely on bit fields or the like being initialized to 0,
-             * so let's accommodate.*/
-            memset(&kelpoTriangle, 0, sizeof(struct kelpo_polygon_triangle_s));
+    if (!(returnValue = read_kac_data(kacFilename, &kac, dstTextures, numTextures)))
+    {
+        goto done;
+    }
+
+    /* Keep the hash table at most half full.*/
+    while (vertexMapSize < (kac.numTriangles * 3 * 2))
+    {
+        vertexMapSize *= 2;
+    }
+
+    vertexMap = (uint32_t*)calloc(vertexMapSize, sizeof(*vertexMap));
+    vertexKeys = (struct vertex_key_s*)malloc(kac.numTriangles * 3 * sizeof(*vertexKeys));
+    assert(vertexMap && vertexKeys && "Failed to allocate memory for loading the mesh.");
+
+    kelpoa_indexed_mesh__clear(dstMesh);
+    kelpoa_generic_stack__grow(dstMesh->triangles, kac.numTriangles);
 
-            for (v = 0; v < 3; v++)
+    for (i = 0; i < kac.numTriangles; i++)
+    {
+        struct kelpoa_indexed_triangle_s kelpoTriangle;
+        uint32_t v = 0;
+        const struct kac_1_0_triangle_s *const kacTriangle = &kac.triangles[i];
+        const struct kac_1_0_material_s *material = &kac.materials[kacTriangle->materialIdx];
+
+        /* The code may rely on bit fields or the like being initialized to 0,
+         * so let's accommodate.*/
+        memset(&kelpoTriangle, 0, sizeof(struct kelpoa_indexed_triangle_s));
+
+        for (v = 0; v < 3; v++)
+        {
+            const struct kac_1_0_vertex_s *const kacVertex = &kacTriangle->vertices[v];
+            uint32_t slot = (kac_vertex_hash(kacVertex, kacTriangle->materialIdx) & (vertexMapSize - 1));
+
+            /* Find the vertex's slot; either one holding an identical vertex,
+             * or an empty one.*/
+            while (vertexMap[slot])
             {
-                /* We'll use div/mul instead of a bit shift to upscale KAC's 4-bit
-                 * polygon colors into 8-bit, for potentially better dynamic range.*/
-                const float materialColorScale = (255 / 15.0);
-
-                const struct kac_1_0_vertex_coordinates_s *vertex = &kacVertexCoords[kacTriangles[i].vertices[v].vertexCoordinatesIdx];
-                const struct kac_1_0_uv_coordinates_s *uv = &kacUVCoords[kacTriangles[i].vertices[v].uvIdx];
-                const struct kac_1_0_normal_s *normal = &kacNormals[kacTriangles[i].vertices[v].normalIdx];
-
-                kelpoTriangle.vertex[v].x = vertex->x;
-                kelpoTriangle.vertex[v].y = vertex->y;
-                kelpoTriangle.vertex[v].z = vertex->z;
-                kelpoTriangle.vertex[v].w = 1;
-
-                kelpoTriangle.vertex[v].nx = normal->x;
-                kelpoTriangle.vertex[v].ny = normal->y;
-                kelpoTriangle.vertex[v].nz = normal->z;
-
-                kelpoTriangle.vertex[v].u = uv->u;
-                kelpoTriangle.vertex[v].v = uv->v;
-
-                kelpoTriangle.vertex[v].r = (material->color.r * materialColorScale);
-                kelpoTriangle.vertex[v].g = (material->color.g * materialColorScale);
-                kelpoTriangle.vertex[v].b = (material->color.b * materialColorScale);
-                kelpoTriangle.vertex[v].a = (material->color.a * materialColorScale);
+                const struct vertex_key_s *const key = &vertexKeys[vertexMap[slot] - 1];
+
+                if ((key->materialIdx == kacTriangle->materialIdx) &&
+                    (key->vertex.vertexCoordinatesIdx == kacVertex->vertexCoordinatesIdx) &&
+                    (key->vertex.normalIdx == kacVertex->normalIdx) &&
+                    (key->vertex.uvIdx == kacVertex->uvIdx))
+                {
+                    break;
+                }
+
+                slot = ((slot + 1) & (vertexMapSize - 1));
             }
 
-            if (material->metadata.hasTexture)
+            if (!vertexMap[slot])
             {
-                kelpoTriangle.texture = &(*dstTextures)[material->metadata.textureIdx];
+                struct kelpo_polygon_vertex_s kelpoVertex;
+
+                memset(&kelpoVertex, 0, sizeof(struct kelpo_polygon_vertex_s));
+                make_vertex(&kelpoVertex, &kac, kacTriangle, v);
+
+                vertexKeys[dstMesh->vertices->count].materialIdx = kacTriangle->materialIdx;
+                vertexKeys[dstMesh->vertices->count].vertex = *kacVertex;
+
+                kelpoa_generic_stack__push_copy(dstMesh->vertices, &kelpoVertex);
+                vertexMap[slot] = dstMesh->vertices->count;
             }
 
-            kelpoa_generic_stack__push_copy(dstTriangles, &kelpoTriangle);
+            kelpoTriangle.vertexIdx[v] = (vertexMap[slot] - 1);
+        }
+
+        if (material->metadata.hasTexture)
+        {
+            kelpoTriangle.texture = &(*dstTextures)[material->metadata.textureIdx];
         }
+
+        kelpoa_generic_stack__push_copy(dstMesh->triangles, &kelpoTriangle);
     }
 
+    kelpoa_bounding_volume__of_vertices(&dstMesh->bounds,
+                                        (struct kelpo_polygon_vertex_s*)dstMesh->vertices->data,
+                                        dstMesh->vertices->count);
+
+    kelpoa_triangle_bvh__build_indexed(dstMesh->bvh, dstMesh);
+
     done:
-    FREE_TEMPORARY_KAC_BUFFERS;
-    kac10_reader__close_file();
+    free(vertexMap);
+    free(vertexKeys);
+    free_kac_data(&kac);
 
-    return returnValue;
+    KELPOA_PROF_END();
 
-    #undef FREE_TEMPORARY_KAC_BUFFERS
+    return returnValue;
 }
@@ -11,6 +11,7 @@
 #include <kelpo_interface/stdint.h>
 
 struct kelpoa_generic_stack_s;
+struct kelpoa_indexed_mesh_s;
 struct kelpo_polygon_texture_s;
 
 /* Loads a triangle mesh - along with any associated textures - from the given
@@ -24,10 +25,25 @@ struct kelpo_polygon_texture_s;
  * case. It's best to initialize the pointer to NULL prior to passing it into the
  * function, and if the call returns an error, check the pointer's value to see
  * whether it should be deallocated.
+ *
+ * The triangles' bounding volume can be computed afterwards with
+ * kelpoa_bounding_volume__of_triangles() (see bounding_volume.h).
  */
 int kelpoa_load_kac10_mesh(const char *const kacFilename,
                            struct kelpoa_generic_stack_s *dstTriangles,
                            struct kelpo_polygon_texture_s **dstTextures,
                            uint32_t *numTextures);
 
+/* Loads a triangle mesh from the given KAC 1.0 file into the given indexed
+ * mesh, replacing its existing contents. Vertices that are identical across
+ * the file's triangles (same coordinates, normal, UV, and material) are stored
+ * in the mesh only once. Textures are loaded as in kelpoa_load_kac10_mesh().
+ * The mesh's bounding volume and the bounding volume hierarchy of its
+ * triangles are computed; the triangles are thus not necessarily in the file's
+ * order. Returns 1 on success; else 0.*/
+int kelpoa_load_kac10_indexed_mesh(const char *const kacFilename,
+                                   struct kelpoa_indexed_mesh_s *dstMesh,
+                                   struct kelpo_polygon_texture_s **dstTextures,
+                                   uint32_t *numTextures);
+
 #endif
@@ -71,6 +71,23 @@ void kelpoa_matrix44__make_translation_matrix(struct kelpoa_matrix44_s *const m,
     return;
 }
 
+void kelpoa_matrix44__make_model_matrix(struct kelpoa_matrix44_s *const m,
+                                        const float rotX,
+                                        const float rotY,
+                                        const float rotZ,
+                                        const float x,
+                                        const float y,
+                                        const float z)
+{
+    struct kelpoa_matrix44_s rotation, translation;
+
+    kelpoa_matrix44__make_rotation_matrix(&rotation, rotX, rotY, rotZ);
+    kelpoa_matrix44__make_translation_matrix(&translation, x, y, z);
+    kelpoa_matrix44__multiply_two_matrices(&translation, &rotation, m);
+
+    return;
+}
+
 void kelpoa_matrix44__make_clip_space_matrix(struct kelpoa_matrix44_s *const m,
                                              const float fov,
                                              const float aspectRatio,
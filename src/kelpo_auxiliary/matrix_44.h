@@ -30,6 +30,18 @@ void kelpoa_matrix44__make_scaling_matrix(struct kelpoa_matrix44_s *const m,
                                           const float y,
                                           const float z);
 
+/* Makes a matrix that rotates around the origin by the given XYZ angles, as
+ * kelpoa_matrix44__make_rotation_matrix() does, and then translates by the given
+ * XYZ offsets. Equivalent to rotating and then translating triangles with the
+ * triangle preparer.*/
+void kelpoa_matrix44__make_model_matrix(struct kelpoa_matrix44_s *const m,
+                                        const float rotX,
+                                        const float rotY,
+                                        const float rotZ,
+                                        const float x,
+                                        const float y,
+                                        const float z);
+
 void kelpoa_matrix44__make_clip_space_matrix(struct kelpoa_matrix44_s *const m,
                                              const float fov,
                                              const float aspectRatio,
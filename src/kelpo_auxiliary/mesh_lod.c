@@ -0,0 +1,134 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * A chain of progressively coarser levels of detail of an indexed mesh.
+ *
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <math.h>
+#include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/indexed_mesh.h>
+#include <kelpo_auxiliary/bounding_volume.h>
+#include <kelpo_auxiliary/mesh_simplifier.h>
+#include <kelpo_auxiliary/matrix_44.h>
+#include <kelpo_auxiliary/mesh_lod.h>
+#include <kelpo_auxiliary/profiler.h>
+#include <kelpo_auxiliary/misc.h>
+
+/* A level that the simplifier can't get below this fraction of the previous
+ * level's triangles isn't worth keeping, and ends the chain.*/
+#define MIN_REDUCTION 0.9
+
+static float PIXELS_PER_TRIANGLE = 4;
+
+struct kelpoa_mesh_lod_s* kelpoa_mesh_lod__create(struct kelpoa_indexed_mesh_s *const mesh,
+                                                  const unsigned numLevels)
+{
+    struct kelpoa_mesh_lod_s *const lod = (struct kelpoa_mesh_lod_s*)calloc(1, sizeof(struct kelpoa_mesh_lod_s));
+    assert(lod && "Failed to allocate memory for a new LOD chain.");
+
+    KELPOA_PROF_BEGIN("kelpoa_mesh_lod__create");
+
+    lod->levels[0] = mesh;
+    lod->numLevels = 1;
+
+    while ((lod->numLevels < numLevels) &&
+           (lod->numLevels < KELPOA_MESH_LOD_MAX_NUM_LEVELS))
+    {
+        const struct kelpoa_indexed_mesh_s *const prevLevel = lod->levels[lod->numLevels - 1];
+        struct kelpoa_indexed_mesh_s *const level = kelpoa_indexed_mesh__create();
+
+        kelpoa_mesh_simplifier__simplify(prevLevel, level, (prevLevel->triangles->count / 2));
+
+        if (!level->triangles->count ||
+            (level->triangles->count > (prevLevel->triangles->count * MIN_REDUCTION)))
+        {
+            kelpoa_indexed_mesh__free(level);
+            break;
+        }
+
+        lod->levels[lod->numLevels++] = level;
+    }
+
+    KELPOA_PROF_END();
+
+    return lod;
+}
+
+void kelpoa_mesh_lod__free(struct kelpoa_mesh_lod_s *const lod)
+{
+    unsigned i = 0;
+
+    if (!lod)
+    {
+        return;
+    }
+
+    /* Level 0 belongs to the caller.*/
+    for (i = 1; i < lod->numLevels; i++)
+    {
+        kelpoa_indexed_mesh__free(lod->levels[i]);
+    }
+
+    free(lod);
+
+    return;
+}
+
+void kelpoa_mesh_lod__set_pixels_per_triangle(const float pixelsPerTriangle)
+{
+    assert((pixelsPerTriangle > 0) && "The number of pixels per triangle must be positive.");
+
+    PIXELS_PER_TRIANGLE = pixelsPerTriangle;
+
+    return;
+}
+
+unsigned kelpoa_mesh_lod__select_level(const struct kelpoa_mesh_lod_s *const lod,
+                                       const struct kelpoa_matrix44_s *const modelMatrix,
+                                       const struct kelpoa_matrix44_s *const clipSpaceMatrix,
+                                       const unsigned screenHeight)
+{
+    const float *const m = clipSpaceMatrix->elements;
+    struct kelpoa_bounding_volume_s bounds = lod->levels[0]->bounds;
+    unsigned i = 0;
+    float w = 0;
+    float pixelRadius = 0;
+    float triangleBudget = 0;
+
+    if (bounds.radius < 0)
+    {
+        return 0;
+    }
+
+    if (modelMatrix)
+    {
+        kelpoa_bounding_volume__transform(&bounds, modelMatrix);
+    }
+
+    /* The sphere's distance along the view direction, i.e. its center's clip
+     * space W (the matrix is column-major).*/
+    w = ((m[3] * bounds.center.x) + (m[7] * bounds.center.y) + (m[11] * bounds.center.z) + m[15]);
+
+    if (w <= bounds.radius)
+    {
+        return 0;
+    }
+
+    /* The sphere's radius projected onto the screen, by the matrix's vertical
+     * scale.*/
+    pixelRadius = (((bounds.radius * m[5]) / w) * (screenHeight / 2.0f));
+    triangleBudget = ((M_PI * pixelRadius * pixelRadius) / PIXELS_PER_TRIANGLE);
+
+    for (i = 0; i < lod->numLevels; i++)
+    {
+        if (lod->levels[i]->triangles->count <= triangleBudget)
+        {
+            return i;
+        }
+    }
+
+    return (lod->numLevels - 1);
+}
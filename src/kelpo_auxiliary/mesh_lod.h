@@ -0,0 +1,67 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * A chain of progressively coarser levels of detail (LODs) of an indexed mesh,
+ * for rendering distant meshes with fewer triangles.
+ *
+ * Usage:
+ *
+ *   1. Load the mesh, e.g. with kelpoa_load_kac10_indexed_mesh(), and create
+ *      its chain with __create(). The coarser levels are generated with the
+ *      mesh simplifier (see mesh_simplifier.h), each with about half of the
+ *      triangles of the previous one.
+ *
+ *   2. Each frame, pick the level to render with __select_level(), which goes
+ *      by the mesh's projected size on the screen; and render the chain's mesh
+ *      at that level (e.g. with kelpoa_triprepr__transform_and_project_indexed_mesh()).
+ *
+ *   3. To deallocate the chain, call __free(). This frees the coarser levels'
+ *      meshes, but not the mesh the chain was created from.
+ *
+ */
+
+#ifndef KELPO_AUXILIARY_MESH_LOD_H
+#define KELPO_AUXILIARY_MESH_LOD_H
+
+#define KELPOA_MESH_LOD_MAX_NUM_LEVELS 5
+
+struct kelpoa_indexed_mesh_s;
+struct kelpoa_matrix44_s;
+
+struct kelpoa_mesh_lod_s
+{
+    /* The levels of detail, from the full-detail mesh (level 0), which is the
+     * one the chain was created from, to the coarsest.*/
+    struct kelpoa_indexed_mesh_s *levels[KELPOA_MESH_LOD_MAX_NUM_LEVELS];
+    unsigned numLevels;
+};
+
+/* Creates a chain of at most the given number of levels of detail (including
+ * the full-detail level) of the given mesh. Fewer levels are created if the
+ * mesh can't be simplified further. The mesh mustn't be modified or freed
+ * while the chain exists.*/
+struct kelpoa_mesh_lod_s* kelpoa_mesh_lod__create(struct kelpoa_indexed_mesh_s *const mesh,
+                                                  const unsigned numLevels);
+
+/* Deallocates the chain and its coarser levels' meshes, including the chain
+ * pointer itself.*/
+void kelpoa_mesh_lod__free(struct kelpoa_mesh_lod_s *const lod);
+
+/* Sets how many pixels of the mesh's projected size (the area of its bounding
+ * sphere on the screen) __select_level() aims to spend per triangle. Higher
+ * values select coarser levels. The default is 4.*/
+void kelpoa_mesh_lod__set_pixels_per_triangle(const float pixelsPerTriangle);
+
+/* Returns the index of the finest of the chain's levels whose number of
+ * triangles is within the budget of the mesh's projected size, or else the
+ * coarsest level. The mesh is placed by the given model matrix (which may be
+ * NULL if the mesh is in world space), and projected by the given clip space
+ * matrix (not multiplied with the model matrix; e.g. one made with
+ * kelpoa_matrix44__make_clip_space_matrix()) onto a screen of the given height
+ * in pixels. A mesh that reaches the camera's plane gets level 0.*/
+unsigned kelpoa_mesh_lod__select_level(const struct kelpoa_mesh_lod_s *const lod,
+                                       const struct kelpoa_matrix44_s *const modelMatrix,
+                                       const struct kelpoa_matrix44_s *const clipSpaceMatrix,
+                                       const unsigned screenHeight);
+
+#endif
@@ -0,0 +1,600 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * Simplifies indexed meshes by quadric error metric edge collapse.
+ *
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <kelpo_interface/polygon/vertex.h>
+#include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/indexed_mesh.h>
+#include <kelpo_auxiliary/triangle_bvh.h>
+#include <kelpo_auxiliary/mesh_simplifier.h>
+
+/* A symmetric 4-by-4 matrix, Q, whose quadratic form v'Qv gives the sum of
+ * squared distances of the point v = (x, y, z, 1) from a set of planes. Stored
+ * as its upper triangle, row by row.*/
+struct quadric_s
+{
+    double q[10];
+};
+
+/* A candidate edge collapse: merging vertex 'srcIdx' into vertex 'dstIdx'.*/
+struct collapse_s
+{
+    double cost;
+    uint32_t srcIdx;
+    uint32_t dstIdx;
+};
+
+/* The state of a mesh being simplified.*/
+struct simplification_s
+{
+    const struct kelpo_polygon_vertex_s *vertices;
+    uint32_t numVertices;
+
+    /* The vertex indices of each of the mesh's triangles, three per triangle,
+     * as the collapses have left them; and whether each triangle still exists.*/
+    uint32_t *triangles;
+    unsigned char *isTriangleAlive;
+    uint32_t numTriangles;
+    uint32_t numAliveTriangles;
+
+    /* Per vertex: its quadric; whether it may be merged into another vertex;
+     * and whether a collapse during the current pass has touched it.*/
+    struct quadric_s *quadrics;
+    unsigned char *isLocked;
+    unsigned char *isTouched;
+
+    /* The alive triangles around each vertex, updated at the start of each
+     * pass: vertex v's are vertexTriangles[vertexTriangleStart[v], vertexTriangleStart[v + 1]).*/
+    uint32_t *vertexTriangleStart;
+    uint32_t *vertexTriangles;
+
+    /* Scratch marks for the link condition test, one per vertex. A vertex is
+     * marked if its mark equals the current stamp.*/
+    uint32_t *marks;
+    uint32_t markStamp;
+
+    /* The candidate collapses of the current pass.*/
+    struct collapse_s *collapses;
+};
+
+static void add_plane_to_quadric(struct quadric_s *const quadric,
+                                 const double a,
+                                 const double b,
+                                 const double c,
+                                 const double d,
+                                 const double weight)
+{
+    double *const q = quadric->q;
+
+    q[0] += (weight * a * a); q[1] += (weight * a * b); q[2] += (weight * a * c); q[3] += (weight * a * d);
+                              q[4] += (weight * b * b); q[5] += (weight * b * c); q[6] += (weight * b * d);
+                                                        q[7] += (weight * c * c); q[8] += (weight * c * d);
+                                                                                  q[9] += (weight * d * d);
+
+    return;
+}
+
+static double quadric_error(const struct quadric_s *const quadric,
+                            const struct kelpo_polygon_vertex_s *const v)
+{
+    const double *const q = quadric->q;
+    const double x = v->x;
+    const double y = v->y;
+    const double z = v->z;
+
+    return ((q[0] * x * x) + (2 * q[1] * x * y) + (2 * q[2] * x * z) + (2 * q[3] * x) +
+            (q[4] * y * y) + (2 * q[5] * y * z) + (2 * q[6] * y) +
+            (q[7] * z * z) + (2 * q[8] * z) +
+            q[9]);
+}
+
+/* Orders collapses by ascending cost, and ties by vertex indices, so that the
+ * order doesn't depend on the sort algorithm.*/
+static int compare_collapses(const void *a, const void *b)
+{
+    const struct collapse_s *const collapseA = (const struct collapse_s*)a;
+    const struct collapse_s *const collapseB = (const struct collapse_s*)b;
+
+    if (collapseA->cost != collapseB->cost)
+    {
+        return ((collapseA->cost < collapseB->cost)? -1 : 1);
+    }
+    else if (collapseA->srcIdx != collapseB->srcIdx)
+    {
+        return ((collapseA->srcIdx < collapseB->srcIdx)? -1 : 1);
+    }
+
+    return ((collapseA->dstIdx < collapseB->dstIdx)? -1 : ((collapseA->dstIdx > collapseB->dstIdx)? 1 : 0));
+}
+
+/* Computes the unnormalized normal of the triangle of the given vertices, as
+ * if vertex 'srcIdx' were at the position of vertex 'dstIdx'. Pass ~0 for both
+ * for the triangle as it is.*/
+static void triangle_normal(const struct simplification_s *const simp,
+                            const uint32_t *const triangle,
+                            const uint32_t srcIdx,
+                            const uint32_t dstIdx,
+                            double *const normal)
+{
+    const struct kelpo_polygon_vertex_s *v[3];
+    unsigned k = 0;
+
+    for (k = 0; k < 3; k++)
+    {
+        v[k] = &simp->vertices[(triangle[k] == srcIdx)? dstIdx : triangle[k]];
+    }
+
+    {
+        const double e1x = (v[1]->x - v[0]->x), e1y = (v[1]->y - v[0]->y), e1z = (v[1]->z - v[0]->z);
+        const double e2x = (v[2]->x - v[0]->x), e2y = (v[2]->y - v[0]->y), e2z = (v[2]->z - v[0]->z);
+
+        normal[0] = ((e1y * e2z) - (e1z * e2y));
+        normal[1] = ((e1z * e2x) - (e1x * e2z));
+        normal[2] = ((e1x * e2y) - (e1y * e2x));
+    }
+
+    return;
+}
+
+/* Computes each vertex's quadric from the planes of its triangles, weighted by
+ * the triangles' areas; and locks the vertices on the mesh's borders: on edges
+ * that don't have exactly one triangle on either side.*/
+static void init_vertices(struct simplification_s *const simp)
+{
+    uint32_t t = 0;
+    unsigned k = 0;
+
+    for (t = 0; t < simp->numTriangles; t++)
+    {
+        const uint32_t *const triangle = &simp->triangles[t * 3];
+        const struct kelpo_polygon_vertex_s *const v0 = &simp->vertices[triangle[0]];
+        double normal[3];
+        double length = 0;
+
+        triangle_normal(simp, triangle, ~0u, ~0u, normal);
+        length = sqrt((normal[0] * normal[0]) + (normal[1] * normal[1]) + (normal[2] * normal[2]));
+
+        if (length <= 0)
+        {
+            continue;
+        }
+
+        for (k = 0; k < 3; k++)
+        {
+            add_plane_to_quadric(&simp->quadrics[triangle[k]],
+                                 (normal[0] / length),
+                                 (normal[1] / length),
+                                 (normal[2] / length),
+                                 -(((normal[0] * v0->x) + (normal[1] * v0->y) + (normal[2] * v0->z)) / length),
+                                 (length / 2));
+        }
+    }
+
+    /* An edge has exactly one triangle on either side if the triangle that
+     * runs along it in one direction is the only one to do so, and the same
+     * goes for the other direction. Tally each edge's directed uses from the
+     * triangles around its lower-indexed vertex.*/
+    for (t = 0; t < simp->numTriangles; t++)
+    {
+        for (k = 0; k < 3; k++)
+        {
+            const uint32_t a = simp->triangles[(t * 3) + k];
+            const uint32_t b = simp->triangles[(t * 3) + ((k + 1) % 3)];
+            const uint32_t lowIdx = ((a < b)? a : b);
+            const uint32_t highIdx = ((a < b)? b : a);
+            unsigned numForward = 0;
+            unsigned numBackward = 0;
+            uint32_t i = 0;
+
+            for (i = simp->vertexTriangleStart[lowIdx]; i < simp->vertexTriangleStart[lowIdx + 1]; i++)
+            {
+                const uint32_t *const other = &simp->triangles[simp->vertexTriangles[i] * 3];
+                unsigned j = 0;
+
+                for (j = 0; j < 3; j++)
+                {
+                    numForward += ((other[j] == lowIdx) && (other[(j + 1) % 3] == highIdx));
+                    numBackward += ((other[j] == highIdx) && (other[(j + 1) % 3] == lowIdx));
+                }
+            }
+
+            if ((numForward != 1) || (numBackward != 1))
+            {
+                simp->isLocked[a] = 1;
+                simp->isLocked[b] = 1;
+            }
+        }
+    }
+
+    return;
+}
+
+/* Rebuilds the lists of alive triangles around each vertex.*/
+static void update_vertex_triangles(struct simplification_s *const simp)
+{
+    uint32_t t = 0;
+    uint32_t v = 0;
+    unsigned k = 0;
+
+    memset(simp->vertexTriangleStart, 0, ((simp->numVertices + 1) * sizeof(simp->vertexTriangleStart[0])));
+
+    for (t = 0; t < simp->numTriangles; t++)
+    {
+        if (simp->isTriangleAlive[t])
+        {
+            for (k = 0; k < 3; k++)
+            {
+                simp->vertexTriangleStart[simp->triangles[(t * 3) + k] + 1]++;
+            }
+        }
+    }
+
+    for (v = 0; v < simp->numVertices; v++)
+    {
+        simp->vertexTriangleStart[v + 1] += simp->vertexTriangleStart[v];
+    }
+
+    /* Fill in the lists, using each list's start as its cursor, which leaves
+     * it at the start of the next list; and then shift the starts back.*/
+    for (t = 0; t < simp->numTriangles; t++)
+    {
+        if (simp->isTriangleAlive[t])
+        {
+            for (k = 0; k < 3; k++)
+            {
+                simp->vertexTriangles[simp->vertexTriangleStart[simp->triangles[(t * 3) + k]]++] = t;
+            }
+        }
+    }
+
+    for (v = simp->numVertices; v > 0; v--)
+    {
+        simp->vertexTriangleStart[v] = simp->vertexTriangleStart[v - 1];
+    }
+
+    simp->vertexTriangleStart[0] = 0;
+
+    return;
+}
+
+/* Returns true if the given vertex is in the given triangle.*/
+static int triangle_has_vertex(const uint32_t *const triangle,
+                               const uint32_t vertexIdx)
+{
+    return ((triangle[0] == vertexIdx) || (triangle[1] == vertexIdx) || (triangle[2] == vertexIdx));
+}
+
+/* Returns true if merging the given source vertex into the given destination
+ * vertex keeps the mesh manifold and doesn't flip any triangles over.*/
+static int is_collapse_valid(struct simplification_s *const simp,
+                             const uint32_t srcIdx,
+                             const uint32_t dstIdx)
+{
+    uint32_t i = 0;
+    unsigned k = 0;
+    unsigned numSharedTriangles = 0;
+    unsigned numSharedNeighbors = 0;
+
+    /* Link condition: the vertices the two have as common neighbors must be
+     * exactly those opposite their shared edge; otherwise the collapse would
+     * fuse two separate edges into one.*/
+    simp->markStamp += 2;
+
+    for (i = simp->vertexTriangleStart[srcIdx]; i < simp->vertexTriangleStart[srcIdx + 1]; i++)
+    {
+        const uint32_t *const triangle = &simp->triangles[simp->vertexTriangles[i] * 3];
+
+        numSharedTriangles += triangle_has_vertex(triangle, dstIdx);
+
+        for (k = 0; k < 3; k++)
+        {
+            simp->marks[triangle[k]] = simp->markStamp;
+        }
+    }
+
+    for (i = simp->vertexTriangleStart[dstIdx]; i < simp->vertexTriangleStart[dstIdx + 1]; i++)
+    {
+        const uint32_t *const triangle = &simp->triangles[simp->vertexTriangles[i] * 3];
+
+        for (k = 0; k < 3; k++)
+        {
+            if ((triangle[k] != srcIdx) &&
+                (triangle[k] != dstIdx) &&
+                (simp->marks[triangle[k]] == simp->markStamp))
+            {
+                simp->marks[triangle[k]] = (simp->markStamp + 1);
+                numSharedNeighbors++;
+            }
+        }
+    }
+
+    if (!numSharedTriangles ||
+        (numSharedNeighbors != numSharedTriangles))
+    {
+        return 0;
+    }
+
+    /* The triangles that remain around the source vertex mustn't turn over
+     * when it moves to the destination vertex.*/
+    for (i = simp->vertexTriangleStart[srcIdx]; i < simp->vertexTriangleStart[srcIdx + 1]; i++)
+    {
+        const uint32_t *const triangle = &simp->triangles[simp->vertexTriangles[i] * 3];
+        double normalBefore[3];
+        double normalAfter[3];
+
+        if (triangle_has_vertex(triangle, dstIdx))
+        {
+            continue;
+        }
+
+        triangle_normal(simp, triangle, ~0u, ~0u, normalBefore);
+        triangle_normal(simp, triangle, srcIdx, dstIdx, normalAfter);
+
+        if (((normalBefore[0] * normalAfter[0]) + (normalBefore[1] * normalAfter[1]) + (normalBefore[2] * normalAfter[2])) <= 0)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* Merges the given source vertex into the given destination vertex, removing
+ * the triangles that they share, and marks the vertices around the source
+ * vertex as touched.*/
+static void collapse(struct simplification_s *const simp,
+                     const uint32_t srcIdx,
+                     const uint32_t dstIdx)
+{
+    uint32_t i = 0;
+    unsigned k = 0;
+
+    for (i = simp->vertexTriangleStart[srcIdx]; i < simp->vertexTriangleStart[srcIdx + 1]; i++)
+    {
+        const uint32_t t = simp->vertexTriangles[i];
+        uint32_t *const triangle = &simp->triangles[t * 3];
+
+        for (k = 0; k < 3; k++)
+        {
+            simp->isTouched[triangle[k]] = 1;
+        }
+
+        if (triangle_has_vertex(triangle, dstIdx))
+        {
+            simp->isTriangleAlive[t] = 0;
+            simp->numAliveTriangles--;
+        }
+        else
+        {
+            for (k = 0; k < 3; k++)
+            {
+                if (triangle[k] == srcIdx)
+                {
+                    triangle[k] = dstIdx;
+                }
+            }
+        }
+    }
+
+    for (k = 0; k < 10; k++)
+    {
+        simp->quadrics[dstIdx].q[k] += simp->quadrics[srcIdx].q[k];
+    }
+
+    return;
+}
+
+/* Performs, in the order of least cost, as many of the current candidate
+ * collapses as don't touch each other's vertices, until the target number of
+ * triangles is reached. Returns the number of collapses made.*/
+static uint32_t simplification_pass(struct simplification_s *const simp,
+                                    const uint32_t targetNumTriangles)
+{
+    uint32_t t = 0;
+    uint32_t c = 0;
+    uint32_t numCollapses = 0;
+    uint32_t numCollapsesMade = 0;
+    unsigned k = 0;
+
+    update_vertex_triangles(simp);
+    memset(simp->isTouched, 0, simp->numVertices);
+
+    /* Each collapse corresponds to a directed edge of a triangle; in a
+     * manifold mesh, the edge's opposite direction belongs to the triangle on
+     * its other side, and gives the opposite collapse.*/
+    for (t = 0; t < simp->numTriangles; t++)
+    {
+        if (!simp->isTriangleAlive[t])
+        {
+            continue;
+        }
+
+        for (k = 0; k < 3; k++)
+        {
+            const uint32_t srcIdx = simp->triangles[(t * 3) + k];
+            const uint32_t dstIdx = simp->triangles[(t * 3) + ((k + 1) % 3)];
+            struct quadric_s combined = simp->quadrics[srcIdx];
+            unsigned j = 0;
+
+            if (simp->isLocked[srcIdx])
+            {
+                continue;
+            }
+
+            for (j = 0; j < 10; j++)
+            {
+                combined.q[j] += simp->quadrics[dstIdx].q[j];
+            }
+
+            simp->collapses[numCollapses].cost = quadric_error(&combined, &simp->vertices[dstIdx]);
+            simp->collapses[numCollapses].srcIdx = srcIdx;
+            simp->collapses[numCollapses].dstIdx = dstIdx;
+            numCollapses++;
+        }
+    }
+
+    qsort(simp->collapses, numCollapses, sizeof(simp->collapses[0]), compare_collapses);
+
+    for (c = 0; (c < numCollapses) && (simp->numAliveTriangles > targetNumTriangles); c++)
+    {
+        const uint32_t srcIdx = simp->collapses[c].srcIdx;
+        const uint32_t dstIdx = simp->collapses[c].dstIdx;
+
+        if (simp->isTouched[srcIdx] ||
+            simp->isTouched[dstIdx] ||
+            !is_collapse_valid(simp, srcIdx, dstIdx))
+        {
+            continue;
+        }
+
+        collapse(simp, srcIdx, dstIdx);
+        numCollapsesMade++;
+    }
+
+    return numCollapsesMade;
+}
+
+/* Copies the alive triangles and the vertices they use into the given mesh.*/
+static void write_mesh(const struct simplification_s *const simp,
+                       const struct kelpoa_indexed_mesh_s *const srcMesh,
+                       struct kelpoa_indexed_mesh_s *const dstMesh)
+{
+    uint32_t t = 0;
+    uint32_t v = 0;
+    unsigned k = 0;
+    uint32_t *const newVertexIdx = (uint32_t*)malloc(simp->numVertices * sizeof(uint32_t));
+
+    assert(newVertexIdx && "Failed to allocate memory for simplifying a mesh.");
+
+    kelpoa_indexed_mesh__clear(dstMesh);
+
+    for (v = 0; v < simp->numVertices; v++)
+    {
+        newVertexIdx[v] = ~0u;
+    }
+
+    for (t = 0; t < simp->numTriangles; t++)
+    {
+        if (simp->isTriangleAlive[t])
+        {
+            for (k = 0; k < 3; k++)
+            {
+                newVertexIdx[simp->triangles[(t * 3) + k]] = 0;
+            }
+        }
+    }
+
+    for (v = 0; v < simp->numVertices; v++)
+    {
+        if (newVertexIdx[v] != ~0u)
+        {
+            newVertexIdx[v] = dstMesh->vertices->count;
+            kelpoa_generic_stack__push_copy(dstMesh->vertices, &simp->vertices[v]);
+        }
+    }
+
+    for (t = 0; t < simp->numTriangles; t++)
+    {
+        if (simp->isTriangleAlive[t])
+        {
+            struct kelpoa_indexed_triangle_s triangle = ((struct kelpoa_indexed_triangle_s*)srcMesh->triangles->data)[t];
+
+            for (k = 0; k < 3; k++)
+            {
+                triangle.vertexIdx[k] = newVertexIdx[simp->triangles[(t * 3) + k]];
+            }
+
+            kelpoa_generic_stack__push_copy(dstMesh->triangles, &triangle);
+        }
+    }
+
+    kelpoa_bounding_volume__of_vertices(&dstMesh->bounds,
+                                        (struct kelpo_polygon_vertex_s*)dstMesh->vertices->data,
+                                        dstMesh->vertices->count);
+
+    kelpoa_triangle_bvh__build_indexed(dstMesh->bvh, dstMesh);
+
+    free(newVertexIdx);
+
+    return;
+}
+
+int kelpoa_mesh_simplifier__simplify(const struct kelpoa_indexed_mesh_s *const srcMesh,
+                                     struct kelpoa_indexed_mesh_s *const dstMesh,
+                                     const uint32_t targetNumTriangles)
+{
+    struct simplification_s simp;
+    uint32_t t = 0;
+    unsigned k = 0;
+
+    assert((srcMesh != dstMesh) && "The source and destination meshes must be different.");
+
+    simp.vertices = (const struct kelpo_polygon_vertex_s*)srcMesh->vertices->data;
+    simp.numVertices = srcMesh->vertices->count;
+    simp.numTriangles = simp.numAliveTriangles = srcMesh->triangles->count;
+    simp.markStamp = 0;
+
+    /* One extra element per array, so that none is empty.*/
+    simp.triangles = (uint32_t*)malloc(((simp.numTriangles * 3) + 1) * sizeof(uint32_t));
+    simp.isTriangleAlive = (unsigned char*)malloc(simp.numTriangles + 1);
+    simp.quadrics = (struct quadric_s*)calloc((simp.numVertices + 1), sizeof(struct quadric_s));
+    simp.isLocked = (unsigned char*)calloc((simp.numVertices + 1), 1);
+    simp.isTouched = (unsigned char*)malloc(simp.numVertices + 1);
+    simp.vertexTriangleStart = (uint32_t*)malloc((simp.numVertices + 1) * sizeof(uint32_t));
+    simp.vertexTriangles = (uint32_t*)malloc(((simp.numTriangles * 3) + 1) * sizeof(uint32_t));
+    simp.marks = (uint32_t*)calloc((simp.numVertices + 1), sizeof(uint32_t));
+    simp.collapses = (struct collapse_s*)malloc(((simp.numTriangles * 3) + 1) * sizeof(struct collapse_s));
+
+    assert((simp.triangles &&
+            simp.isTriangleAlive &&
+            simp.quadrics &&
+            simp.isLocked &&
+            simp.isTouched &&
+            simp.vertexTriangleStart &&
+            simp.vertexTriangles &&
+            simp.marks &&
+            simp.collapses) &&
+           "Failed to allocate memory for simplifying a mesh.");
+
+    for (t = 0; t < simp.numTriangles; t++)
+    {
+        const struct kelpoa_indexed_triangle_s *const triangle = &((struct kelpoa_indexed_triangle_s*)srcMesh->triangles->data)[t];
+
+        for (k = 0; k < 3; k++)
+        {
+            simp.triangles[(t * 3) + k] = triangle->vertexIdx[k];
+        }
+
+        simp.isTriangleAlive[t] = 1;
+    }
+
+    update_vertex_triangles(&simp);
+    init_vertices(&simp);
+
+    while ((simp.numAliveTriangles > targetNumTriangles) &&
+           simplification_pass(&simp, targetNumTriangles))
+    {
+        ;
+    }
+
+    write_mesh(&simp, srcMesh, dstMesh);
+
+    free(simp.triangles);
+    free(simp.isTriangleAlive);
+    free(simp.quadrics);
+    free(simp.isLocked);
+    free(simp.isTouched);
+    free(simp.vertexTriangleStart);
+    free(simp.vertexTriangles);
+    free(simp.marks);
+    free(simp.collapses);
+
+    return (simp.numAliveTriangles <= targetNumTriangles);
+}
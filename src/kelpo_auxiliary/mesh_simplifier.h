@@ -0,0 +1,36 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * Reduces the number of triangles in an indexed mesh by collapsing its edges
+ * in the order of least quadric error (Garland & Heckbert, "Surface
+ * Simplification Using Quadric Error Metrics").
+ *
+ * An edge is collapsed by merging one of its vertices into the other, so the
+ * surviving vertices keep their UVs, normals and colors as they are. Since the
+ * mesh stores a vertex that differs in UV or material from its neighbor at the
+ * same position as a separate vertex (see kelpoa_load_kac10_indexed_mesh()),
+ * UV seams and material boundaries are open borders in the mesh; vertices on
+ * them and on the mesh's other borders are never merged away, so the borders
+ * don't tear open.
+ *
+ */
+
+#ifndef KELPO_AUXILIARY_MESH_SIMPLIFIER_H
+#define KELPO_AUXILIARY_MESH_SIMPLIFIER_H
+
+#include <kelpo_interface/stdint.h>
+
+struct kelpoa_indexed_mesh_s;
+
+/* Places into 'dstMesh', replacing its contents, a version of 'srcMesh' with
+ * at most the given number of triangles, or as close to it as the mesh can be
+ * simplified without tearing or folding over. The two meshes must be
+ * different. The destination mesh holds only the vertices its triangles use,
+ * and has its bounding volume and bounding volume hierarchy computed (see
+ * indexed_mesh.h). Returns 1 if the target number of triangles was reached;
+ * else 0.*/
+int kelpoa_mesh_simplifier__simplify(const struct kelpoa_indexed_mesh_s *const srcMesh,
+                                     struct kelpoa_indexed_mesh_s *const dstMesh,
+                                     const uint32_t targetNumTriangles);
+
+#endif
@@ -0,0 +1,145 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * A lightweight instrumenting profiler.
+ *
+ */
+
+#include <stdio.h>
+#include <assert.h>
+#include <kelpo_auxiliary/profiler.h>
+#include <kelpo_auxiliary/clock.h>
+
+struct zone_s
+{
+    const char *name;
+
+    /* In nanoseconds, as given by kelpoa_clock__nanoseconds().*/
+    double startTime;
+    double duration;
+};
+
+/* Closed zones, in the order in which they were closed. Once the buffer is
+ * full, new zones overwrite the oldest ones.*/
+static struct zone_s ZONES[KELPOA_PROF_RING_BUFFER_SIZE];
+static unsigned long NUM_ZONES_RECORDED = 0;
+
+/* The zones that have been opened but not yet closed.*/
+static struct zone_s OPEN_ZONES[KELPOA_PROF_MAX_ZONE_DEPTH];
+static unsigned ZONE_DEPTH = 0;
+
+/* The time at which the current frame began, or 0 if no zones have yet been
+ * opened.*/
+static double FRAME_START_TIME = 0;
+
+static void record_zone(const char *const name,
+                        const double startTime,
+                        const double endTime)
+{
+    struct zone_s *const zone = &ZONES[NUM_ZONES_RECORDED++ % KELPOA_PROF_RING_BUFFER_SIZE];
+
+    zone->name = name;
+    zone->startTime = startTime;
+    zone->duration = (endTime - startTime);
+
+    return;
+}
+
+void kelpoa_prof__begin(const char *const zoneName)
+{
+    const double now = kelpoa_clock__nanoseconds();
+
+    if (!FRAME_START_TIME)
+    {
+        FRAME_START_TIME = now;
+    }
+
+    /* Zones beyond the maximum depth are still counted, so that the calls to
+     * __end() match up.*/
+    if (ZONE_DEPTH < KELPOA_PROF_MAX_ZONE_DEPTH)
+    {
+        OPEN_ZONES[ZONE_DEPTH].name = zoneName;
+        OPEN_ZONES[ZONE_DEPTH].startTime = now;
+    }
+
+    ZONE_DEPTH++;
+
+    return;
+}
+
+void kelpoa_prof__end(void)
+{
+    const double now = kelpoa_clock__nanoseconds();
+
+    assert(ZONE_DEPTH && "No zone to end.");
+
+    if (--ZONE_DEPTH < KELPOA_PROF_MAX_ZONE_DEPTH)
+    {
+        record_zone(OPEN_ZONES[ZONE_DEPTH].name, OPEN_ZONES[ZONE_DEPTH].startTime, now);
+    }
+
+    return;
+}
+
+void kelpoa_prof__end_frame(void)
+{
+    const double now = kelpoa_clock__nanoseconds();
+
+    if (FRAME_START_TIME)
+    {
+        record_zone("frame", FRAME_START_TIME, now);
+    }
+
+    FRAME_START_TIME = now;
+
+    return;
+}
+
+void kelpoa_prof__reset(void)
+{
+    NUM_ZONES_RECORDED = 0;
+
+    return;
+}
+
+int kelpoa_prof__write_chrome_trace(const char *const filename,
+                                    const int append)
+{
+    const unsigned long numZones = ((NUM_ZONES_RECORDED < KELPOA_PROF_RING_BUFFER_SIZE)? NUM_ZONES_RECORDED : KELPOA_PROF_RING_BUFFER_SIZE);
+    FILE *const file = fopen(filename, (append? "a" : "w"));
+    unsigned long i = 0;
+    int writeFailed = 0;
+
+    if (!file)
+    {
+        fprintf(stderr, "ERROR: Could not open \"%s\" for writing\n", filename);
+        return 0;
+    }
+
+    if (!append)
+    {
+        fprintf(file, "[\n");
+    }
+
+    /* Oldest zones first. Times are given in microseconds.*/
+    for (i = (NUM_ZONES_RECORDED - numZones); i < NUM_ZONES_RECORDED; i++)
+    {
+        const struct zone_s *const zone = &ZONES[i % KELPOA_PROF_RING_BUFFER_SIZE];
+
+        fprintf(file, "{\"name\": \"%s\", \"cat\": \"kelpo\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": 1},\n",
+                zone->name,
+                (zone->startTime / 1000.0),
+                (zone->duration / 1000.0));
+    }
+
+    writeFailed = ferror(file);
+
+    if ((fclose(file) != 0) ||
+        writeFailed)
+    {
+        fprintf(stderr, "ERROR: Could not write into \"%s\"\n", filename);
+        return 0;
+    }
+
+    return 1;
+}
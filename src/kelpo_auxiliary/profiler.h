@@ -0,0 +1,80 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * A lightweight instrumenting profiler. Records named, nested time zones into
+ * a ring buffer, and exports them in Chrome's trace event format, viewable e.g.
+ * in chrome://tracing or Perfetto.
+ *
+ * Usage:
+ *
+ *   1. Surround the code to be timed with KELPOA_PROF_BEGIN("name") and
+ *      KELPOA_PROF_END(). Zones can be nested. The name must remain valid
+ *      until the zones have been exported; e.g. a string literal.
+ *
+ *   2. Call KELPOA_PROF_END_FRAME() at the end of each rendered frame. Frames
+ *      show up in the exported trace as zones of their own, and make it easy
+ *      to see which zones belong to which frame.
+ *
+ *   3. Call kelpoa_prof__write_chrome_trace() to write the buffered zones into
+ *      a file.
+ *
+ * The macros compile to nothing unless KELPOA_PROFILE is defined, in which case
+ * the program must also be built with profiler.c and clock.c. The auxiliary
+ * triangle preparer, KAC loader and vertex lightmapper, and each renderer's
+ * rasterizer, are instrumented with the macros.
+ *
+ * A renderer DLL built with KELPOA_PROFILE has its own zone buffer. The client
+ * can look up the DLL's kelpoa_prof__write_chrome_trace() with
+ * kelpo_renderer_function() and call it with 'append' set, to add the
+ * renderer's zones to the client's trace file. Timestamps are comparable between the two.
+ *
+ * Zones should only be recorded from one thread.
+ *
+ */
+
+#ifndef KELPO_AUXILIARY_PROFILER_H
+#define KELPO_AUXILIARY_PROFILER_H
+
+#ifdef KELPOA_PROFILE
+    #define KELPOA_PROF_BEGIN(zoneName) kelpoa_prof__begin(zoneName)
+    #define KELPOA_PROF_END() kelpoa_prof__end()
+    #define KELPOA_PROF_END_FRAME() kelpoa_prof__end_frame()
+#else
+    #define KELPOA_PROF_BEGIN(zoneName) ((void)0)
+    #define KELPOA_PROF_END() ((void)0)
+    #define KELPOA_PROF_END_FRAME() ((void)0)
+#endif
+
+/* The number of most recent zones (including frames) that the ring buffer
+ * retains. Older zones are overwritten.*/
+#define KELPOA_PROF_RING_BUFFER_SIZE 32768
+
+/* How deeply zones can be nested. Zones beyond this depth aren't recorded.*/
+#define KELPOA_PROF_MAX_ZONE_DEPTH 32
+
+/* The type of kelpoa_prof__write_chrome_trace(), for clients obtaining it from
+ * a renderer DLL.*/
+typedef int (*kelpoa_prof_write_chrome_trace_fn)(const char *const filename, const int append);
+
+/* Opens a new zone, nested in the currently open one, if any.*/
+void kelpoa_prof__begin(const char *const zoneName);
+
+/* Closes the most recently opened zone, recording it in the ring buffer.*/
+void kelpoa_prof__end(void);
+
+/* Records a zone named "frame" spanning the time since the previous call (or,
+ * on the first call, since the first zone was opened).*/
+void kelpoa_prof__end_frame(void);
+
+/* Discards all recorded zones. Open zones remain open.*/
+void kelpoa_prof__reset(void);
+
+/* Writes the zones in the ring buffer into the given file as a JSON array of
+ * Chrome trace events. If 'append' is 1, appends the events to an existing
+ * trace file. The array's closing bracket is left out so that other events can
+ * be appended (which the trace event format permits). Returns 1 on success; 0
+ * on failure.*/
+int kelpoa_prof__write_chrome_trace(const char *const filename,
+                                    const int append);
+
+#endif
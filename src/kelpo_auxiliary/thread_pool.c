@@ -0,0 +1,352 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * A pool of worker threads for running batches of independent jobs in parallel.
+ *
+ * Uses Win32 threads on Windows and POSIX threads elsewhere. The Win32 version
+ * sticks to primitives available on Windows 95 (no condition variables).
+ *
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdlib.h>
+#include <assert.h>
+#include <kelpo_auxiliary/thread_pool.h>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+struct kelpoa_thread_pool_s
+{
+    unsigned numWorkerThreads;
+
+    /* The current batch of jobs. Workers claim job indices by incrementing
+     * 'nextJobIdx' while holding the pool's lock.*/
+    kelpoa_thread_pool_job_fn job;
+    void *context;
+    unsigned numJobs;
+    unsigned nextJobIdx;
+
+    /* The number of worker threads yet to finish their part of the current
+     * batch.*/
+    unsigned numBusyWorkers;
+
+    /* Set to tell the worker threads to exit.*/
+    int quit;
+
+    #if defined(_WIN32)
+        HANDLE *threads;
+        CRITICAL_SECTION lock;
+
+        /* Released once per worker thread when a new batch of jobs is posted.*/
+        HANDLE batchStartSemaphore;
+
+        /* Signaled by the last worker thread to finish its part of a batch.*/
+        HANDLE batchDoneEvent;
+    #else
+        pthread_t *threads;
+        pthread_mutex_t lock;
+        pthread_cond_t batchStartCond;
+        pthread_cond_t batchDoneCond;
+
+        /* Incremented for each new batch of jobs, so that worker threads can
+         * tell a new batch from a spurious wakeup.*/
+        unsigned long batchNumber;
+    #endif
+};
+
+static void lock_pool(struct kelpoa_thread_pool_s *const pool)
+{
+    #if defined(_WIN32)
+        EnterCriticalSection(&pool->lock);
+    #else
+        pthread_mutex_lock(&pool->lock);
+    #endif
+
+    return;
+}
+
+static void unlock_pool(struct kelpoa_thread_pool_s *const pool)
+{
+    #if defined(_WIN32)
+        LeaveCriticalSection(&pool->lock);
+    #else
+        pthread_mutex_unlock(&pool->lock);
+    #endif
+
+    return;
+}
+
+/* Runs jobs from the pool's current batch until there are none left to claim.*/
+static void run_available_jobs(struct kelpoa_thread_pool_s *const pool)
+{
+    for (;;)
+    {
+        unsigned jobIdx = 0;
+
+        lock_pool(pool);
+        jobIdx = pool->nextJobIdx;
+        if (jobIdx < pool->numJobs)
+        {
+            pool->nextJobIdx++;
+        }
+        unlock_pool(pool);
+
+        if (jobIdx >= pool->numJobs)
+        {
+            break;
+        }
+
+        pool->job(pool->context, jobIdx);
+    }
+
+    return;
+}
+
+#if defined(_WIN32)
+    static DWORD WINAPI worker_thread(LPVOID param)
+    {
+        struct kelpoa_thread_pool_s *const pool = (struct kelpoa_thread_pool_s*)param;
+
+        for (;;)
+        {
+            WaitForSingleObject(pool->batchStartSemaphore, INFINITE);
+
+            if (pool->quit)
+            {
+                break;
+            }
+
+            run_available_jobs(pool);
+
+            lock_pool(pool);
+            if (!--pool->numBusyWorkers)
+            {
+                SetEvent(pool->batchDoneEvent);
+            }
+            unlock_pool(pool);
+        }
+
+        return 0;
+    }
+#else
+    static void* worker_thread(void *param)
+    {
+        struct kelpoa_thread_pool_s *const pool = (struct kelpoa_thread_pool_s*)param;
+        unsigned long lastBatchNumber = 0;
+
+        for (;;)
+        {
+            pthread_mutex_lock(&pool->lock);
+            while (!pool->quit &&
+                   (pool->batchNumber == lastBatchNumber))
+            {
+                pthread_cond_wait(&pool->batchStartCond, &pool->lock);
+            }
+            lastBatchNumber = pool->batchNumber;
+            pthread_mutex_unlock(&pool->lock);
+
+            if (pool->quit)
+            {
+                break;
+            }
+
+            run_available_jobs(pool);
+
+            pthread_mutex_lock(&pool->lock);
+            if (!--pool->numBusyWorkers)
+            {
+                pthread_cond_signal(&pool->batchDoneCond);
+            }
+            pthread_mutex_unlock(&pool->lock);
+        }
+
+        return NULL;
+    }
+#endif
+
+struct kelpoa_thread_pool_s* kelpoa_thread_pool__create(const unsigned numWorkerThreads)
+{
+    unsigned i = 0;
+    struct kelpoa_thread_pool_s *const pool = (struct kelpoa_thread_pool_s*)calloc(1, sizeof(struct kelpoa_thread_pool_s));
+
+    if (!pool)
+    {
+        return NULL;
+    }
+
+    #if defined(_WIN32)
+        InitializeCriticalSection(&pool->lock);
+
+        if (!(pool->batchStartSemaphore = CreateSemaphoreA(NULL, 0, (numWorkerThreads? numWorkerThreads : 1), NULL)) ||
+            !(pool->batchDoneEvent = CreateEventA(NULL, FALSE, FALSE, NULL)) ||
+            !(pool->threads = (HANDLE*)calloc((numWorkerThreads + 1), sizeof(pool->threads[0]))))
+        {
+            kelpoa_thread_pool__free(pool);
+            return NULL;
+        }
+
+        for (i = 0; i < numWorkerThreads; i++)
+        {
+            DWORD threadId = 0;
+
+            if (!(pool->threads[i] = CreateThread(NULL, 0, worker_thread, pool, 0, &threadId)))
+            {
+                kelpoa_thread_pool__free(pool);
+                return NULL;
+            }
+
+            pool->numWorkerThreads++;
+        }
+    #else
+        pthread_mutex_init(&pool->lock, NULL);
+        pthread_cond_init(&pool->batchStartCond, NULL);
+        pthread_cond_init(&pool->batchDoneCond, NULL);
+
+        if (!(pool->threads = (pthread_t*)calloc((numWorkerThreads + 1), sizeof(pool->threads[0]))))
+        {
+            kelpoa_thread_pool__free(pool);
+            return NULL;
+        }
+
+        for (i = 0; i < numWorkerThreads; i++)
+        {
+            if (pthread_create(&pool->threads[i], NULL, worker_thread, pool) != 0)
+            {
+                kelpoa_thread_pool__free(pool);
+                return NULL;
+            }
+
+            pool->numWorkerThreads++;
+        }
+    #endif
+
+    return pool;
+}
+
+void kelpoa_thread_pool__run(struct kelpoa_thread_pool_s *const pool,
+                             kelpoa_thread_pool_job_fn job,
+                             void *const context,
+                             const unsigned numJobs)
+{
+    assert(pool && "Attempting to operate on a NULL thread pool.");
+
+    if (!numJobs)
+    {
+        return;
+    }
+
+    lock_pool(pool);
+    pool->job = job;
+    pool->context = context;
+    pool->numJobs = numJobs;
+    pool->nextJobIdx = 0;
+    pool->numBusyWorkers = pool->numWorkerThreads;
+    #if !defined(_WIN32)
+        pool->batchNumber++;
+        pthread_cond_broadcast(&pool->batchStartCond);
+    #endif
+    unlock_pool(pool);
+
+    #if defined(_WIN32)
+        if (pool->numWorkerThreads)
+        {
+            ReleaseSemaphore(pool->batchStartSemaphore, pool->numWorkerThreads, NULL);
+        }
+    #endif
+
+    run_available_jobs(pool);
+
+    /* Wait for the worker threads to finish the jobs they've claimed.*/
+    if (pool->numWorkerThreads)
+    {
+        #if defined(_WIN32)
+            WaitForSingleObject(pool->batchDoneEvent, INFINITE);
+        #else
+            pthread_mutex_lock(&pool->lock);
+            while (pool->numBusyWorkers)
+            {
+                pthread_cond_wait(&pool->batchDoneCond, &pool->lock);
+            }
+            pthread_mutex_unlock(&pool->lock);
+        #endif
+    }
+
+    return;
+}
+
+unsigned kelpoa_thread_pool__num_threads(const struct kelpoa_thread_pool_s *const pool)
+{
+    assert(pool && "Attempting to operate on a NULL thread pool.");
+
+    return (pool->numWorkerThreads + 1);
+}
+
+void kelpoa_thread_pool__free(struct kelpoa_thread_pool_s *const pool)
+{
+    unsigned i = 0;
+
+    if (!pool)
+    {
+        return;
+    }
+
+    lock_pool(pool);
+    pool->quit = 1;
+    #if !defined(_WIN32)
+        pthread_cond_broadcast(&pool->batchStartCond);
+    #endif
+    unlock_pool(pool);
+
+    #if defined(_WIN32)
+        if (pool->numWorkerThreads)
+        {
+            ReleaseSemaphore(pool->batchStartSemaphore, pool->numWorkerThreads, NULL);
+        }
+
+        for (i = 0; i < pool->numWorkerThreads; i++)
+        {
+            WaitForSingleObject(pool->threads[i], INFINITE);
+            CloseHandle(pool->threads[i]);
+        }
+
+        if (pool->batchStartSemaphore) CloseHandle(pool->batchStartSemaphore);
+        if (pool->batchDoneEvent) CloseHandle(pool->batchDoneEvent);
+        DeleteCriticalSection(&pool->lock);
+    #else
+        for (i = 0; i < pool->numWorkerThreads; i++)
+        {
+            pthread_join(pool->threads[i], NULL);
+        }
+
+        pthread_cond_destroy(&pool->batchDoneCond);
+        pthread_cond_destroy(&pool->batchStartCond);
+        pthread_mutex_destroy(&pool->lock);
+    #endif
+
+    free(pool->threads);
+    free(pool);
+
+    return;
+}
+
+unsigned kelpoa_thread_pool__num_cpu_cores(void)
+{
+    #if defined(_WIN32)
+        SYSTEM_INFO systemInfo;
+        GetSystemInfo(&systemInfo);
+
+        return (systemInfo.dwNumberOfProcessors? systemInfo.dwNumberOfProcessors : 1);
+    #else
+        const long numCores = sysconf(_SC_NPROCESSORS_ONLN);
+
+        return ((numCores > 0)? numCores : 1);
+    #endif
+}
@@ -0,0 +1,59 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * A pool of worker threads for running batches of independent jobs in parallel.
+ *
+ * Usage:
+ *
+ *   1. Call __create() to set up a new pool with a given number of worker
+ *      threads. A pool with 0 worker threads is valid; its jobs will be run
+ *      on the calling thread.
+ *
+ *   2. Call __run() to execute a batch of jobs. Each job is identified by its
+ *      index in the batch, and is handed to exactly one thread. The calling
+ *      thread takes part in running the jobs, and __run() returns once all of
+ *      the batch's jobs have finished.
+ *
+ *   3. To shut down the worker threads and deallocate the pool, call __free().
+ *      The pool pointer obtained in (1) will no longer be valid.
+ *
+ * Jobs are claimed in ascending index order, but may run concurrently and finish
+ * in any order. Callers that need deterministic results should have each job
+ * write only to data that no other job in the batch touches.
+ *
+ */
+
+#ifndef KELPO_AUXILIARY_THREAD_POOL_H
+#define KELPO_AUXILIARY_THREAD_POOL_H
+
+struct kelpoa_thread_pool_s;
+
+/* A job function. The 'context' pointer is the one given to __run(), and
+ * 'jobIdx' is the job's index in the batch, in the range [0,numJobs).*/
+typedef void (*kelpoa_thread_pool_job_fn)(void *const context, const unsigned jobIdx);
+
+/* Creates a new pool with the given number of worker threads. Returns NULL on
+ * failure.*/
+struct kelpoa_thread_pool_s* kelpoa_thread_pool__create(const unsigned numWorkerThreads);
+
+/* Runs the given number of jobs on the pool's threads and the calling thread,
+ * returning once all of them have finished. Must not be called concurrently on
+ * the same pool, nor from inside a job.*/
+void kelpoa_thread_pool__run(struct kelpoa_thread_pool_s *const pool,
+                             kelpoa_thread_pool_job_fn job,
+                             void *const context,
+                             const unsigned numJobs);
+
+/* Returns the number of threads, including the calling thread, that run the
+ * pool's jobs.*/
+unsigned kelpoa_thread_pool__num_threads(const struct kelpoa_thread_pool_s *const pool);
+
+/* Stops the pool's worker threads and deallocates the pool. After this call,
+ * the pool pointer should be considered invalid.*/
+void kelpoa_thread_pool__free(struct kelpoa_thread_pool_s *const pool);
+
+/* Returns the number of logical CPU cores in the system, or 1 if the number
+ * can't be determined.*/
+unsigned kelpoa_thread_pool__num_cpu_cores(void);
+
+#endif
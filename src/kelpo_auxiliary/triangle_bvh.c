@@ -0,0 +1,364 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * A bounding volume hierarchy over clusters of a mesh's triangles.
+ *
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <kelpo_interface/polygon/triangle/triangle.h>
+#include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/indexed_mesh.h>
+#include <kelpo_auxiliary/triangle_bvh.h>
+
+/* Nodes with at most this many triangles aren't subdivided further.*/
+#define MAX_LEAF_TRIANGLES 64
+
+/* Subdividing the triangles in halves keeps the hierarchy's depth below the
+ * number of bits in a triangle index.*/
+#define MAX_TRAVERSAL_DEPTH 64
+
+/* The state of a hierarchy being built.*/
+struct bvh_build_s
+{
+    struct kelpoa_generic_stack_s *nodes;
+
+    /* The vertices of each triangle, three per triangle, in the mesh's
+     * original order of triangles.*/
+    const struct kelpo_polygon_vertex_s *corners;
+
+    /* The XYZ centroid of each triangle, in the mesh's original order.*/
+    float *centroids;
+
+    /* The mesh's triangles' original indices, in the order they're being
+     * sorted into.*/
+    uint32_t *order;
+
+    /* Working memory for gathering a node's triangles' vertices.*/
+    struct kelpo_polygon_vertex_s *nodeCorners;
+};
+
+/* The sort key of compare_centroids(). qsort() takes no context, so it's
+ * passed in here.*/
+static const float *SORT_CENTROIDS = NULL;
+static unsigned SORT_AXIS = 0;
+
+/* Orders triangle indices by their triangles' centroids along SORT_AXIS, and
+ * ties by index, so that the order doesn't depend on the sort algorithm.*/
+static int compare_centroids(const void *a, const void *b)
+{
+    const uint32_t idxA = *(const uint32_t*)a;
+    const uint32_t idxB = *(const uint32_t*)b;
+    const float centroidA = SORT_CENTROIDS[(idxA * 3) + SORT_AXIS];
+    const float centroidB = SORT_CENTROIDS[(idxB * 3) + SORT_AXIS];
+
+    if (centroidA != centroidB)
+    {
+        return ((centroidA < centroidB)? -1 : 1);
+    }
+
+    return ((idxA < idxB)? -1 : ((idxA > idxB)? 1 : 0));
+}
+
+/* Adds a node for the triangles build->order[first, first + count), and then
+ * recursively its children, splitting the triangles in halves by their
+ * centroids along the axis in which the centroids are most spread out.*/
+static void build_node(struct bvh_build_s *const build,
+                       const uint32_t first,
+                       const uint32_t count)
+{
+    const uint32_t nodeIdx = build->nodes->count;
+    struct kelpoa_triangle_bvh_node_s node;
+    uint32_t i = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        const struct kelpo_polygon_vertex_s *const corners = &build->corners[build->order[first + i] * 3];
+
+        build->nodeCorners[(i * 3) + 0] = corners[0];
+        build->nodeCorners[(i * 3) + 1] = corners[1];
+        build->nodeCorners[(i * 3) + 2] = corners[2];
+    }
+
+    kelpoa_bounding_volume__of_vertices(&node.bounds, build->nodeCorners, (count * 3));
+    node.firstTriangleIdx = first;
+    node.numTriangles = count;
+    node.secondChildIdx = 0;
+
+    kelpoa_generic_stack__push_copy(build->nodes, &node);
+
+    if (count <= MAX_LEAF_TRIANGLES)
+    {
+        return;
+    }
+
+    /* Find the axis along which to split the triangles.*/
+    {
+        unsigned axis = 0;
+        float minCentroid[3];
+        float maxCentroid[3];
+        float maxExtent = -1;
+
+        for (axis = 0; axis < 3; axis++)
+        {
+            minCentroid[axis] = maxCentroid[axis] = build->centroids[(build->order[first] * 3) + axis];
+        }
+
+        for (i = 1; i < count; i++)
+        {
+            const float *const centroid = &build->centroids[build->order[first + i] * 3];
+
+            for (axis = 0; axis < 3; axis++)
+            {
+                if (centroid[axis] < minCentroid[axis]) minCentroid[axis] = centroid[axis];
+                if (centroid[axis] > maxCentroid[axis]) maxCentroid[axis] = centroid[axis];
+            }
+        }
+
+        for (axis = 0; axis < 3; axis++)
+        {
+            if ((maxCentroid[axis] - minCentroid[axis]) > maxExtent)
+            {
+                maxExtent = (maxCentroid[axis] - minCentroid[axis]);
+                SORT_AXIS = axis;
+            }
+        }
+    }
+
+    SORT_CENTROIDS = build->centroids;
+    qsort(&build->order[first], count, sizeof(build->order[0]), compare_centroids);
+
+    build_node(build, first, (count / 2));
+    ((struct kelpoa_triangle_bvh_node_s*)build->nodes->data)[nodeIdx].secondChildIdx = build->nodes->count;
+    build_node(build, (first + (count / 2)), (count - (count / 2)));
+
+    return;
+}
+
+/* Builds the hierarchy of the triangles whose vertices are given, three per
+ * triangle, into the given stack of nodes. Returns the order into which the
+ * mesh's triangles are to be rearranged: element i is the original index of
+ * the triangle that goes to index i. The caller is to free() it. There must be
+ * at least one triangle.*/
+static uint32_t* build_hierarchy(struct kelpoa_generic_stack_s *const nodes,
+                                 const struct kelpo_polygon_vertex_s *const corners,
+                                 const uint32_t numTriangles)
+{
+    struct bvh_build_s build;
+    uint32_t i = 0;
+
+    build.nodes = nodes;
+    build.corners = corners;
+    build.centroids = (float*)malloc(numTriangles * 3 * sizeof(float));
+    build.order = (uint32_t*)malloc(numTriangles * sizeof(uint32_t));
+    build.nodeCorners = (struct kelpo_polygon_vertex_s*)malloc(numTriangles * 3 * sizeof(struct kelpo_polygon_vertex_s));
+
+    assert((build.centroids && build.order && build.nodeCorners) &&
+           "Failed to allocate memory for building a triangle BVH.");
+
+    for (i = 0; i < numTriangles; i++)
+    {
+        const struct kelpo_polygon_vertex_s *const v = &corners[i * 3];
+
+        build.centroids[(i * 3) + 0] = ((v[0].x + v[1].x + v[2].x) / 3);
+        build.centroids[(i * 3) + 1] = ((v[0].y + v[1].y + v[2].y) / 3);
+        build.centroids[(i * 3) + 2] = ((v[0].z + v[1].z + v[2].z) / 3);
+        build.order[i] = i;
+    }
+
+    kelpoa_generic_stack__clear(nodes);
+    build_node(&build, 0, numTriangles);
+
+    free(build.centroids);
+    free(build.nodeCorners);
+
+    return build.order;
+}
+
+/* Rearranges the given stack's elements into the given order (see
+ * build_hierarchy()).*/
+static void reorder_elements(struct kelpoa_generic_stack_s *const stack,
+                             const uint32_t *const order)
+{
+    uint32_t i = 0;
+    const uint32_t elementSize = stack->elementByteSize;
+    char *const reordered = (char*)malloc(stack->count * elementSize);
+
+    assert(reordered && "Failed to allocate memory for building a triangle BVH.");
+
+    for (i = 0; i < stack->count; i++)
+    {
+        memcpy(&reordered[i * elementSize], &((char*)stack->data)[order[i] * elementSize], elementSize);
+    }
+
+    memcpy(stack->data, reordered, (stack->count * elementSize));
+    free(reordered);
+
+    return;
+}
+
+void kelpoa_triangle_bvh__build(struct kelpoa_generic_stack_s *const nodes,
+                                struct kelpoa_generic_stack_s *const triangles)
+{
+    uint32_t i = 0;
+    uint32_t *order = NULL;
+    const struct kelpo_polygon_triangle_s *const tris = (struct kelpo_polygon_triangle_s*)triangles->data;
+    struct kelpo_polygon_vertex_s *corners = NULL;
+
+    if (!triangles->count)
+    {
+        kelpoa_generic_stack__clear(nodes);
+        return;
+    }
+
+    corners = (struct kelpo_polygon_vertex_s*)malloc(triangles->count * 3 * sizeof(struct kelpo_polygon_vertex_s));
+    assert(corners && "Failed to allocate memory for building a triangle BVH.");
+
+    for (i = 0; i < triangles->count; i++)
+    {
+        corners[(i * 3) + 0] = tris[i].vertex[0];
+        corners[(i * 3) + 1] = tris[i].vertex[1];
+        corners[(i * 3) + 2] = tris[i].vertex[2];
+    }
+
+    order = build_hierarchy(nodes, corners, triangles->count);
+    reorder_elements(triangles, order);
+
+    free(order);
+    free(corners);
+
+    return;
+}
+
+void kelpoa_triangle_bvh__build_indexed(struct kelpoa_generic_stack_s *const nodes,
+                                        struct kelpoa_indexed_mesh_s *const mesh)
+{
+    uint32_t i = 0;
+    uint32_t *order = NULL;
+    const struct kelpo_polygon_vertex_s *const vertices = (struct kelpo_polygon_vertex_s*)mesh->vertices->data;
+    const struct kelpoa_indexed_triangle_s *const tris = (struct kelpoa_indexed_triangle_s*)mesh->triangles->data;
+    struct kelpo_polygon_vertex_s *corners = NULL;
+
+    if (!mesh->triangles->count)
+    {
+        kelpoa_generic_stack__clear(nodes);
+        return;
+    }
+
+    corners = (struct kelpo_polygon_vertex_s*)malloc(mesh->triangles->count * 3 * sizeof(struct kelpo_polygon_vertex_s));
+    assert(corners && "Failed to allocate memory for building a triangle BVH.");
+
+    for (i = 0; i < mesh->triangles->count; i++)
+    {
+        corners[(i * 3) + 0] = vertices[tris[i].vertexIdx[0]];
+        corners[(i * 3) + 1] = vertices[tris[i].vertexIdx[1]];
+        corners[(i * 3) + 2] = vertices[tris[i].vertexIdx[2]];
+    }
+
+    order = build_hierarchy(nodes, corners, mesh->triangles->count);
+    reorder_elements(mesh->triangles, order);
+    kelpoa_generic_stack__clear(mesh->facePlanes);
+
+    free(order);
+    free(corners);
+
+    return;
+}
+
+void kelpoa_triangle_bvh__transform(struct kelpoa_generic_stack_s *const nodes,
+                                    const struct kelpoa_matrix44_s *const matrix)
+{
+    uint32_t i = 0;
+
+    for (i = 0; i < nodes->count; i++)
+    {
+        kelpoa_bounding_volume__transform(&((struct kelpoa_triangle_bvh_node_s*)nodes->data)[i].bounds, matrix);
+    }
+
+    return;
+}
+
+/* Appends the given range of triangles to the given stack of spans, merging it
+ * with the last span if they're adjacent and alike.*/
+static void add_span(struct kelpoa_generic_stack_s *const spans,
+                     const uint32_t firstTriangleIdx,
+                     const uint32_t endTriangleIdx,
+                     const int isInsideFrustum)
+{
+    struct kelpoa_triangle_bvh_span_s span;
+
+    if (spans->count)
+    {
+        struct kelpoa_triangle_bvh_span_s *const lastSpan = &((struct kelpoa_triangle_bvh_span_s*)spans->data)[spans->count - 1];
+
+        if ((lastSpan->endTriangleIdx == firstTriangleIdx) &&
+            (lastSpan->isInsideFrustum == isInsideFrustum))
+        {
+            lastSpan->endTriangleIdx = endTriangleIdx;
+            return;
+        }
+    }
+
+    span.firstTriangleIdx = firstTriangleIdx;
+    span.endTriangleIdx = endTriangleIdx;
+    span.isInsideFrustum = isInsideFrustum;
+
+    kelpoa_generic_stack__push_copy(spans, &span);
+
+    return;
+}
+
+void kelpoa_triangle_bvh__find_visible_spans(const struct kelpoa_generic_stack_s *const nodes,
+                                             const struct kelpoa_matrix44_s *const clipSpaceMatrix,
+                                             struct kelpoa_generic_stack_s *const dstSpans)
+{
+    const struct kelpoa_triangle_bvh_node_s *const bvhNodes = (struct kelpoa_triangle_bvh_node_s*)nodes->data;
+    uint32_t pendingNodes[MAX_TRAVERSAL_DEPTH];
+    unsigned numPendingNodes = 0;
+    uint32_t nodeIdx = 0;
+
+    kelpoa_generic_stack__clear(dstSpans);
+
+    if (!nodes->count)
+    {
+        return;
+    }
+
+    /* Visit the nodes depth first, first child first, so that the spans come
+     * out in ascending order.*/
+    while (1)
+    {
+        const struct kelpoa_triangle_bvh_node_s *const node = &bvhNodes[nodeIdx];
+        const enum kelpoa_bounding_volume_frustum_test_e frustumTest = kelpoa_bounding_volume__test_frustum(&node->bounds, clipSpaceMatrix);
+
+        /* Descend into nodes that straddle the frustum, unless they're leaves.*/
+        if ((frustumTest == KELPOA_BOUNDING_VOLUME_INTERSECTS_FRUSTUM) &&
+            node->secondChildIdx)
+        {
+            assert((numPendingNodes < MAX_TRAVERSAL_DEPTH) && "The triangle BVH is too deep.");
+
+            pendingNodes[numPendingNodes++] = node->secondChildIdx;
+            nodeIdx++;
+            continue;
+        }
+
+        if (frustumTest != KELPOA_BOUNDING_VOLUME_OUTSIDE_FRUSTUM)
+        {
+            add_span(dstSpans,
+                     node->firstTriangleIdx,
+                     (node->firstTriangleIdx + node->numTriangles),
+                     (frustumTest == KELPOA_BOUNDING_VOLUME_INSIDE_FRUSTUM));
+        }
+
+        if (!numPendingNodes)
+        {
+            break;
+        }
+
+        nodeIdx = pendingNodes[--numPendingNodes];
+    }
+
+    return;
+}
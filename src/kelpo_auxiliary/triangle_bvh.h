@@ -0,0 +1,91 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * A bounding volume hierarchy (BVH) over clusters of a mesh's triangles, for
+ * culling large meshes against the view frustum a cluster at a time rather
+ * than a triangle at a time.
+ *
+ * Usage:
+ *
+ *   1. Create a stack of nodes (struct kelpoa_triangle_bvh_node_s) and build
+ *      the hierarchy of a mesh's triangles into it with __build() or
+ *      __build_indexed(). The mesh's triangles are reordered so that each
+ *      cluster's are contiguous. Indexed meshes loaded with
+ *      kelpoa_load_kac10_indexed_mesh() have theirs built already (see
+ *      indexed_mesh.h).
+ *
+ *   2. Project the mesh with the triangle preparer, passing in the hierarchy
+ *      (e.g. kelpoa_triprepr__project_triangle_bvh_to_screen()). Clusters
+ *      outside the view frustum are skipped without their triangles being
+ *      touched, and those inside it have their triangles projected without
+ *      being tested against it.
+ *
+ *   3. The hierarchy remains valid for as long as the mesh's triangles aren't
+ *      reordered, added or removed, and their vertices don't move other than
+ *      by __transform().
+ *
+ */
+
+#ifndef KELPO_AUXILIARY_TRIANGLE_BVH_H
+#define KELPO_AUXILIARY_TRIANGLE_BVH_H
+
+#include <kelpo_interface/stdint.h>
+#include <kelpo_auxiliary/bounding_volume.h>
+
+struct kelpoa_generic_stack_s;
+struct kelpoa_indexed_mesh_s;
+struct kelpoa_matrix44_s;
+
+struct kelpoa_triangle_bvh_node_s
+{
+    /* The bounding volume of the node's triangles.*/
+    struct kelpoa_bounding_volume_s bounds;
+
+    /* The node's triangles are the mesh's triangles in the range
+     * [firstTriangleIdx, firstTriangleIdx + numTriangles).*/
+    uint32_t firstTriangleIdx;
+    uint32_t numTriangles;
+
+    /* The index of the node's second child node; or 0 if the node is a leaf.
+     * The first child node follows its parent. The nodes are thus in depth-first
+     * order, and the root is the first node.*/
+    uint32_t secondChildIdx;
+};
+
+/* A range of a mesh's triangles that may be visible.*/
+struct kelpoa_triangle_bvh_span_s
+{
+    /* The range [firstTriangleIdx, endTriangleIdx).*/
+    uint32_t firstTriangleIdx;
+    uint32_t endTriangleIdx;
+
+    /* True if the triangles are known to be inside the view frustum.*/
+    int isInsideFrustum;
+};
+
+/* Builds into the given stack of nodes (struct kelpoa_triangle_bvh_node_s) the
+ * hierarchy of the given triangles (struct kelpo_polygon_triangle_s), replacing
+ * the stack's existing contents. The triangles are reordered.*/
+void kelpoa_triangle_bvh__build(struct kelpoa_generic_stack_s *const nodes,
+                                struct kelpoa_generic_stack_s *const triangles);
+
+/* As __build(), but for the triangles of the given indexed mesh. Since the
+ * mesh's triangles are reordered, its face planes are discarded.*/
+void kelpoa_triangle_bvh__build_indexed(struct kelpoa_generic_stack_s *const nodes,
+                                        struct kelpoa_indexed_mesh_s *const mesh);
+
+/* Transforms the nodes' bounding volumes by the given affine matrix; see
+ * kelpoa_bounding_volume__transform().*/
+void kelpoa_triangle_bvh__transform(struct kelpoa_generic_stack_s *const nodes,
+                                    const struct kelpoa_matrix44_s *const matrix);
+
+/* Traverses the hierarchy against the view frustum of the given matrix, which
+ * takes the nodes' space into clip space (see kelpoa_bounding_volume__test_frustum()),
+ * and places into the given stack (struct kelpoa_triangle_bvh_span_s) the
+ * ranges of triangles that may be visible, replacing the stack's existing
+ * contents. The ranges are in ascending order, and adjacent ones are merged.*/
+void kelpoa_triangle_bvh__find_visible_spans(const struct kelpoa_generic_stack_s *const nodes,
+                                             const struct kelpoa_matrix44_s *const clipSpaceMatrix,
+                                             struct kelpoa_generic_stack_s *const dstSpans);
+
+#endif
@@ -39,16 +39,11 @@
 
 /* A buffer to store the triangles we've clipped from a given input triangle.
  * An pointer to this buffer will be returned to the caller when they request
- * to have a triangle clipped.*/
+ * to have a triangle clipped with kelpoa_triclipr__clip_triangle().*/
 static struct kelpo_polygon_triangle_s CLIPPED_TRIANGLES[KELPOA_TRICLIPR_MAX_NUM_CLIPPED_TRIANGLES];
 
-/* Temporary buffers to hold vertex data during clipping.*/
-static struct vert_buffer_s
-{
-    struct kelpo_polygon_vertex_s v[KELPOA_TRICLIPR_MAX_NUM_CLIPPED_VERTICES];
-    unsigned idx;
-} VERTEX_BUFFER_1,
-  VERTEX_BUFFER_2;
+/* The clipping context of kelpoa_triclipr__clip_triangle().*/
+static struct kelpoa_triclipr_context_s CONTEXT;
 
 static float vertex_component(const struct kelpo_polygon_vertex_s *const vertex,
                               const unsigned componentIdx)
@@ -62,8 +57,8 @@ static float vertex_component(const struct kelpo_polygon_vertex_s *const vertex,
     }
 }
 
-static void clip_polygon_component(struct vert_buffer_s *vertsIn,
-                                   struct vert_buffer_s *vertsOut,
+static void clip_polygon_component(struct kelpoa_triclipr_vertex_buffer_s *vertsIn,
+                                   struct kelpoa_triclipr_vertex_buffer_s *vertsOut,
                                    const unsigned componentIdx,
                                    const float componentFactor)
 {
@@ -116,51 +111,76 @@ static void clip_polygon_component(struct vert_buffer_s *vertsIn,
     return;
 }
 
-static int clip_polygon_axis(const int componentIdx)
+/* The planes against which triangles are clipped, in the order of clipping.
+ * A vertex is inside a plane if its given component, multiplied by the given
+ * sign (and for the X and Y planes, divided by the guard band), is at most W.*/
+static const struct clip_plane_s
 {
-    clip_polygon_component(&VERTEX_BUFFER_1, &VERTEX_BUFFER_2, componentIdx, 1);
-    VERTEX_BUFFER_1.idx = 0;
-    
-    if (VERTEX_BUFFER_2.idx == 0)
-    {
-        return 0;
-    }
+    unsigned planeBit;
+    unsigned componentIdx;
+    float sign;
+} CLIP_PLANES[6] = {{KELPOA_TRICLIPR_PLANE_RIGHT,  0,  1},
+                    {KELPOA_TRICLIPR_PLANE_LEFT,   0, -1},
+                    {KELPOA_TRICLIPR_PLANE_TOP,    1,  1},
+                    {KELPOA_TRICLIPR_PLANE_BOTTOM, 1, -1},
+                    {KELPOA_TRICLIPR_PLANE_FAR,    2,  1},
+                    {KELPOA_TRICLIPR_PLANE_NEAR,   2, -1}};
+
+unsigned kelpoa_triclipr__clip_triangle_into(struct kelpoa_triclipr_context_s *const context,
+                                             const struct kelpo_polygon_triangle_s *const triangle,
+                                             const float guardBand,
+                                             const unsigned planeMask,
+                                             struct kelpo_polygon_triangle_s *const dstClippedTriangles)
+{
+    unsigned p = 0;
+    unsigned numClippedTriangles = 0;
+    const float xyFactor = (1 / guardBand);
+    struct kelpoa_triclipr_vertex_buffer_s *vertexBuffer = &context->vertexBuffer[0];
+    struct kelpoa_triclipr_vertex_buffer_s *spareVertexBuffer = &context->vertexBuffer[1];
 
-    clip_polygon_component(&VERTEX_BUFFER_2, &VERTEX_BUFFER_1, componentIdx, -1);
-    VERTEX_BUFFER_2.idx = 0;
+    assert((guardBand >= 1) && "Invalid guard band.");
 
-    return (VERTEX_BUFFER_1.idx != 0);
-}
+    vertexBuffer->idx = 0;
+    vertexBuffer->v[vertexBuffer->idx++] = triangle->vertex[0];
+    vertexBuffer->v[vertexBuffer->idx++] = triangle->vertex[1];
+    vertexBuffer->v[vertexBuffer->idx++] = triangle->vertex[2];
 
-unsigned kelpoa_triclipr__clip_triangle(const struct kelpo_polygon_triangle_s *const triangle,
-                                        struct kelpo_polygon_triangle_s **dstClippedTriangles)
-{
-    unsigned numClippedTriangles = 0;
-    
-    *dstClippedTriangles = CLIPPED_TRIANGLES;
+    /* Clip the polygon against each of the requested planes in turn, alternating
+     * between the two vertex buffers.*/
+    for (p = 0; p < 6; p++)
+    {
+        struct kelpoa_triclipr_vertex_buffer_s *const clippedBuffer = spareVertexBuffer;
 
-    VERTEX_BUFFER_1.idx = 0;
-    VERTEX_BUFFER_2.idx = 0;
+        if (!(planeMask & CLIP_PLANES[p].planeBit))
+        {
+            continue;
+        }
+
+        clippedBuffer->idx = 0;
+        clip_polygon_component(vertexBuffer, clippedBuffer, CLIP_PLANES[p].componentIdx,
+                               (CLIP_PLANES[p].sign * ((CLIP_PLANES[p].componentIdx < 2)? xyFactor : 1)));
+
+        spareVertexBuffer = vertexBuffer;
+        vertexBuffer = clippedBuffer;
 
-    VERTEX_BUFFER_1.v[VERTEX_BUFFER_1.idx++] = triangle->vertex[0];
-    VERTEX_BUFFER_1.v[VERTEX_BUFFER_1.idx++] = triangle->vertex[1];
-    VERTEX_BUFFER_1.v[VERTEX_BUFFER_1.idx++] = triangle->vertex[2];
+        if (!vertexBuffer->idx)
+        {
+            return 0;
+        }
+    }
 
-    if (clip_polygon_axis(0) &&
-        clip_polygon_axis(1) &&
-        clip_polygon_axis(2))
     {
         unsigned i = 0;
-        struct kelpo_polygon_vertex_s *initialVertex = &VERTEX_BUFFER_1.v[0];
+        struct kelpo_polygon_vertex_s *initialVertex = &vertexBuffer->v[0];
 
-        for (i = 1; i < (VERTEX_BUFFER_1.idx - 1); i++)
+        for (i = 1; i < (vertexBuffer->idx - 1); i++)
         {
-            CLIPPED_TRIANGLES[numClippedTriangles].texture = triangle->texture;
-            CLIPPED_TRIANGLES[numClippedTriangles].flags = triangle->flags;
+            dstClippedTriangles[numClippedTriangles].texture = triangle->texture;
+            dstClippedTriangles[numClippedTriangles].flags = triangle->flags;
             
-            CLIPPED_TRIANGLES[numClippedTriangles].vertex[0] = *initialVertex;
-            CLIPPED_TRIANGLES[numClippedTriangles].vertex[1] = VERTEX_BUFFER_1.v[i];
-            CLIPPED_TRIANGLES[numClippedTriangles].vertex[2] = VERTEX_BUFFER_1.v[i+1];
+            dstClippedTriangles[numClippedTriangles].vertex[0] = *initialVertex;
+            dstClippedTriangles[numClippedTriangles].vertex[1] = vertexBuffer->v[i];
+            dstClippedTriangles[numClippedTriangles].vertex[2] = vertexBuffer->v[i+1];
 
             if (++numClippedTriangles >= KELPOA_TRICLIPR_MAX_NUM_CLIPPED_TRIANGLES)
             {
@@ -171,3 +191,11 @@ unsigned kelpoa_triclipr__clip_triangle(const struct kelpo_polygon_triangle_s *c
     
     return numClippedTriangles;
 }
+
+unsigned kelpoa_triclipr__clip_triangle(const struct kelpo_polygon_triangle_s *const triangle,
+                                        struct kelpo_polygon_triangle_s **dstClippedTriangles)
+{
+    *dstClippedTriangles = CLIPPED_TRIANGLES;
+
+    return kelpoa_triclipr__clip_triangle_into(&CONTEXT, triangle, 1, KELPOA_TRICLIPR_ALL_PLANES, CLIPPED_TRIANGLES);
+}
@@ -8,14 +8,42 @@
 #ifndef KELPO_AUXILIARY_TRIANGLE_CLIPPER_H
 #define KELPO_AUXILIARY_TRIANGLE_CLIPPER_H
 
+#include <kelpo_interface/polygon/vertex.h>
+
 /* The maximum number of triangles and vertices we can clip a source triangle into.
  * These will be used to size the working buffers on the stack, so better conservative
  * than greedy values.*/
 #define KELPOA_TRICLIPR_MAX_NUM_CLIPPED_VERTICES 9
 #define KELPOA_TRICLIPR_MAX_NUM_CLIPPED_TRIANGLES (KELPOA_TRICLIPR_MAX_NUM_CLIPPED_VERTICES - 2)
 
+/* Bits identifying the clip-space planes of the view frustum, e.g. in a vertex's
+ * outcode (a bit is set for each plane the vertex is outside of) or in the mask
+ * of planes to clip against.*/
+#define KELPOA_TRICLIPR_PLANE_LEFT   0x01
+#define KELPOA_TRICLIPR_PLANE_RIGHT  0x02
+#define KELPOA_TRICLIPR_PLANE_BOTTOM 0x04
+#define KELPOA_TRICLIPR_PLANE_TOP    0x08
+#define KELPOA_TRICLIPR_PLANE_NEAR   0x10
+#define KELPOA_TRICLIPR_PLANE_FAR    0x20
+#define KELPOA_TRICLIPR_ALL_PLANES   0x3f
+
 struct kelpo_polygon_triangle_s;
 
+/* A buffer to hold vertex data during clipping.*/
+struct kelpoa_triclipr_vertex_buffer_s
+{
+    struct kelpo_polygon_vertex_s v[KELPOA_TRICLIPR_MAX_NUM_CLIPPED_VERTICES];
+    unsigned idx;
+};
+
+/* The working memory of a call to kelpoa_triclipr__clip_triangle_into(). Needs
+ * no initialization. A context can be reused for any number of calls, but by
+ * only one thread at a time; each thread clipping triangles should have its own.*/
+struct kelpoa_triclipr_context_s
+{
+    struct kelpoa_triclipr_vertex_buffer_s vertexBuffer[2];
+};
+
 /* Clips the given triangle (whose vertices are in [-1,1] clip space) against the
  * view frustum, The 'dstClippedTriangles' pointer will be assigned the address of a
  * memory buffer holding the clipped triangles - the original triangle will not be
@@ -26,4 +54,27 @@ struct kelpo_polygon_triangle_s;
 unsigned kelpoa_triclipr__clip_triangle(const struct kelpo_polygon_triangle_s *const triangle,
                                         struct kelpo_polygon_triangle_s **dstClippedTriangles);
 
+/* As kelpoa_triclipr__clip_triangle(), but reentrant: uses the given context
+ * for working memory, and writes the clipped triangles directly into the given
+ * array, which must have room for KELPOA_TRICLIPR_MAX_NUM_CLIPPED_TRIANGLES
+ * triangles (e.g. the unused capacity at the end of a triangle stack). Can be
+ * called from several threads at once, as long as each uses its own context
+ * and destination array. Returns the number of triangles written; or 0 if the
+ * triangle could not be clipped.
+ *
+ * The triangle is clipped against the near and far planes, and against a
+ * guard band whose left, right, top and bottom planes are at the given multiple
+ * (at least 1) of the view frustum's; so with a guard band of 1, the triangle
+ * is clipped against the view frustum as such.
+ *
+ * Only the planes whose KELPOA_TRICLIPR_PLANE_* bits are set in 'planeMask' are
+ * clipped against. Passing the OR of the triangle's vertex outcodes skips the
+ * planes that the triangle doesn't cross, producing the same result as clipping
+ * against KELPOA_TRICLIPR_ALL_PLANES.*/
+unsigned kelpoa_triclipr__clip_triangle_into(struct kelpoa_triclipr_context_s *const context,
+                                             const struct kelpo_polygon_triangle_s *const triangle,
+                                             const float guardBand,
+                                             const unsigned planeMask,
+                                             struct kelpo_polygon_triangle_s *const dstClippedTriangles);
+
 #endif
@@ -4,14 +4,22 @@
  * Software: Kelpo
  */
 
+#include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <kelpo_interface/polygon/triangle/triangle.h>
 #include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/bounding_volume.h>
+#include <kelpo_auxiliary/thread_pool.h>
+#include <kelpo_auxiliary/indexed_mesh.h>
 #include <kelpo_auxiliary/triangle_preparer.h>
+#include <kelpo_auxiliary/triangle_bvh.h>
+#include <kelpo_auxiliary/vertex_stream.h>
 #include <kelpo_auxiliary/matrix_44.h>
 #include <kelpo_auxiliary/vector_3.h>
 #include <kelpo_auxiliary/triangle_clipper.h>
+#include <kelpo_auxiliary/profiler.h>
 
 static void transform_vert(struct kelpo_polygon_vertex_s *const v,
                            const struct kelpoa_matrix44_s *const m)
@@ -43,206 +51,1659 @@ static void transform_normal(struct kelpo_polygon_vertex_s *const v,
     return;
 }
 
+static void vert_perspective_divide(struct kelpo_polygon_vertex_s *const v,
+                                    const float zNear,
+                                    const float zFar)
+{
+    v->x /= v->w;
+    v->y /= v->w;
+    v->w = (1 / v->w);
+
+    /* Scale the depth value to the range [0,1].*/
+    v->z = ((v->z - zNear) / (zFar - zNear));
+
+    return;
+}
+
 static void tri_perspective_divide(struct kelpo_polygon_triangle_s *const t,
                                    const float zNear,
                                    const float zFar)
 {
-    unsigned i;
+    unsigned i;
+
+    for (i = 0; i < 3; i++)
+    {
+        vert_perspective_divide(&t->vertex[i], zNear, zFar);
+    }
+
+    return;
+}
+
+/* The size of the view frustum's guard band, as a multiple of the frustum's
+ * width and height; see kelpoa_triprepr__set_guard_band().*/
+static float GUARD_BAND = 1;
+
+/* The reciprocal of GUARD_BAND; the factor by which the clipper scales X and Y
+ * when testing them against the guard band.*/
+static float GUARD_BAND_XY_FACTOR = 1;
+
+/* Returns the outcode of the given clip space vertex: a combination of the
+ * KELPOA_TRICLIPR_PLANE_* bits of the planes the vertex is outside of. X and Y
+ * are first scaled by the given factor; 1 for the view frustum's planes, or
+ * GUARD_BAND_XY_FACTOR for its guard band's. The tests are those used by the
+ * clipper, so that it agrees on which planes a triangle crosses.*/
+static unsigned vertex_outcode(const struct kelpo_polygon_vertex_s *const v,
+                               const float xyFactor)
+{
+    const float x = (v->x * xyFactor);
+    const float y = (v->y * xyFactor);
+
+    return (((-x > v->w)? KELPOA_TRICLIPR_PLANE_LEFT : 0) |
+            (( x > v->w)? KELPOA_TRICLIPR_PLANE_RIGHT : 0) |
+            ((-y > v->w)? KELPOA_TRICLIPR_PLANE_BOTTOM : 0) |
+            (( y > v->w)? KELPOA_TRICLIPR_PLANE_TOP : 0) |
+            ((-v->z > v->w)? KELPOA_TRICLIPR_PLANE_NEAR : 0) |
+            (( v->z > v->w)? KELPOA_TRICLIPR_PLANE_FAR : 0));
+}
+
+/* Status bits of a vertex being projected by project_indexed_mesh_to_screen().*/
+#define PROJECTED_VERTEX_CLIP_SPACE   0x1 /* The vertex has been transformed into clip space and its outcodes computed.*/
+#define PROJECTED_VERTEX_SCREEN_SPACE 0x2 /* The vertex has been transformed into screen space.*/
+#define PROJECTED_VERTEX_FACING_KNOWN 0x4 /* The vertex has been tested for backfacing.*/
+#define PROJECTED_VERTEX_BACKFACING   0x8 /* Triangles whose first vertex this is face away from the camera.*/
+
+/* Transforms the given vertex into clip space and computes its outcodes against
+ * the view frustum and its guard band, unless this has already been done.*/
+static struct kelpoa_projected_vertex_s* project_vertex_to_clip_space(struct kelpoa_projected_vertex_s *const projectedVertex,
+                                                                       const struct kelpo_polygon_vertex_s *const vertex,
+                                                                       const struct kelpoa_matrix44_s *const clipSpaceMatrix)
+{
+    if (!(projectedVertex->status & PROJECTED_VERTEX_CLIP_SPACE))
+    {
+        struct kelpo_polygon_vertex_s *const v = &projectedVertex->clipSpace;
+
+        *v = *vertex;
+        transform_vert(v, clipSpaceMatrix);
+
+        projectedVertex->frustumOutcode = vertex_outcode(v, 1);
+        projectedVertex->guardBandOutcode = ((GUARD_BAND == 1)
+                                             ? projectedVertex->frustumOutcode
+                                             : vertex_outcode(v, GUARD_BAND_XY_FACTOR));
+
+        projectedVertex->status |= PROJECTED_VERTEX_CLIP_SPACE;
+    }
+
+    return projectedVertex;
+}
+
+/* Transforms the given clip space vertex into screen space, unless this has
+ * already been done.*/
+static const struct kelpo_polygon_vertex_s* project_vertex_to_screen_space(struct kelpoa_projected_vertex_s *const projectedVertex,
+                                                                            const struct kelpoa_matrix44_s *const screenSpaceMatrix,
+                                                                            const float zNear,
+                                                                            const float zFar)
+{
+    if (!(projectedVertex->status & PROJECTED_VERTEX_SCREEN_SPACE))
+    {
+        projectedVertex->screenSpace = projectedVertex->clipSpace;
+        transform_vert(&projectedVertex->screenSpace, screenSpaceMatrix);
+        vert_perspective_divide(&projectedVertex->screenSpace, zNear, zFar);
+
+        projectedVertex->status |= PROJECTED_VERTEX_SCREEN_SPACE;
+    }
+
+    return &projectedVertex->screenSpace;
+}
+
+/* Returns 1 if a triangle whose first vertex is the given world space vertex
+ * faces away from the camera; 0 otherwise.*/
+static int is_backfacing(const struct kelpo_polygon_vertex_s *const worldSpaceVertex)
+{
+    struct kelpoa_vector3_s viewVector;
+    struct kelpoa_vector3_s surfaceNormal;
+
+    surfaceNormal.x = worldSpaceVertex->nx;
+    surfaceNormal.y = worldSpaceVertex->ny;
+    surfaceNormal.z = worldSpaceVertex->nz;
+
+    viewVector.x = worldSpaceVertex->x;
+    viewVector.y = worldSpaceVertex->y;
+    viewVector.z = worldSpaceVertex->z;
+
+    return (kelpoa_vector3__dot(&surfaceNormal, &viewVector) >= 0);
+}
+
+/* As is_backfacing(), but for a model space vertex that the given model matrix
+ * transforms into world space.*/
+static int is_backfacing_in_model(const struct kelpo_polygon_vertex_s *const modelSpaceVertex,
+                                  const struct kelpoa_matrix44_s *const modelMatrix)
+{
+    struct kelpo_polygon_vertex_s worldSpaceVertex = *modelSpaceVertex;
+
+    transform_vert(&worldSpaceVertex, modelMatrix);
+    transform_normal(&worldSpaceVertex, modelMatrix);
+
+    return is_backfacing(&worldSpaceVertex);
+}
+
+/* How backfacing triangles are detected; see kelpoa_triprepr__set_backface_cull_mode().*/
+static enum kelpoa_triprepr_backface_cull_mode_e BACKFACE_CULL_MODE = KELPOA_TRIPREPR_CULL_BY_VERTEX_NORMAL;
+
+/* Returns the plane of the triangle formed by the given vertices. The plane's
+ * normal points out of the triangle's front face, and isn't normalized.*/
+static struct kelpoa_face_plane_s face_plane(const struct kelpo_polygon_vertex_s *const v0,
+                                             const struct kelpo_polygon_vertex_s *const v1,
+                                             const struct kelpo_polygon_vertex_s *const v2)
+{
+    struct kelpoa_face_plane_s plane;
+    const float e1x = (v1->x - v0->x), e1y = (v1->y - v0->y), e1z = (v1->z - v0->z);
+    const float e2x = (v2->x - v0->x), e2y = (v2->y - v0->y), e2z = (v2->z - v0->z);
+
+    plane.nx = ((e1y * e2z) - (e1z * e2y));
+    plane.ny = ((e1z * e2x) - (e1x * e2z));
+    plane.nz = ((e1x * e2y) - (e1y * e2x));
+    plane.d = -((plane.nx * v0->x) + (plane.ny * v0->y) + (plane.nz * v0->z));
+
+    return plane;
+}
+
+/* Returns 1 if the given eye position is behind (or on) the given face plane,
+ * i.e. if the face is seen from the back; 0 otherwise.*/
+static int is_face_plane_backfacing(const struct kelpoa_face_plane_s *const plane,
+                                    const struct kelpoa_vector3_s *const eye)
+{
+    return ((((plane->nx * eye->x) + (plane->ny * eye->y) + (plane->nz * eye->z)) + plane->d) <= 0);
+}
+
+/* Returns the camera's position - the world space origin - in the model space
+ * of the given model matrix; or the origin if the matrix is NULL. The matrix's
+ * upper 3-by-3 part must be invertible.*/
+static struct kelpoa_vector3_s eye_in_model_space(const struct kelpoa_matrix44_s *const modelMatrix)
+{
+    if (!modelMatrix)
+    {
+        return kelpoa_vector3(0, 0, 0);
+    }
+    else
+    {
+        /* Solve M * eye = -translation, where M is the matrix's upper 3-by-3
+         * part, by Cramer's rule.*/
+        const float *const m = modelMatrix->elements;
+        const struct kelpoa_vector3_s col0 = kelpoa_vector3(m[0], m[1], m[2]);
+        const struct kelpoa_vector3_s col1 = kelpoa_vector3(m[4], m[5], m[6]);
+        const struct kelpoa_vector3_s col2 = kelpoa_vector3(m[8], m[9], m[10]);
+        const struct kelpoa_vector3_s b = kelpoa_vector3(-m[12], -m[13], -m[14]);
+        const struct kelpoa_vector3_s col1xcol2 = kelpoa_vector3__cross(&col1, &col2);
+        const struct kelpoa_vector3_s col2xcol0 = kelpoa_vector3__cross(&col2, &col0);
+        const struct kelpoa_vector3_s col0xcol1 = kelpoa_vector3__cross(&col0, &col1);
+        const float det = kelpoa_vector3__dot(&col0, &col1xcol2);
+
+        assert((det != 0) && "The model matrix isn't invertible.");
+
+        return kelpoa_vector3((kelpoa_vector3__dot(&b, &col1xcol2) / det),
+                              (kelpoa_vector3__dot(&b, &col2xcol0) / det),
+                              (kelpoa_vector3__dot(&b, &col0xcol1) / det));
+    }
+}
+
+/* Returns 1 if the given triangle, in world space or (if 'modelMatrix' isn't
+ * NULL) in model space, is to be culled as backfacing before it's projected;
+ * 0 otherwise. 'eye' is the camera's position in the triangle's space (see
+ * eye_in_model_space()). With screen area culling, triangles are culled only
+ * once they've been projected; see is_backfacing_on_screen().*/
+static int is_culled_before_projection(const struct kelpo_polygon_triangle_s *const triangle,
+                                       const struct kelpoa_matrix44_s *const modelMatrix,
+                                       const struct kelpoa_vector3_s *const eye)
+{
+    switch (BACKFACE_CULL_MODE)
+    {
+        case KELPOA_TRIPREPR_CULL_BY_VERTEX_NORMAL:
+        {
+            return (modelMatrix
+                    ? is_backfacing_in_model(&triangle->vertex[0], modelMatrix)
+                    : is_backfacing(&triangle->vertex[0]));
+        }
+        case KELPOA_TRIPREPR_CULL_BY_FACE_PLANE:
+        {
+            const struct kelpoa_face_plane_s plane = face_plane(&triangle->vertex[0], &triangle->vertex[1], &triangle->vertex[2]);
+
+            return is_face_plane_backfacing(&plane, eye);
+        }
+        case KELPOA_TRIPREPR_CULL_BY_SCREEN_AREA: return 0;
+        default: assert(0 && "Unknown backface culling mode."); return 0;
+    }
+}
+
+/* Returns 1 if the given screen space triangle's signed area is zero or
+ * negative, i.e. if its vertices wind counter-clockwise on the screen (whose
+ * Y axis points down) and so the triangle faces away from the camera; 0
+ * otherwise.*/
+static int is_backfacing_on_screen(const struct kelpo_polygon_triangle_s *const triangle)
+{
+    const struct kelpo_polygon_vertex_s *const v = triangle->vertex;
+
+    return ((((v[1].x - v[0].x) * (v[2].y - v[0].y)) - ((v[2].x - v[0].x) * (v[1].y - v[0].y))) <= 0);
+}
+
+/* How a clip space triangle relates to the view frustum.*/
+enum frustum_test_e
+{
+    TRIANGLE_TRIVIALLY_ACCEPTED, /* All of the triangle's vertices are inside the frustum's guard band; no clipping needed.*/
+    TRIANGLE_TRIVIALLY_REJECTED, /* All of the triangle's vertices are outside the same plane of the frustum.*/
+    TRIANGLE_NEEDS_CLIPPING      /* The triangle may be partially inside the frustum, and needs clipping.*/
+};
+
+/* Classifies a triangle against the view frustum given its vertices' frustum
+ * and guard band outcodes (see vertex_outcode()). If the triangle needs clipping,
+ * 'clipPlanes' is assigned the mask of the guard band planes it crosses.*/
+static enum frustum_test_e test_outcodes_against_frustum(const unsigned frustumOutcode0,
+                                                         const unsigned frustumOutcode1,
+                                                         const unsigned frustumOutcode2,
+                                                         const unsigned guardBandOutcode0,
+                                                         const unsigned guardBandOutcode1,
+                                                         const unsigned guardBandOutcode2,
+                                                         unsigned *const clipPlanes)
+{
+    if (frustumOutcode0 & frustumOutcode1 & frustumOutcode2)
+    {
+        return TRIANGLE_TRIVIALLY_REJECTED;
+    }
+    else if (!(*clipPlanes = (guardBandOutcode0 | guardBandOutcode1 | guardBandOutcode2)))
+    {
+        return TRIANGLE_TRIVIALLY_ACCEPTED;
+    }
+
+    return TRIANGLE_NEEDS_CLIPPING;
+}
+
+static enum frustum_test_e test_triangle_against_frustum(const struct kelpo_polygon_triangle_s *const triangle,
+                                                         unsigned *const clipPlanes)
+{
+    unsigned frustumOutcode[3];
+
+    frustumOutcode[0] = vertex_outcode(&triangle->vertex[0], 1);
+    frustumOutcode[1] = vertex_outcode(&triangle->vertex[1], 1);
+    frustumOutcode[2] = vertex_outcode(&triangle->vertex[2], 1);
+
+    if (GUARD_BAND == 1)
+    {
+        return test_outcodes_against_frustum(frustumOutcode[0], frustumOutcode[1], frustumOutcode[2],
+                                             frustumOutcode[0], frustumOutcode[1], frustumOutcode[2],
+                                             clipPlanes);
+    }
+
+    return test_outcodes_against_frustum(frustumOutcode[0], frustumOutcode[1], frustumOutcode[2],
+                                         vertex_outcode(&triangle->vertex[0], GUARD_BAND_XY_FACTOR),
+                                         vertex_outcode(&triangle->vertex[1], GUARD_BAND_XY_FACTOR),
+                                         vertex_outcode(&triangle->vertex[2], GUARD_BAND_XY_FACTOR),
+                                         clipPlanes);
+}
+
+/* Transforms the given clip space triangle, which needs no further clipping,
+ * into screen space.*/
+static void triangle_to_screen_space(struct kelpo_polygon_triangle_s *const triangle,
+                                     const struct kelpoa_matrix44_s *const screenSpaceMatrix,
+                                     const float zNear,
+                                     const float zFar)
+{
+    transform_vert(&triangle->vertex[0], screenSpaceMatrix);
+    transform_vert(&triangle->vertex[1], screenSpaceMatrix);
+    transform_vert(&triangle->vertex[2], screenSpaceMatrix);
+    tri_perspective_divide(triangle, zNear, zFar);
+
+    return;
+}
+
+/* Returns a pointer to the end of the given stack of triangles, having grown
+ * the stack as needed to make room for at least the given number of triangles
+ * there. The stack's count isn't changed.*/
+static struct kelpo_polygon_triangle_s* reserve_triangles(struct kelpoa_generic_stack_s *const stack,
+                                                          const uint32_t numTriangles)
+{
+    const uint32_t minCapacity = (stack->count + numTriangles);
+
+    if (stack->capacity < minCapacity)
+    {
+        const uint32_t grownCapacity = ((stack->capacity * 3) / 2);
+
+        kelpoa_generic_stack__grow(stack, ((grownCapacity > minCapacity)? grownCapacity : minCapacity));
+    }
+
+    return &((struct kelpo_polygon_triangle_s*)stack->data)[stack->count];
+}
+
+/* Clips the given clip space triangle, which is known to be partially inside
+ * the view frustum, against the given planes (KELPOA_TRICLIPR_PLANE_* bits),
+ * transforms the clippings into screen space, and adds them to the given stack.
+ * The clipper writes directly into the stack. If 'cullBackfacing' is true and
+ * backfaces are culled by screen area, clippings facing away are dropped.*/
+static void emit_clipped_triangle(struct kelpoa_triclipr_context_s *const clipContext,
+                                  const struct kelpo_polygon_triangle_s *const triangle,
+                                  const unsigned clipPlanes,
+                                  const int cullBackfacing,
+                                  struct kelpoa_generic_stack_s *const screenSpaceTriangles,
+                                  const struct kelpoa_matrix44_s *const screenSpaceMatrix,
+                                  const float zNear,
+                                  const float zFar)
+{
+    unsigned k = 0;
+    unsigned numEmittedTris = 0;
+    const int cullOnScreen = (cullBackfacing && (BACKFACE_CULL_MODE == KELPOA_TRIPREPR_CULL_BY_SCREEN_AREA));
+    struct kelpo_polygon_triangle_s *const clippedTris = reserve_triangles(screenSpaceTriangles, KELPOA_TRICLIPR_MAX_NUM_CLIPPED_TRIANGLES);
+    const unsigned numClippedTris = kelpoa_triclipr__clip_triangle_into(clipContext, triangle, GUARD_BAND, clipPlanes, clippedTris);
+
+    for (k = 0; k < numClippedTris; k++)
+    {
+        triangle_to_screen_space(&clippedTris[k], screenSpaceMatrix, zNear, zFar);
+
+        if (cullOnScreen &&
+            is_backfacing_on_screen(&clippedTris[k]))
+        {
+            continue;
+        }
+
+        if (numEmittedTris != k)
+        {
+            clippedTris[numEmittedTris] = clippedTris[k];
+        }
+
+        numEmittedTris++;
+    }
+
+    screenSpaceTriangles->count += numEmittedTris;
+
+    return;
+}
+
+/* Clips the given clip space triangle against the view frustum, transforms the
+ * result into screen space, and adds it to the given stack. The triangle may
+ * be modified. 'cullBackfacing' is as for emit_clipped_triangle(). If
+ * 'isInsideFrustum' is true, the triangle is known to be inside the frustum
+ * (e.g. its mesh's bounding volume is), and isn't tested against it.*/
+static void clip_and_emit_triangle(struct kelpoa_triclipr_context_s *const clipContext,
+                                   struct kelpo_polygon_triangle_s *const triangle,
+                                   const int cullBackfacing,
+                                   const int isInsideFrustum,
+                                   struct kelpoa_generic_stack_s *const screenSpaceTriangles,
+                                   const struct kelpoa_matrix44_s *const screenSpaceMatrix,
+                                   const float zNear,
+                                   const float zFar)
+{
+    unsigned clipPlanes = 0;
+
+    switch (isInsideFrustum? TRIANGLE_TRIVIALLY_ACCEPTED : test_triangle_against_frustum(triangle, &clipPlanes))
+    {
+        case TRIANGLE_TRIVIALLY_ACCEPTED:
+        {
+            triangle_to_screen_space(triangle, screenSpaceMatrix, zNear, zFar);
+
+            if (cullBackfacing &&
+                (BACKFACE_CULL_MODE == KELPOA_TRIPREPR_CULL_BY_SCREEN_AREA) &&
+                is_backfacing_on_screen(triangle))
+            {
+                break;
+            }
+
+            *reserve_triangles(screenSpaceTriangles, 1) = *triangle;
+            screenSpaceTriangles->count++;
+            break;
+        }
+        case TRIANGLE_TRIVIALLY_REJECTED: break;
+        case TRIANGLE_NEEDS_CLIPPING:
+        {
+            emit_clipped_triangle(clipContext, triangle, clipPlanes, cullBackfacing, screenSpaceTriangles, screenSpaceMatrix, zNear, zFar);
+            break;
+        }
+        default: assert(0 && "Unknown frustum test result."); break;
+    }
+
+    return;
+}
+
+/* The clipping context of triangles clipped on the calling thread.*/
+static struct kelpoa_triclipr_context_s CLIP_CONTEXT;
+
+/* Large stacks of triangles are projected in parallel, in batches of this many
+ * triangles. Each batch is culled, transformed, clipped and projected by one
+ * thread into a stack of its own, after which the batches' stacks are appended
+ * onto the output stack in the order of the input triangles; so the output is
+ * the same as if the triangles had been projected one at a time.*/
+#define PROJECTION_BATCH_SIZE 1024
+
+/* Stacks with fewer triangles than this are projected on the calling thread
+ * only.*/
+#define MIN_NUM_PARALLEL_TRIANGLES 4096
+
+/* Triangles are projected in chunks of this many, each chunk for every instance
+ * of the triangles in turn (see kelpoa_triprepr__transform_and_project_triangle_instances()),
+ * so that the chunk's source triangles stay in the cache across the instances.
+ * Divides PROJECTION_BATCH_SIZE, so that batches start on chunk boundaries and
+ * the output order doesn't depend on the number of threads.*/
+#define INSTANCE_CHUNK_SIZE 128
+
+/* Projects the triangles in parallel. Created on first use, with the number of
+ * threads given by the KELPOA_TRIPREPR_NUM_THREADS environment variable, or by
+ * default one per CPU core. NULL if projection is single-threaded.*/
+static struct kelpoa_thread_pool_s *THREAD_POOL = NULL;
+static int IS_THREAD_POOL_INITIALIZED = 0;
+
+/* A placement of the triangles being projected; see add_projection_instance().*/
+struct projection_instance_s
+{
+    const struct kelpoa_matrix44_s *modelMatrix; /* NULL if the triangles are in world space.*/
+    struct kelpoa_matrix44_s clipSpaceMatrix; /* Takes the triangles' space into clip space.*/
+    struct kelpoa_vector3_s eye; /* The camera's position in the triangles' space.*/
+    int isInsideFrustum; /* The instance is known to be inside the view frustum.*/
+};
+
+/* The parameters of the current projection.*/
+static struct
+{
+    const struct kelpo_polygon_triangle_s *triangles;
+    uint32_t numTriangles;
+    const struct projection_instance_s *instances;
+    unsigned numInstances;
+    const struct kelpoa_matrix44_s *screenSpaceMatrix;
+    float zNear;
+    float zFar;
+    int backfaceCull;
+} PROJECTION;
+
+/* The instances of the current projection. Grows as needed.*/
+static struct projection_instance_s *INSTANCES = NULL;
+static unsigned NUM_INSTANCES_ALLOCATED = 0;
+
+/* The ranges of PROJECTION.triangles projected in parallel, one per batch;
+ * and the batches' output stacks (struct kelpo_polygon_triangle_s). Grow as
+ * needed, and the stacks are reused between calls.*/
+static struct kelpoa_triangle_bvh_span_s *BATCHES = NULL;
+static struct kelpoa_generic_stack_s **BATCH_TRIANGLES = NULL;
+static unsigned NUM_BATCH_STACKS = 0;
+
+/* The ranges of triangles found visible by a mesh's bounding volume hierarchy
+ * (struct kelpoa_triangle_bvh_span_s). Created on first use.*/
+static struct kelpoa_generic_stack_s *VISIBLE_SPANS = NULL;
+
+static struct kelpoa_thread_pool_s* thread_pool(void)
+{
+    if (!IS_THREAD_POOL_INITIALIZED)
+    {
+        const char *const envValue = getenv("KELPOA_TRIPREPR_NUM_THREADS");
+        const int envNumThreads = (envValue? atoi(envValue) : 0);
+        const unsigned numThreads = ((envNumThreads > 0)? (unsigned)envNumThreads : kelpoa_thread_pool__num_cpu_cores());
+
+        IS_THREAD_POOL_INITIALIZED = 1;
+
+        /* The calling thread projects too, so it doesn't need a worker.*/
+        if (numThreads > 1)
+        {
+            THREAD_POOL = kelpoa_thread_pool__create(numThreads - 1);
+        }
+    }
+
+    return THREAD_POOL;
+}
+
+/* Sets the parameters of the projection of the given triangles by
+ * project_triangle_span() and project_triangles_in_parallel(). The projection
+ * starts with no instances; see add_projection_instance().*/
+static void begin_projection(const struct kelpoa_generic_stack_s *const triangles,
+                             const struct kelpoa_matrix44_s *const screenSpaceMatrix,
+                             const float zNear,
+                             const float zFar,
+                             const int backfaceCull)
+{
+    PROJECTION.triangles = (const struct kelpo_polygon_triangle_s*)triangles->data;
+    PROJECTION.numTriangles = triangles->count;
+    PROJECTION.instances = INSTANCES;
+    PROJECTION.numInstances = 0;
+    PROJECTION.screenSpaceMatrix = screenSpaceMatrix;
+    PROJECTION.zNear = zNear;
+    PROJECTION.zFar = zFar;
+    PROJECTION.backfaceCull = backfaceCull;
+
+    return;
+}
+
+/* Adds to the current projection an instance of its triangles, each of which
+ * is projected once per instance. If 'modelMatrix' is not NULL, the triangles
+ * are taken to be in model space, and 'clipSpaceMatrix' to have been
+ * pre-multiplied with the model matrix. If 'isInsideFrustum' is true, the
+ * instance is known to be inside the view frustum, and its triangles aren't
+ * tested against it.*/
+static void add_projection_instance(const struct kelpoa_matrix44_s *const modelMatrix,
+                                    const struct kelpoa_matrix44_s *const clipSpaceMatrix,
+                                    const int isInsideFrustum)
+{
+    struct projection_instance_s *instance = NULL;
+
+    if (PROJECTION.numInstances == NUM_INSTANCES_ALLOCATED)
+    {
+        NUM_INSTANCES_ALLOCATED = (NUM_INSTANCES_ALLOCATED? (NUM_INSTANCES_ALLOCATED * 2) : 16);
+        INSTANCES = (struct projection_instance_s*)realloc(INSTANCES, (NUM_INSTANCES_ALLOCATED * sizeof(INSTANCES[0])));
+        assert(INSTANCES && "Failed to allocate memory for projection instances.");
+
+        PROJECTION.instances = INSTANCES;
+    }
+
+    instance = &INSTANCES[PROJECTION.numInstances++];
+    instance->modelMatrix = modelMatrix;
+    instance->clipSpaceMatrix = *clipSpaceMatrix;
+    instance->eye = eye_in_model_space(modelMatrix);
+    instance->isInsideFrustum = isInsideFrustum;
+
+    return;
+}
+
+/* Culls, transforms, clips and projects the given span of PROJECTION.triangles
+ * into the given stack, once for each of the projection's instances. The span
+ * is processed in chunks of INSTANCE_CHUNK_SIZE triangles, each chunk for every
+ * instance before the next chunk. The source triangles aren't modified.*/
+static void project_triangle_span(struct kelpoa_triclipr_context_s *const clipContext,
+                                  const struct kelpoa_triangle_bvh_span_s *const span,
+                                  struct kelpoa_generic_stack_s *const dstTriangles)
+{
+    uint32_t chunkIdx = 0;
+
+    for (chunkIdx = span->firstTriangleIdx; chunkIdx < span->endTriangleIdx; chunkIdx += INSTANCE_CHUNK_SIZE)
+    {
+        const uint32_t chunkEndIdx = (((chunkIdx + INSTANCE_CHUNK_SIZE) < span->endTriangleIdx)
+                                      ? (chunkIdx + INSTANCE_CHUNK_SIZE)
+                                      : span->endTriangleIdx);
+        unsigned n = 0;
+
+        for (n = 0; n < PROJECTION.numInstances; n++)
+        {
+            const struct projection_instance_s *const instance = &PROJECTION.instances[n];
+            const int isInsideFrustum = (span->isInsideFrustum || instance->isInsideFrustum);
+            uint32_t i = 0;
+
+            for (i = chunkIdx; i < chunkEndIdx; i++)
+            {
+                struct kelpo_polygon_triangle_s triangle = PROJECTION.triangles[i];
+                const int cullBackfacing = (PROJECTION.backfaceCull && !triangle.flags.twoSided);
+
+                if (cullBackfacing &&
+                    is_culled_before_projection(&triangle, instance->modelMatrix, &instance->eye))
+                {
+                    continue;
+                }
+
+                transform_vert(&triangle.vertex[0], &instance->clipSpaceMatrix);
+                transform_vert(&triangle.vertex[1], &instance->clipSpaceMatrix);
+                transform_vert(&triangle.vertex[2], &instance->clipSpaceMatrix);
+
+                clip_and_emit_triangle(clipContext, &triangle, cullBackfacing, isInsideFrustum, dstTriangles,
+                                       PROJECTION.screenSpaceMatrix, PROJECTION.zNear, PROJECTION.zFar);
+            }
+        }
+    }
+
+    return;
+}
+
+/* Thread pool job. Projects the given batch of PROJECTION.triangles into the
+ * batch's output stack.*/
+static void project_triangle_batch(void *const context, const unsigned batchIdx)
+{
+    struct kelpoa_generic_stack_s *const dstTriangles = BATCH_TRIANGLES[batchIdx];
+    struct kelpoa_triclipr_context_s clipContext;
+
+    (void)context;
+
+    kelpoa_generic_stack__clear(dstTriangles);
+    kelpoa_generic_stack__grow(dstTriangles, ((BATCHES[batchIdx].endTriangleIdx - BATCHES[batchIdx].firstTriangleIdx) * PROJECTION.numInstances));
+
+    project_triangle_span(&clipContext, &BATCHES[batchIdx], dstTriangles);
+
+    return;
+}
+
+/* Projects the given spans of the triangles given to begin_projection() as
+ * project_triangle_span() does, but in parallel on the given thread pool. Each
+ * span is split into batches of about PROJECTION_BATCH_SIZE triangles across
+ * the projection's instances.*/
+static void project_triangles_in_parallel(struct kelpoa_thread_pool_s *const threadPool,
+                                          const struct kelpoa_triangle_bvh_span_s *const spans,
+                                          const unsigned numSpans,
+                                          struct kelpoa_generic_stack_s *const screenSpaceTriangles)
+{
+    uint32_t b = 0;
+    uint32_t s = 0;
+    uint32_t numBatches = 0;
+    uint32_t numProjectedTriangles = 0;
+    uint32_t batchSize = ((PROJECTION_BATCH_SIZE / PROJECTION.numInstances / INSTANCE_CHUNK_SIZE) * INSTANCE_CHUNK_SIZE);
+
+    if (batchSize < INSTANCE_CHUNK_SIZE)
+    {
+        batchSize = INSTANCE_CHUNK_SIZE;
+    }
+
+    for (s = 0; s < numSpans; s++)
+    {
+        numBatches += ((spans[s].endTriangleIdx - spans[s].firstTriangleIdx + batchSize - 1) / batchSize);
+    }
+
+    if (numBatches > NUM_BATCH_STACKS)
+    {
+        BATCHES = (struct kelpoa_triangle_bvh_span_s*)realloc(BATCHES, (numBatches * sizeof(BATCHES[0])));
+        BATCH_TRIANGLES = (struct kelpoa_generic_stack_s**)realloc(BATCH_TRIANGLES, (numBatches * sizeof(BATCH_TRIANGLES[0])));
+        assert((BATCHES && BATCH_TRIANGLES) && "Failed to allocate memory for projection batches.");
+
+        for (b = NUM_BATCH_STACKS; b < numBatches; b++)
+        {
+            BATCH_TRIANGLES[b] = kelpoa_generic_stack__create(PROJECTION_BATCH_SIZE, sizeof(struct kelpo_polygon_triangle_s));
+        }
+
+        NUM_BATCH_STACKS = numBatches;
+    }
+
+    for (s = 0, b = 0; s < numSpans; s++)
+    {
+        uint32_t firstIdx = 0;
+
+        for (firstIdx = spans[s].firstTriangleIdx; firstIdx < spans[s].endTriangleIdx; firstIdx += batchSize, b++)
+        {
+            BATCHES[b].firstTriangleIdx = firstIdx;
+            BATCHES[b].endTriangleIdx = (((firstIdx + batchSize) < spans[s].endTriangleIdx)
+                                         ? (firstIdx + batchSize)
+                                         : spans[s].endTriangleIdx);
+            BATCHES[b].isInsideFrustum = spans[s].isInsideFrustum;
+        }
+    }
+
+    kelpoa_thread_pool__run(threadPool, project_triangle_batch, NULL, numBatches);
+
+    /* Append the batches' triangles onto the output stack in input order.*/
+    for (b = 0; b < numBatches; b++)
+    {
+        numProjectedTriangles += BATCH_TRIANGLES[b]->count;
+    }
+
+    kelpoa_generic_stack__grow(screenSpaceTriangles, (screenSpaceTriangles->count + numProjectedTriangles));
+
+    for (b = 0; b < numBatches; b++)
+    {
+        memcpy(&((struct kelpo_polygon_triangle_s*)screenSpaceTriangles->data)[screenSpaceTriangles->count],
+               BATCH_TRIANGLES[b]->data,
+               (BATCH_TRIANGLES[b]->count * sizeof(struct kelpo_polygon_triangle_s)));
+
+        screenSpaceTriangles->count += BATCH_TRIANGLES[b]->count;
+    }
+
+    return;
+}
+
+/* Returns the spans of the given triangles that the given bounding volume
+ * hierarchy finds may be visible in the view frustum of the given matrix,
+ * which takes the hierarchy's space into clip space. The spans are valid until
+ * the next call.*/
+static const struct kelpoa_generic_stack_s* find_visible_spans(const struct kelpoa_generic_stack_s *const bvh,
+                                                               const struct kelpoa_matrix44_s *const clipSpaceMatrix)
+{
+    if (!VISIBLE_SPANS)
+    {
+        VISIBLE_SPANS = kelpoa_generic_stack__create(1, sizeof(struct kelpoa_triangle_bvh_span_s));
+    }
+
+    kelpoa_triangle_bvh__find_visible_spans(bvh, clipSpaceMatrix, VISIBLE_SPANS);
+
+    return VISIBLE_SPANS;
+}
+
+/* A vertex stream is projected by kelpoa_triprepr__project_vertex_stream_to_screen()
+ * in chunks of this many triangles, each chunk through all of the passes before
+ * the next chunk, so that the chunk's vertices stay in the cache between the
+ * passes. A multiple of 4, so that each chunk's component arrays stay aligned
+ * for the stream's SIMD kernels.*/
+#define STREAM_CHUNK_SIZE 1024
+
+/* The clip space copies of the triangles of a vertex stream's chunk that need
+ * clipping, in the order of the triangles. Created on first use, and reused
+ * between chunks.*/
+static struct kelpoa_generic_stack_s *STREAM_CLIPPED_TRIANGLES = NULL;
+
+/* Points 'chunk' at the given range of the given stream's vertices, so that it
+ * can be processed as a stream of its own. The chunk shares the stream's
+ * memory; it mustn't be resized or freed.*/
+static void get_stream_chunk(const struct kelpoa_vertex_stream_s *const stream,
+                             const uint32_t firstVertexIdx,
+                             const uint32_t numVertices,
+                             struct kelpoa_vertex_stream_s *const chunk)
+{
+    chunk->x = (stream->x + firstVertexIdx);
+    chunk->y = (stream->y + firstVertexIdx);
+    chunk->z = (stream->z + firstVertexIdx);
+    chunk->w = (stream->w + firstVertexIdx);
+    chunk->nx = (stream->nx + firstVertexIdx);
+    chunk->ny = (stream->ny + firstVertexIdx);
+    chunk->nz = (stream->nz + firstVertexIdx);
+    chunk->u = (stream->u + firstVertexIdx);
+    chunk->v = (stream->v + firstVertexIdx);
+    chunk->r = (stream->r + firstVertexIdx);
+    chunk->g = (stream->g + firstVertexIdx);
+    chunk->b = (stream->b + firstVertexIdx);
+    chunk->a = (stream->a + firstVertexIdx);
+    chunk->count = numVertices;
+    chunk->capacity = numVertices;
+    chunk->memory = NULL;
+
+    return;
+}
+
+/* Copies the vertices of the given triangle of the given vertex stream, which
+ * holds three vertices per triangle, into 'triangle'. The triangle's texture
+ * and flags aren't touched.*/
+static void get_stream_triangle_vertices(const struct kelpoa_vertex_stream_s *const stream,
+                                         const uint32_t triangleIdx,
+                                         struct kelpo_polygon_triangle_s *const triangle)
+{
+    unsigned k = 0;
+
+    for (k = 0; k < 3; k++)
+    {
+        const uint32_t idx = ((triangleIdx * 3) + k);
+        struct kelpo_polygon_vertex_s *const v = &triangle->vertex[k];
+
+        v->x = stream->x[idx];
+        v->y = stream->y[idx];
+        v->z = stream->z[idx];
+        v->w = stream->w[idx];
+        v->nx = stream->nx[idx];
+        v->ny = stream->ny[idx];
+        v->nz = stream->nz[idx];
+        v->u = stream->u[idx];
+        v->v = stream->v[idx];
+        v->r = stream->r[idx];
+        v->g = stream->g[idx];
+        v->b = stream->b[idx];
+        v->a = stream->a[idx];
+    }
+
+    return;
+}
+
+/* As is_culled_before_projection(), but for the given triangle of the given
+ * world space vertex stream, which holds three vertices per triangle. Only the
+ * vertex components that the culling mode reads are copied out of the stream.*/
+static int is_stream_triangle_culled_before_projection(const struct kelpoa_vertex_stream_s *const stream,
+                                                       const uint32_t triangleIdx,
+                                                       const struct kelpoa_vector3_s *const eye)
+{
+    unsigned k = 0;
+    const unsigned numVertices = ((BACKFACE_CULL_MODE == KELPOA_TRIPREPR_CULL_BY_VERTEX_NORMAL)? 1 : 3);
+    struct kelpo_polygon_triangle_s triangle;
+
+    for (k = 0; k < numVertices; k++)
+    {
+        const uint32_t idx = ((triangleIdx * 3) + k);
+        struct kelpo_polygon_vertex_s *const v = &triangle.vertex[k];
+
+        v->x = stream->x[idx];
+        v->y = stream->y[idx];
+        v->z = stream->z[idx];
+        v->nx = stream->nx[idx];
+        v->ny = stream->ny[idx];
+        v->nz = stream->nz[idx];
+    }
+
+    return is_culled_before_projection(&triangle, NULL, eye);
+}
+
+/* As test_triangle_against_frustum(), but for the given triangle of the given
+ * clip space vertex stream, which holds three vertices per triangle.*/
+static enum frustum_test_e test_stream_triangle_against_frustum(const struct kelpoa_vertex_stream_s *const stream,
+                                                                const uint32_t triangleIdx,
+                                                                unsigned *const clipPlanes)
+{
+    unsigned k = 0;
+    struct kelpo_polygon_triangle_s triangle;
+
+    for (k = 0; k < 3; k++)
+    {
+        const uint32_t idx = ((triangleIdx * 3) + k);
+
+        triangle.vertex[k].x = stream->x[idx];
+        triangle.vertex[k].y = stream->y[idx];
+        triangle.vertex[k].z = stream->z[idx];
+        triangle.vertex[k].w = stream->w[idx];
+    }
+
+    return test_triangle_against_frustum(&triangle, clipPlanes);
+}
+
+void kelpoa_triprepr__set_guard_band(const float guardBand)
+{
+    assert((guardBand >= 1) && "The guard band can't be smaller than the view frustum.");
+
+    GUARD_BAND = guardBand;
+    GUARD_BAND_XY_FACTOR = (1 / guardBand);
+
+    return;
+}
+
+void kelpoa_triprepr__set_backface_cull_mode(const enum kelpoa_triprepr_backface_cull_mode_e mode)
+{
+    BACKFACE_CULL_MODE = mode;
+
+    return;
+}
+
+void kelpoa_triprepr__duplicate_triangles(const struct kelpoa_generic_stack_s *const triangles,
+                                          struct kelpoa_generic_stack_s *const duplicatedTriangles)
+{
+    KELPOA_PROF_BEGIN("kelpoa_triprepr__duplicate_triangles");
+
+    kelpoa_generic_stack__grow(duplicatedTriangles, triangles->count);
+
+    /* The triangle stack stores its data contiguously, so we can just memcpy()
+     * it. Note that this only does a shallow copy.*/
+    memcpy(duplicatedTriangles->data, triangles->data, (sizeof(struct kelpo_polygon_triangle_s) * triangles->count));
+
+    duplicatedTriangles->count = triangles->count;
+
+    KELPOA_PROF_END();
+
+    return;
+}
+
+void kelpoa_triprepr__transform_triangles(struct kelpoa_generic_stack_s *const triangles,
+                                          struct kelpoa_matrix44_s *const matrix)
+{
+    unsigned i = 0;
+
+    KELPOA_PROF_BEGIN("kelpoa_triprepr__transform_triangles");
+
+    for (i = 0; i < triangles->count; i++)
+    {
+        struct kelpo_polygon_triangle_s *const triangle = &((struct kelpo_polygon_triangle_s*)triangles->data)[i];
+
+        transform_vert(&triangle->vertex[0], matrix);
+        transform_vert(&triangle->vertex[1], matrix);
+        transform_vert(&triangle->vertex[2], matrix);
+    }
+
+    KELPOA_PROF_END();
+
+    return;
+}
+
+void kelpoa_triprepr__transform_triangle_normals(struct kelpoa_generic_stack_s *const triangles,
+                                                 struct kelpoa_matrix44_s *const matrix)
+{
+    unsigned i = 0;
+
+    KELPOA_PROF_BEGIN("kelpoa_triprepr__transform_triangle_normals");
+
+    for (i = 0; i < triangles->count; i++)
+    {
+        struct kelpo_polygon_triangle_s *const triangle = &((struct kelpo_polygon_triangle_s*)triangles->data)[i];
+
+        transform_normal(&triangle->vertex[0], matrix);
+        transform_normal(&triangle->vertex[1], matrix);
+        transform_normal(&triangle->vertex[2], matrix);
+    }
+
+    KELPOA_PROF_END();
+
+    return;
+}
+
+void kelpoa_triprepr__rotate_triangles(struct kelpoa_generic_stack_s *const triangles,
+                                       const float x,
+                                       const float y,
+                                       const float z)
+{
+    struct kelpoa_matrix44_s rotationMatrix;
+    
+    KELPOA_PROF_BEGIN("kelpoa_triprepr__rotate_triangles");
+
+    kelpoa_matrix44__make_rotation_matrix(&rotationMatrix, x, y, z);
+
+    kelpoa_triprepr__transform_triangles(triangles, &rotationMatrix);
+    kelpoa_triprepr__transform_triangle_normals(triangles, &rotationMatrix);
+
+    KELPOA_PROF_END();
+
+    return;
+}
+
+void kelpoa_triprepr__translate_triangles(struct kelpoa_generic_stack_s *const triangles,
+                                          const float x,
+                                          const float y,
+                                          const float z)
+{
+    struct kelpoa_matrix44_s translationMatrix;
+    
+    KELPOA_PROF_BEGIN("kelpoa_triprepr__translate_triangles");
+
+    kelpoa_matrix44__make_translation_matrix(&translationMatrix, x, y, z);
+
+    kelpoa_triprepr__transform_triangles(triangles, &translationMatrix);
+
+    KELPOA_PROF_END();
+
+    return;
+}
+
+void kelpoa_triprepr__scale_triangles(struct kelpoa_generic_stack_s *const triangles,
+                                      const float x,
+                                      const float y,
+                                      const float z)
+{
+    struct kelpoa_matrix44_s scalingMatrix;
+    
+    KELPOA_PROF_BEGIN("kelpoa_triprepr__scale_triangles");
+
+    kelpoa_matrix44__make_scaling_matrix(&scalingMatrix, x, y, z);
+
+    kelpoa_triprepr__transform_triangles(triangles, &scalingMatrix);
+
+    KELPOA_PROF_END();
+
+    return;
+}
+
+void kelpoa_triprepr__project_triangles_to_screen(const struct kelpoa_generic_stack_s *const triangles,
+                                                  struct kelpoa_generic_stack_s *const screenSpaceTriangles,
+                                                  const struct kelpoa_matrix44_s *const clipSpaceMatrix,
+                                                  const struct kelpoa_matrix44_s *const screenSpaceMatrix,
+                                                  const float zNear,
+                                                  const float zFar,
+                                                  const int backfaceCull)
+{
+    unsigned i = 0;
+    const struct kelpoa_vector3_s eye = eye_in_model_space(NULL);
+    struct kelpoa_thread_pool_s *threadPool = NULL;
 
-    for (i = 0; i < 3; i++)
+    KELPOA_PROF_BEGIN("kelpoa_triprepr__project_triangles_to_screen");
+
+    if ((triangles->count >= MIN_NUM_PARALLEL_TRIANGLES) &&
+        (threadPool = thread_pool()))
+    {
+        struct kelpoa_triangle_bvh_span_s span;
+
+        span.firstTriangleIdx = 0;
+        span.endTriangleIdx = triangles->count;
+        span.isInsideFrustum = 0;
+
+        begin_projection(triangles, screenSpaceMatrix, zNear, zFar, backfaceCull);
+        add_projection_instance(NULL, clipSpaceMatrix, 0);
+        project_triangles_in_parallel(threadPool, &span, 1, screenSpaceTriangles);
+
+        KELPOA_PROF_END();
+        return;
+    }
+
+    for (i = 0; i < triangles->count; i++)
     {
-        t->vertex[i].x /= t->vertex[i].w;
-        t->vertex[i].y /= t->vertex[i].w;
-        t->vertex[i].w = (1 / t->vertex[i].w);
+        /* A copy, so that the caller's triangles aren't modified.*/
+        struct kelpo_polygon_triangle_s triangle = ((const struct kelpo_polygon_triangle_s*)triangles->data)[i];
+        const int cullBackfacing = (backfaceCull && !triangle.flags.twoSided);
 
-        /* Scale the depth value to the range [0,1].*/
-        t->vertex[i].z = ((t->vertex[i].z - zNear) / (zFar - zNear));
+        if (cullBackfacing &&
+            is_culled_before_projection(&triangle, NULL, &eye))
+        {
+            continue;
+        }
+
+        transform_vert(&triangle.vertex[0], clipSpaceMatrix);
+        transform_vert(&triangle.vertex[1], clipSpaceMatrix);
+        transform_vert(&triangle.vertex[2], clipSpaceMatrix);
+
+        clip_and_emit_triangle(&CLIP_CONTEXT, &triangle, cullBackfacing, 0, screenSpaceTriangles, screenSpaceMatrix, zNear, zFar);
     }
 
+    KELPOA_PROF_END();
+
     return;
 }
 
-void kelpoa_triprepr__duplicate_triangles(const struct kelpoa_generic_stack_s *const triangles,
-                                          struct kelpoa_generic_stack_s *const duplicatedTriangles)
+void kelpoa_triprepr__transform_and_project_triangles(const struct kelpoa_generic_stack_s *const triangles,
+                                                      struct kelpoa_generic_stack_s *const screenSpaceTriangles,
+                                                      const struct kelpoa_bounding_volume_s *const bounds,
+                                                      const struct kelpoa_matrix44_s *const modelMatrix,
+                                                      const struct kelpoa_matrix44_s *const clipSpaceMatrix,
+                                                      const struct kelpoa_matrix44_s *const screenSpaceMatrix,
+                                                      const float zNear,
+                                                      const float zFar,
+                                                      const int backfaceCull)
 {
-    kelpoa_generic_stack__grow(duplicatedTriangles, triangles->count);
+    unsigned i = 0;
+    struct kelpoa_matrix44_s modelClipSpaceMatrix;
+    const struct kelpoa_vector3_s eye = eye_in_model_space(modelMatrix);
+    struct kelpoa_thread_pool_s *threadPool = NULL;
+    enum kelpoa_bounding_volume_frustum_test_e frustumTest = KELPOA_BOUNDING_VOLUME_INTERSECTS_FRUSTUM;
 
-    /* The triangle stack stores its data contiguously, so we can just memcpy()
-     * it. Note that this only does a shallow copy.*/
-    memcpy(duplicatedTriangles->data, triangles->data, (sizeof(struct kelpo_polygon_triangle_s) * triangles->count));
+    KELPOA_PROF_BEGIN("kelpoa_triprepr__transform_and_project_triangles");
 
-    duplicatedTriangles->count = triangles->count;
+    kelpoa_matrix44__multiply_two_matrices(clipSpaceMatrix, modelMatrix, &modelClipSpaceMatrix);
+
+    if (bounds &&
+        ((frustumTest = kelpoa_bounding_volume__test_frustum(bounds, &modelClipSpaceMatrix)) == KELPOA_BOUNDING_VOLUME_OUTSIDE_FRUSTUM))
+    {
+        KELPOA_PROF_END();
+        return;
+    }
+
+    if ((triangles->count >= MIN_NUM_PARALLEL_TRIANGLES) &&
+        (threadPool = thread_pool()))
+    {
+        struct kelpoa_triangle_bvh_span_s span;
+
+        span.firstTriangleIdx = 0;
+        span.endTriangleIdx = triangles->count;
+        span.isInsideFrustum = (frustumTest == KELPOA_BOUNDING_VOLUME_INSIDE_FRUSTUM);
+
+        begin_projection(triangles, screenSpaceMatrix, zNear, zFar, backfaceCull);
+        add_projection_instance(modelMatrix, &modelClipSpaceMatrix, 0);
+        project_triangles_in_parallel(threadPool, &span, 1, screenSpaceTriangles);
+
+        KELPOA_PROF_END();
+        return;
+    }
+
+    for (i = 0; i < triangles->count; i++)
+    {
+        struct kelpo_polygon_triangle_s triangle = ((const struct kelpo_polygon_triangle_s*)triangles->data)[i];
+        const int cullBackfacing = (backfaceCull && !triangle.flags.twoSided);
+
+        if (cullBackfacing &&
+            is_culled_before_projection(&triangle, modelMatrix, &eye))
+        {
+            continue;
+        }
+
+        transform_vert(&triangle.vertex[0], &modelClipSpaceMatrix);
+        transform_vert(&triangle.vertex[1], &modelClipSpaceMatrix);
+        transform_vert(&triangle.vertex[2], &modelClipSpaceMatrix);
+
+        clip_and_emit_triangle(&CLIP_CONTEXT, &triangle, cullBackfacing, (frustumTest == KELPOA_BOUNDING_VOLUME_INSIDE_FRUSTUM),
+                               screenSpaceTriangles, screenSpaceMatrix, zNear, zFar);
+    }
+
+    KELPOA_PROF_END();
 
     return;
 }
 
-void kelpoa_triprepr__transform_triangles(struct kelpoa_generic_stack_s *const triangles,
-                                          struct kelpoa_matrix44_s *const matrix)
+void kelpoa_triprepr__transform_and_project_triangle_instances(const struct kelpoa_generic_stack_s *const triangles,
+                                                               struct kelpoa_generic_stack_s *const screenSpaceTriangles,
+                                                               const struct kelpoa_bounding_volume_s *const bounds,
+                                                               const struct kelpoa_matrix44_s *const modelMatrices,
+                                                               const unsigned numInstances,
+                                                               const struct kelpoa_matrix44_s *const clipSpaceMatrix,
+                                                               const struct kelpoa_matrix44_s *const screenSpaceMatrix,
+                                                               const float zNear,
+                                                               const float zFar,
+                                                               const int backfaceCull)
 {
-    unsigned i = 0;
+    unsigned n = 0;
+    struct kelpoa_triangle_bvh_span_s span;
+    struct kelpoa_thread_pool_s *threadPool = NULL;
 
-    for (i = 0; i < triangles->count; i++)
+    KELPOA_PROF_BEGIN("kelpoa_triprepr__transform_and_project_triangle_instances");
+
+    begin_projection(triangles, screenSpaceMatrix, zNear, zFar, backfaceCull);
+
+    /* Instances outside the view frustum are dropped here, and those inside it
+     * needn't be clipped.*/
+    for (n = 0; n < numInstances; n++)
     {
-        struct kelpo_polygon_triangle_s *const triangle = &((struct kelpo_polygon_triangle_s*)triangles->data)[i];
+        struct kelpoa_matrix44_s modelClipSpaceMatrix;
+        enum kelpoa_bounding_volume_frustum_test_e frustumTest = KELPOA_BOUNDING_VOLUME_INTERSECTS_FRUSTUM;
 
-        transform_vert(&triangle->vertex[0], matrix);
-        transform_vert(&triangle->vertex[1], matrix);
-        transform_vert(&triangle->vertex[2], matrix);
+        kelpoa_matrix44__multiply_two_matrices(clipSpaceMatrix, &modelMatrices[n], &modelClipSpaceMatrix);
+
+        if (bounds &&
+            ((frustumTest = kelpoa_bounding_volume__test_frustum(bounds, &modelClipSpaceMatrix)) == KELPOA_BOUNDING_VOLUME_OUTSIDE_FRUSTUM))
+        {
+            continue;
+        }
+
+        add_projection_instance(&modelMatrices[n], &modelClipSpaceMatrix, (frustumTest == KELPOA_BOUNDING_VOLUME_INSIDE_FRUSTUM));
+    }
+
+    if (!PROJECTION.numInstances)
+    {
+        KELPOA_PROF_END();
+        return;
+    }
+
+    span.firstTriangleIdx = 0;
+    span.endTriangleIdx = triangles->count;
+    span.isInsideFrustum = 0;
+
+    if (((triangles->count * PROJECTION.numInstances) >= MIN_NUM_PARALLEL_TRIANGLES) &&
+        (threadPool = thread_pool()))
+    {
+        project_triangles_in_parallel(threadPool, &span, 1, screenSpaceTriangles);
+    }
+    else
+    {
+        project_triangle_span(&CLIP_CONTEXT, &span, screenSpaceTriangles);
     }
 
+    KELPOA_PROF_END();
+
     return;
 }
 
-void kelpoa_triprepr__transform_triangle_normals(struct kelpoa_generic_stack_s *const triangles,
-                                                 struct kelpoa_matrix44_s *const matrix)
+void kelpoa_triprepr__project_triangle_bvh_to_screen(const struct kelpoa_generic_stack_s *const triangles,
+                                                     const struct kelpoa_generic_stack_s *const bvh,
+                                                     struct kelpoa_generic_stack_s *const screenSpaceTriangles,
+                                                     const struct kelpoa_matrix44_s *const clipSpaceMatrix,
+                                                     const struct kelpoa_matrix44_s *const screenSpaceMatrix,
+                                                     const float zNear,
+                                                     const float zFar,
+                                                     const int backfaceCull)
 {
-    unsigned i = 0;
+    unsigned s = 0;
+    uint32_t numVisibleTriangles = 0;
+    const struct kelpoa_generic_stack_s *const visibleSpans = find_visible_spans(bvh, clipSpaceMatrix);
+    const struct kelpoa_triangle_bvh_span_s *const spans = (struct kelpoa_triangle_bvh_span_s*)visibleSpans->data;
+    struct kelpoa_thread_pool_s *threadPool = NULL;
 
-    for (i = 0; i < triangles->count; i++)
+    KELPOA_PROF_BEGIN("kelpoa_triprepr__project_triangle_bvh_to_screen");
+
+    begin_projection(triangles, screenSpaceMatrix, zNear, zFar, backfaceCull);
+    add_projection_instance(NULL, clipSpaceMatrix, 0);
+
+    for (s = 0; s < visibleSpans->count; s++)
     {
-        struct kelpo_polygon_triangle_s *const triangle = &((struct kelpo_polygon_triangle_s*)triangles->data)[i];
+        numVisibleTriangles += (spans[s].endTriangleIdx - spans[s].firstTriangleIdx);
+    }
 
-        transform_normal(&triangle->vertex[0], matrix);
-        transform_normal(&triangle->vertex[1], matrix);
-        transform_normal(&triangle->vertex[2], matrix);
+    if ((numVisibleTriangles >= MIN_NUM_PARALLEL_TRIANGLES) &&
+        (threadPool = thread_pool()))
+    {
+        project_triangles_in_parallel(threadPool, spans, visibleSpans->count, screenSpaceTriangles);
+    }
+    else
+    {
+        for (s = 0; s < visibleSpans->count; s++)
+        {
+            project_triangle_span(&CLIP_CONTEXT, &spans[s], screenSpaceTriangles);
+        }
     }
 
+    KELPOA_PROF_END();
+
     return;
 }
 
-void kelpoa_triprepr__rotate_triangles(struct kelpoa_generic_stack_s *const triangles,
-                                       const float x,
-                                       const float y,
-                                       const float z)
+void kelpoa_triprepr__project_vertex_stream_to_screen(struct kelpoa_vertex_stream_s *const stream,
+                                                      const struct kelpoa_generic_stack_s *const triangles,
+                                                      struct kelpoa_generic_stack_s *const screenSpaceTriangles,
+                                                      const struct kelpoa_matrix44_s *const clipSpaceMatrix,
+                                                      const struct kelpoa_matrix44_s *const screenSpaceMatrix,
+                                                      const float zNear,
+                                                      const float zFar,
+                                                      const int backfaceCull)
 {
-    struct kelpoa_matrix44_s rotationMatrix;
-    
-    kelpoa_matrix44__make_rotation_matrix(&rotationMatrix, x, y, z);
+    uint32_t chunkIdx = 0;
+    const struct kelpoa_vector3_s eye = eye_in_model_space(NULL);
+    const int cullOnScreen = (BACKFACE_CULL_MODE == KELPOA_TRIPREPR_CULL_BY_SCREEN_AREA);
 
-    kelpoa_triprepr__transform_triangles(triangles, &rotationMatrix);
-    kelpoa_triprepr__transform_triangle_normals(triangles, &rotationMatrix);
+    KELPOA_PROF_BEGIN("kelpoa_triprepr__project_vertex_stream_to_screen");
+
+    assert((stream->count == (triangles->count * 3)) &&
+           "The vertex stream doesn't match the triangles.");
+
+    if (!STREAM_CLIPPED_TRIANGLES)
+    {
+        STREAM_CLIPPED_TRIANGLES = kelpoa_generic_stack__create(1, sizeof(struct kelpo_polygon_triangle_s));
+    }
+
+    for (chunkIdx = 0; chunkIdx < triangles->count; chunkIdx += STREAM_CHUNK_SIZE)
+    {
+        const uint32_t numChunkTriangles = (((chunkIdx + STREAM_CHUNK_SIZE) < triangles->count)
+                                            ? STREAM_CHUNK_SIZE
+                                            : (triangles->count - chunkIdx));
+        const struct kelpo_polygon_triangle_s *const tris = &((const struct kelpo_polygon_triangle_s*)triangles->data)[chunkIdx];
+        uint32_t visible[STREAM_CHUNK_SIZE]; /* The chunk's triangles not culled as backfacing.*/
+        enum frustum_test_e status[STREAM_CHUNK_SIZE]; /* For each visible triangle.*/
+        struct kelpoa_vertex_stream_s chunk;
+        uint32_t numVisible = 0;
+        uint32_t clippedIdx = 0;
+        uint32_t i = 0;
+
+        get_stream_chunk(stream, (chunkIdx * 3), (numChunkTriangles * 3), &chunk);
+        kelpoa_generic_stack__clear(STREAM_CLIPPED_TRIANGLES);
+
+        /* Cull backfacing triangles while the chunk is still in world space.
+         * The passes below visit only the remaining triangles, so that they
+         * don't branch on whether each triangle was culled.*/
+        for (i = 0; i < numChunkTriangles; i++)
+        {
+            const int isCulled = (backfaceCull &&
+                                  !cullOnScreen &&
+                                  !tris[i].flags.twoSided &&
+                                  is_stream_triangle_culled_before_projection(&chunk, i, &eye));
+
+            visible[numVisible] = i;
+            numVisible += !isCulled;
+        }
+
+        /* Test the triangles against the view frustum in clip space, and set
+         * aside the ones to be clipped, since the clipper needs their clip space
+         * vertices.*/
+        kelpoa_vertex_stream__transform(&chunk, clipSpaceMatrix);
+
+        for (i = 0; i < numVisible; i++)
+        {
+            unsigned clipPlanes = 0;
+
+            status[i] = test_stream_triangle_against_frustum(&chunk, visible[i], &clipPlanes);
+
+            if (status[i] == TRIANGLE_NEEDS_CLIPPING)
+            {
+                struct kelpo_polygon_triangle_s triangle = tris[visible[i]];
+
+                get_stream_triangle_vertices(&chunk, visible[i], &triangle);
+                kelpoa_generic_stack__push_copy(STREAM_CLIPPED_TRIANGLES, &triangle);
+            }
+        }
+
+        /* The rest of the triangles need no clipping, so the whole chunk can be
+         * taken into screen space at once.*/
+        kelpoa_vertex_stream__transform(&chunk, screenSpaceMatrix);
+        kelpoa_vertex_stream__perspective_divide(&chunk, zNear, zFar);
+
+        for (i = 0; i < numVisible; i++)
+        {
+            const struct kelpo_polygon_triangle_s *const srcTriangle = &tris[visible[i]];
+            const int cullBackfacing = (backfaceCull && !srcTriangle->flags.twoSided);
+
+            switch (status[i])
+            {
+                case TRIANGLE_TRIVIALLY_ACCEPTED:
+                {
+                    struct kelpo_polygon_triangle_s *const triangle = reserve_triangles(screenSpaceTriangles, 1);
+
+                    get_stream_triangle_vertices(&chunk, visible[i], triangle);
+                    triangle->texture = srcTriangle->texture;
+                    triangle->flags = srcTriangle->flags;
+
+                    if (cullBackfacing &&
+                        cullOnScreen &&
+                        is_backfacing_on_screen(triangle))
+                    {
+                        break;
+                    }
+
+                    screenSpaceTriangles->count++;
+                    break;
+                }
+                case TRIANGLE_NEEDS_CLIPPING:
+                {
+                    struct kelpo_polygon_triangle_s *const triangle = (struct kelpo_polygon_triangle_s*)kelpoa_generic_stack__at(STREAM_CLIPPED_TRIANGLES, clippedIdx++);
+
+                    clip_and_emit_triangle(&CLIP_CONTEXT, triangle, cullBackfacing, 0, screenSpaceTriangles, screenSpaceMatrix, zNear, zFar);
+                    break;
+                }
+                case TRIANGLE_TRIVIALLY_REJECTED: break;
+                default: assert(0 && "Unknown frustum test result."); break;
+            }
+        }
+    }
+
+    KELPOA_PROF_END();
 
     return;
 }
 
-void kelpoa_triprepr__translate_triangles(struct kelpoa_generic_stack_s *const triangles,
+void kelpoa_triprepr__duplicate_indexed_mesh(const struct kelpoa_indexed_mesh_s *const mesh,
+                                             struct kelpoa_indexed_mesh_s *const duplicatedMesh)
+{
+    KELPOA_PROF_BEGIN("kelpoa_triprepr__duplicate_indexed_mesh");
+
+    kelpoa_generic_stack__grow(duplicatedMesh->vertices, mesh->vertices->count);
+    kelpoa_generic_stack__grow(duplicatedMesh->triangles, mesh->triangles->count);
+
+    memcpy(duplicatedMesh->vertices->data, mesh->vertices->data, (sizeof(struct kelpo_polygon_vertex_s) * mesh->vertices->count));
+    memcpy(duplicatedMesh->triangles->data, mesh->triangles->data, (sizeof(struct kelpoa_indexed_triangle_s) * mesh->triangles->count));
+
+    duplicatedMesh->vertices->count = mesh->vertices->count;
+    duplicatedMesh->triangles->count = mesh->triangles->count;
+
+    kelpoa_generic_stack__grow(duplicatedMesh->bvh, mesh->bvh->count);
+    memcpy(duplicatedMesh->bvh->data, mesh->bvh->data, (sizeof(struct kelpoa_triangle_bvh_node_s) * mesh->bvh->count));
+    duplicatedMesh->bvh->count = mesh->bvh->count;
+
+    kelpoa_generic_stack__clear(duplicatedMesh->facePlanes);
+    duplicatedMesh->bounds = mesh->bounds;
+
+    KELPOA_PROF_END();
+
+    return;
+}
+
+void kelpoa_triprepr__transform_indexed_mesh(struct kelpoa_indexed_mesh_s *const mesh,
+                                             struct kelpoa_matrix44_s *const matrix)
+{
+    unsigned i = 0;
+
+    KELPOA_PROF_BEGIN("kelpoa_triprepr__transform_indexed_mesh");
+
+    for (i = 0; i < mesh->vertices->count; i++)
+    {
+        transform_vert(&((struct kelpo_polygon_vertex_s*)mesh->vertices->data)[i], matrix);
+    }
+
+    kelpoa_generic_stack__clear(mesh->facePlanes);
+    kelpoa_bounding_volume__transform(&mesh->bounds, matrix);
+    kelpoa_triangle_bvh__transform(mesh->bvh, matrix);
+
+    KELPOA_PROF_END();
+
+    return;
+}
+
+void kelpoa_triprepr__transform_indexed_mesh_normals(struct kelpoa_indexed_mesh_s *const mesh,
+                                                     struct kelpoa_matrix44_s *const matrix)
+{
+    unsigned i = 0;
+
+    KELPOA_PROF_BEGIN("kelpoa_triprepr__transform_indexed_mesh_normals");
+
+    for (i = 0; i < mesh->vertices->count; i++)
+    {
+        transform_normal(&((struct kelpo_polygon_vertex_s*)mesh->vertices->data)[i], matrix);
+    }
+
+    KELPOA_PROF_END();
+
+    return;
+}
+
+void kelpoa_triprepr__rotate_indexed_mesh(struct kelpoa_indexed_mesh_s *const mesh,
                                           const float x,
                                           const float y,
                                           const float z)
+{
+    struct kelpoa_matrix44_s rotationMatrix;
+
+    KELPOA_PROF_BEGIN("kelpoa_triprepr__rotate_indexed_mesh");
+
+    kelpoa_matrix44__make_rotation_matrix(&rotationMatrix, x, y, z);
+
+    kelpoa_triprepr__transform_indexed_mesh(mesh, &rotationMatrix);
+    kelpoa_triprepr__transform_indexed_mesh_normals(mesh, &rotationMatrix);
+
+    KELPOA_PROF_END();
+
+    return;
+}
+
+void kelpoa_triprepr__translate_indexed_mesh(struct kelpoa_indexed_mesh_s *const mesh,
+                                             const float x,
+                                             const float y,
+                                             const float z)
 {
     struct kelpoa_matrix44_s translationMatrix;
-    
+
+    KELPOA_PROF_BEGIN("kelpoa_triprepr__translate_indexed_mesh");
+
     kelpoa_matrix44__make_translation_matrix(&translationMatrix, x, y, z);
 
-    kelpoa_triprepr__transform_triangles(triangles, &translationMatrix);
+    kelpoa_triprepr__transform_indexed_mesh(mesh, &translationMatrix);
+
+    KELPOA_PROF_END();
 
     return;
 }
 
-void kelpoa_triprepr__scale_triangles(struct kelpoa_generic_stack_s *const triangles,
-                                      const float x,
-                                      const float y,
-                                      const float z)
+void kelpoa_triprepr__scale_indexed_mesh(struct kelpoa_indexed_mesh_s *const mesh,
+                                         const float x,
+                                         const float y,
+                                         const float z)
 {
     struct kelpoa_matrix44_s scalingMatrix;
-    
+
+    KELPOA_PROF_BEGIN("kelpoa_triprepr__scale_indexed_mesh");
+
     kelpoa_matrix44__make_scaling_matrix(&scalingMatrix, x, y, z);
 
-    kelpoa_triprepr__transform_triangles(triangles, &scalingMatrix);
+    kelpoa_triprepr__transform_indexed_mesh(mesh, &scalingMatrix);
+
+    KELPOA_PROF_END();
 
     return;
 }
 
-void kelpoa_triprepr__project_triangles_to_screen(const struct kelpoa_generic_stack_s *const triangles,
-                                                  struct kelpoa_generic_stack_s *const screenSpaceTriangles,
-                                                  const struct kelpoa_matrix44_s *const clipSpaceMatrix,
-                                                  const struct kelpoa_matrix44_s *const screenSpaceMatrix,
-                                                  const float zNear,
-                                                  const float zFar,
-                                                  const int backfaceCull)
+/* Returns the given mesh's face planes, one per triangle, in the same space as
+ * its vertices. They're computed if the mesh doesn't have them yet; functions
+ * that modify the mesh's vertices discard them.*/
+static const struct kelpoa_face_plane_s* update_face_planes(struct kelpoa_indexed_mesh_s *const mesh)
+{
+    if (mesh->facePlanes->count != mesh->triangles->count)
+    {
+        unsigned i = 0;
+        const struct kelpo_polygon_vertex_s *const vertices = (struct kelpo_polygon_vertex_s*)mesh->vertices->data;
+        const struct kelpoa_indexed_triangle_s *const triangles = (struct kelpoa_indexed_triangle_s*)mesh->triangles->data;
+        struct kelpoa_face_plane_s *facePlanes = NULL;
+
+        kelpoa_generic_stack__grow(mesh->facePlanes, mesh->triangles->count);
+        mesh->facePlanes->count = mesh->triangles->count;
+        facePlanes = (struct kelpoa_face_plane_s*)mesh->facePlanes->data;
+
+        for (i = 0; i < mesh->triangles->count; i++)
+        {
+            facePlanes[i] = face_plane(&vertices[triangles[i].vertexIdx[0]],
+                                       &vertices[triangles[i].vertexIdx[1]],
+                                       &vertices[triangles[i].vertexIdx[2]]);
+        }
+    }
+
+    return (struct kelpoa_face_plane_s*)mesh->facePlanes->data;
+}
+
+/* Projects the given indexed mesh into screen space. If 'modelMatrix' is not
+ * NULL, the mesh's vertices are taken to be in model space, and 'clipSpaceMatrix'
+ * to have been pre-multiplied with the model matrix; otherwise, the vertices are
+ * taken to be in world space. The mesh's triangles are culled against the view
+ * frustum by its bounding volume hierarchy if it has one, or else by its
+ * bounding volume.*/
+static void project_indexed_mesh(struct kelpoa_indexed_mesh_s *const mesh,
+                                 struct kelpoa_generic_stack_s *const screenSpaceTriangles,
+                                 const struct kelpoa_matrix44_s *const modelMatrix,
+                                 const struct kelpoa_matrix44_s *const clipSpaceMatrix,
+                                 const struct kelpoa_matrix44_s *const screenSpaceMatrix,
+                                 const float zNear,
+                                 const float zFar,
+                                 const int backfaceCull)
 {
     unsigned i = 0;
+    const struct kelpo_polygon_vertex_s *const vertices = (struct kelpo_polygon_vertex_s*)mesh->vertices->data;
+    const struct kelpoa_face_plane_s *facePlanes = NULL;
+    const struct kelpoa_vector3_s eye = eye_in_model_space(modelMatrix);
+    const struct kelpoa_triangle_bvh_span_s *spans = NULL;
+    unsigned numSpans = 0;
+    unsigned s = 0;
+    struct kelpoa_triangle_bvh_span_s meshSpan;
+    struct kelpoa_projected_vertex_s *projectedVertices = NULL;
 
-    for (i = 0; i < triangles->count; i++)
+    /* Find the ranges of triangles that may be visible. Those outside the view
+     * frustum are skipped, and those inside it needn't be clipped.*/
+    if (mesh->bvh->count)
     {
-        struct kelpo_polygon_triangle_s *const triangle = &((struct kelpo_polygon_triangle_s*)triangles->data)[i];
+        const struct kelpoa_generic_stack_s *const visibleSpans = find_visible_spans(mesh->bvh, clipSpaceMatrix);
 
-        if (backfaceCull &&
-            !triangle->flags.twoSided)
-        {
-            struct kelpoa_vector3_s viewVector;
-            struct kelpoa_vector3_s surfaceNormal;
+        spans = (struct kelpoa_triangle_bvh_span_s*)visibleSpans->data;
+        numSpans = visibleSpans->count;
+    }
+    else
+    {
+        const enum kelpoa_bounding_volume_frustum_test_e meshFrustumTest = ((mesh->bounds.radius < 0)
+                                                                            ? KELPOA_BOUNDING_VOLUME_INTERSECTS_FRUSTUM
+                                                                            : kelpoa_bounding_volume__test_frustum(&mesh->bounds, clipSpaceMatrix));
+
+        meshSpan.firstTriangleIdx = 0;
+        meshSpan.endTriangleIdx = mesh->triangles->count;
+        meshSpan.isInsideFrustum = (meshFrustumTest == KELPOA_BOUNDING_VOLUME_INSIDE_FRUSTUM);
+
+        spans = &meshSpan;
+        numSpans = (meshFrustumTest != KELPOA_BOUNDING_VOLUME_OUTSIDE_FRUSTUM);
+    }
 
-            surfaceNormal.x = triangle->vertex[0].nx;
-            surfaceNormal.y = triangle->vertex[0].ny;
-            surfaceNormal.z = triangle->vertex[0].nz;
+    if (!numSpans)
+    {
+        return;
+    }
+
+    if (backfaceCull &&
+        (BACKFACE_CULL_MODE == KELPOA_TRIPREPR_CULL_BY_FACE_PLANE))
+    {
+        facePlanes = update_face_planes(mesh);
+    }
+
+    /* Vertices are projected on demand, the first time a visible triangle
+     * references them, so that vertices only used by culled triangles aren't
+     * projected at all.*/
+    kelpoa_generic_stack__grow(mesh->projectedVertices, mesh->vertices->count);
+    mesh->projectedVertices->count = mesh->vertices->count;
+    projectedVertices = (struct kelpoa_projected_vertex_s*)mesh->projectedVertices->data;
+
+    for (i = 0; i < mesh->vertices->count; i++)
+    {
+        projectedVertices[i].status = 0;
+    }
 
-            viewVector.x = triangle->vertex[0].x;
-            viewVector.y = triangle->vertex[0].y;
-            viewVector.z = triangle->vertex[0].z;
+    for (s = 0; s < numSpans; s++)
+    {
+        for (i = spans[s].firstTriangleIdx; i < spans[s].endTriangleIdx; i++)
+        {
+            const struct kelpoa_indexed_triangle_s *const triangle = &((struct kelpoa_indexed_triangle_s*)mesh->triangles->data)[i];
+            struct kelpoa_projected_vertex_s *triVerts[3];
+            enum frustum_test_e frustumTest = TRIANGLE_NEEDS_CLIPPING;
+            unsigned clipPlanes = 0;
+            const int cullBackfacing = (backfaceCull && !triangle->flags.twoSided);
 
-            if (kelpoa_vector3__dot(&surfaceNormal, &viewVector) >= 0)
+            if (cullBackfacing &&
+                facePlanes &&
+                is_face_plane_backfacing(&facePlanes[i], &eye))
             {
                 continue;
             }
-        }
+            /* Whether a triangle is backfacing by its vertex normal depends only on
+             * its first vertex, so the result is shared by the triangles that start
+             * at the vertex.*/
+            else if (cullBackfacing &&
+                     (BACKFACE_CULL_MODE == KELPOA_TRIPREPR_CULL_BY_VERTEX_NORMAL))
+            {
+                struct kelpoa_projected_vertex_s *const firstVertex = &projectedVertices[triangle->vertexIdx[0]];
+
+                if (!(firstVertex->status & PROJECTED_VERTEX_FACING_KNOWN))
+                {
+                    const int backfacing = (modelMatrix
+                                            ? is_backfacing_in_model(&vertices[triangle->vertexIdx[0]], modelMatrix)
+                                            : is_backfacing(&vertices[triangle->vertexIdx[0]]));
+
+                    firstVertex->status |= (PROJECTED_VERTEX_FACING_KNOWN | (backfacing? PROJECTED_VERTEX_BACKFACING : 0));
+                }
+
+                if (firstVertex->status & PROJECTED_VERTEX_BACKFACING)
+                {
+                    continue;
+                }
+            }
+
+            triVerts[0] = project_vertex_to_clip_space(&projectedVertices[triangle->vertexIdx[0]], &vertices[triangle->vertexIdx[0]], clipSpaceMatrix);
+            triVerts[1] = project_vertex_to_clip_space(&projectedVertices[triangle->vertexIdx[1]], &vertices[triangle->vertexIdx[1]], clipSpaceMatrix);
+            triVerts[2] = project_vertex_to_clip_space(&projectedVertices[triangle->vertexIdx[2]], &vertices[triangle->vertexIdx[2]], clipSpaceMatrix);
 
-        transform_vert(&triangle->vertex[0], clipSpaceMatrix);
-        transform_vert(&triangle->vertex[1], clipSpaceMatrix);
-        transform_vert(&triangle->vertex[2], clipSpaceMatrix);
-
-        /* Clip the triangle against the viewing frustum, and transform the clippings
-         * into screen space.*/
-        {
-            unsigned k = 0;
-            struct kelpo_polygon_triangle_s *clippedTris;
-            unsigned numClippedTris = 0;
-
-           /* Test the triangle against the view frustum. If all of its vertices are
-            * inside the frustum, the triangle doesn't need to be clipped.*/
-            if ((fabs(triangle->vertex[0].x) <= fabs(triangle->vertex[0].w)) &&
-                (fabs(triangle->vertex[0].y) <= fabs(triangle->vertex[0].w)) &&
-                (fabs(triangle->vertex[0].z) <= fabs(triangle->vertex[0].w)) &&
-                (fabs(triangle->vertex[1].x) <= fabs(triangle->vertex[1].w)) &&
-                (fabs(triangle->vertex[1].y) <= fabs(triangle->vertex[1].w)) &&
-                (fabs(triangle->vertex[1].z) <= fabs(triangle->vertex[1].w)) &&
-                (fabs(triangle->vertex[2].x) <= fabs(triangle->vertex[2].w)) &&
-                (fabs(triangle->vertex[2].y) <= fabs(triangle->vertex[2].w)) &&
-                (fabs(triangle->vertex[2].z) <= fabs(triangle->vertex[2].w)))
+            frustumTest = (spans[s].isInsideFrustum
+                           ? TRIANGLE_TRIVIALLY_ACCEPTED
+                           : test_outcodes_against_frustum(triVerts[0]->frustumOutcode,
+                                                           triVerts[1]->frustumOutcode,
+                                                           triVerts[2]->frustumOutcode,
+                                                           triVerts[0]->guardBandOutcode,
+                                                           triVerts[1]->guardBandOutcode,
+                                                           triVerts[2]->guardBandOutcode,
+                                                           &clipPlanes));
+
+            /* If all of the triangle's vertices are inside the view frustum (or
+             * its guard band), the triangle doesn't need to be clipped, and its
+             * vertices' screen space coordinates can be shared with other triangles.*/
+            if (frustumTest == TRIANGLE_TRIVIALLY_ACCEPTED)
             {
-                clippedTris = triangle;
-                numClippedTris = 1;
+                struct kelpo_polygon_triangle_s screenSpaceTriangle;
+
+                screenSpaceTriangle.vertex[0] = *project_vertex_to_screen_space(triVerts[0], screenSpaceMatrix, zNear, zFar);
+                screenSpaceTriangle.vertex[1] = *project_vertex_to_screen_space(triVerts[1], screenSpaceMatrix, zNear, zFar);
+                screenSpaceTriangle.vertex[2] = *project_vertex_to_screen_space(triVerts[2], screenSpaceMatrix, zNear, zFar);
+                screenSpaceTriangle.texture = triangle->texture;
+                screenSpaceTriangle.flags = triangle->flags;
+
+                if (cullBackfacing &&
+                    (BACKFACE_CULL_MODE == KELPOA_TRIPREPR_CULL_BY_SCREEN_AREA) &&
+                    is_backfacing_on_screen(&screenSpaceTriangle))
+                {
+                    continue;
+                }
+
+                kelpoa_generic_stack__push_copy(screenSpaceTriangles, &screenSpaceTriangle);
             }
-            /* If all of the triangle's vertices are outside of the view
-             * frustum, the triangle is fully invisible and can be ignored.*/
-            else if ((fabs(triangle->vertex[0].x) > fabs(triangle->vertex[0].w)) &&
-                     (fabs(triangle->vertex[0].y) > fabs(triangle->vertex[0].w)) &&
-                     (fabs(triangle->vertex[0].z) > fabs(triangle->vertex[0].w)) &&
-                     (fabs(triangle->vertex[1].x) > fabs(triangle->vertex[1].w)) &&
-                     (fabs(triangle->vertex[1].y) > fabs(triangle->vertex[1].w)) &&
-                     (fabs(triangle->vertex[1].z) > fabs(triangle->vertex[1].w)) &&
-                     (fabs(triangle->vertex[2].x) > fabs(triangle->vertex[2].w)) &&
-                     (fabs(triangle->vertex[2].y) > fabs(triangle->vertex[2].w)) &&
-                     (fabs(triangle->vertex[2].z) > fabs(triangle->vertex[2].w)))
+            /* If all of the triangle's vertices are outside of the same plane of
+             * the view frustum, the triangle is fully invisible and can be ignored.*/
+            else if (frustumTest == TRIANGLE_TRIVIALLY_REJECTED)
             {
                 continue;
             }
             else
             {
-                numClippedTris = kelpoa_triclipr__clip_triangle(triangle, &clippedTris);
-            }
+                struct kelpo_polygon_triangle_s clipSpaceTriangle;
 
-            for (k = 0; k < numClippedTris; k++)
-            {
-                transform_vert(&clippedTris[k].vertex[0], screenSpaceMatrix);
-                transform_vert(&clippedTris[k].vertex[1], screenSpaceMatrix);
-                transform_vert(&clippedTris[k].vertex[2], screenSpaceMatrix);
-                tri_perspective_divide(&clippedTris[k], zNear, zFar);
+                clipSpaceTriangle.vertex[0] = triVerts[0]->clipSpace;
+                clipSpaceTriangle.vertex[1] = triVerts[1]->clipSpace;
+                clipSpaceTriangle.vertex[2] = triVerts[2]->clipSpace;
+                clipSpaceTriangle.texture = triangle->texture;
+                clipSpaceTriangle.flags = triangle->flags;
 
-                kelpoa_generic_stack__push_copy(screenSpaceTriangles, &clippedTris[k]);
+                emit_clipped_triangle(&CLIP_CONTEXT, &clipSpaceTriangle, clipPlanes, cullBackfacing, screenSpaceTriangles, screenSpaceMatrix, zNear, zFar);
             }
         }
     }
 
     return;
 }
+
+void kelpoa_triprepr__project_indexed_mesh_to_screen(struct kelpoa_indexed_mesh_s *const mesh,
+                                                     struct kelpoa_generic_stack_s *const screenSpaceTriangles,
+                                                     const struct kelpoa_matrix44_s *const clipSpaceMatrix,
+                                                     const struct kelpoa_matrix44_s *const screenSpaceMatrix,
+                                                     const float zNear,
+                                                     const float zFar,
+                                                     const int backfaceCull)
+{
+    KELPOA_PROF_BEGIN("kelpoa_triprepr__project_indexed_mesh_to_screen");
+
+    project_indexed_mesh(mesh, screenSpaceTriangles, NULL, clipSpaceMatrix, screenSpaceMatrix, zNear, zFar, backfaceCull);
+
+    KELPOA_PROF_END();
+
+    return;
+}
+
+void kelpoa_triprepr__transform_and_project_indexed_mesh(struct kelpoa_indexed_mesh_s *const mesh,
+                                                         struct kelpoa_generic_stack_s *const screenSpaceTriangles,
+                                                         const struct kelpoa_matrix44_s *const modelMatrix,
+                                                         const struct kelpoa_matrix44_s *const clipSpaceMatrix,
+                                                         const struct kelpoa_matrix44_s *const screenSpaceMatrix,
+                                                         const float zNear,
+                                                         const float zFar,
+                                                         const int backfaceCull)
+{
+    struct kelpoa_matrix44_s modelClipSpaceMatrix;
+
+    KELPOA_PROF_BEGIN("kelpoa_triprepr__transform_and_project_indexed_mesh");
+
+    kelpoa_matrix44__multiply_two_matrices(clipSpaceMatrix, modelMatrix, &modelClipSpaceMatrix);
+
+    project_indexed_mesh(mesh, screenSpaceTriangles, modelMatrix, &modelClipSpaceMatrix, screenSpaceMatrix, zNear, zFar, backfaceCull);
+
+    KELPOA_PROF_END();
+
+    return;
+}
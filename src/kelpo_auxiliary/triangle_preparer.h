@@ -6,8 +6,54 @@
 #ifndef KELPO_AUXILIARY_TRIANGLE_PREPARER_H
 #define KELPO_AUXILIARY_TRIANGLE_PREPARER_H
 
+struct kelpoa_bounding_volume_s;
 struct kelpoa_generic_stack_s;
+struct kelpoa_indexed_mesh_s;
 struct kelpoa_matrix44_s;
+struct kelpoa_vertex_stream_s;
+
+/* Sets the size of the view frustum's guard band, as a multiple of the
+ * frustum's width and height. When projecting triangles onto the screen, a
+ * triangle that crosses the frustum's left, right, top or bottom plane but is
+ * inside the guard band isn't clipped, but is passed on with vertices outside
+ * the screen, leaving it to the rasterizer to discard the off-screen pixels.
+ * Triangles that cross the near or far plane, or the guard band, are clipped
+ * against those planes and the guard band. E.g. 2 lets triangles extend half a
+ * screen beyond each edge. The default, 1, means no guard band: triangles are
+ * clipped to the view frustum.
+ *
+ * Kelpo's software and OpenGL renderers accept off-screen vertices; others may
+ * limit how far off the screen vertices can be, in which case the guard band
+ * should be kept within that limit.*/
+void kelpoa_triprepr__set_guard_band(const float guardBand);
+
+/* Ways of detecting which triangles face away from the camera, for backface
+ * culling; see kelpoa_triprepr__set_backface_cull_mode().*/
+enum kelpoa_triprepr_backface_cull_mode_e
+{
+    /* A triangle faces away if its first vertex's normal does. Needs the
+     * normals to be up to date, and misclassifies triangles whose vertex
+     * normals are smoothed across the surface.*/
+    KELPOA_TRIPREPR_CULL_BY_VERTEX_NORMAL,
+
+    /* A triangle faces away if its signed area on the screen is zero or less,
+     * i.e. if its vertices wind counter-clockwise once projected. Culling
+     * happens after projection, so culled triangles are still transformed (and
+     * clipped).*/
+    KELPOA_TRIPREPR_CULL_BY_SCREEN_AREA,
+
+    /* A triangle faces away if the camera is behind the plane of its vertices,
+     * whose front face is the one from which its vertices appear in clockwise
+     * order. The camera is transformed into the triangles' space, and triangles
+     * are culled before any of their vertices are transformed. Indexed meshes
+     * store their face planes (see indexed_mesh.h).*/
+    KELPOA_TRIPREPR_CULL_BY_FACE_PLANE
+};
+
+/* Sets how the projection functions below detect backfacing triangles when
+ * asked to cull them. Applies to triangles not flagged as two-sided. The default
+ * is KELPOA_TRIPREPR_CULL_BY_VERTEX_NORMAL.*/
+void kelpoa_triprepr__set_backface_cull_mode(const enum kelpoa_triprepr_backface_cull_mode_e mode);
 
 /* Shallowly copies the given triangles into the destination stack. It's
  * expected that triangles' vertices aren't pointers, so that even a shallow
@@ -53,7 +99,13 @@ void kelpoa_triprepr__scale_triangles(struct kelpoa_generic_stack_s *const trian
  * The clipped vertices will be transformed into screen space. Vertices' Z
  * coordinates will be scaled to the range [0,1] relative to the given distances
  * to the near and far planes (these should be the same distance values as what
- * the given clip space matrix was constructed with).*/
+ * the given clip space matrix was constructed with).
+ *
+ * Large stacks of triangles are projected in parallel on a pool of threads,
+ * one per CPU core unless the KELPOA_TRIPREPR_NUM_THREADS environment variable
+ * says otherwise (1 disables threading). The output is the same, and in the
+ * same order, regardless of the number of threads. The triangle preparer's
+ * functions must not be called concurrently.*/
 void kelpoa_triprepr__project_triangles_to_screen(const struct kelpoa_generic_stack_s *const triangles,
                                                   struct kelpoa_generic_stack_s *const screenSpaceTriangles,
                                                   const struct kelpoa_matrix44_s *const clipSpaceMatrix,
@@ -62,4 +114,158 @@ void kelpoa_triprepr__project_triangles_to_screen(const struct kelpoa_generic_st
                                                   const float zFar,
                                                   const int backfaceCull);
 
+/* Transforms the given model space triangles into world space by the given
+ * model matrix, and then projects them as kelpoa_triprepr__project_triangles_to_screen()
+ * does, in a single pass. The model and clip space matrices are pre-multiplied,
+ * and each source triangle is read once and not modified; there's no need for
+ * a world space copy of the triangles. Vertex normals are transformed by the
+ * model matrix's upper 3-by-3 part, so for correct backface culling the matrix
+ * should be a rotation and translation, with at most uniform scaling (e.g. one
+ * made with kelpoa_matrix44__make_model_matrix()). Large stacks of triangles are
+ * processed in parallel, as in kelpoa_triprepr__project_triangles_to_screen().
+ *
+ * If 'bounds' isn't NULL, it's the model space bounding volume of the triangles
+ * (e.g. as given by kelpoa_bounding_volume__of_triangles()), and is first
+ * tested against the view frustum: if it's outside, no triangles are projected;
+ * and if it's inside, the triangles are projected without being tested against
+ * the frustum.*/
+void kelpoa_triprepr__transform_and_project_triangles(const struct kelpoa_generic_stack_s *const triangles,
+                                                      struct kelpoa_generic_stack_s *const screenSpaceTriangles,
+                                                      const struct kelpoa_bounding_volume_s *const bounds,
+                                                      const struct kelpoa_matrix44_s *const modelMatrix,
+                                                      const struct kelpoa_matrix44_s *const clipSpaceMatrix,
+                                                      const struct kelpoa_matrix44_s *const screenSpaceMatrix,
+                                                      const float zNear,
+                                                      const float zFar,
+                                                      const int backfaceCull);
+
+/* As kelpoa_triprepr__transform_and_project_triangles(), but for the given
+ * number of instances of the triangles, each placed by its own model matrix
+ * in the 'modelMatrices' array; e.g. for drawing many copies of a prop. The
+ * source triangles are read in chunks, and each chunk is projected for every
+ * instance before moving on to the next, so that it stays in the cache; and
+ * the triangles needn't be duplicated for any of the instances. Instances whose
+ * bounding volume ('bounds', if not NULL) is outside the view frustum are
+ * skipped.
+ *
+ * The output interleaves the instances: it's ordered by chunk, and within a
+ * chunk by instance. The order is the same regardless of the number of threads,
+ * but isn't that of projecting each instance with a call of its own.*/
+void kelpoa_triprepr__transform_and_project_triangle_instances(const struct kelpoa_generic_stack_s *const triangles,
+                                                               struct kelpoa_generic_stack_s *const screenSpaceTriangles,
+                                                               const struct kelpoa_bounding_volume_s *const bounds,
+                                                               const struct kelpoa_matrix44_s *const modelMatrices,
+                                                               const unsigned numInstances,
+                                                               const struct kelpoa_matrix44_s *const clipSpaceMatrix,
+                                                               const struct kelpoa_matrix44_s *const screenSpaceMatrix,
+                                                               const float zNear,
+                                                               const float zFar,
+                                                               const int backfaceCull);
+
+/* As kelpoa_triprepr__project_triangles_to_screen(), but culls the triangles
+ * against the view frustum by the given bounding volume hierarchy of them (see
+ * triangle_bvh.h), so that triangles in clusters outside the frustum aren't
+ * touched, and those in clusters inside it aren't tested against it. Meant for
+ * static meshes, e.g. level geometry, whose triangles and hierarchy are built
+ * in world space and then left as they are: the triangles are not modified, so
+ * they needn't be duplicated for each frame. The output is in the order of the
+ * triangles, as for kelpoa_triprepr__project_triangles_to_screen().*/
+void kelpoa_triprepr__project_triangle_bvh_to_screen(const struct kelpoa_generic_stack_s *const triangles,
+                                                     const struct kelpoa_generic_stack_s *const bvh,
+                                                     struct kelpoa_generic_stack_s *const screenSpaceTriangles,
+                                                     const struct kelpoa_matrix44_s *const clipSpaceMatrix,
+                                                     const struct kelpoa_matrix44_s *const screenSpaceMatrix,
+                                                     const float zNear,
+                                                     const float zFar,
+                                                     const int backfaceCull);
+
+/* As kelpoa_triprepr__project_triangles_to_screen(), but for triangles whose
+ * world space vertices are in the given vertex stream (see vertex_stream.h),
+ * three per triangle, e.g. as made by kelpoa_vertex_stream__from_triangles()
+ * and then transformed. The given triangles provide the textures and flags,
+ * and their vertices aren't read. The stream's vertices are transformed into
+ * clip space and, after the triangles needing clipping have been copied out,
+ * into screen space in place, with the stream's SIMD kernels; so the stream
+ * won't be in world space afterwards. The triangles are projected on the
+ * calling thread, and the output is the same as that of
+ * kelpoa_triprepr__project_triangles_to_screen().*/
+void kelpoa_triprepr__project_vertex_stream_to_screen(struct kelpoa_vertex_stream_s *const stream,
+                                                      const struct kelpoa_generic_stack_s *const triangles,
+                                                      struct kelpoa_generic_stack_s *const screenSpaceTriangles,
+                                                      const struct kelpoa_matrix44_s *const clipSpaceMatrix,
+                                                      const struct kelpoa_matrix44_s *const screenSpaceMatrix,
+                                                      const float zNear,
+                                                      const float zFar,
+                                                      const int backfaceCull);
+
+/* The following functions are counterparts of the above for indexed meshes
+ * (see indexed_mesh.h). They transform each of the mesh's unique vertices
+ * once, however many triangles share it.*/
+
+/* Copies the given mesh's vertices, triangles, bounding volume and bounding
+ * volume hierarchy into the destination mesh.*/
+void kelpoa_triprepr__duplicate_indexed_mesh(const struct kelpoa_indexed_mesh_s *const mesh,
+                                             struct kelpoa_indexed_mesh_s *const duplicatedMesh);
+
+/* Transforms the given mesh's vertices by the given 4-by-4 matrix. The mesh's
+ * bounding volume and bounding volume hierarchy are transformed along,
+ * conservatively; so the matrix should be affine.*/
+void kelpoa_triprepr__transform_indexed_mesh(struct kelpoa_indexed_mesh_s *const mesh,
+                                             struct kelpoa_matrix44_s *const matrix);
+
+/* Transforms the given mesh's vertex normals by the given 4-by-4 matrix.*/
+void kelpoa_triprepr__transform_indexed_mesh_normals(struct kelpoa_indexed_mesh_s *const mesh,
+                                                     struct kelpoa_matrix44_s *const matrix);
+
+/* Rotates the given mesh's vertices around the origin 0, 0, 0. Expects the
+ * mesh to be in world space.*/
+void kelpoa_triprepr__rotate_indexed_mesh(struct kelpoa_indexed_mesh_s *const mesh,
+                                          const float x,
+                                          const float y,
+                                          const float z);
+
+/* Appends the given XYZ coordinate values to the given mesh's vertex
+ * coordinates. Expects the mesh to be in world space.*/
+void kelpoa_triprepr__translate_indexed_mesh(struct kelpoa_indexed_mesh_s *const mesh,
+                                             const float x,
+                                             const float y,
+                                             const float z);
+
+/* Multiplies the mesh's vertex coordinates by the given XYZ scale values.
+ * Expects the mesh to be in world space.*/
+void kelpoa_triprepr__scale_indexed_mesh(struct kelpoa_indexed_mesh_s *const mesh,
+                                         const float x,
+                                         const float y,
+                                         const float z);
+
+/* As kelpoa_triprepr__project_triangles_to_screen(), but for an indexed mesh.
+ * The mesh's triangles are assembled from its vertices as they're emitted into
+ * 'screenSpaceTriangles', in the same order and with the same results as for
+ * the equivalent non-indexed triangles. A vertex is projected at most once per
+ * call, and not at all if only culled triangles use it. The mesh's vertices
+ * and triangles will not be modified. The mesh's triangles are culled against
+ * the view frustum by its bounding volume hierarchy, as in
+ * kelpoa_triprepr__project_triangle_bvh_to_screen(); or if it has none, by its
+ * bounding volume, as for the 'bounds' argument of
+ * kelpoa_triprepr__transform_and_project_triangles().*/
+void kelpoa_triprepr__project_indexed_mesh_to_screen(struct kelpoa_indexed_mesh_s *const mesh,
+                                                     struct kelpoa_generic_stack_s *const screenSpaceTriangles,
+                                                     const struct kelpoa_matrix44_s *const clipSpaceMatrix,
+                                                     const struct kelpoa_matrix44_s *const screenSpaceMatrix,
+                                                     const float zNear,
+                                                     const float zFar,
+                                                     const int backfaceCull);
+
+/* As kelpoa_triprepr__transform_and_project_triangles(), but for an indexed
+ * mesh. Each vertex is transformed from model space into clip space with a
+ * single matrix multiply, and the mesh needn't be duplicated.*/
+void kelpoa_triprepr__transform_and_project_indexed_mesh(struct kelpoa_indexed_mesh_s *const mesh,
+                                                         struct kelpoa_generic_stack_s *const screenSpaceTriangles,
+                                                         const struct kelpoa_matrix44_s *const modelMatrix,
+                                                         const struct kelpoa_matrix44_s *const clipSpaceMatrix,
+                                                         const struct kelpoa_matrix44_s *const screenSpaceMatrix,
+                                                         const float zNear,
+                                                         const float zFar,
+                                                         const int backfaceCull);
+
 #endif
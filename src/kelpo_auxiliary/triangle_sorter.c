@@ -0,0 +1,324 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * Stable radix sorting of screen space triangles.
+ *
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <kelpo_interface/polygon/triangle/triangle.h>
+#include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/triangle_sorter.h>
+#include <kelpo_auxiliary/profiler.h>
+
+/* Working memory, grown as needed. ORDER holds the indices of the triangles
+ * in the order they're being sorted into, and KEYS the current sort key of
+ * each of them (KEYS[i] is that of triangle ORDER[i]). The scratch arrays are
+ * the destinations of each radix pass.*/
+static uint32_t *ORDER = NULL;
+static uint32_t *KEYS = NULL;
+static uint32_t *SCRATCH_ORDER = NULL;
+static uint32_t *SCRATCH_KEYS = NULL;
+static struct kelpo_polygon_triangle_s *SCRATCH_TRIANGLES = NULL;
+static uint32_t CAPACITY = 0;
+
+static void reserve_working_memory(const uint32_t numTriangles)
+{
+    if (numTriangles > CAPACITY)
+    {
+        ORDER = (uint32_t*)realloc(ORDER, (numTriangles * sizeof(ORDER[0])));
+        KEYS = (uint32_t*)realloc(KEYS, (numTriangles * sizeof(KEYS[0])));
+        SCRATCH_ORDER = (uint32_t*)realloc(SCRATCH_ORDER, (numTriangles * sizeof(SCRATCH_ORDER[0])));
+        SCRATCH_KEYS = (uint32_t*)realloc(SCRATCH_KEYS, (numTriangles * sizeof(SCRATCH_KEYS[0])));
+        SCRATCH_TRIANGLES = (struct kelpo_polygon_triangle_s*)realloc(SCRATCH_TRIANGLES, (numTriangles * sizeof(SCRATCH_TRIANGLES[0])));
+
+        assert((ORDER && KEYS && SCRATCH_ORDER && SCRATCH_KEYS && SCRATCH_TRIANGLES) &&
+               "Failed to allocate memory for sorting triangles.");
+
+        CAPACITY = numTriangles;
+    }
+
+    return;
+}
+
+/* The textures seen by the current sort, each with its rank in the order of
+ * their first appearance: a hash table with open addressing, keyed by the
+ * render API's identifier of the texture ('apiId'), by which the rasterizers
+ * batch triangles. Entries whose stamp isn't the current sort's are empty, so
+ * that the table needn't be cleared between sorts.*/
+struct texture_rank_s
+{
+    uint32_t apiId;
+    uint32_t rank;
+    uint32_t stamp;
+};
+
+static struct texture_rank_s *TEXTURE_RANKS = NULL;
+static uint32_t TEXTURE_RANKS_CAPACITY = 0; /* A power of two.*/
+static uint32_t NUM_TEXTURE_RANKS = 0;
+static uint32_t STAMP = 0;
+
+static struct texture_rank_s* find_texture_rank(const uint32_t apiId)
+{
+    uint32_t idx = ((apiId * 2654435761u) & (TEXTURE_RANKS_CAPACITY - 1));
+
+    while ((TEXTURE_RANKS[idx].stamp == STAMP) &&
+           (TEXTURE_RANKS[idx].apiId != apiId))
+    {
+        idx = ((idx + 1) & (TEXTURE_RANKS_CAPACITY - 1));
+    }
+
+    return &TEXTURE_RANKS[idx];
+}
+
+/* Empties the texture rank table for a new sort.*/
+static void clear_texture_ranks(void)
+{
+    NUM_TEXTURE_RANKS = 0;
+
+    if (!TEXTURE_RANKS)
+    {
+        TEXTURE_RANKS_CAPACITY = 64;
+        TEXTURE_RANKS = (struct texture_rank_s*)calloc(TEXTURE_RANKS_CAPACITY, sizeof(TEXTURE_RANKS[0]));
+        assert(TEXTURE_RANKS && "Failed to allocate memory for sorting triangles.");
+    }
+
+    /* Stamp 0 marks entries that have never been used.*/
+    if (++STAMP == 0)
+    {
+        memset(TEXTURE_RANKS, 0, (TEXTURE_RANKS_CAPACITY * sizeof(TEXTURE_RANKS[0])));
+        STAMP = 1;
+    }
+
+    return;
+}
+
+/* Returns the texture key of the given triangle: the rank of its texture in
+ * the order in which the current sort first saw the textures. Untextured
+ * triangles count as having a texture of their own, as for the rasterizers.*/
+static uint32_t texture_key(const struct kelpo_polygon_triangle_s *const triangle)
+{
+    const uint32_t apiId = (triangle->texture? triangle->texture->apiId : 0);
+    struct texture_rank_s *entry = find_texture_rank(apiId);
+
+    if (entry->stamp == STAMP)
+    {
+        return entry->rank;
+    }
+
+    /* Keep the table at most half full, so that probe sequences stay short.*/
+    if (((NUM_TEXTURE_RANKS + 1) * 2) > TEXTURE_RANKS_CAPACITY)
+    {
+        struct texture_rank_s *const oldRanks = TEXTURE_RANKS;
+        const uint32_t oldCapacity = TEXTURE_RANKS_CAPACITY;
+        uint32_t i = 0;
+
+        TEXTURE_RANKS_CAPACITY *= 2;
+        TEXTURE_RANKS = (struct texture_rank_s*)calloc(TEXTURE_RANKS_CAPACITY, sizeof(TEXTURE_RANKS[0]));
+        assert(TEXTURE_RANKS && "Failed to allocate memory for sorting triangles.");
+
+        for (i = 0; i < oldCapacity; i++)
+        {
+            if (oldRanks[i].stamp == STAMP)
+            {
+                *find_texture_rank(oldRanks[i].apiId) = oldRanks[i];
+            }
+        }
+
+        free(oldRanks);
+
+        entry = find_texture_rank(apiId);
+    }
+
+    entry->apiId = apiId;
+    entry->rank = NUM_TEXTURE_RANKS++;
+    entry->stamp = STAMP;
+
+    return entry->rank;
+}
+
+/* Returns the depth key of the given triangle: the depth of its nearest vertex
+ * (screen space depths increase away from the camera), in a bucket of the
+ * range [0,1] quantized to the given number of bits.*/
+static uint32_t depth_key(const struct kelpo_polygon_triangle_s *const triangle,
+                          const unsigned numBits)
+{
+    const float maxKey = (float)((1ul << numBits) - 1);
+    float depth = triangle->vertex[0].z;
+    unsigned i = 0;
+
+    for (i = 1; i < 3; i++)
+    {
+        if (triangle->vertex[i].z < depth)
+        {
+            depth = triangle->vertex[i].z;
+        }
+    }
+
+    return ((depth <= 0)? 0 : (depth >= 1)? (uint32_t)maxKey : (uint32_t)(depth * maxKey));
+}
+
+/* Stably sorts the first 'numKeys' elements of ORDER by their KEYS, in passes
+ * of one byte of the keys, least significant first. Bytes that all the keys
+ * share need no pass.*/
+static void radix_sort(const uint32_t numKeys)
+{
+    unsigned shift = 0;
+
+    for (shift = 0; shift < 32; shift += 8)
+    {
+        uint32_t offsets[256];
+        uint32_t i = 0;
+        uint32_t offset = 0;
+
+        memset(offsets, 0, sizeof(offsets));
+
+        for (i = 0; i < numKeys; i++)
+        {
+            offsets[(KEYS[i] >> shift) & 0xff]++;
+        }
+
+        if (offsets[(KEYS[0] >> shift) & 0xff] == numKeys)
+        {
+            continue;
+        }
+
+        for (i = 0; i < 256; i++)
+        {
+            const uint32_t count = offsets[i];
+
+            offsets[i] = offset;
+            offset += count;
+        }
+
+        for (i = 0; i < numKeys; i++)
+        {
+            const uint32_t dstIdx = offsets[(KEYS[i] >> shift) & 0xff]++;
+
+            SCRATCH_KEYS[dstIdx] = KEYS[i];
+            SCRATCH_ORDER[dstIdx] = ORDER[i];
+        }
+
+        /* The pass's output is the next pass's input.*/
+        {
+            uint32_t *const keys = KEYS;
+            uint32_t *const order = ORDER;
+
+            KEYS = SCRATCH_KEYS;
+            ORDER = SCRATCH_ORDER;
+            SCRATCH_KEYS = keys;
+            SCRATCH_ORDER = order;
+        }
+    }
+
+    return;
+}
+
+void kelpoa_trisortr__sort(struct kelpoa_generic_stack_s *const triangles,
+                           const unsigned keys)
+{
+    struct kelpo_polygon_triangle_s *const tris = (struct kelpo_polygon_triangle_s*)triangles->data;
+    uint32_t numSortable = 0;
+    uint32_t i = 0;
+    int isReordered = 0;
+
+    if (!keys || (triangles->count < 2))
+    {
+        return;
+    }
+
+    KELPOA_PROF_BEGIN("kelpoa_trisortr__sort");
+
+    reserve_working_memory(triangles->count);
+
+    /* Gather the sortable triangles. If a triangle that mustn't be sorted is
+     * followed by one that may, the latter will move.*/
+    for (i = 0; i < triangles->count; i++)
+    {
+        if (!tris[i].flags.noSort)
+        {
+            isReordered |= (numSortable != i);
+            ORDER[numSortable++] = i;
+        }
+    }
+
+    if (numSortable > 1)
+    {
+        unsigned numDepthBits = 16;
+        int isSorted = 1;
+
+        if (keys & KELPOA_TRISORTR_KEY_TEXTURE)
+        {
+            clear_texture_ranks();
+
+            for (i = 0; i < numSortable; i++)
+            {
+                const struct kelpo_polygon_triangle_s *const triangle = &tris[ORDER[i]];
+
+                /* Consecutive triangles tend to share a texture.*/
+                KEYS[i] = ((i && (triangle->texture == tris[ORDER[i - 1]].texture))
+                           ? KEYS[i - 1]
+                           : texture_key(triangle));
+            }
+
+            /* The texture ranks take the upper bits of the combined key, so
+             * with very many textures, the depths get fewer bits.*/
+            while (numDepthBits && ((NUM_TEXTURE_RANKS - 1) >> (32 - numDepthBits)))
+            {
+                numDepthBits--;
+            }
+        }
+        else
+        {
+            memset(KEYS, 0, (numSortable * sizeof(KEYS[0])));
+        }
+
+        if (keys & KELPOA_TRISORTR_KEY_DEPTH)
+        {
+            for (i = 0; i < numSortable; i++)
+            {
+                KEYS[i] = ((KEYS[i] << numDepthBits) | depth_key(&tris[ORDER[i]], numDepthBits));
+            }
+        }
+
+        /* If e.g. the triangles are already grouped by texture, the texture
+         * ranks are in order.*/
+        for (i = 1; (i < numSortable) && isSorted; i++)
+        {
+            isSorted = (KEYS[i] >= KEYS[i - 1]);
+        }
+
+        if (!isSorted)
+        {
+            radix_sort(numSortable);
+            isReordered = 1;
+        }
+    }
+
+    if (isReordered)
+    {
+        uint32_t numOrdered = numSortable;
+
+        /* Triangles that mustn't be sorted go after the others, as they are.*/
+        for (i = 0; i < triangles->count; i++)
+        {
+            if (tris[i].flags.noSort)
+            {
+                ORDER[numOrdered++] = i;
+            }
+        }
+
+        for (i = 0; i < triangles->count; i++)
+        {
+            SCRATCH_TRIANGLES[i] = tris[ORDER[i]];
+        }
+
+        memcpy(tris, SCRATCH_TRIANGLES, (triangles->count * sizeof(tris[0])));
+    }
+
+    KELPOA_PROF_END();
+
+    return;
+}
@@ -0,0 +1,49 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * Reorders screen space triangles before they're drawn, to reduce the number
+ * of batches a rasterizer breaks them into.
+ *
+ * Kelpo's rasterizers draw consecutive triangles that share a texture as one
+ * batch, and start a new batch (with its draw call and state changes) whenever
+ * the texture changes. Grouping the triangles by texture, e.g. after
+ * kelpoa_triprepr__project_triangles_to_screen() and the like, and before
+ * kelpo_interface_s.rasterizer.draw_triangles(), gives one batch per texture.
+ *
+ * Triangles can also be ordered front to back, so that a rasterizer that tests
+ * depth before shading (e.g. the software rasterizer, or depth-buffered
+ * hardware) can reject more of the pixels of the triangles behind them rather
+ * than shading them over. The two can be combined, in which case the triangles
+ * are grouped by texture and ordered front to back within each group.
+ *
+ * The sort is stable: triangles that compare equal keep their relative order.
+ * Triangles whose order matters - e.g. translucent ones, which are to be drawn
+ * in order over what's behind them - can be flagged with 'noSort' (see
+ * kelpo_polygon_triangle_s), in which case they're moved after the others,
+ * in their original order.
+ *
+ */
+
+#ifndef KELPO_AUXILIARY_TRIANGLE_SORTER_H
+#define KELPO_AUXILIARY_TRIANGLE_SORTER_H
+
+struct kelpoa_generic_stack_s;
+
+/* Bits selecting the keys that kelpoa_trisortr__sort() orders triangles by.*/
+#define KELPOA_TRISORTR_KEY_TEXTURE 0x1 /* Group triangles by texture, in the order of the textures' first appearance.*/
+#define KELPOA_TRISORTR_KEY_DEPTH   0x2 /* Order triangles front to back, by the depth of their nearest vertex.*/
+
+/* Stably sorts the given triangles (struct kelpo_polygon_triangle_s) by the
+ * given keys (KELPOA_TRISORTR_KEY_* bits), with a radix sort. With both keys,
+ * texture is the major key and depth the minor one. Triangles flagged 'noSort'
+ * are placed after the others, in their original order. With no keys, the
+ * triangles are left as they are.
+ *
+ * The triangles are expected to be in screen space, with depth values in the
+ * range [0,1] (as from kelpoa_triprepr__project_triangles_to_screen()). Depths
+ * are compared in 65536 buckets over that range, or fewer if there are very
+ * many textures to also group by.*/
+void kelpoa_trisortr__sort(struct kelpoa_generic_stack_s *const triangles,
+                           const unsigned keys);
+
+#endif
@@ -0,0 +1,139 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * Submits screen space triangles to a renderer in its native vertex format.
+ *
+ */
+
+#include <kelpo_interface/interface.h>
+#include <kelpo_interface/polygon/triangle/triangle.h>
+#include <kelpo_interface/polygon/vertex_buffer.h>
+#include <kelpo_interface/error.h>
+#include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/triangle_submitter.h>
+#include <kelpo_auxiliary/profiler.h>
+
+/* The batches of the current submission. Stack elements will be of type
+ * struct kelpo_vertex_batch_s.*/
+static struct kelpoa_generic_stack_s *BATCHES = NULL;
+
+/* Writes the given vertex into the given memory in the given format.*/
+static void write_vertex(uint8_t *const dst,
+                         const struct kelpo_polygon_vertex_s *const src,
+                         const struct kelpo_vertex_format_s *const format)
+{
+    float *const xy = (float*)(dst + format->xyOffset);
+    float *const uv = (float*)(dst + format->uvOffset);
+    uint8_t *const color = (dst + format->colorOffset);
+    const float uvScale = (format->isUVPremultiplied? (format->uvScale * src->w) : format->uvScale);
+
+    xy[0] = src->x;
+    xy[1] = src->y;
+
+    if (format->zOffset != KELPO_VERTEX_ATTRIBUTE_ABSENT)
+    {
+        *(float*)(dst + format->zOffset) = src->z;
+    }
+
+    *(float*)(dst + format->wOffset) = src->w;
+
+    uv[0] = (src->u * uvScale);
+    uv[1] = (src->v * uvScale);
+
+    if (format->colorOrder == KELPO_VERTEX_COLOR_BGRA)
+    {
+        color[0] = src->b;
+        color[1] = src->g;
+        color[2] = src->r;
+    }
+    else
+    {
+        color[0] = src->r;
+        color[1] = src->g;
+        color[2] = src->b;
+    }
+
+    color[3] = src->a;
+
+    return;
+}
+
+int kelpoa_trisubmr__is_direct(const struct kelpo_interface_s *const renderer)
+{
+    return (renderer->rasterizer.map_vertex_buffer &&
+            renderer->rasterizer.draw_vertex_buffer);
+}
+
+int kelpoa_trisubmr__draw_triangles(const struct kelpo_interface_s *const renderer,
+                                    struct kelpoa_generic_stack_s *const triangles)
+{
+    const struct kelpo_polygon_triangle_s *const tris = (struct kelpo_polygon_triangle_s*)triangles->data;
+    struct kelpo_vertex_format_s format;
+    struct kelpo_vertex_batch_s *batch = NULL;
+    void *mappedVertices = NULL;
+    uint8_t *vertices = NULL;
+    uint32_t i = 0;
+    int isSuccess = 0;
+
+    if (!kelpoa_trisubmr__is_direct(renderer))
+    {
+        return renderer->rasterizer.draw_triangles((struct kelpo_polygon_triangle_s*)triangles->data,
+                                                   triangles->count);
+    }
+
+    if (!triangles->count)
+    {
+        return 1;
+    }
+
+    KELPOA_PROF_BEGIN("kelpoa_trisubmr__draw_triangles");
+
+    if (!BATCHES)
+    {
+        BATCHES = kelpoa_generic_stack__create(16, sizeof(struct kelpo_vertex_batch_s));
+    }
+
+    kelpoa_generic_stack__clear(BATCHES);
+
+    if (!renderer->rasterizer.map_vertex_buffer((3 * triangles->count), &mappedVertices, &format))
+    {
+        kelpo_error(KELPOERR_API_CALL_FAILED);
+        KELPOA_PROF_END();
+        return 0;
+    }
+
+    vertices = (uint8_t*)mappedVertices;
+
+    for (i = 0; i < triangles->count; i++)
+    {
+        const struct kelpo_polygon_triangle_s *const triangle = &tris[i];
+        const uint32_t apiId = (triangle->texture? triangle->texture->apiId : 0);
+
+        /* Consecutive triangles that share a texture are drawn as one batch.*/
+        if (!batch ||
+            (apiId != (batch->texture? batch->texture->apiId : 0)))
+        {
+            struct kelpo_vertex_batch_s newBatch;
+
+            newBatch.firstVertex = (3 * i);
+            newBatch.numVertices = 0;
+            newBatch.texture = triangle->texture;
+
+            kelpoa_generic_stack__push_copy(BATCHES, &newBatch);
+            batch = (struct kelpo_vertex_batch_s*)kelpoa_generic_stack__front(BATCHES);
+        }
+
+        write_vertex(vertices, &triangle->vertex[0], &format);
+        write_vertex((vertices + format.stride), &triangle->vertex[1], &format);
+        write_vertex((vertices + (2 * format.stride)), &triangle->vertex[2], &format);
+        vertices += (3 * format.stride);
+
+        batch->numVertices += 3;
+    }
+
+    isSuccess = renderer->rasterizer.draw_vertex_buffer((struct kelpo_vertex_batch_s*)BATCHES->data, BATCHES->count);
+
+    KELPOA_PROF_END();
+
+    return isSuccess;
+}
@@ -0,0 +1,39 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * Submits screen space triangles to a renderer for drawing, writing their
+ * vertices directly into the renderer's memory in its native vertex format
+ * when the renderer provides for it.
+ *
+ * kelpo_interface_s.rasterizer.draw_triangles() has the renderer copy each of
+ * the triangles' vertices into its own format before it can draw them. With
+ * renderers that provide map_vertex_buffer() and draw_vertex_buffer(), this
+ * module writes the vertices in their final form instead, and batches them by
+ * texture as draw_triangles() would.
+ *
+ * Usage: in place of kelpo_interface_s.rasterizer.draw_triangles(triangles,
+ * numTriangles), call kelpoa_trisubmr__draw_triangles(renderer, triangles),
+ * where 'triangles' is e.g. the output of kelpoa_triprepr__project_triangles_to_screen().
+ *
+ */
+
+#ifndef KELPO_AUXILIARY_TRIANGLE_SUBMITTER_H
+#define KELPO_AUXILIARY_TRIANGLE_SUBMITTER_H
+
+struct kelpo_interface_s;
+struct kelpoa_generic_stack_s;
+
+/* Returns 1 if the given renderer accepts vertices in its native format, i.e.
+ * if kelpoa_trisubmr__draw_triangles() will write them directly into its
+ * memory; 0 if it falls back to the renderer's draw_triangles().*/
+int kelpoa_trisubmr__is_direct(const struct kelpo_interface_s *const renderer);
+
+/* Draws the given screen space triangles (struct kelpo_polygon_triangle_s)
+ * with the given renderer, via its vertex buffer if it has one, or else its
+ * draw_triangles(). Returns 1 on success; 0 on failure, in which case an error
+ * code will have been pushed into Kelpo's error queue (see
+ * kelpo_interface/error.h).*/
+int kelpoa_trisubmr__draw_triangles(const struct kelpo_interface_s *const renderer,
+                                    struct kelpoa_generic_stack_s *const triangles);
+
+#endif
@@ -15,6 +15,7 @@
 #include <string.h>
 #include <kelpo_auxiliary/vertex_lightmapper.h>
 #include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/profiler.h>
 #include <kelpo_interface/polygon/triangle/triangle.h>
 #include <kelpo_auxiliary/vector_3d.h>
 #include <kelpo_interface/stdint.h>
@@ -176,6 +177,8 @@ void kelpoa_vertlit__bake(const struct kelpoa_generic_stack_s *const triangles,
     uint32_t i = 0;
     struct kelpo_polygon_triangle_s *triangle = NULL;
 
+    KELPOA_PROF_BEGIN("kelpoa_vertlit__bake");
+
     /* We'll use vertices' W component as temporary storage for lighting data.*/
     for ((i = 0, triangle = triangles->data); i < triangles->count; (i++, triangle++))
     {
@@ -336,5 +339,7 @@ void kelpoa_vertlit__bake(const struct kelpoa_generic_stack_s *const triangles,
         }
     }
 
+    KELPOA_PROF_END();
+
     return;
 }
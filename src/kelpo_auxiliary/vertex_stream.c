@@ -0,0 +1,385 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * A structure-of-arrays store of vertices.
+ *
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <kelpo_interface/polygon/triangle/triangle.h>
+#include <kelpo_interface/polygon/vertex.h>
+#include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/matrix_44.h>
+#include <kelpo_auxiliary/vertex_stream.h>
+#include <kelpo_auxiliary/vertex_stream_kernels.h>
+#include <kelpo_auxiliary/profiler.h>
+
+/* Rounds the given byte count up to the stream's array alignment.*/
+#define ALIGNED_SIZE(numBytes) ((((numBytes) + KELPOA_VERTEX_STREAM_ALIGNMENT - 1) / KELPOA_VERTEX_STREAM_ALIGNMENT) * KELPOA_VERTEX_STREAM_ALIGNMENT)
+
+/* The number of bytes needed for the component arrays of the given number of
+ * vertices, including slack for aligning the first array.*/
+#define STREAM_MEMORY_SIZE(capacity) ((ALIGNED_SIZE((capacity) * sizeof(float)) * 9) +\
+                                      (ALIGNED_SIZE(capacity) * 4) +\
+                                      KELPOA_VERTEX_STREAM_ALIGNMENT)
+
+/* Whether to use the SIMD kernels: 1 if so, 0 if not, -1 if not yet decided.*/
+static int USE_SIMD = -1;
+
+static int use_simd(void)
+{
+    if (USE_SIMD < 0)
+    {
+        USE_SIMD = (!getenv("KELPOA_NO_SIMD") &&
+                    kelpoa_vertex_stream_sse__is_supported());
+    }
+
+    return USE_SIMD;
+}
+
+/* Points the stream's component arrays into the given block of memory, which
+ * must be STREAM_MEMORY_SIZE(capacity) bytes.*/
+static void assign_arrays(struct kelpoa_vertex_stream_s *const stream,
+                          void *const memory,
+                          const uint32_t capacity)
+{
+    const unsigned long floatArraySize = ALIGNED_SIZE(capacity * sizeof(float));
+    const unsigned long byteArraySize = ALIGNED_SIZE(capacity);
+    unsigned char *p = (unsigned char*)memory;
+
+    p += ((KELPOA_VERTEX_STREAM_ALIGNMENT - ((unsigned long)p % KELPOA_VERTEX_STREAM_ALIGNMENT)) % KELPOA_VERTEX_STREAM_ALIGNMENT);
+
+    stream->x  = (float*)p; p += floatArraySize;
+    stream->y  = (float*)p; p += floatArraySize;
+    stream->z  = (float*)p; p += floatArraySize;
+    stream->w  = (float*)p; p += floatArraySize;
+    stream->nx = (float*)p; p += floatArraySize;
+    stream->ny = (float*)p; p += floatArraySize;
+    stream->nz = (float*)p; p += floatArraySize;
+    stream->u  = (float*)p; p += floatArraySize;
+    stream->v  = (float*)p; p += floatArraySize;
+    stream->r  = p; p += byteArraySize;
+    stream->g  = p; p += byteArraySize;
+    stream->b  = p; p += byteArraySize;
+    stream->a  = p;
+
+    stream->memory = memory;
+    stream->capacity = capacity;
+
+    return;
+}
+
+/* Copies the first 'count' vertices of the source stream into the destination
+ * stream, which must have room for them.*/
+static void copy_vertices(const struct kelpoa_vertex_stream_s *const src,
+                          struct kelpoa_vertex_stream_s *const dst,
+                          const uint32_t count)
+{
+    memcpy(dst->x,  src->x,  (count * sizeof(float)));
+    memcpy(dst->y,  src->y,  (count * sizeof(float)));
+    memcpy(dst->z,  src->z,  (count * sizeof(float)));
+    memcpy(dst->w,  src->w,  (count * sizeof(float)));
+    memcpy(dst->nx, src->nx, (count * sizeof(float)));
+    memcpy(dst->ny, src->ny, (count * sizeof(float)));
+    memcpy(dst->nz, src->nz, (count * sizeof(float)));
+    memcpy(dst->u,  src->u,  (count * sizeof(float)));
+    memcpy(dst->v,  src->v,  (count * sizeof(float)));
+    memcpy(dst->r,  src->r,  count);
+    memcpy(dst->g,  src->g,  count);
+    memcpy(dst->b,  src->b,  count);
+    memcpy(dst->a,  src->a,  count);
+
+    return;
+}
+
+static void set_vertex(struct kelpoa_vertex_stream_s *const stream,
+                       const uint32_t idx,
+                       const struct kelpo_polygon_vertex_s *const vertex)
+{
+    stream->x[idx] = vertex->x;
+    stream->y[idx] = vertex->y;
+    stream->z[idx] = vertex->z;
+    stream->w[idx] = vertex->w;
+    stream->nx[idx] = vertex->nx;
+    stream->ny[idx] = vertex->ny;
+    stream->nz[idx] = vertex->nz;
+    stream->u[idx] = vertex->u;
+    stream->v[idx] = vertex->v;
+    stream->r[idx] = vertex->r;
+    stream->g[idx] = vertex->g;
+    stream->b[idx] = vertex->b;
+    stream->a[idx] = vertex->a;
+
+    return;
+}
+
+static void get_vertex(const struct kelpoa_vertex_stream_s *const stream,
+                       const uint32_t idx,
+                       struct kelpo_polygon_vertex_s *const vertex)
+{
+    vertex->x = stream->x[idx];
+    vertex->y = stream->y[idx];
+    vertex->z = stream->z[idx];
+    vertex->w = stream->w[idx];
+    vertex->nx = stream->nx[idx];
+    vertex->ny = stream->ny[idx];
+    vertex->nz = stream->nz[idx];
+    vertex->u = stream->u[idx];
+    vertex->v = stream->v[idx];
+    vertex->r = stream->r[idx];
+    vertex->g = stream->g[idx];
+    vertex->b = stream->b[idx];
+    vertex->a = stream->a[idx];
+
+    return;
+}
+
+struct kelpoa_vertex_stream_s* kelpoa_vertex_stream__create(const uint32_t initialCapacity)
+{
+    struct kelpoa_vertex_stream_s *newStream = (struct kelpoa_vertex_stream_s*)calloc(1, sizeof(struct kelpoa_vertex_stream_s));
+    void *memory = malloc(STREAM_MEMORY_SIZE(initialCapacity));
+
+    assert((newStream && memory) && "Failed to allocate memory for a new vertex stream.");
+
+    assign_arrays(newStream, memory, initialCapacity);
+    newStream->count = 0;
+
+    return newStream;
+}
+
+void kelpoa_vertex_stream__resize(struct kelpoa_vertex_stream_s *const stream,
+                                  const uint32_t newCount)
+{
+    assert(stream && "Attempting to operate on a NULL vertex stream.");
+
+    if (newCount > stream->capacity)
+    {
+        /* Grow by at least half, so that repeated resizing stays cheap.*/
+        const uint32_t newCapacity = ((newCount > (stream->capacity * 1.5))? newCount : (uint32_t)(stream->capacity * 1.5));
+        struct kelpoa_vertex_stream_s newStream;
+        void *memory = malloc(STREAM_MEMORY_SIZE(newCapacity));
+
+        assert(memory && "Failed to allocate memory to grow the vertex stream.");
+
+        assign_arrays(&newStream, memory, newCapacity);
+        copy_vertices(stream, &newStream, stream->count);
+        free(stream->memory);
+
+        newStream.count = stream->count;
+        *stream = newStream;
+    }
+
+    stream->count = newCount;
+
+    return;
+}
+
+void kelpoa_vertex_stream__copy(const struct kelpoa_vertex_stream_s *const stream,
+                                struct kelpoa_vertex_stream_s *const dstStream)
+{
+    KELPOA_PROF_BEGIN("kelpoa_vertex_stream__copy");
+
+    kelpoa_vertex_stream__resize(dstStream, 0);
+    kelpoa_vertex_stream__resize(dstStream, stream->count);
+    copy_vertices(stream, dstStream, stream->count);
+
+    KELPOA_PROF_END();
+
+    return;
+}
+
+void kelpoa_vertex_stream__from_vertices(struct kelpoa_vertex_stream_s *const stream,
+                                         const struct kelpo_polygon_vertex_s *const vertices,
+                                         const uint32_t numVertices)
+{
+    uint32_t i = 0;
+
+    KELPOA_PROF_BEGIN("kelpoa_vertex_stream__from_vertices");
+
+    kelpoa_vertex_stream__resize(stream, 0);
+    kelpoa_vertex_stream__resize(stream, numVertices);
+
+    for (i = 0; i < numVertices; i++)
+    {
+        set_vertex(stream, i, &vertices[i]);
+    }
+
+    KELPOA_PROF_END();
+
+    return;
+}
+
+void kelpoa_vertex_stream__to_vertices(const struct kelpoa_vertex_stream_s *const stream,
+                                       struct kelpo_polygon_vertex_s *const dstVertices)
+{
+    uint32_t i = 0;
+
+    KELPOA_PROF_BEGIN("kelpoa_vertex_stream__to_vertices");
+
+    for (i = 0; i < stream->count; i++)
+    {
+        get_vertex(stream, i, &dstVertices[i]);
+    }
+
+    KELPOA_PROF_END();
+
+    return;
+}
+
+void kelpoa_vertex_stream__from_triangles(struct kelpoa_vertex_stream_s *const stream,
+                                          const struct kelpoa_generic_stack_s *const triangles)
+{
+    uint32_t i = 0;
+    const struct kelpo_polygon_triangle_s *const tris = (const struct kelpo_polygon_triangle_s*)triangles->data;
+
+    KELPOA_PROF_BEGIN("kelpoa_vertex_stream__from_triangles");
+
+    kelpoa_vertex_stream__resize(stream, 0);
+    kelpoa_vertex_stream__resize(stream, (triangles->count * 3));
+
+    for (i = 0; i < triangles->count; i++)
+    {
+        set_vertex(stream, ((i * 3) + 0), &tris[i].vertex[0]);
+        set_vertex(stream, ((i * 3) + 1), &tris[i].vertex[1]);
+        set_vertex(stream, ((i * 3) + 2), &tris[i].vertex[2]);
+    }
+
+    KELPOA_PROF_END();
+
+    return;
+}
+
+void kelpoa_vertex_stream__to_triangles(const struct kelpoa_vertex_stream_s *const stream,
+                                        struct kelpoa_generic_stack_s *const triangles)
+{
+    uint32_t i = 0;
+    struct kelpo_polygon_triangle_s *const tris = (struct kelpo_polygon_triangle_s*)triangles->data;
+
+    KELPOA_PROF_BEGIN("kelpoa_vertex_stream__to_triangles");
+
+    assert((stream->count == (triangles->count * 3)) &&
+           "The vertex stream doesn't match the triangles.");
+
+    for (i = 0; i < triangles->count; i++)
+    {
+        get_vertex(stream, ((i * 3) + 0), &tris[i].vertex[0]);
+        get_vertex(stream, ((i * 3) + 1), &tris[i].vertex[1]);
+        get_vertex(stream, ((i * 3) + 2), &tris[i].vertex[2]);
+    }
+
+    KELPOA_PROF_END();
+
+    return;
+}
+
+/* The scalar code below uses the same order of operations as the triangle
+ * preparer's transform_vert(), transform_normal() and vert_perspective_divide(),
+ * which the SIMD kernels also follow.*/
+
+void kelpoa_vertex_stream__transform(struct kelpoa_vertex_stream_s *const stream,
+                                     const struct kelpoa_matrix44_s *const matrix)
+{
+    const float *const m = matrix->elements;
+    float *const xs = stream->x;
+    float *const ys = stream->y;
+    float *const zs = stream->z;
+    float *const ws = stream->w;
+    uint32_t i = 0;
+
+    KELPOA_PROF_BEGIN("kelpoa_vertex_stream__transform");
+
+    if (use_simd())
+    {
+        i = kelpoa_vertex_stream_sse__transform(stream, matrix);
+    }
+
+    for (; i < stream->count; i++)
+    {
+        const float x = xs[i];
+        const float y = ys[i];
+        const float z = zs[i];
+        const float w = ws[i];
+
+        xs[i] = ((m[0] * x) + (m[4] * y) + (m[ 8] * z) + (m[12] * w));
+        ys[i] = ((m[1] * x) + (m[5] * y) + (m[ 9] * z) + (m[13] * w));
+        zs[i] = ((m[2] * x) + (m[6] * y) + (m[10] * z) + (m[14] * w));
+        ws[i] = ((m[3] * x) + (m[7] * y) + (m[11] * z) + (m[15] * w));
+    }
+
+    KELPOA_PROF_END();
+
+    return;
+}
+
+void kelpoa_vertex_stream__transform_normals(struct kelpoa_vertex_stream_s *const stream,
+                                             const struct kelpoa_matrix44_s *const matrix)
+{
+    const float *const m = matrix->elements;
+    float *const nxs = stream->nx;
+    float *const nys = stream->ny;
+    float *const nzs = stream->nz;
+    uint32_t i = 0;
+
+    KELPOA_PROF_BEGIN("kelpoa_vertex_stream__transform_normals");
+
+    if (use_simd())
+    {
+        i = kelpoa_vertex_stream_sse__transform_normals(stream, matrix);
+    }
+
+    for (; i < stream->count; i++)
+    {
+        const float x = nxs[i];
+        const float y = nys[i];
+        const float z = nzs[i];
+
+        nxs[i] = ((m[0] * x) + (m[4] * y) + (m[ 8] * z));
+        nys[i] = ((m[1] * x) + (m[5] * y) + (m[ 9] * z));
+        nzs[i] = ((m[2] * x) + (m[6] * y) + (m[10] * z));
+    }
+
+    KELPOA_PROF_END();
+
+    return;
+}
+
+void kelpoa_vertex_stream__perspective_divide(struct kelpoa_vertex_stream_s *const stream,
+                                              const float zNear,
+                                              const float zFar)
+{
+    uint32_t i = 0;
+
+    KELPOA_PROF_BEGIN("kelpoa_vertex_stream__perspective_divide");
+
+    if (use_simd())
+    {
+        i = kelpoa_vertex_stream_sse__perspective_divide(stream, zNear, zFar);
+    }
+
+    for (; i < stream->count; i++)
+    {
+        stream->x[i] /= stream->w[i];
+        stream->y[i] /= stream->w[i];
+        stream->w[i] = (1 / stream->w[i]);
+        stream->z[i] = ((stream->z[i] - zNear) / (zFar - zNear));
+    }
+
+    KELPOA_PROF_END();
+
+    return;
+}
+
+void kelpoa_vertex_stream__free(struct kelpoa_vertex_stream_s *const stream)
+{
+    if (!stream)
+    {
+        return;
+    }
+
+    free(stream->memory);
+    free(stream);
+
+    return;
+}
@@ -0,0 +1,119 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * A structure-of-arrays store of vertices, i.e. one with a separate array for
+ * each vertex component (all X coordinates, then all Y coordinates, etc.), so
+ * that the components of consecutive vertices can be processed several at a
+ * time with SIMD instructions.
+ *
+ * Usage:
+ *
+ *   1. Call __create() to set up a new stream.
+ *
+ *   2. Fill the stream from Kelpo's array-of-structures vertex or triangle data
+ *      with __from_vertices() or __from_triangles().
+ *
+ *   3. Transform the stream's vertices with __transform(), __transform_normals()
+ *      and __perspective_divide(). These use SSE instructions if the CPU
+ *      supports them, and produce the same results as the scalar code of the
+ *      triangle preparer.
+ *
+ *   4. Write the vertices back into array-of-structures form with __to_vertices()
+ *      or __to_triangles(), e.g. for the rasterizer. A stream of world space
+ *      triangle vertices can instead be projected onto the screen directly, with
+ *      kelpoa_triprepr__project_vertex_stream_to_screen() (see triangle_preparer.h).
+ *
+ *   5. To deallocate the stream, call __free(). The stream pointer obtained in
+ *      (1) will no longer be valid.
+ *
+ * Setting the KELPOA_NO_SIMD environment variable forces the scalar code.
+ *
+ */
+
+#ifndef KELPO_AUXILIARY_VERTEX_STREAM_H
+#define KELPO_AUXILIARY_VERTEX_STREAM_H
+
+#include <kelpo_interface/stdint.h>
+
+struct kelpo_polygon_vertex_s;
+struct kelpoa_generic_stack_s;
+struct kelpoa_matrix44_s;
+
+/* The alignment, in bytes, of each of a stream's component arrays.*/
+#define KELPOA_VERTEX_STREAM_ALIGNMENT 16
+
+struct kelpoa_vertex_stream_s
+{
+    /* The number of vertices in the stream.*/
+    uint32_t count;
+
+    /* The number of vertices that the component arrays have room for.*/
+    uint32_t capacity;
+
+    /* The component arrays, as in struct kelpo_polygon_vertex_s. Each array
+     * holds 'count' elements and is aligned to KELPOA_VERTEX_STREAM_ALIGNMENT
+     * bytes.*/
+    float *x, *y, *z, *w;
+    float *nx, *ny, *nz;
+    float *u, *v;
+    uint8_t *r, *g, *b, *a;
+
+    /* The block of memory in which the component arrays reside.*/
+    void *memory;
+};
+
+/* Creates a new stream with no vertices.*/
+struct kelpoa_vertex_stream_s* kelpoa_vertex_stream__create(const uint32_t initialCapacity);
+
+/* Sets the number of vertices in the stream, growing its capacity as needed.
+ * Existing vertices are preserved; new vertices are uninitialized. Growing the
+ * capacity invalidates existing pointers to the component arrays.*/
+void kelpoa_vertex_stream__resize(struct kelpoa_vertex_stream_s *const stream,
+                                  const uint32_t newCount);
+
+/* Copies the given stream's vertices into the destination stream.*/
+void kelpoa_vertex_stream__copy(const struct kelpoa_vertex_stream_s *const stream,
+                                struct kelpoa_vertex_stream_s *const dstStream);
+
+/* Replaces the stream's vertices with the given vertices.*/
+void kelpoa_vertex_stream__from_vertices(struct kelpoa_vertex_stream_s *const stream,
+                                         const struct kelpo_polygon_vertex_s *const vertices,
+                                         const uint32_t numVertices);
+
+/* Writes the stream's vertices into the given array, which must have room for
+ * them.*/
+void kelpoa_vertex_stream__to_vertices(const struct kelpoa_vertex_stream_s *const stream,
+                                       struct kelpo_polygon_vertex_s *const dstVertices);
+
+/* Replaces the stream's vertices with those of the given stack of triangles
+ * (struct kelpo_polygon_triangle_s), three vertices per triangle.*/
+void kelpoa_vertex_stream__from_triangles(struct kelpoa_vertex_stream_s *const stream,
+                                          const struct kelpoa_generic_stack_s *const triangles);
+
+/* Writes the stream's vertices into the vertices of the given stack of triangles,
+ * three vertices per triangle, leaving the triangles' other data (texture, flags)
+ * as they are. The stream must have three vertices for each triangle; e.g. be
+ * made from the triangles with __from_triangles().*/
+void kelpoa_vertex_stream__to_triangles(const struct kelpoa_vertex_stream_s *const stream,
+                                        struct kelpoa_generic_stack_s *const triangles);
+
+/* Transforms the stream's vertex coordinates by the given 4-by-4 matrix.*/
+void kelpoa_vertex_stream__transform(struct kelpoa_vertex_stream_s *const stream,
+                                     const struct kelpoa_matrix44_s *const matrix);
+
+/* Transforms the stream's vertex normals by the given matrix's upper 3-by-3
+ * part.*/
+void kelpoa_vertex_stream__transform_normals(struct kelpoa_vertex_stream_s *const stream,
+                                             const struct kelpoa_matrix44_s *const matrix);
+
+/* Divides the stream's clip space vertex coordinates by W, replaces W with its
+ * reciprocal, and scales Z into the range [0,1] relative to the given distances
+ * to the near and far planes; as the triangle preparer does when projecting
+ * triangles onto the screen.*/
+void kelpoa_vertex_stream__perspective_divide(struct kelpoa_vertex_stream_s *const stream,
+                                              const float zNear,
+                                              const float zFar);
+
+void kelpoa_vertex_stream__free(struct kelpoa_vertex_stream_s *const stream);
+
+#endif
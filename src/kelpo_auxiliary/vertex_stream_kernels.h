@@ -0,0 +1,34 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * SIMD kernels of the vertex stream. Not part of the vertex stream's public
+ * interface.
+ *
+ * Each kernel processes the stream's vertices from index 0 onward in groups of
+ * four, and returns the number of vertices it processed; the caller processes
+ * any remaining vertices with scalar code.
+ *
+ */
+
+#ifndef KELPO_AUXILIARY_VERTEX_STREAM_KERNELS_H
+#define KELPO_AUXILIARY_VERTEX_STREAM_KERNELS_H
+
+#include <kelpo_interface/stdint.h>
+
+struct kelpoa_vertex_stream_s;
+struct kelpoa_matrix44_s;
+
+/* Returns 1 if the CPU supports the SSE kernels; 0 otherwise.*/
+int kelpoa_vertex_stream_sse__is_supported(void);
+
+uint32_t kelpoa_vertex_stream_sse__transform(struct kelpoa_vertex_stream_s *const stream,
+                                             const struct kelpoa_matrix44_s *const matrix);
+
+uint32_t kelpoa_vertex_stream_sse__transform_normals(struct kelpoa_vertex_stream_s *const stream,
+                                                     const struct kelpoa_matrix44_s *const matrix);
+
+uint32_t kelpoa_vertex_stream_sse__perspective_divide(struct kelpoa_vertex_stream_s *const stream,
+                                                      const float zNear,
+                                                      const float zFar);
+
+#endif
@@ -0,0 +1,176 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * SSE kernels of the vertex stream.
+ *
+ * Each kernel processes four vertices at a time, using the same arithmetic as
+ * the scalar loops in vertex_stream.c; so that, where the scalar code is itself
+ * compiled to SSE arithmetic (as on x86-64), the results are identical.
+ *
+ * This file must be compiled with SSE code generation enabled (e.g. -msse);
+ * otherwise, the kernels report themselves as unsupported.
+ *
+ */
+
+#include <kelpo_auxiliary/vertex_stream_kernels.h>
+
+#if defined(__SSE__)
+
+#include <xmmintrin.h>
+#include <kelpo_auxiliary/matrix_44.h>
+#include <kelpo_auxiliary/vertex_stream.h>
+
+#if defined(__GNUC__) && !defined(__x86_64__)
+    #include <cpuid.h>
+#endif
+
+int kelpoa_vertex_stream_sse__is_supported(void)
+{
+    #if defined(__x86_64__)
+        /* SSE is part of the x86-64 baseline.*/
+        return 1;
+    #elif defined(__GNUC__)
+        unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        {
+            return 0;
+        }
+
+        return ((edx & bit_SSE) != 0);
+    #else
+        return 0;
+    #endif
+}
+
+uint32_t kelpoa_vertex_stream_sse__transform(struct kelpoa_vertex_stream_s *const stream,
+                                             const struct kelpoa_matrix44_s *const matrix)
+{
+    const float *const m = matrix->elements;
+    const uint32_t numVectorized = (stream->count & ~3u);
+    uint32_t i = 0;
+    __m128 mv[16];
+
+    for (i = 0; i < 16; i++)
+    {
+        mv[i] = _mm_set1_ps(m[i]);
+    }
+
+    for (i = 0; i < numVectorized; i += 4)
+    {
+        const __m128 x = _mm_load_ps(&stream->x[i]);
+        const __m128 y = _mm_load_ps(&stream->y[i]);
+        const __m128 z = _mm_load_ps(&stream->z[i]);
+        const __m128 w = _mm_load_ps(&stream->w[i]);
+
+        #define TRANSFORM_ROW(row) _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(mv[(row) + 0], x),\
+                                                                  _mm_mul_ps(mv[(row) + 4], y)),\
+                                                       _mm_mul_ps(mv[(row) + 8], z)),\
+                                            _mm_mul_ps(mv[(row) + 12], w))
+
+        _mm_store_ps(&stream->x[i], TRANSFORM_ROW(0));
+        _mm_store_ps(&stream->y[i], TRANSFORM_ROW(1));
+        _mm_store_ps(&stream->z[i], TRANSFORM_ROW(2));
+        _mm_store_ps(&stream->w[i], TRANSFORM_ROW(3));
+
+        #undef TRANSFORM_ROW
+    }
+
+    return numVectorized;
+}
+
+uint32_t kelpoa_vertex_stream_sse__transform_normals(struct kelpoa_vertex_stream_s *const stream,
+                                                     const struct kelpoa_matrix44_s *const matrix)
+{
+    const float *const m = matrix->elements;
+    const uint32_t numVectorized = (stream->count & ~3u);
+    uint32_t i = 0;
+    __m128 mv[11];
+
+    for (i = 0; i < 11; i++)
+    {
+        mv[i] = _mm_set1_ps(m[i]);
+    }
+
+    for (i = 0; i < numVectorized; i += 4)
+    {
+        const __m128 x = _mm_load_ps(&stream->nx[i]);
+        const __m128 y = _mm_load_ps(&stream->ny[i]);
+        const __m128 z = _mm_load_ps(&stream->nz[i]);
+
+        #define TRANSFORM_ROW(row) _mm_add_ps(_mm_add_ps(_mm_mul_ps(mv[(row) + 0], x),\
+                                                       _mm_mul_ps(mv[(row) + 4], y)),\
+                                            _mm_mul_ps(mv[(row) + 8], z))
+
+        _mm_store_ps(&stream->nx[i], TRANSFORM_ROW(0));
+        _mm_store_ps(&stream->ny[i], TRANSFORM_ROW(1));
+        _mm_store_ps(&stream->nz[i], TRANSFORM_ROW(2));
+
+        #undef TRANSFORM_ROW
+    }
+
+    return numVectorized;
+}
+
+uint32_t kelpoa_vertex_stream_sse__perspective_divide(struct kelpoa_vertex_stream_s *const stream,
+                                                      const float zNear,
+                                                      const float zFar)
+{
+    const uint32_t numVectorized = (stream->count & ~3u);
+    const __m128 one = _mm_set1_ps(1);
+    const __m128 nearv = _mm_set1_ps(zNear);
+    const __m128 depthRange = _mm_set1_ps(zFar - zNear);
+    uint32_t i = 0;
+
+    /* Note: true division rather than _mm_rcp_ps(), whose approximation would
+     * make the results differ from the scalar code's.*/
+    for (i = 0; i < numVectorized; i += 4)
+    {
+        const __m128 w = _mm_load_ps(&stream->w[i]);
+
+        _mm_store_ps(&stream->x[i], _mm_div_ps(_mm_load_ps(&stream->x[i]), w));
+        _mm_store_ps(&stream->y[i], _mm_div_ps(_mm_load_ps(&stream->y[i]), w));
+        _mm_store_ps(&stream->w[i], _mm_div_ps(one, w));
+        _mm_store_ps(&stream->z[i], _mm_div_ps(_mm_sub_ps(_mm_load_ps(&stream->z[i]), nearv), depthRange));
+    }
+
+    return numVectorized;
+}
+
+#else
+
+int kelpoa_vertex_stream_sse__is_supported(void)
+{
+    return 0;
+}
+
+uint32_t kelpoa_vertex_stream_sse__transform(struct kelpoa_vertex_stream_s *const stream,
+                                             const struct kelpoa_matrix44_s *const matrix)
+{
+    (void)stream;
+    (void)matrix;
+
+    return 0;
+}
+
+uint32_t kelpoa_vertex_stream_sse__transform_normals(struct kelpoa_vertex_stream_s *const stream,
+                                                     const struct kelpoa_matrix44_s *const matrix)
+{
+    (void)stream;
+    (void)matrix;
+
+    return 0;
+}
+
+uint32_t kelpoa_vertex_stream_sse__perspective_divide(struct kelpoa_vertex_stream_s *const stream,
+                                                      const float zNear,
+                                                      const float zFar)
+{
+    (void)stream;
+    (void)zNear;
+    (void)zFar;
+
+    return 0;
+}
+
+#endif
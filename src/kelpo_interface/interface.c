@@ -1,10 +1,21 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200112L
+#endif
+
 #include <assert.h>
 #include <string.h>
+#include <stdlib.h>
 #include <stdio.h>
 #include <kelpo_interface/interface.h>
 #include <kelpo_interface/error.h>
 
-#include <windows.h>
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <dlfcn.h>
+    #include <dirent.h>
+    #include <unistd.h>
+#endif
 
 typedef void *(*dll_import_fn_t)(struct kelpo_interface_s *const, const unsigned);
 
@@ -12,13 +23,234 @@ typedef void *(*dll_import_fn_t)(struct kelpo_interface_s *const, const unsigned
  * kelpo_create_interface(). Only one interface can be active at a time.*/
 static struct kelpo_interface_s ACTIVE_INTERFACE = {0};
 
+/* Renderers are loaded from DLLs named RENDERER_FILENAME_PREFIX + renderer name
+ * + RENDERER_FILENAME_SUFFIX, located in the renderer directory. The renderer
+ * directory is the one containing the program's executable, unless another is
+ * given via the RENDERER_DIRECTORY_ENV_VAR environment variable. A DLL not found
+ * in the renderer directory is loaded by its bare filename, i.e. from wherever
+ * the system's DLL search order finds it (on Win32, e.g. the working directory
+ * or PATH).*/
+static const char RENDERER_DIRECTORY_ENV_VAR[] = "KELPO_RENDERER_DIRECTORY";
+static const char RENDERER_FILENAME_PREFIX[] = "kelpo_renderer_";
+#if defined(_WIN32)
+    static const char RENDERER_FILENAME_SUFFIX[] = ".dll";
+#else
+    static const char RENDERER_FILENAME_SUFFIX[] = ".so";
+#endif
+
+#define MAX_PATH_LENGTH 1024
+
+#if defined(_WIN32)
+    static HMODULE load_dll(const char *const filename)
+    {
+        return LoadLibraryA(filename);
+    }
+
+    static int free_dll(HMODULE dllHandle)
+    {
+        return (FreeLibrary(dllHandle) != 0);
+    }
+
+    static kelpo_renderer_fn_t find_dll_function(HMODULE dllHandle,
+                                                 const char *const functionName)
+    {
+        return (kelpo_renderer_fn_t)GetProcAddress(dllHandle, functionName);
+    }
+
+    /* Copies the path and filename of the program's executable into 'dst'.
+     * Returns 1 on success; 0 on failure.*/
+    static int get_executable_filename(char *const dst, const unsigned dstSize)
+    {
+        const DWORD length = GetModuleFileNameA(NULL, dst, dstSize);
+
+        return ((length > 0) && (length < dstSize));
+    }
+#else
+    static HMODULE load_dll(const char *const filename)
+    {
+        return dlopen(filename, (RTLD_NOW | RTLD_LOCAL));
+    }
+
+    static int free_dll(HMODULE dllHandle)
+    {
+        return (dlclose(dllHandle) == 0);
+    }
+
+    static kelpo_renderer_fn_t find_dll_function(HMODULE dllHandle,
+                                                 const char *const functionName)
+    {
+        /* ISO C doesn't allow casting dlsym()'s object pointer into a function
+         * pointer, so we'll copy it over instead.*/
+        void *const symbol = dlsym(dllHandle, functionName);
+        kelpo_renderer_fn_t function = NULL;
+
+        assert((sizeof(function) == sizeof(symbol)) &&
+               "Function pointers and object pointers are expected to be the same size.");
+
+        memcpy(&function, &symbol, sizeof(function));
+
+        return function;
+    }
+
+    /* Copies the path and filename of the program's executable into 'dst'.
+     * Returns 1 on success; 0 on failure.*/
+    static int get_executable_filename(char *const dst, const unsigned dstSize)
+    {
+        const ssize_t length = readlink("/proc/self/exe", dst, (dstSize - 1));
+
+        if (length <= 0)
+        {
+            return 0;
+        }
+
+        dst[length] = '\0';
+
+        return 1;
+    }
+#endif
+
+/* Copies the path of the renderer directory, without a trailing path
+ * separator, into 'dst'. Returns 1 on success; 0 on failure.*/
+static int get_renderer_directory(char *const dst, const unsigned dstSize)
+{
+    const char *const envDirectory = getenv(RENDERER_DIRECTORY_ENV_VAR);
+
+    if (envDirectory && *envDirectory)
+    {
+        if (strlen(envDirectory) >= dstSize)
+        {
+            return 0;
+        }
+
+        strcpy(dst, envDirectory);
+    }
+    else if (get_executable_filename(dst, dstSize))
+    {
+        char *const separator = ((strrchr(dst, '\\') > strrchr(dst, '/'))? strrchr(dst, '\\') : strrchr(dst, '/'));
+
+        if (!separator)
+        {
+            strcpy(dst, ".");
+        }
+        else
+        {
+            *separator = '\0';
+        }
+    }
+    else
+    {
+        strcpy(dst, ".");
+    }
+
+    return 1;
+}
+
+/* Returns 1 if the given string can be used as a renderer name; 0 otherwise.
+ * Renderer names are made up of lowercase letters, digits and underscores.*/
+static int is_valid_renderer_name(const char *const rendererName)
+{
+    const char *c = rendererName;
+
+    if (!*rendererName ||
+        (strlen(rendererName) >= sizeof(ACTIVE_INTERFACE.metadata.rendererName)))
+    {
+        return 0;
+    }
+
+    for (c = rendererName; *c; c++)
+    {
+        if (!(((*c >= 'a') && (*c <= 'z')) ||
+              ((*c >= '0') && (*c <= '9')) ||
+              (*c == '_')))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* Copies the filename of the given renderer's DLL into 'dst', preceded by the
+ * path of the renderer directory if 'inRendererDirectory' is set. Returns 1 on
+ * success; 0 on failure.*/
+static int get_renderer_filename(char *const dst,
+                                 const unsigned dstSize,
+                                 const char *const rendererName,
+                                 const int inRendererDirectory)
+{
+    char directory[MAX_PATH_LENGTH];
+
+    if (inRendererDirectory)
+    {
+        /* Leaving room for the path separator.*/
+        if (!get_renderer_directory(directory, (sizeof(directory) - 1)))
+        {
+            return 0;
+        }
+
+        strcat(directory, "/");
+    }
+    else
+    {
+        directory[0] = '\0';
+    }
+
+    if (!is_valid_renderer_name(rendererName) ||
+        ((strlen(directory) + strlen(RENDERER_FILENAME_PREFIX) + strlen(rendererName) + strlen(RENDERER_FILENAME_SUFFIX)) >= dstSize))
+    {
+        return 0;
+    }
+
+    strcpy(dst, directory);
+    strcat(dst, RENDERER_FILENAME_PREFIX);
+    strcat(dst, rendererName);
+    strcat(dst, RENDERER_FILENAME_SUFFIX);
+
+    return 1;
+}
+
+/* If the given filename is that of a renderer DLL, passes the renderer's name
+ * to the given handler function (if not NULL) and returns 1; otherwise, returns
+ * 0.*/
+static int report_renderer_file(const char *const filename,
+                                kelpo_renderer_enumeration_handler_t *const handlerFn)
+{
+    const unsigned prefixLength = strlen(RENDERER_FILENAME_PREFIX);
+    const unsigned suffixLength = strlen(RENDERER_FILENAME_SUFFIX);
+    const unsigned filenameLength = strlen(filename);
+    char rendererName[sizeof(ACTIVE_INTERFACE.metadata.rendererName)];
+
+    if ((filenameLength <= (prefixLength + suffixLength)) ||
+        ((filenameLength - prefixLength - suffixLength) >= sizeof(rendererName)) ||
+        (strncmp(filename, RENDERER_FILENAME_PREFIX, prefixLength) != 0) ||
+        (strcmp(&filename[filenameLength - suffixLength], RENDERER_FILENAME_SUFFIX) != 0))
+    {
+        return 0;
+    }
+
+    memcpy(rendererName, &filename[prefixLength], (filenameLength - prefixLength - suffixLength));
+    rendererName[filenameLength - prefixLength - suffixLength] = '\0';
+
+    if (!is_valid_renderer_name(rendererName))
+    {
+        return 0;
+    }
+
+    if (handlerFn)
+    {
+        handlerFn(rendererName);
+    }
+
+    return 1;
+}
+
 /* Initializes a Kelpo interface for the given renderer, and sets 'dst' to point
  * to that interface. Returns 1 on success; 0 on failure. If the call fails,
  * the dst pointer won't be modified.*/
 int kelpo_create_interface(const struct kelpo_interface_s **dst,
                            const char *const rendererName)
 {
-    const char *dllFilename = NULL;
+    char dllFilename[MAX_PATH_LENGTH];
     dll_import_fn_t get_kelpo_interface = NULL;
 
     /* In case parts of the interface have already been initialized. We want a
@@ -35,20 +267,26 @@ int kelpo_create_interface(const struct kelpo_interface_s **dst,
      * renderer name.*/
     KELPO_COPY_RENDERER_NAME(ACTIVE_INTERFACE.metadata.rendererName, rendererName);
 
-    if      (strcmp(rendererName, "opengl_1_1") == 0) dllFilename = "kelpo_renderer_opengl_1_1.dll";
-    else if (strcmp(rendererName, "opengl_3_0") == 0) dllFilename = "kelpo_renderer_opengl_3_0.dll";
-    else if (strcmp(rendererName, "glide_3")    == 0) dllFilename = "kelpo_renderer_glide_3.dll";
-    else if (strcmp(rendererName, "direct3d_5") == 0) dllFilename = "kelpo_renderer_direct3d_5.dll";
-    else if (strcmp(rendererName, "direct3d_7") == 0) dllFilename = "kelpo_renderer_direct3d_7.dll";
+    /* Any renderer whose DLL is in the renderer directory, or failing that in
+     * the system's DLL search path, can be loaded.*/
+    if (get_renderer_filename(dllFilename, sizeof(dllFilename), rendererName, 1))
+    {
+        ACTIVE_INTERFACE.dllHandle = load_dll(dllFilename);
+    }
 
-    if (!dllFilename ||
-        !(ACTIVE_INTERFACE.dllHandle = LoadLibraryA(dllFilename)))
+    if (!ACTIVE_INTERFACE.dllHandle &&
+        get_renderer_filename(dllFilename, sizeof(dllFilename), rendererName, 0))
+    {
+        ACTIVE_INTERFACE.dllHandle = load_dll(dllFilename);
+    }
+
+    if (!ACTIVE_INTERFACE.dllHandle)
     {
         kelpo_error(KELPOERR_RENDERER_NOT_AVAILABLE);
         return 0;
     }
 
-    get_kelpo_interface = (dll_import_fn_t)GetProcAddress(ACTIVE_INTERFACE.dllHandle, "export_interface");
+    get_kelpo_interface = (dll_import_fn_t)find_dll_function(ACTIVE_INTERFACE.dllHandle, "export_interface");
     assert(get_kelpo_interface && "Malformed renderer DLL; required export not found.");
 
     if (!get_kelpo_interface(&ACTIVE_INTERFACE, KELPO_INTERFACE_VERSION_MAJOR))
@@ -102,7 +340,7 @@ int kelpo_release_interface(const struct kelpo_interface_s *const kelpoInterface
     }
     
     if (kelpoInterface->dllHandle &&
-        !FreeLibrary(ACTIVE_INTERFACE.dllHandle))
+        !free_dll(ACTIVE_INTERFACE.dllHandle))
     {
         kelpo_error(KELPOERR_API_CALL_FAILED);
         return 0;
@@ -119,3 +357,84 @@ const char* kelpo_active_renderer_name(void)
            ? ACTIVE_INTERFACE.metadata.rendererName
            : "No active renderer";
 }
+
+/* Calls the given handler function with the name of each renderer whose DLL is
+ * in the renderer directory. Returns the number of renderers found. The handler
+ * function can be NULL, e.g. if only the number of renderers is needed.*/
+unsigned kelpo_enumerate_renderers(kelpo_renderer_enumeration_handler_t *const handlerFn)
+{
+    char directory[MAX_PATH_LENGTH];
+    unsigned numRenderers = 0;
+
+    if (!get_renderer_directory(directory, sizeof(directory)))
+    {
+        return 0;
+    }
+
+    #if defined(_WIN32)
+    {
+        char searchPattern[MAX_PATH_LENGTH];
+        WIN32_FIND_DATAA findData;
+        HANDLE findHandle = INVALID_HANDLE_VALUE;
+
+        if ((strlen(directory) + 2 + strlen(RENDERER_FILENAME_PREFIX) + strlen(RENDERER_FILENAME_SUFFIX)) >= sizeof(searchPattern))
+        {
+            return 0;
+        }
+
+        strcpy(searchPattern, directory);
+        strcat(searchPattern, "/");
+        strcat(searchPattern, RENDERER_FILENAME_PREFIX);
+        strcat(searchPattern, "*");
+        strcat(searchPattern, RENDERER_FILENAME_SUFFIX);
+
+        if ((findHandle = FindFirstFileA(searchPattern, &findData)) == INVALID_HANDLE_VALUE)
+        {
+            return 0;
+        }
+
+        do
+        {
+            numRenderers += report_renderer_file(findData.cFileName, handlerFn);
+        } while (FindNextFileA(findHandle, &findData));
+
+        FindClose(findHandle);
+    }
+    #else
+    {
+        DIR *const dir = opendir(directory);
+        const struct dirent *entry = NULL;
+
+        if (!dir)
+        {
+            return 0;
+        }
+
+        while ((entry = readdir(dir)))
+        {
+            numRenderers += report_renderer_file(entry->d_name, handlerFn);
+        }
+
+        closedir(dir);
+    }
+    #endif
+
+    return numRenderers;
+}
+
+/* Returns a pointer to the given function exported by the DLL from which the
+ * given interface was loaded; or NULL if there's no such function. Renderers
+ * can provide functionality beyond the interface this way, e.g. the null
+ * renderer's kelpo_rasterizer_null__counters(). The pointer must be cast into
+ * the function's actual type before calling.*/
+kelpo_renderer_fn_t kelpo_renderer_function(const struct kelpo_interface_s *const kelpoInterface,
+                                            const char *const functionName)
+{
+    if (!kelpoInterface ||
+        !kelpoInterface->dllHandle)
+    {
+        return NULL;
+    }
+
+    return find_dll_function(kelpoInterface->dllHandle, functionName);
+}
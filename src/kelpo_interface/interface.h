@@ -3,10 +3,23 @@
 
 #include <string.h>
 #include <kelpo_interface/stdint.h>
-#include <windef.h>
+
+#if defined(_WIN32)
+    #include <windef.h>
+#else
+    /* Stand-ins for the Win32 types used in the interface, so that clients and
+     * renderers that don't open an OS window can be built for other platforms.
+     * No window messages are sent on these platforms.*/
+    typedef void* HMODULE;
+    typedef void* HWND;
+    typedef unsigned UINT;
+    typedef unsigned long WPARAM;
+    typedef long LPARAM;
+    typedef long LRESULT;
+#endif
 
 #define KELPO_INTERFACE_VERSION_MAJOR 0 /* Starting from version 1, bumped when introducing breaking interface changes.*/
-#define KELPO_INTERFACE_VERSION_MINOR 9 /* Bumped (or not) when such new functionality is added that doesn't break compatibility with existing implementations of current major version.*/
+#define KELPO_INTERFACE_VERSION_MINOR 10 /* Bumped (or not) when such new functionality is added that doesn't break compatibility with existing implementations of current major version.*/
 #define KELPO_INTERFACE_VERSION_PATCH 0 /* Bumped (or not) on minor bug fixes etc.*/
 
 /* Utility function for renderers. Copies the renderer name (src) into an
@@ -22,13 +35,23 @@
 /* A user-provided function that will receive the renderer window's messages.*/
 typedef LRESULT kelpo_custom_window_message_handler_t(HWND windowHandle, UINT message, WPARAM wParam, LPARAM lParam);
 
+/* A user-provided function that will receive the names of the available
+ * renderers; see kelpo_enumerate_renderers().*/
+typedef void kelpo_renderer_enumeration_handler_t(const char *const rendererName);
+
+/* A generic function pointer, as returned by kelpo_renderer_function(). To be
+ * cast into the function's actual type before calling.*/
+typedef void (*kelpo_renderer_fn_t)(void);
+
 struct kelpo_polygon_triangle_s;
 struct kelpo_polygon_texture_s;
+struct kelpo_vertex_format_s;
+struct kelpo_vertex_batch_s;
 
 struct kelpo_interface_s
 {
     /* A handle to the DLL file from which this interface was loaded, as
-       returned by LoadLibraryA().*/
+       returned by LoadLibraryA() on Win32 or by dlopen() elsewhere.*/
     HMODULE dllHandle;
 
     struct kelpo_interface_window_s
@@ -68,6 +91,23 @@ struct kelpo_interface_s
         int (*draw_triangles)(struct kelpo_polygon_triangle_s *const triangles,
                               const unsigned numTriangles);
 
+        /* Optional; NULL if the renderer doesn't provide them. For drawing
+         * vertices that the client writes directly into the renderer's memory
+         * in the renderer's native format, sparing the renderer from copying
+         * and converting them as draw_triangles() does.
+         *
+         * map_vertex_buffer() points 'vertices' at room for the given number
+         * of vertices, and describes their format in 'format'. The memory
+         * stays valid until draw_vertex_buffer() is called, which draws the
+         * given batches of the vertices as triangle lists, in order. See also
+         * kelpo_auxiliary/triangle_submitter.h.*/
+        int (*map_vertex_buffer)(const unsigned numVertices,
+                                 void **const vertices,
+                                 struct kelpo_vertex_format_s *const format);
+
+        int (*draw_vertex_buffer)(const struct kelpo_vertex_batch_s *const batches,
+                                  const unsigned numBatches);
+
         /*release*/
 
         /*framebuffer*/
@@ -89,4 +129,9 @@ int kelpo_release_interface(const struct kelpo_interface_s *const kelpoInterface
 
 const char* kelpo_active_renderer_name(void);
 
+unsigned kelpo_enumerate_renderers(kelpo_renderer_enumeration_handler_t *const handlerFn);
+
+kelpo_renderer_fn_t kelpo_renderer_function(const struct kelpo_interface_s *const kelpoInterface,
+                                            const char *const functionName);
+
 #endif
@@ -16,6 +16,7 @@ struct kelpo_polygon_triangle_s
         unsigned wireframe : 1;     /* Render triangle with... 0 = no wireframe, 1 = wireframe   */
         unsigned ignore : 1;        /* Triangle should... 0 = not be rendered, 1 = be rendered   */
         unsigned twoSided : 1;      /* Backface culling... 0 = on, 1 = off                       */
+        unsigned noSort : 1;        /* Sorting... 0 = may be reordered, 1 = kept in order        */
     } flags;
 };
 
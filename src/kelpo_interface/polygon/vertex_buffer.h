@@ -0,0 +1,52 @@
+#ifndef KELPO_INTERFACE_POLYGON_VERTEX_BUFFER_H
+#define KELPO_INTERFACE_POLYGON_VERTEX_BUFFER_H
+
+#include <kelpo_interface/polygon/texture.h>
+
+/* A vertex format's offset for an attribute that the format doesn't store.*/
+#define KELPO_VERTEX_ATTRIBUTE_ABSENT -1
+
+/* The byte orders in which a vertex format stores the color channels.*/
+#define KELPO_VERTEX_COLOR_RGBA 0
+#define KELPO_VERTEX_COLOR_BGRA 1
+
+/* Describes the layout of a renderer's native screen space vertex, as returned
+ * by kelpo_interface_s.rasterizer.map_vertex_buffer(), so that clients can
+ * write the fields of struct kelpo_polygon_vertex_s directly into it. The
+ * offsets are in bytes from the start of the vertex, and each is a multiple
+ * of 4.*/
+struct kelpo_vertex_format_s
+{
+    /* The size of a vertex, in bytes.*/
+    unsigned stride;
+
+    /* Where the vertex's screen coordinates are stored: x and y as two
+     * consecutive floats, the depth value z as a float, and w (which after
+     * the perspective divide is 1/w) as a float. The depth value may be
+     * absent.*/
+    int xyOffset;
+    int zOffset;
+    int wOffset;
+
+    /* Where the texture coordinates are stored, as two consecutive floats u
+     * and v; multiplied by 'uvScale', and if 'isUVPremultiplied', by w.*/
+    int uvOffset;
+    float uvScale;
+    unsigned isUVPremultiplied;
+
+    /* Where the color is stored, as four bytes, in 'colorOrder' (one of the
+     * KELPO_VERTEX_COLOR_* orders).*/
+    int colorOffset;
+    unsigned colorOrder;
+};
+
+/* A range of vertices in a mapped vertex buffer, to be drawn as a list of
+ * triangles with the given texture (or untextured if NULL).*/
+struct kelpo_vertex_batch_s
+{
+    unsigned firstVertex;
+    unsigned numVertices;
+    struct kelpo_polygon_texture_s *texture;
+};
+
+#endif
@@ -13,6 +13,7 @@
 #include <stdio.h>
 #include <math.h>
 #include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/profiler.h>
 #include <kelpo_renderer/surface/directdraw_7/create_directdraw_7_surface_from_texture.h>
 #include <kelpo_renderer/surface/direct3d_7/surface_direct3d_7.h>
 #include <kelpo_renderer/rasterizer/direct3d_7/rasterizer_direct3d_7.h>
@@ -270,6 +271,8 @@ int kelpo_rasterizer_direct3d_7__draw_triangles(struct kelpo_polygon_triangle_s
     unsigned numTrianglesInBatch = 0;
     const struct kelpo_polygon_triangle_s *triangle = triangles;
 
+    KELPOA_PROF_BEGIN("kelpo_rasterizer_direct3d_7__draw_triangles");
+
     if ((3 * numTriangles) > D3D7_VERTEX_CACHE->capacity)
     {
         kelpoa_generic_stack__grow(D3D7_VERTEX_CACHE, (3 * numTriangles));
@@ -279,6 +282,7 @@ int kelpo_rasterizer_direct3d_7__draw_triangles(struct kelpo_polygon_triangle_s
     {
         fprintf(stderr, "Direct3D error 0x%x\n", hr);
         kelpo_error(KELPOERR_API_CALL_FAILED);
+        KELPOA_PROF_END();
         return 0;
     }
 
@@ -379,8 +383,10 @@ int kelpo_rasterizer_direct3d_7__draw_triangles(struct kelpo_polygon_triangle_s
     {
         fprintf(stderr, "Direct3D error 0x%x\n", hr);
         kelpo_error(KELPOERR_API_CALL_FAILED);
+        KELPOA_PROF_END();
         return 0;
     }
     
+    KELPOA_PROF_END();
     return 1;
 }
@@ -13,6 +13,7 @@
 #include <kelpo_interface/polygon/triangle/triangle.h>
 #include <kelpo_interface/polygon/texture.h>
 #include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/profiler.h>
 #include <kelpo_interface/error.h>
 
 #include <glide/glide.h>
@@ -228,6 +229,8 @@ int kelpo_rasterizer_glide_3__draw_triangles(struct kelpo_polygon_triangle_s *co
     unsigned numTrianglesInBatch = 0;
     const struct kelpo_polygon_triangle_s *triangle = triangles;
 
+    KELPOA_PROF_BEGIN("kelpo_rasterizer_glide_3__draw_triangles");
+
     if ((3 * numTriangles) > GR3_VERTEX_CACHE->capacity)
     {
         kelpoa_generic_stack__grow(GR3_VERTEX_CACHE, (3 * numTriangles));
@@ -336,5 +339,6 @@ int kelpo_rasterizer_glide_3__draw_triangles(struct kelpo_polygon_triangle_s *co
         triangle++;
     }
 
+    KELPOA_PROF_END();
     return 1;
 }
@@ -0,0 +1,200 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * Null rasterizer for the Kelpo renderer.
+ *
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#include <kelpo_renderer/rasterizer/null/rasterizer_null.h>
+#include <kelpo_interface/polygon/triangle/triangle.h>
+#include <kelpo_interface/polygon/vertex_buffer.h>
+#include <kelpo_interface/polygon/texture.h>
+#include <kelpo_interface/stdint.h>
+#include <kelpo_interface/error.h>
+#include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/profiler.h>
+
+static struct kelpo_rasterizer_null_counters_s COUNTERS;
+
+/* The memory returned by map_vertex_buffer(). Stack elements will be of type
+ * struct null_vertex_s.*/
+static struct kelpoa_generic_stack_s *VERTEX_BUFFER = NULL;
+
+/* The native vertex format, as a hardware rasterizer might have it.*/
+struct null_vertex_s
+{
+    float x, y, z, w;
+    float u, v;
+    uint8_t r, g, b, a;
+};
+
+/* The number of textures uploaded since the last call to unload_textures().
+ * Used to give each uploaded texture a unique, non-zero 'apiId'.*/
+static uint32_t NUM_UPLOADED_TEXTURES = 0;
+
+/* Returns the size, in bytes, of the given texture's pixel data across all of
+ * its mip levels.*/
+static unsigned long texture_byte_size(const struct kelpo_polygon_texture_s *const texture)
+{
+    unsigned m = 0;
+    unsigned long byteSize = 0;
+    const unsigned numMipLevels = (texture->numMipLevels? texture->numMipLevels : 1);
+
+    for (m = 0; m < numMipLevels; m++)
+    {
+        const unsigned long mipLevelSideLength = (texture->width >> m);
+
+        byteSize += (mipLevelSideLength * mipLevelSideLength * sizeof(texture->mipLevel[0][0]));
+    }
+
+    return byteSize;
+}
+
+int kelpo_rasterizer_null__initialize(void)
+{
+    memset(&COUNTERS, 0, sizeof(COUNTERS));
+    NUM_UPLOADED_TEXTURES = 0;
+
+    VERTEX_BUFFER = kelpoa_generic_stack__create(1000, sizeof(struct null_vertex_s));
+
+    return 1;
+}
+
+int kelpo_rasterizer_null__release(void)
+{
+    kelpoa_generic_stack__free(VERTEX_BUFFER);
+    VERTEX_BUFFER = NULL;
+
+    return 1;
+}
+
+const struct kelpo_rasterizer_null_counters_s* kelpo_rasterizer_null__counters(void)
+{
+    return &COUNTERS;
+}
+
+int kelpo_rasterizer_null__clear_frame(void)
+{
+    COUNTERS.numFrameClears++;
+
+    return 1;
+}
+
+int kelpo_rasterizer_null__upload_texture(struct kelpo_polygon_texture_s *const texture)
+{
+    assert(texture && "Attempting to upload a NULL texture.");
+
+    assert(!texture->apiId &&
+           "This texture has already been registered. Use update_texture() instead.");
+
+    texture->apiId = ++NUM_UPLOADED_TEXTURES;
+
+    COUNTERS.numTextureUploads++;
+    COUNTERS.numTextureBytes += texture_byte_size(texture);
+
+    return 1;
+}
+
+int kelpo_rasterizer_null__update_texture(struct kelpo_polygon_texture_s *const texture)
+{
+    assert(texture && "Attempting to update a NULL texture.");
+
+    assert(texture->apiId &&
+           "This texture has not yet been registered. Use upload_texture() instead.");
+
+    COUNTERS.numTextureUpdates++;
+    COUNTERS.numTextureBytes += texture_byte_size(texture);
+
+    return 1;
+}
+
+int kelpo_rasterizer_null__unload_textures(void)
+{
+    NUM_UPLOADED_TEXTURES = 0;
+
+    return 1;
+}
+
+int kelpo_rasterizer_null__draw_triangles(struct kelpo_polygon_triangle_s *const triangles,
+                                          const unsigned numTriangles)
+{
+    unsigned i = 0;
+
+    KELPOA_PROF_BEGIN("kelpo_rasterizer_null__draw_triangles");
+
+    COUNTERS.numDrawCalls++;
+    COUNTERS.numTriangles += numTriangles;
+
+    for (i = 1; i < numTriangles; i++)
+    {
+        const uint32_t apiId = (triangles[i].texture? triangles[i].texture->apiId : 0);
+        const uint32_t prevApiId = (triangles[i - 1].texture? triangles[i - 1].texture->apiId : 0);
+
+        if (apiId != prevApiId)
+        {
+            COUNTERS.numTextureBatchBreaks++;
+        }
+    }
+
+    KELPOA_PROF_END();
+    return 1;
+}
+
+int kelpo_rasterizer_null__map_vertex_buffer(const unsigned numVertices,
+                                             void **const vertices,
+                                             struct kelpo_vertex_format_s *const format)
+{
+    kelpoa_generic_stack__grow(VERTEX_BUFFER, numVertices);
+
+    if (!VERTEX_BUFFER->data)
+    {
+        kelpo_error(KELPOERR_OUT_OF_SYSTEM_MEMORY);
+        return 0;
+    }
+
+    format->stride = sizeof(struct null_vertex_s);
+    format->xyOffset = offsetof(struct null_vertex_s, x);
+    format->zOffset = offsetof(struct null_vertex_s, z);
+    format->wOffset = offsetof(struct null_vertex_s, w);
+    format->uvOffset = offsetof(struct null_vertex_s, u);
+    format->uvScale = 1;
+    format->isUVPremultiplied = 0;
+    format->colorOffset = offsetof(struct null_vertex_s, r);
+    format->colorOrder = KELPO_VERTEX_COLOR_RGBA;
+
+    *vertices = VERTEX_BUFFER->data;
+
+    return 1;
+}
+
+int kelpo_rasterizer_null__draw_vertex_buffer(const struct kelpo_vertex_batch_s *const batches,
+                                              const unsigned numBatches)
+{
+    unsigned i = 0;
+
+    KELPOA_PROF_BEGIN("kelpo_rasterizer_null__draw_vertex_buffer");
+
+    COUNTERS.numDrawCalls++;
+
+    for (i = 0; i < numBatches; i++)
+    {
+        COUNTERS.numTriangles += (batches[i].numVertices / 3);
+
+        if (i)
+        {
+            const uint32_t apiId = (batches[i].texture? batches[i].texture->apiId : 0);
+            const uint32_t prevApiId = (batches[i - 1].texture? batches[i - 1].texture->apiId : 0);
+
+            if (apiId != prevApiId)
+            {
+                COUNTERS.numTextureBatchBreaks++;
+            }
+        }
+    }
+
+    KELPOA_PROF_END();
+    return 1;
+}
@@ -0,0 +1,74 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * Null rasterizer for the Kelpo renderer. Draws nothing; only counts the work
+ * it's given. Useful for timing the CPU-side cost of a frame (mesh loading,
+ * triangle preparation, interface calls) without a render API's involvement.
+ *
+ * The renderer DLL exports kelpo_rasterizer_null__counters(), which clients
+ * can look up with kelpo_renderer_function() to read the counts.
+ *
+ * Vertices submitted via map_vertex_buffer() are written into a native vertex
+ * format of its own, as they would be for a hardware rasterizer, and then
+ * counted like triangles.
+ *
+ */
+
+#ifndef KELPO_RENDERER_RASTERIZER_NULL_H
+#define KELPO_RENDERER_RASTERIZER_NULL_H
+
+struct kelpo_polygon_triangle_s;
+struct kelpo_polygon_texture_s;
+struct kelpo_vertex_format_s;
+struct kelpo_vertex_batch_s;
+
+/* Running totals of the calls made to the rasterizer since it was initialized.*/
+struct kelpo_rasterizer_null_counters_s
+{
+    unsigned long numFrameClears;
+    unsigned long numDrawCalls;
+    unsigned long numTriangles;
+
+    /* The number of times consecutive triangles within a draw call had a
+     * different texture (counting untextured as a texture of its own); i.e.
+     * how many extra batches a renderer that batches by texture would issue.*/
+    unsigned long numTextureBatchBreaks;
+
+    unsigned long numTextureUploads;
+    unsigned long numTextureUpdates;
+
+    /* The size, in bytes, of the pixel data of all uploaded and updated
+     * textures, including mip levels.*/
+    unsigned long numTextureBytes;
+};
+
+/* The type of kelpo_rasterizer_null__counters(), for clients obtaining it from
+ * the renderer DLL.*/
+typedef const struct kelpo_rasterizer_null_counters_s* (*kelpo_rasterizer_null_counters_fn)(void);
+
+int kelpo_rasterizer_null__initialize(void);
+
+int kelpo_rasterizer_null__release(void);
+
+int kelpo_rasterizer_null__clear_frame(void);
+
+int kelpo_rasterizer_null__upload_texture(struct kelpo_polygon_texture_s *const texture);
+
+int kelpo_rasterizer_null__update_texture(struct kelpo_polygon_texture_s *const texture);
+
+int kelpo_rasterizer_null__unload_textures(void);
+
+int kelpo_rasterizer_null__draw_triangles(struct kelpo_polygon_triangle_s *const triangles,
+                                          const unsigned numTriangles);
+
+int kelpo_rasterizer_null__map_vertex_buffer(const unsigned numVertices,
+                                             void **const vertices,
+                                             struct kelpo_vertex_format_s *const format);
+
+int kelpo_rasterizer_null__draw_vertex_buffer(const struct kelpo_vertex_batch_s *const batches,
+                                              const unsigned numBatches);
+
+/* Returns the rasterizer's counters.*/
+const struct kelpo_rasterizer_null_counters_s* kelpo_rasterizer_null__counters(void);
+
+#endif
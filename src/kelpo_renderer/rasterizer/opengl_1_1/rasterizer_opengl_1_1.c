@@ -13,6 +13,7 @@
 #include <math.h>
 #include <kelpo_renderer/rasterizer/opengl_1_1/rasterizer_opengl_1_1.h>
 #include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/profiler.h>
 #include <kelpo_interface/polygon/triangle/triangle.h>
 #include <kelpo_interface/polygon/texture.h>
 #include <kelpo_interface/error.h>
@@ -248,6 +249,8 @@ int kelpo_rasterizer_opengl_1_1__draw_triangles(struct kelpo_polygon_triangle_s
     unsigned i = 0, v = 0;
     GLuint lastBoundTexture = 0; /* Assumes OpenGL never generates texture id 0.*/
 
+    KELPOA_PROF_BEGIN("kelpo_rasterizer_opengl_1_1__draw_triangles");
+
     for (i = 0; i < numTriangles; i++)
     {
         if (!triangles[i].texture)
@@ -291,5 +294,6 @@ int kelpo_rasterizer_opengl_1_1__draw_triangles(struct kelpo_polygon_triangle_s
         }
     }
 
+    KELPOA_PROF_END();
     return 1;
 }
@@ -13,6 +13,7 @@
 #include <math.h>
 #include <kelpo_renderer/rasterizer/opengl_3_0/rasterizer_opengl_3_0.h>
 #include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/profiler.h>
 #include <kelpo_interface/polygon/triangle/triangle.h>
 #include <kelpo_interface/polygon/texture.h>
 #include <kelpo_interface/error.h>
@@ -294,8 +295,11 @@ int kelpo_rasterizer_opengl_3_0__draw_triangles(struct kelpo_polygon_triangle_s
     unsigned numTrianglesInBatch = 0;
     const struct kelpo_polygon_triangle_s *triangle = triangles;
 
+    KELPOA_PROF_BEGIN("kelpo_rasterizer_opengl_3_0__draw_triangles");
+
     if (!numTriangles)
     {
+        KELPOA_PROF_END();
         return 1;
     }
 
@@ -383,5 +387,6 @@ int kelpo_rasterizer_opengl_3_0__draw_triangles(struct kelpo_polygon_triangle_s
         triangle++;
     }
 
+    KELPOA_PROF_END();
     return 1;
 }
@@ -0,0 +1,562 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * Recording rasterizer for the Kelpo renderer.
+ *
+ */
+
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+#include <kelpo_renderer/rasterizer/recording/rasterizer_recording.h>
+#include <kelpo_auxiliary/command_trace.h>
+#include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/profiler.h>
+#include <kelpo_interface/polygon/triangle/triangle.h>
+#include <kelpo_interface/polygon/texture.h>
+#include <kelpo_interface/interface.h>
+#include <kelpo_interface/error.h>
+
+/* The number of buckets with which the hash table of recorded payloads starts
+ * out. The number is doubled whenever the payloads come to outnumber it.*/
+#define INITIAL_NUM_PAYLOAD_BUCKETS 64
+
+/* A texture payload that has been written into the trace file. Payloads are
+ * identified by their data, so that identical pixel data need only be stored
+ * once. They're looked up by the hashes and size of their data, and a match
+ * confirmed by reading the data back from the trace file.*/
+struct recorded_payload_s
+{
+    uint32_t hashA;
+    uint32_t hashB;
+    uint32_t byteSize;
+    uint32_t id;
+
+    /* Where in the trace file the payload's pixel data begin.*/
+    long fileOffset;
+
+    /* The next earlier payload in the same hash table bucket, as 1 + its index
+     * in RECORDED_PAYLOADS; or 0 if there's none.*/
+    uint32_t nextInBucket;
+};
+
+/* A texture that has been uploaded since textures were last unloaded, and the
+ * ID by which the trace file refers to it.*/
+struct recorded_texture_s
+{
+    const struct kelpo_polygon_texture_s *texture;
+    uint32_t id;
+};
+
+/* The renderer to which calls are passed on.*/
+static const struct kelpo_interface_s *TARGET_RENDERER = NULL;
+
+static FILE *TRACE_FILE = NULL;
+
+/* Commands are encoded into this byte buffer and then written into the trace
+ * file with a single call.*/
+static struct kelpoa_generic_stack_s *ENCODE_BUFFER = NULL;
+
+/* Stack elements are of type struct recorded_payload_s.*/
+static struct kelpoa_generic_stack_s *RECORDED_PAYLOADS = NULL;
+
+/* The hash table of recorded payloads. Each element (uint32_t) is a bucket
+ * holding the most recent payload that hashes to it, as 1 + its index in
+ * RECORDED_PAYLOADS, or 0 if the bucket is empty. The number of buckets is a
+ * power of two.*/
+static struct kelpoa_generic_stack_s *PAYLOAD_BUCKETS = NULL;
+
+/* Stack elements are of type struct recorded_texture_s.*/
+static struct kelpoa_generic_stack_s *RECORDED_TEXTURES = NULL;
+
+static uint32_t NUM_TEXTURE_IDS = 0;
+
+/* The texture most recently looked up by draw_triangles(). Consecutive
+ * triangles tend to share a texture.*/
+static const struct kelpo_polygon_texture_s *CACHED_TEXTURE = NULL;
+static uint32_t CACHED_TEXTURE_ID = 0;
+
+static uint8_t* put_uint32(uint8_t *const dst, const uint32_t value)
+{
+    dst[0] = (uint8_t)(value & 0xff);
+    dst[1] = (uint8_t)((value >> 8) & 0xff);
+    dst[2] = (uint8_t)((value >> 16) & 0xff);
+    dst[3] = (uint8_t)((value >> 24) & 0xff);
+
+    return (dst + 4);
+}
+
+static uint8_t* put_float(uint8_t *const dst, const float value)
+{
+    uint32_t bits = 0;
+
+    memcpy(&bits, &value, sizeof(bits));
+
+    return put_uint32(dst, bits);
+}
+
+/* Returns a pointer to the start of the encode buffer, having made sure that it
+ * can hold at least the given number of bytes.*/
+static uint8_t* encode_buffer(const uint32_t byteSize)
+{
+    kelpoa_generic_stack__grow(ENCODE_BUFFER, byteSize);
+
+    return (uint8_t*)ENCODE_BUFFER->data;
+}
+
+/* Writes the given bytes into the trace file. Returns 1 on success; 0 on
+ * failure.*/
+static int write_trace(const uint8_t *const data,
+                       const uint32_t byteSize)
+{
+    assert(TRACE_FILE && "No trace file open for recording.");
+
+    if (fwrite(data, 1, byteSize, TRACE_FILE) != byteSize)
+    {
+        kelpo_error(KELPOERR_API_CALL_FAILED);
+        return 0;
+    }
+
+    return 1;
+}
+
+static int write_command(const enum kelpoa_cmdtrace_command_type_e commandType)
+{
+    uint8_t data[4];
+
+    put_uint32(data, commandType);
+
+    return write_trace(data, sizeof(data));
+}
+
+/* Returns the trace file's ID for the given uploaded texture, or 0 if the
+ * texture is NULL.*/
+static uint32_t texture_id(const struct kelpo_polygon_texture_s *const texture)
+{
+    uint32_t i = 0;
+
+    if (!texture)
+    {
+        return 0;
+    }
+
+    if (texture == CACHED_TEXTURE)
+    {
+        return CACHED_TEXTURE_ID;
+    }
+
+    /* Search from the most recent upload, in case a texture has been uploaded
+     * more than once.*/
+    for (i = RECORDED_TEXTURES->count; i-- > 0;)
+    {
+        const struct recorded_texture_s *const recorded = kelpoa_generic_stack__at(RECORDED_TEXTURES, i);
+
+        if (recorded->texture == texture)
+        {
+            CACHED_TEXTURE = texture;
+            CACHED_TEXTURE_ID = recorded->id;
+
+            return recorded->id;
+        }
+    }
+
+    assert(0 && "Attempting to record an unknown texture.");
+
+    return 0;
+}
+
+/* Returns the hash table bucket for a payload of the given hashes and size.*/
+static uint32_t* payload_bucket(const uint32_t hashA,
+                                const uint32_t hashB,
+                                const uint32_t byteSize)
+{
+    const uint32_t bucketIdx = ((hashA ^ (hashB * 2654435761u) ^ byteSize) & (PAYLOAD_BUCKETS->count - 1));
+
+    return (uint32_t*)kelpoa_generic_stack__at(PAYLOAD_BUCKETS, bucketIdx);
+}
+
+/* Adds the given recorded payload into the hash table.*/
+static void link_payload(const uint32_t payloadIdx)
+{
+    struct recorded_payload_s *const payload = kelpoa_generic_stack__at(RECORDED_PAYLOADS, payloadIdx);
+    uint32_t *const bucket = payload_bucket(payload->hashA, payload->hashB, payload->byteSize);
+
+    payload->nextInBucket = *bucket;
+    *bucket = (payloadIdx + 1);
+
+    return;
+}
+
+/* Rebuilds the hash table of recorded payloads with the given number of
+ * buckets, which must be a power of two.*/
+static void rehash_payloads(const uint32_t numBuckets)
+{
+    uint32_t i = 0;
+
+    kelpoa_generic_stack__grow(PAYLOAD_BUCKETS, numBuckets);
+    PAYLOAD_BUCKETS->count = numBuckets;
+    memset(PAYLOAD_BUCKETS->data, 0, (numBuckets * sizeof(uint32_t)));
+
+    for (i = 0; i < RECORDED_PAYLOADS->count; i++)
+    {
+        link_payload(i);
+    }
+
+    return;
+}
+
+/* Compares the given payload's pixel data in the trace file against the given
+ * data, leaving the file positioned at its end for further writing. Returns 1
+ * if the data are identical; 0 if they differ; or -1 on failure.*/
+static int compare_payload_data(const struct recorded_payload_s *const payload,
+                                const uint8_t *const data)
+{
+    uint8_t chunk[4096];
+    uint32_t numCompared = 0;
+    int isIdentical = 1;
+
+    if (fseek(TRACE_FILE, payload->fileOffset, SEEK_SET) != 0)
+    {
+        kelpo_error(KELPOERR_API_CALL_FAILED);
+        return -1;
+    }
+
+    while (isIdentical &&
+           (numCompared < payload->byteSize))
+    {
+        const uint32_t remaining = (payload->byteSize - numCompared);
+        const uint32_t chunkSize = ((remaining < sizeof(chunk))? remaining : sizeof(chunk));
+
+        if (fread(chunk, 1, chunkSize, TRACE_FILE) != chunkSize)
+        {
+            kelpo_error(KELPOERR_API_CALL_FAILED);
+            return -1;
+        }
+
+        isIdentical = (memcmp(chunk, (data + numCompared), chunkSize) == 0);
+        numCompared += chunkSize;
+    }
+
+    if (fseek(TRACE_FILE, 0, SEEK_END) != 0)
+    {
+        kelpo_error(KELPOERR_API_CALL_FAILED);
+        return -1;
+    }
+
+    return isIdentical;
+}
+
+/* Writes the given texture's pixels into the trace file, unless identical
+ * pixels have already been written. Returns the ID of the payload holding the
+ * pixels, or 0 on failure.*/
+static uint32_t write_texture_payload(const struct kelpo_polygon_texture_s *const texture)
+{
+    const unsigned numMipLevels = (texture->numMipLevels? texture->numMipLevels : 1);
+    const unsigned paddingSize = 3;
+    uint32_t byteSize = 0;
+    uint32_t hashA = 2166136261u;
+    uint32_t hashB = 0;
+    uint32_t i = 0;
+    uint8_t *data = NULL;
+    uint8_t *dst = NULL;
+    unsigned m = 0;
+
+    for (m = 0; m < numMipLevels; m++)
+    {
+        byteSize += ((texture->width >> m) * (texture->width >> m) * sizeof(texture->mipLevel[0][0]));
+    }
+
+    /* The command's header is placed before the pixel data in the buffer, and
+     * the pixel data are followed by padding to a multiple of 4 bytes.*/
+    data = encode_buffer(12 + byteSize + paddingSize);
+    dst = (data + 12);
+
+    for (m = 0; m < numMipLevels; m++)
+    {
+        const unsigned mipLevelByteSize = ((texture->width >> m) * (texture->width >> m) * sizeof(texture->mipLevel[0][0]));
+
+        if (texture->mipLevel[m])
+        {
+            memcpy(dst, texture->mipLevel[m], mipLevelByteSize);
+        }
+        else
+        {
+            memset(dst, 0, mipLevelByteSize);
+        }
+
+        dst += mipLevelByteSize;
+    }
+
+    memset(dst, 0, paddingSize);
+
+    /* FNV-1a and sdbm hashes of the pixel data.*/
+    for (i = 0; i < byteSize; i++)
+    {
+        hashA = ((hashA ^ data[12 + i]) * 16777619u);
+        hashB = (data[12 + i] + (hashB << 6) + (hashB << 16) - hashB);
+    }
+
+    /* Look for an earlier payload of the same data.*/
+    i = *payload_bucket(hashA, hashB, byteSize);
+
+    while (i)
+    {
+        const struct recorded_payload_s *const payload = kelpoa_generic_stack__at(RECORDED_PAYLOADS, (i - 1));
+
+        i = payload->nextInBucket;
+
+        if ((payload->byteSize == byteSize) &&
+            (payload->hashA == hashA) &&
+            (payload->hashB == hashB))
+        {
+            const int comparison = compare_payload_data(payload, (data + 12));
+
+            if (comparison < 0)
+            {
+                return 0;
+            }
+            else if (comparison)
+            {
+                return payload->id;
+            }
+        }
+    }
+
+    {
+        struct recorded_payload_s payload;
+
+        payload.hashA = hashA;
+        payload.hashB = hashB;
+        payload.byteSize = byteSize;
+        payload.id = (RECORDED_PAYLOADS->count + 1);
+        payload.fileOffset = (ftell(TRACE_FILE) + 12);
+        payload.nextInBucket = 0;
+
+        put_uint32((data + 0), KELPOA_CMDTRACE_TEXTURE_DATA);
+        put_uint32((data + 4), payload.id);
+        put_uint32((data + 8), byteSize);
+
+        if (payload.fileOffset < 12)
+        {
+            kelpo_error(KELPOERR_API_CALL_FAILED);
+            return 0;
+        }
+
+        if (!write_trace(data, (12 + ((byteSize + 3) & ~3u))))
+        {
+            return 0;
+        }
+
+        kelpoa_generic_stack__push_copy(RECORDED_PAYLOADS, &payload);
+
+        if (RECORDED_PAYLOADS->count > PAYLOAD_BUCKETS->count)
+        {
+            rehash_payloads(2 * PAYLOAD_BUCKETS->count);
+        }
+        else
+        {
+            link_payload(RECORDED_PAYLOADS->count - 1);
+        }
+
+        return payload.id;
+    }
+}
+
+/* Writes into the trace file an upload or update command for the given texture,
+ * whose pixels are in the given payload. Returns 1 on success; 0 on failure.*/
+static int write_texture_command(const enum kelpoa_cmdtrace_command_type_e commandType,
+                                 const uint32_t textureId,
+                                 const uint32_t payloadId,
+                                 const struct kelpo_polygon_texture_s *const texture)
+{
+    uint8_t data[28];
+    uint8_t *dst = data;
+
+    dst = put_uint32(dst, commandType);
+    dst = put_uint32(dst, textureId);
+    dst = put_uint32(dst, payloadId);
+    dst = put_uint32(dst, texture->width);
+    dst = put_uint32(dst, texture->height);
+    dst = put_uint32(dst, texture->numMipLevels);
+    dst = put_uint32(dst, ((texture->flags.noFiltering? KELPOA_CMDTRACE_TEXTURE_FLAG_NO_FILTERING : 0) |
+                           (texture->flags.clamped? KELPOA_CMDTRACE_TEXTURE_FLAG_CLAMPED : 0) |
+                           (texture->flags.noMipmapping? KELPOA_CMDTRACE_TEXTURE_FLAG_NO_MIPMAPPING : 0)));
+
+    return write_trace(data, sizeof(data));
+}
+
+int kelpo_rasterizer_recording__initialize(const struct kelpo_interface_s *const targetRenderer,
+                                           const char *const traceFilename,
+                                           const unsigned screenWidth,
+                                           const unsigned screenHeight,
+                                           const unsigned screenBPP)
+{
+    uint8_t header[KELPOA_CMDTRACE_HEADER_SIZE];
+
+    assert(targetRenderer && "Expected a renderer to record.");
+
+    TARGET_RENDERER = targetRenderer;
+    NUM_TEXTURE_IDS = 0;
+    CACHED_TEXTURE = NULL;
+    CACHED_TEXTURE_ID = 0;
+
+    ENCODE_BUFFER = kelpoa_generic_stack__create((KELPO_TEXTURE_MAX_SIDE_LENGTH * KELPO_TEXTURE_MAX_SIDE_LENGTH * 3), sizeof(uint8_t));
+    RECORDED_PAYLOADS = kelpoa_generic_stack__create(64, sizeof(struct recorded_payload_s));
+    PAYLOAD_BUCKETS = kelpoa_generic_stack__create(INITIAL_NUM_PAYLOAD_BUCKETS, sizeof(uint32_t));
+    rehash_payloads(INITIAL_NUM_PAYLOAD_BUCKETS);
+    RECORDED_TEXTURES = kelpoa_generic_stack__create(64, sizeof(struct recorded_texture_s));
+
+    if (!(TRACE_FILE = fopen(traceFilename, "w+b")))
+    {
+        fprintf(stderr, "Could not open the trace file \"%s\" for writing.\n", traceFilename);
+        kelpo_error(KELPOERR_API_CALL_FAILED);
+        return 0;
+    }
+
+    memcpy(header, KELPOA_CMDTRACE_MAGIC, 8);
+    put_uint32((header + 8), KELPOA_CMDTRACE_FORMAT_VERSION);
+    put_uint32((header + 12), screenWidth);
+    put_uint32((header + 16), screenHeight);
+    put_uint32((header + 20), screenBPP);
+
+    return write_trace(header, sizeof(header));
+}
+
+int kelpo_rasterizer_recording__release(void)
+{
+    int success = 1;
+
+    if (TRACE_FILE &&
+        (fclose(TRACE_FILE) != 0))
+    {
+        kelpo_error(KELPOERR_API_CALL_FAILED);
+        success = 0;
+    }
+
+    TRACE_FILE = NULL;
+    TARGET_RENDERER = NULL;
+
+    if (ENCODE_BUFFER) kelpoa_generic_stack__free(ENCODE_BUFFER);
+    if (RECORDED_PAYLOADS) kelpoa_generic_stack__free(RECORDED_PAYLOADS);
+    if (PAYLOAD_BUCKETS) kelpoa_generic_stack__free(PAYLOAD_BUCKETS);
+    if (RECORDED_TEXTURES) kelpoa_generic_stack__free(RECORDED_TEXTURES);
+
+    ENCODE_BUFFER = NULL;
+    RECORDED_PAYLOADS = NULL;
+    PAYLOAD_BUCKETS = NULL;
+    RECORDED_TEXTURES = NULL;
+
+    return success;
+}
+
+int kelpo_rasterizer_recording__clear_frame(void)
+{
+    return (write_command(KELPOA_CMDTRACE_CLEAR_FRAME) &&
+            TARGET_RENDERER->rasterizer.clear_frame());
+}
+
+int kelpo_rasterizer_recording__flip_surface(void)
+{
+    return (write_command(KELPOA_CMDTRACE_FLIP_SURFACE) &&
+            TARGET_RENDERER->window.flip_surface());
+}
+
+int kelpo_rasterizer_recording__upload_texture(struct kelpo_polygon_texture_s *const texture)
+{
+    struct recorded_texture_s recorded;
+    uint32_t payloadId = 0;
+
+    assert(texture && "Attempting to upload a NULL texture.");
+
+    if (!(payloadId = write_texture_payload(texture)))
+    {
+        return 0;
+    }
+
+    recorded.texture = texture;
+    recorded.id = ++NUM_TEXTURE_IDS;
+    kelpoa_generic_stack__push_copy(RECORDED_TEXTURES, &recorded);
+
+    CACHED_TEXTURE = texture;
+    CACHED_TEXTURE_ID = recorded.id;
+
+    return (write_texture_command(KELPOA_CMDTRACE_UPLOAD_TEXTURE, recorded.id, payloadId, texture) &&
+            TARGET_RENDERER->rasterizer.upload_texture(texture));
+}
+
+int kelpo_rasterizer_recording__update_texture(struct kelpo_polygon_texture_s *const texture)
+{
+    uint32_t payloadId = 0;
+
+    assert(texture && "Attempting to update a NULL texture.");
+
+    if (!(payloadId = write_texture_payload(texture)))
+    {
+        return 0;
+    }
+
+    return (write_texture_command(KELPOA_CMDTRACE_UPDATE_TEXTURE, texture_id(texture), payloadId, texture) &&
+            TARGET_RENDERER->rasterizer.update_texture(texture));
+}
+
+int kelpo_rasterizer_recording__unload_textures(void)
+{
+    kelpoa_generic_stack__clear(RECORDED_TEXTURES);
+    CACHED_TEXTURE = NULL;
+    CACHED_TEXTURE_ID = 0;
+
+    return (write_command(KELPOA_CMDTRACE_UNLOAD_TEXTURES) &&
+            TARGET_RENDERER->rasterizer.unload_textures());
+}
+
+int kelpo_rasterizer_recording__draw_triangles(struct kelpo_polygon_triangle_s *const triangles,
+                                               const unsigned numTriangles)
+{
+    uint8_t *const data = encode_buffer(8 + (numTriangles * KELPOA_CMDTRACE_TRIANGLE_SIZE));
+    uint8_t *dst = data;
+    unsigned i = 0;
+    int returnValue = 0;
+
+    KELPOA_PROF_BEGIN("kelpo_rasterizer_recording__draw_triangles");
+
+    dst = put_uint32(dst, KELPOA_CMDTRACE_DRAW_TRIANGLES);
+    dst = put_uint32(dst, numTriangles);
+
+    for (i = 0; i < numTriangles; i++)
+    {
+        const struct kelpo_polygon_triangle_s *const triangle = &triangles[i];
+        unsigned v = 0;
+
+        dst = put_uint32(dst, texture_id(triangle->texture));
+        dst = put_uint32(dst, ((triangle->flags.wireframe? KELPOA_CMDTRACE_TRIANGLE_FLAG_WIREFRAME : 0) |
+                               (triangle->flags.ignore? KELPOA_CMDTRACE_TRIANGLE_FLAG_IGNORE : 0) |
+                               (triangle->flags.twoSided? KELPOA_CMDTRACE_TRIANGLE_FLAG_TWO_SIDED : 0)));
+
+        for (v = 0; v < 3; v++)
+        {
+            const struct kelpo_polygon_vertex_s *const vertex = &triangle->vertex[v];
+
+            dst = put_float(dst, vertex->x);
+            dst = put_float(dst, vertex->y);
+            dst = put_float(dst, vertex->z);
+            dst = put_float(dst, vertex->w);
+            dst = put_float(dst, vertex->nx);
+            dst = put_float(dst, vertex->ny);
+            dst = put_float(dst, vertex->nz);
+            dst = put_float(dst, vertex->u);
+            dst = put_float(dst, vertex->v);
+            *dst++ = vertex->r;
+            *dst++ = vertex->g;
+            *dst++ = vertex->b;
+            *dst++ = vertex->a;
+        }
+    }
+
+    KELPOA_PROF_END();
+
+    /* The target renderer's time isn't included in our zone.*/
+    returnValue = (write_trace(data, (uint32_t)(dst - data)) &&
+                   TARGET_RENDERER->rasterizer.draw_triangles(triangles, numTriangles));
+
+    return returnValue;
+}
@@ -0,0 +1,44 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * Recording rasterizer for the Kelpo renderer. Passes each call on to another
+ * Kelpo renderer, and writes the call and its data into a command trace file
+ * (see kelpo_auxiliary/command_trace.h for the file format) from which the
+ * rendering can later be replayed.
+ *
+ */
+
+#ifndef KELPO_RENDERER_RASTERIZER_RECORDING_H
+#define KELPO_RENDERER_RASTERIZER_RECORDING_H
+
+struct kelpo_interface_s;
+struct kelpo_polygon_triangle_s;
+struct kelpo_polygon_texture_s;
+
+/* Starts recording into the given trace file the calls made to the rasterizer,
+ * passing them on to the given renderer, whose window must be open.*/
+int kelpo_rasterizer_recording__initialize(const struct kelpo_interface_s *const targetRenderer,
+                                           const char *const traceFilename,
+                                           const unsigned screenWidth,
+                                           const unsigned screenHeight,
+                                           const unsigned screenBPP);
+
+/* Finishes writing the trace file.*/
+int kelpo_rasterizer_recording__release(void);
+
+int kelpo_rasterizer_recording__clear_frame(void);
+
+/* Recorded here rather than by the window, so that the trace's commands stay in
+ * the order in which they were issued.*/
+int kelpo_rasterizer_recording__flip_surface(void);
+
+int kelpo_rasterizer_recording__upload_texture(struct kelpo_polygon_texture_s *const texture);
+
+int kelpo_rasterizer_recording__update_texture(struct kelpo_polygon_texture_s *const texture);
+
+int kelpo_rasterizer_recording__unload_textures(void);
+
+int kelpo_rasterizer_recording__draw_triangles(struct kelpo_polygon_triangle_s *const triangles,
+                                               const unsigned numTriangles);
+
+#endif
@@ -0,0 +1,990 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * Software rasterizer for the Kelpo renderer.
+ *
+ * Rasterizes screen-space triangles into an in-memory pixel buffer, with depth
+ * buffering and perspective-correct, mipmapped texturing. Needs no graphics
+ * hardware.
+ *
+ * Triangles are first set up for rasterization and then binned into fixed-size
+ * screen tiles, each of which is rasterized as a separate job on a pool of
+ * worker threads. A tile's triangles are drawn in the order in which they were
+ * submitted, and every pixel's values are computed independently of where the
+ * tile boundaries lie, so the output is identical regardless of the number of
+ * threads.
+ *
+ * The number of threads defaults to the number of CPU cores, and can be set via
+ * the KELPO_SOFTWARE_NUM_THREADS environment variable (a value of 1 renders on
+ * the calling thread only).
+ *
+ * Pixels are visited by a SIMD kernel if the CPU supports one, or else by a
+ * scalar loop. Setting the KELPO_SOFTWARE_NO_SIMD environment variable forces
+ * the scalar loop.
+ *
+ * The rasterizer's native vertex format, for map_vertex_buffer(), is struct
+ * kelpo_polygon_vertex_s itself, so vertices drawn via draw_vertex_buffer() are
+ * set up for rasterization straight from the mapped memory, as triangles passed
+ * to draw_triangles() are from the client's.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stddef.h>
+#include <math.h>
+#include <kelpo_renderer/rasterizer/software/rasterizer_software.h>
+#include <kelpo_renderer/rasterizer/software/rasterizer_software_kernels.h>
+#include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/thread_pool.h>
+#include <kelpo_auxiliary/profiler.h>
+#include <kelpo_interface/polygon/triangle/triangle.h>
+#include <kelpo_interface/polygon/vertex_buffer.h>
+#include <kelpo_interface/polygon/texture.h>
+#include <kelpo_interface/error.h>
+
+/* Vertex XY coordinates are snapped to this many sub-pixel steps per pixel
+ * prior to rasterization. Triangles sharing an edge will then evaluate exactly
+ * the same edge function for it, so no pixel along the edge gets drawn twice
+ * or skipped.*/
+#define SUBPIXEL_STEPS 16.0f
+
+/* Evaluates the given attribute plane at the given pixel offset from the
+ * plane's origin vertex.*/
+#define INTERPOLATE(plane, offsX, offsY) ((plane).origin + ((plane).dx * (offsX)) + ((plane).dy * (offsY)))
+
+/* The number of triangles set up for rasterization per thread pool job.*/
+#define SETUP_BATCH_SIZE 256
+
+/* Triangles with a vertex further than this many pixels from the screen's
+ * origin aren't drawn. Keeps the edge functions' values exact.*/
+#define MAX_SCREEN_COORDINATE 1048576.0f
+
+/* The render target. Pixels are 32-bit XRGB 8888; depth values are in the
+ * range [0,1], smaller values being closer to the viewer.*/
+static uint32_t *PIXEL_BUFFER = NULL;
+static float *DEPTH_BUFFER = NULL;
+static unsigned RENDER_WIDTH = 0;
+static unsigned RENDER_HEIGHT = 0;
+
+/* The textures uploaded to the rasterizer. Stack elements will be of type
+ * struct kelpo_software_texture_s. A texture's 'apiId' is its index in this stack
+ * plus one, so that an 'apiId' of 0 never refers to a valid texture.*/
+static struct kelpoa_generic_stack_s *UPLOADED_TEXTURES = NULL;
+
+/* The memory returned by map_vertex_buffer(). Stack elements will be of type
+ * struct kelpo_polygon_vertex_s.*/
+static struct kelpoa_generic_stack_s *VERTEX_BUFFER = NULL;
+
+/* The triangles of the current draw call, set up for rasterization. Stack
+ * elements will be of type struct kelpo_software_triangle_setup_s.*/
+static struct kelpoa_generic_stack_s *TRIANGLE_SETUPS = NULL;
+
+/* One bin per screen tile, in row-major order, holding the indices (uint32_t)
+ * in TRIANGLE_SETUPS of the triangles whose bounding rectangle overlaps the
+ * tile.*/
+static struct kelpoa_generic_stack_s **TILE_BINS = NULL;
+static unsigned NUM_TILES_X = 0;
+static unsigned NUM_TILES_Y = 0;
+
+static struct kelpoa_thread_pool_s *THREAD_POOL = NULL;
+
+static void rasterize_triangle_scalar(const struct kelpo_software_triangle_setup_s *const setup,
+                                      const int tileX,
+                                      const int tileY);
+
+/* The kernel with which triangles are rasterized, chosen at initialization
+ * based on the CPU's capabilities (see also kelpo_rasterizer_software__use_simd()).*/
+static void (*RASTERIZE_TRIANGLE)(const struct kelpo_software_triangle_setup_s *const setup,
+                                  const int tileX,
+                                  const int tileY) = NULL;
+
+/* Returns the number of threads the rasterizer should render with.*/
+static unsigned num_render_threads(void)
+{
+    const char *const envValue = getenv("KELPO_SOFTWARE_NUM_THREADS");
+    const int numThreads = (envValue? atoi(envValue) : 0);
+
+    return ((numThreads > 0)? (unsigned)numThreads : kelpoa_thread_pool__num_cpu_cores());
+}
+
+int kelpo_rasterizer_software__initialize(const unsigned width,
+                                          const unsigned height)
+{
+    unsigned i = 0;
+
+    assert((width && height) && "Invalid render resolution.");
+
+    RENDER_WIDTH = width;
+    RENDER_HEIGHT = height;
+    NUM_TILES_X = ((width + KELPO_SOFTWARE_TILE_SIZE - 1) / KELPO_SOFTWARE_TILE_SIZE);
+    NUM_TILES_Y = ((height + KELPO_SOFTWARE_TILE_SIZE - 1) / KELPO_SOFTWARE_TILE_SIZE);
+
+    if (!(PIXEL_BUFFER = malloc(width * height * sizeof(PIXEL_BUFFER[0]))) ||
+        !(DEPTH_BUFFER = malloc(width * height * sizeof(DEPTH_BUFFER[0]))) ||
+        !(UPLOADED_TEXTURES = kelpoa_generic_stack__create(10, sizeof(struct kelpo_software_texture_s))) ||
+        !(VERTEX_BUFFER = kelpoa_generic_stack__create(1024, sizeof(struct kelpo_polygon_vertex_s))) ||
+        !(TRIANGLE_SETUPS = kelpoa_generic_stack__create(1024, sizeof(struct kelpo_software_triangle_setup_s))) ||
+        !(TILE_BINS = calloc((NUM_TILES_X * NUM_TILES_Y), sizeof(TILE_BINS[0]))))
+    {
+        kelpo_error(KELPOERR_OUT_OF_SYSTEM_MEMORY);
+        return 0;
+    }
+
+    for (i = 0; i < (NUM_TILES_X * NUM_TILES_Y); i++)
+    {
+        if (!(TILE_BINS[i] = kelpoa_generic_stack__create(256, sizeof(uint32_t))))
+        {
+            kelpo_error(KELPOERR_OUT_OF_SYSTEM_MEMORY);
+            return 0;
+        }
+    }
+
+    /* The calling thread renders too, so it doesn't need a worker.*/
+    if (!(THREAD_POOL = kelpoa_thread_pool__create(num_render_threads() - 1)))
+    {
+        kelpo_error(KELPOERR_API_CALL_FAILED);
+        return 0;
+    }
+
+    kelpo_rasterizer_software__use_simd(!getenv("KELPO_SOFTWARE_NO_SIMD"));
+
+    return kelpo_rasterizer_software__clear_frame();
+}
+
+int kelpo_rasterizer_software__use_simd(const int useSimd)
+{
+    if (useSimd &&
+        kelpo_rasterizer_software_sse2__is_supported())
+    {
+        RASTERIZE_TRIANGLE = kelpo_rasterizer_software_sse2__rasterize_triangle;
+        return 1;
+    }
+
+    RASTERIZE_TRIANGLE = rasterize_triangle_scalar;
+    return 0;
+}
+
+int kelpo_rasterizer_software__release(void)
+{
+    if (UPLOADED_TEXTURES)
+    {
+        kelpo_rasterizer_software__unload_textures();
+        kelpoa_generic_stack__free(UPLOADED_TEXTURES);
+        UPLOADED_TEXTURES = NULL;
+    }
+
+    if (TILE_BINS)
+    {
+        unsigned i = 0;
+
+        for (i = 0; i < (NUM_TILES_X * NUM_TILES_Y); i++)
+        {
+            if (TILE_BINS[i])
+            {
+                kelpoa_generic_stack__free(TILE_BINS[i]);
+            }
+        }
+
+        free(TILE_BINS);
+        TILE_BINS = NULL;
+    }
+
+    if (VERTEX_BUFFER)
+    {
+        kelpoa_generic_stack__free(VERTEX_BUFFER);
+        VERTEX_BUFFER = NULL;
+    }
+
+    if (TRIANGLE_SETUPS)
+    {
+        kelpoa_generic_stack__free(TRIANGLE_SETUPS);
+        TRIANGLE_SETUPS = NULL;
+    }
+
+    kelpoa_thread_pool__free(THREAD_POOL);
+    THREAD_POOL = NULL;
+
+    free(PIXEL_BUFFER);
+    free(DEPTH_BUFFER);
+    PIXEL_BUFFER = NULL;
+    DEPTH_BUFFER = NULL;
+
+    return 1;
+}
+
+const uint32_t* kelpo_rasterizer_software__pixels(void)
+{
+    return PIXEL_BUFFER;
+}
+
+int kelpo_rasterizer_software__clear_frame(void)
+{
+    unsigned i = 0;
+    const unsigned numPixels = (RENDER_WIDTH * RENDER_HEIGHT);
+
+    assert((PIXEL_BUFFER && DEPTH_BUFFER) &&
+           "Attempting to clear the frame before the rasterizer has been initialized.");
+
+    memset(PIXEL_BUFFER, 0, (numPixels * sizeof(PIXEL_BUFFER[0])));
+
+    for (i = 0; i < numPixels; i++)
+    {
+        DEPTH_BUFFER[i] = 1;
+    }
+
+    return 1;
+}
+
+/* Copies the given texture's mip level pixels into the rasterizer's version of
+ * the texture.*/
+static void copy_texture_data(struct kelpo_software_texture_s *const dst,
+                              const struct kelpo_polygon_texture_s *const src)
+{
+    unsigned m = 0;
+
+    for (m = 0; m < dst->numMipLevels; m++)
+    {
+        const unsigned mipLevelSideLength = (dst->sideLength >> m);
+
+        if (src->mipLevel[m])
+        {
+            memcpy(dst->mipLevel[m], src->mipLevel[m], (mipLevelSideLength * mipLevelSideLength * sizeof(dst->mipLevel[m][0])));
+        }
+    }
+
+    return;
+}
+
+int kelpo_rasterizer_software__upload_texture(struct kelpo_polygon_texture_s *const texture)
+{
+    unsigned m = 0;
+    struct kelpo_software_texture_s newTexture;
+
+    assert(texture && "Attempting to upload a NULL texture.");
+
+    assert(!texture->apiId &&
+           "This texture has already been registered. Use update_texture() instead.");
+
+    assert((texture->width == texture->height) && "Expected square textures.");
+
+    assert((texture->width <= KELPO_TEXTURE_MAX_SIDE_LENGTH) &&
+           !(texture->width & (texture->width - 1)) &&
+           "Expected the texture's side length to be a power of two.");
+
+    memset(&newTexture, 0, sizeof(newTexture));
+    newTexture.sideLength = texture->width;
+    newTexture.numMipLevels = (texture->numMipLevels? texture->numMipLevels : 1);
+
+    for (m = 0; m < newTexture.numMipLevels; m++)
+    {
+        const unsigned mipLevelSideLength = (newTexture.sideLength >> m);
+
+        if (!(newTexture.mipLevel[m] = malloc(mipLevelSideLength * mipLevelSideLength * sizeof(newTexture.mipLevel[m][0]))))
+        {
+            while (m--)
+            {
+                free(newTexture.mipLevel[m]);
+            }
+
+            kelpo_error(KELPOERR_OUT_OF_SYSTEM_MEMORY);
+            return 0;
+        }
+    }
+
+    copy_texture_data(&newTexture, texture);
+
+    kelpoa_generic_stack__push_copy(UPLOADED_TEXTURES, &newTexture);
+    texture->apiId = UPLOADED_TEXTURES->count;
+
+    return 1;
+}
+
+int kelpo_rasterizer_software__update_texture(struct kelpo_polygon_texture_s *const texture)
+{
+    struct kelpo_software_texture_s *existingTexture = NULL;
+
+    assert(texture && "Attempting to update a NULL texture.");
+
+    assert(texture->apiId &&
+           (texture->apiId <= UPLOADED_TEXTURES->count) &&
+           "This texture has not yet been registered. Use upload_texture() instead.");
+
+    existingTexture = (struct kelpo_software_texture_s*)kelpoa_generic_stack__at(UPLOADED_TEXTURES, (texture->apiId - 1));
+
+    assert((existingTexture->sideLength == texture->width) &&
+           "The texture's dimensions have changed since it was uploaded.");
+
+    copy_texture_data(existingTexture, texture);
+
+    return 1;
+}
+
+int kelpo_rasterizer_software__unload_textures(void)
+{
+    uint32_t i = 0;
+
+    for (i = 0; i < UPLOADED_TEXTURES->count; i++)
+    {
+        unsigned m = 0;
+        struct kelpo_software_texture_s *const texture = (struct kelpo_software_texture_s*)kelpoa_generic_stack__at(UPLOADED_TEXTURES, i);
+
+        for (m = 0; m < texture->numMipLevels; m++)
+        {
+            free(texture->mipLevel[m]);
+        }
+    }
+
+    kelpoa_generic_stack__clear(UPLOADED_TEXTURES);
+
+    return 1;
+}
+
+static void setup_attribute_plane(struct kelpo_software_attribute_plane_s *const plane,
+                                  const float value0,
+                                  const float value1,
+                                  const float value2,
+                                  const float dx1, /* X distance from vertex 0 to vertex 1.*/
+                                  const float dy1,
+                                  const float dx2, /* X distance from vertex 0 to vertex 2.*/
+                                  const float dy2,
+                                  const float invArea)
+{
+    plane->origin = value0;
+    plane->dx = ((((value1 - value0) * dy2) - ((value2 - value0) * dy1)) * invArea);
+    plane->dy = ((((value2 - value0) * dx1) - ((value1 - value0) * dx2)) * invArea);
+
+    return;
+}
+
+/* Returns the mip level at which the texture of the triangle of the given three
+ * vertices should be sampled, given the triangle's doubled screen-space area.
+ * The level is chosen once per triangle, by comparing the triangle's area in
+ * texels with its area in pixels.*/
+static unsigned select_mip_level(const struct kelpo_polygon_vertex_s *const v,
+                                 const struct kelpo_polygon_texture_s *const polygonTexture,
+                                 const struct kelpo_software_texture_s *const texture,
+                                 const float screenArea)
+{
+    unsigned mipLevel = 0;
+
+    if ((texture->numMipLevels > 1) &&
+        !polygonTexture->flags.noMipmapping)
+    {
+        const float du1 = ((v[1].u - v[0].u) * texture->sideLength);
+        const float dv1 = ((v[1].v - v[0].v) * texture->sideLength);
+        const float du2 = ((v[2].u - v[0].u) * texture->sideLength);
+        const float dv2 = ((v[2].v - v[0].v) * texture->sideLength);
+        const float texelArea = fabs((du1 * dv2) - (du2 * dv1));
+
+        if (texelArea > screenArea)
+        {
+            /* Each mip level quarters the texel area.*/
+            const double level = (0.5 * (log(texelArea / screenArea) / log(2)));
+
+            mipLevel = ((level >= (texture->numMipLevels - 1))
+                        ? (texture->numMipLevels - 1)
+                        : (unsigned)level);
+        }
+    }
+
+    return mipLevel;
+}
+
+/* Computes the rasterization parameters of the triangle of the given three
+ * vertices and texture (NULL if untextured). Returns 1 if the triangle covers
+ * any pixels in the render target; 0 otherwise, in which case the setup's
+ * bounding rectangle is left empty.*/
+static int setup_triangle(const struct kelpo_polygon_vertex_s *const vertex,
+                          const struct kelpo_polygon_texture_s *const texture,
+                          struct kelpo_software_triangle_setup_s *const setup)
+{
+    unsigned i = 0;
+    float x[3], y[3];
+    double xSub[3], ySub[3]; /* In sub-pixel units.*/
+    double areaSub = 0;
+    float area = 0;
+
+    setup->minX = setup->maxX = 0;
+    setup->minY = setup->maxY = 0;
+
+    for (i = 0; i < 3; i++)
+    {
+        if (!(fabs(vertex[i].x) < MAX_SCREEN_COORDINATE) ||
+            !(fabs(vertex[i].y) < MAX_SCREEN_COORDINATE))
+        {
+            return 0;
+        }
+
+        xSub[i] = floor((vertex[i].x * SUBPIXEL_STEPS) + 0.5f);
+        ySub[i] = floor((vertex[i].y * SUBPIXEL_STEPS) + 0.5f);
+        x[i] = (xSub[i] / SUBPIXEL_STEPS);
+        y[i] = (ySub[i] / SUBPIXEL_STEPS);
+    }
+
+    /* Twice the triangle's signed area. Degenerate triangles cover no pixels.*/
+    areaSub = (((xSub[1] - xSub[0]) * (ySub[2] - ySub[0])) - ((xSub[2] - xSub[0]) * (ySub[1] - ySub[0])));
+    if (areaSub == 0)
+    {
+        return 0;
+    }
+    area = (areaSub / (SUBPIXEL_STEPS * SUBPIXEL_STEPS));
+
+    /* Bounding rectangle. Pixel centers are at integer coordinates.*/
+    {
+        float minX = x[0], maxX = x[0];
+        float minY = y[0], maxY = y[0];
+
+        for (i = 1; i < 3; i++)
+        {
+            if (x[i] < minX) minX = x[i];
+            if (x[i] > maxX) maxX = x[i];
+            if (y[i] < minY) minY = y[i];
+            if (y[i] > maxY) maxY = y[i];
+        }
+
+        minX = ((minX < 0)? 0 : (minX > RENDER_WIDTH)? RENDER_WIDTH : ceil(minX));
+        minY = ((minY < 0)? 0 : (minY > RENDER_HEIGHT)? RENDER_HEIGHT : ceil(minY));
+        maxX = ((maxX < 0)? 0 : (maxX >= RENDER_WIDTH)? RENDER_WIDTH : (floor(maxX) + 1));
+        maxY = ((maxY < 0)? 0 : (maxY >= RENDER_HEIGHT)? RENDER_HEIGHT : (floor(maxY) + 1));
+
+        setup->minX = minX;
+        setup->minY = minY;
+        setup->maxX = maxX;
+        setup->maxY = maxY;
+
+        if ((setup->minX >= setup->maxX) ||
+            (setup->minY >= setup->maxY))
+        {
+            return 0;
+        }
+    }
+
+    /* Edge functions. Edge i runs from vertex i to vertex i+1.*/
+    for (i = 0; i < 3; i++)
+    {
+        const unsigned j = ((i + 1) % 3);
+        int includesTies = 0;
+
+        setup->edgeA[i] = ((ySub[i] - ySub[j]) * SUBPIXEL_STEPS);
+        setup->edgeB[i] = ((xSub[j] - xSub[i]) * SUBPIXEL_STEPS);
+        setup->edgeC[i] = ((xSub[i] * ySub[j]) - (xSub[j] * ySub[i]));
+
+        /* The edge functions as computed are positive inside counter-clockwise
+         * (in screen space) triangles; flip them for clockwise ones. Negation
+         * is exact, so a shared edge stays watertight either way.*/
+        if (areaSub < 0)
+        {
+            setup->edgeA[i] = -setup->edgeA[i];
+            setup->edgeB[i] = -setup->edgeB[i];
+            setup->edgeC[i] = -setup->edgeC[i];
+        }
+
+        /* Top-left fill rule: pixels exactly on a top or left edge are inside
+         * the triangle. Edge values being integers, excluding the other ties
+         * is a matter of biasing the edge function down by one.*/
+        includesTies = ((setup->edgeA[i] > 0) ||
+                        ((setup->edgeA[i] == 0) && (setup->edgeB[i] > 0)));
+
+        if (!includesTies)
+        {
+            setup->edgeC[i] -= 1;
+        }
+    }
+
+    /* Attribute planes.*/
+    {
+        const struct kelpo_polygon_vertex_s *const v = vertex;
+        const float dx1 = (x[1] - x[0]);
+        const float dy1 = (y[1] - y[0]);
+        const float dx2 = (x[2] - x[0]);
+        const float dy2 = (y[2] - y[0]);
+        const float invArea = (1 / area);
+
+        setup->originX = x[0];
+        setup->originY = y[0];
+
+        setup_attribute_plane(&setup->z, v[0].z, v[1].z, v[2].z, dx1, dy1, dx2, dy2, invArea);
+        setup_attribute_plane(&setup->r, v[0].r, v[1].r, v[2].r, dx1, dy1, dx2, dy2, invArea);
+        setup_attribute_plane(&setup->g, v[0].g, v[1].g, v[2].g, dx1, dy1, dx2, dy2, invArea);
+        setup_attribute_plane(&setup->b, v[0].b, v[1].b, v[2].b, dx1, dy1, dx2, dy2, invArea);
+        setup_attribute_plane(&setup->a, v[0].a, v[1].a, v[2].a, dx1, dy1, dx2, dy2, invArea);
+
+        if (texture &&
+            texture->apiId)
+        {
+            assert((texture->apiId <= UPLOADED_TEXTURES->count) &&
+                   "Attempting to render with a texture that hasn't been uploaded.");
+
+            setup->texture = (const struct kelpo_software_texture_s*)kelpoa_generic_stack__at(UPLOADED_TEXTURES, (texture->apiId - 1));
+            setup->mipLevel = select_mip_level(v, texture, setup->texture, fabs(area));
+            setup->noFiltering = texture->flags.noFiltering;
+            setup->clamped = texture->flags.clamped;
+
+            setup_attribute_plane(&setup->w, v[0].w, v[1].w, v[2].w, dx1, dy1, dx2, dy2, invArea);
+            setup_attribute_plane(&setup->uw, (v[0].u * v[0].w), (v[1].u * v[1].w), (v[2].u * v[2].w), dx1, dy1, dx2, dy2, invArea);
+            setup_attribute_plane(&setup->vw, (v[0].v * v[0].w), (v[1].v * v[1].w), (v[2].v * v[2].w), dx1, dy1, dx2, dy2, invArea);
+        }
+        else
+        {
+            setup->texture = NULL;
+            memset(&setup->w, 0, sizeof(setup->w));
+            memset(&setup->uw, 0, sizeof(setup->uw));
+            memset(&setup->vw, 0, sizeof(setup->vw));
+        }
+    }
+
+    return 1;
+}
+
+/* Returns the given texel in 32-bit ARGB 8888 format.*/
+static uint32_t argb1555_to_argb8888(const uint16_t texel)
+{
+    const uint32_t r = ((texel >> 10) & 0x1f);
+    const uint32_t g = ((texel >> 5) & 0x1f);
+    const uint32_t b = ((texel >> 0) & 0x1f);
+
+    return (((texel & 0x8000)? 0xff000000u : 0) |
+            (((r << 3) | (r >> 2)) << 16) |
+            (((g << 3) | (g >> 2)) << 8) |
+            (((b << 3) | (b >> 2)) << 0));
+}
+
+/* Maps the given texel coordinate into the range [0,sideLength).*/
+static int wrap_texel_coordinate(const int coordinate,
+                                 const int sideLength,
+                                 const int clamped)
+{
+    if (clamped)
+    {
+        return ((coordinate < 0)? 0 : (coordinate >= sideLength)? (sideLength - 1) : coordinate);
+    }
+
+    /* Side lengths are powers of two.*/
+    return (coordinate & (sideLength - 1));
+}
+
+/* Maps the given UV coordinate into the range [0,1] as per the texture's wrap
+ * mode. Non-finite values are mapped to 0.*/
+static float wrap_uv_coordinate(float coordinate,
+                                const int clamped)
+{
+    if (clamped)
+    {
+        coordinate = ((coordinate > 1)? 1 : coordinate);
+    }
+    else
+    {
+        coordinate -= floor(coordinate);
+    }
+
+    return ((coordinate >= 0) && (coordinate <= 1))? coordinate : 0;
+}
+
+/* Returns the color, in 32-bit ARGB 8888 format, of the given triangle's texture
+ * at the given UV coordinates.*/
+static uint32_t sample_texture(const struct kelpo_software_triangle_setup_s *const setup,
+                               const float u,
+                               const float v)
+{
+    const int sideLength = (setup->texture->sideLength >> setup->mipLevel);
+    const uint16_t *const texels = setup->texture->mipLevel[setup->mipLevel];
+    const float texelU = (wrap_uv_coordinate(u, setup->clamped) * sideLength);
+    const float texelV = (wrap_uv_coordinate(v, setup->clamped) * sideLength);
+
+    if (setup->noFiltering)
+    {
+        const int tx = wrap_texel_coordinate(texelU, sideLength, setup->clamped);
+        const int ty = wrap_texel_coordinate(texelV, sideLength, setup->clamped);
+
+        return argb1555_to_argb8888(texels[tx + (ty * sideLength)]);
+    }
+    /* Bilinear filtering.*/
+    else
+    {
+        unsigned c = 0;
+        uint32_t result = 0;
+        const float fu = (texelU - 0.5f);
+        const float fv = (texelV - 0.5f);
+        const int baseX = floor(fu);
+        const int baseY = floor(fv);
+        const uint32_t weightX = ((fu - baseX) * 256);
+        const uint32_t weightY = ((fv - baseY) * 256);
+        const int x0 = wrap_texel_coordinate(baseX, sideLength, setup->clamped);
+        const int x1 = wrap_texel_coordinate((baseX + 1), sideLength, setup->clamped);
+        const int y0 = wrap_texel_coordinate(baseY, sideLength, setup->clamped);
+        const int y1 = wrap_texel_coordinate((baseY + 1), sideLength, setup->clamped);
+        const uint32_t t00 = argb1555_to_argb8888(texels[x0 + (y0 * sideLength)]);
+        const uint32_t t10 = argb1555_to_argb8888(texels[x1 + (y0 * sideLength)]);
+        const uint32_t t01 = argb1555_to_argb8888(texels[x0 + (y1 * sideLength)]);
+        const uint32_t t11 = argb1555_to_argb8888(texels[x1 + (y1 * sideLength)]);
+
+        /* Blend each 8-bit channel separately.*/
+        for (c = 0; c < 32; c += 8)
+        {
+            const uint32_t top = ((((t00 >> c) & 0xff) * (256 - weightX)) + (((t10 >> c) & 0xff) * weightX));
+            const uint32_t bottom = ((((t01 >> c) & 0xff) * (256 - weightX)) + (((t11 >> c) & 0xff) * weightX));
+
+            result |= ((((top * (256 - weightY)) + (bottom * weightY)) >> 16) << c);
+        }
+
+        return result;
+    }
+}
+
+static uint32_t clamp_color_channel(const float value)
+{
+    return ((value <= 0)? 0 : (value >= 255)? 255 : (uint32_t)value);
+}
+
+void kelpo_rasterizer_software__shade_fragment(const struct kelpo_software_triangle_setup_s *const setup,
+                                               const int x,
+                                               const int y,
+                                               const struct kelpo_software_fragment_s *const fragment)
+{
+    const unsigned bufferIdx = (x + (y * RENDER_WIDTH));
+    uint32_t r, g, b;
+
+    if (fragment->depth > DEPTH_BUFFER[bufferIdx])
+    {
+        return;
+    }
+
+    r = clamp_color_channel(fragment->r);
+    g = clamp_color_channel(fragment->g);
+    b = clamp_color_channel(fragment->b);
+
+    if (setup->texture)
+    {
+        const float u = (fragment->uw / fragment->w);
+        const float v = (fragment->vw / fragment->w);
+        const uint32_t texel = sample_texture(setup, u, v);
+        const uint32_t a = clamp_color_channel(fragment->a);
+
+        /* Alpha test, as in the hardware rasterizers: the texel's alpha
+         * modulated by the vertex alpha must exceed one half.*/
+        if ((((texel >> 24) * a) / 255) <= 127)
+        {
+            return;
+        }
+
+        r = ((r * ((texel >> 16) & 0xff)) / 255);
+        g = ((g * ((texel >> 8) & 0xff)) / 255);
+        b = ((b * ((texel >> 0) & 0xff)) / 255);
+    }
+
+    PIXEL_BUFFER[bufferIdx] = ((r << 16) | (g << 8) | b);
+    DEPTH_BUFFER[bufferIdx] = fragment->depth;
+
+    return;
+}
+
+/* Shades the given pixel, which is assumed to be inside the given triangle.*/
+static void shade_pixel(const struct kelpo_software_triangle_setup_s *const setup,
+                        const int x,
+                        const int y)
+{
+    struct kelpo_software_fragment_s fragment;
+    const float offsX = (x - setup->originX);
+    const float offsY = (y - setup->originY);
+
+    fragment.depth = INTERPOLATE(setup->z, offsX, offsY);
+    fragment.r = INTERPOLATE(setup->r, offsX, offsY);
+    fragment.g = INTERPOLATE(setup->g, offsX, offsY);
+    fragment.b = INTERPOLATE(setup->b, offsX, offsY);
+    fragment.a = INTERPOLATE(setup->a, offsX, offsY);
+
+    if (setup->texture)
+    {
+        fragment.w = INTERPOLATE(setup->w, offsX, offsY);
+        fragment.uw = INTERPOLATE(setup->uw, offsX, offsY);
+        fragment.vw = INTERPOLATE(setup->vw, offsX, offsY);
+    }
+
+    kelpo_rasterizer_software__shade_fragment(setup, x, y, &fragment);
+
+    return;
+}
+
+/* Returns 1 if the given pixel is inside the given triangle; 0 otherwise.*/
+static int is_pixel_inside_triangle(const struct kelpo_software_triangle_setup_s *const setup,
+                                    const int x,
+                                    const int y)
+{
+    unsigned i = 0;
+
+    for (i = 0; i < 3; i++)
+    {
+        if (((setup->edgeA[i] * x) + (setup->edgeB[i] * y) + setup->edgeC[i]) < 0)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* Rasterizes the part of the given triangle that lies inside the given tile,
+ * visiting the pixels one at a time. Used when no SIMD kernel is available.*/
+static void rasterize_triangle_scalar(const struct kelpo_software_triangle_setup_s *const setup,
+                                      const int tileX,
+                                      const int tileY)
+{
+    int x = 0, y = 0;
+    const int minX = ((setup->minX > tileX)? setup->minX : tileX);
+    const int minY = ((setup->minY > tileY)? setup->minY : tileY);
+    const int maxX = ((setup->maxX < (tileX + KELPO_SOFTWARE_TILE_SIZE))? setup->maxX : (tileX + KELPO_SOFTWARE_TILE_SIZE));
+    const int maxY = ((setup->maxY < (tileY + KELPO_SOFTWARE_TILE_SIZE))? setup->maxY : (tileY + KELPO_SOFTWARE_TILE_SIZE));
+
+    for (y = minY; y < maxY; y++)
+    {
+        for (x = minX; x < maxX; x++)
+        {
+            if (is_pixel_inside_triangle(setup, x, y))
+            {
+                shade_pixel(setup, x, y);
+            }
+        }
+    }
+
+    return;
+}
+
+/* Triangles of the current draw call to be set up for rasterization: either
+ * those passed to draw_triangles(), or the vertices (three per triangle) of a
+ * batch passed to draw_vertex_buffer(), with the batch's texture. Their setups
+ * go into TRIANGLE_SETUPS from index 'firstSetupIdx' on.*/
+struct setup_source_s
+{
+    const struct kelpo_polygon_triangle_s *triangles;
+    const struct kelpo_polygon_vertex_s *vertices;
+    const struct kelpo_polygon_texture_s *texture;
+    unsigned firstSetupIdx;
+    unsigned numTriangles;
+};
+
+/* Thread pool job. Sets up the given batch of the current draw call's triangles
+ * for rasterization. The context is the struct setup_source_s of the triangles.*/
+static void setup_triangle_batch(void *const context, const unsigned batchIdx)
+{
+    unsigned i = 0;
+    const struct setup_source_s *const source = (const struct setup_source_s*)context;
+    const unsigned firstIdx = (batchIdx * SETUP_BATCH_SIZE);
+    const unsigned endIdx = (((firstIdx + SETUP_BATCH_SIZE) < source->numTriangles)
+                             ? (firstIdx + SETUP_BATCH_SIZE)
+                             : source->numTriangles);
+    struct kelpo_software_triangle_setup_s *const setups = &((struct kelpo_software_triangle_setup_s*)TRIANGLE_SETUPS->data)[source->firstSetupIdx];
+
+    for (i = firstIdx; i < endIdx; i++)
+    {
+        if (source->triangles)
+        {
+            setup_triangle(source->triangles[i].vertex, source->triangles[i].texture, &setups[i]);
+        }
+        else
+        {
+            setup_triangle(&source->vertices[i * 3], source->texture, &setups[i]);
+        }
+    }
+
+    return;
+}
+
+/* Sets up the given triangles for rasterization.*/
+static void setup_triangles(struct setup_source_s *const source)
+{
+    kelpoa_thread_pool__run(THREAD_POOL, setup_triangle_batch, source, ((source->numTriangles + SETUP_BATCH_SIZE - 1) / SETUP_BATCH_SIZE));
+
+    return;
+}
+
+/* Thread pool job. Rasterizes the triangles binned into the given tile.*/
+static void rasterize_tile(void *const context, const unsigned tileIdx)
+{
+    uint32_t i = 0;
+    const struct kelpoa_generic_stack_s *const bin = TILE_BINS[tileIdx];
+    const uint32_t *const setupIndices = (const uint32_t*)bin->data;
+    const struct kelpo_software_triangle_setup_s *const setups = (const struct kelpo_software_triangle_setup_s*)TRIANGLE_SETUPS->data;
+    const int tileX = ((tileIdx % NUM_TILES_X) * KELPO_SOFTWARE_TILE_SIZE);
+    const int tileY = ((tileIdx / NUM_TILES_X) * KELPO_SOFTWARE_TILE_SIZE);
+
+    (void)context;
+
+    for (i = 0; i < bin->count; i++)
+    {
+        RASTERIZE_TRIANGLE(&setups[setupIndices[i]], tileX, tileY);
+    }
+
+    return;
+}
+
+/* Adds each set-up triangle to the bins of the tiles its bounding rectangle
+ * overlaps, in submission order.*/
+static void bin_triangles(void)
+{
+    uint32_t i = 0;
+    const struct kelpo_software_triangle_setup_s *const setups = (const struct kelpo_software_triangle_setup_s*)TRIANGLE_SETUPS->data;
+
+    for (i = 0; i < (NUM_TILES_X * NUM_TILES_Y); i++)
+    {
+        kelpoa_generic_stack__clear(TILE_BINS[i]);
+    }
+
+    for (i = 0; i < TRIANGLE_SETUPS->count; i++)
+    {
+        int tx = 0, ty = 0;
+        const struct kelpo_software_triangle_setup_s *const setup = &setups[i];
+
+        if ((setup->minX >= setup->maxX) ||
+            (setup->minY >= setup->maxY))
+        {
+            continue;
+        }
+
+        for (ty = (setup->minY / KELPO_SOFTWARE_TILE_SIZE); ty <= ((setup->maxY - 1) / KELPO_SOFTWARE_TILE_SIZE); ty++)
+        {
+            for (tx = (setup->minX / KELPO_SOFTWARE_TILE_SIZE); tx <= ((setup->maxX - 1) / KELPO_SOFTWARE_TILE_SIZE); tx++)
+            {
+                kelpoa_generic_stack__push_copy(TILE_BINS[tx + (ty * NUM_TILES_X)], &i);
+            }
+        }
+    }
+
+    return;
+}
+
+/* Bins and rasterizes the triangles set up in TRIANGLE_SETUPS.*/
+static void rasterize_triangles(void)
+{
+    KELPOA_PROF_BEGIN("bin");
+    bin_triangles();
+    KELPOA_PROF_END();
+
+    KELPOA_PROF_BEGIN("rasterize");
+    kelpoa_thread_pool__run(THREAD_POOL, rasterize_tile, NULL, (NUM_TILES_X * NUM_TILES_Y));
+    KELPOA_PROF_END();
+
+    return;
+}
+
+int kelpo_rasterizer_software__draw_triangles(struct kelpo_polygon_triangle_s *const triangles,
+                                              const unsigned numTriangles)
+{
+    struct setup_source_s source;
+
+    assert((PIXEL_BUFFER && DEPTH_BUFFER) &&
+           "Attempting to draw before the rasterizer has been initialized.");
+
+    KELPOA_PROF_BEGIN("kelpo_rasterizer_software__draw_triangles");
+
+    if (!numTriangles)
+    {
+        KELPOA_PROF_END();
+        return 1;
+    }
+
+    kelpoa_generic_stack__grow(TRIANGLE_SETUPS, numTriangles);
+    TRIANGLE_SETUPS->count = numTriangles;
+
+    source.triangles = triangles;
+    source.vertices = NULL;
+    source.texture = NULL;
+    source.firstSetupIdx = 0;
+    source.numTriangles = numTriangles;
+
+    KELPOA_PROF_BEGIN("setup");
+    setup_triangles(&source);
+    KELPOA_PROF_END();
+
+    rasterize_triangles();
+
+    KELPOA_PROF_END();
+    return 1;
+}
+
+int kelpo_rasterizer_software__map_vertex_buffer(const unsigned numVertices,
+                                                 void **const vertices,
+                                                 struct kelpo_vertex_format_s *const format)
+{
+    assert(VERTEX_BUFFER &&
+           "Attempting to map the vertex buffer before the rasterizer has been initialized.");
+
+    kelpoa_generic_stack__grow(VERTEX_BUFFER, numVertices);
+
+    if (!VERTEX_BUFFER->data)
+    {
+        kelpo_error(KELPOERR_OUT_OF_SYSTEM_MEMORY);
+        return 0;
+    }
+
+    VERTEX_BUFFER->count = numVertices;
+
+    format->stride = sizeof(struct kelpo_polygon_vertex_s);
+    format->xyOffset = offsetof(struct kelpo_polygon_vertex_s, x);
+    format->zOffset = offsetof(struct kelpo_polygon_vertex_s, z);
+    format->wOffset = offsetof(struct kelpo_polygon_vertex_s, w);
+    format->uvOffset = offsetof(struct kelpo_polygon_vertex_s, u);
+    format->uvScale = 1;
+    format->isUVPremultiplied = 0;
+    format->colorOffset = offsetof(struct kelpo_polygon_vertex_s, r);
+    format->colorOrder = KELPO_VERTEX_COLOR_RGBA;
+
+    *vertices = VERTEX_BUFFER->data;
+
+    return 1;
+}
+
+int kelpo_rasterizer_software__draw_vertex_buffer(const struct kelpo_vertex_batch_s *const batches,
+                                                  const unsigned numBatches)
+{
+    unsigned i = 0;
+    unsigned numTriangles = 0;
+    struct setup_source_s source;
+
+    assert((PIXEL_BUFFER && DEPTH_BUFFER) &&
+           "Attempting to draw before the rasterizer has been initialized.");
+
+    KELPOA_PROF_BEGIN("kelpo_rasterizer_software__draw_vertex_buffer");
+
+    for (i = 0; i < numBatches; i++)
+    {
+        assert(!(batches[i].numVertices % 3) &&
+               ((batches[i].firstVertex + batches[i].numVertices) <= VERTEX_BUFFER->count) &&
+               "Invalid vertex batch.");
+
+        numTriangles += (batches[i].numVertices / 3);
+    }
+
+    if (!numTriangles)
+    {
+        KELPOA_PROF_END();
+        return 1;
+    }
+
+    kelpoa_generic_stack__grow(TRIANGLE_SETUPS, numTriangles);
+    TRIANGLE_SETUPS->count = numTriangles;
+
+    source.triangles = NULL;
+    source.firstSetupIdx = 0;
+
+    /* The batches are set up one after the other, so that the setups stay
+     * in the order of the batches.*/
+    KELPOA_PROF_BEGIN("setup");
+    for (i = 0; i < numBatches; i++)
+    {
+        source.vertices = &((const struct kelpo_polygon_vertex_s*)VERTEX_BUFFER->data)[batches[i].firstVertex];
+        source.texture = batches[i].texture;
+        source.numTriangles = (batches[i].numVertices / 3);
+
+        setup_triangles(&source);
+
+        source.firstSetupIdx += source.numTriangles;
+    }
+    KELPOA_PROF_END();
+
+    rasterize_triangles();
+
+    KELPOA_PROF_END();
+    return 1;
+}
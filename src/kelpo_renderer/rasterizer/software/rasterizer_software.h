@@ -0,0 +1,57 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * Software rasterizer for the Kelpo renderer.
+ *
+ */
+
+#ifndef KELPO_RENDERER_RASTERIZER_SOFTWARE_H
+#define KELPO_RENDERER_RASTERIZER_SOFTWARE_H
+
+#include <kelpo_interface/stdint.h>
+
+struct kelpo_polygon_triangle_s;
+struct kelpo_polygon_texture_s;
+struct kelpo_vertex_format_s;
+struct kelpo_vertex_batch_s;
+
+/* Allocates the rasterizer's in-memory render target (pixel and depth buffers)
+ * at the given resolution.*/
+int kelpo_rasterizer_software__initialize(const unsigned width,
+                                          const unsigned height);
+
+int kelpo_rasterizer_software__release(void);
+
+int kelpo_rasterizer_software__clear_frame(void);
+
+int kelpo_rasterizer_software__upload_texture(struct kelpo_polygon_texture_s *const texture);
+
+int kelpo_rasterizer_software__update_texture(struct kelpo_polygon_texture_s *const texture);
+
+int kelpo_rasterizer_software__unload_textures(void);
+
+int kelpo_rasterizer_software__draw_triangles(struct kelpo_polygon_triangle_s *const triangles,
+                                              const unsigned numTriangles);
+
+int kelpo_rasterizer_software__map_vertex_buffer(const unsigned numVertices,
+                                                 void **const vertices,
+                                                 struct kelpo_vertex_format_s *const format);
+
+int kelpo_rasterizer_software__draw_vertex_buffer(const struct kelpo_vertex_batch_s *const batches,
+                                                  const unsigned numBatches);
+
+/* Returns a pointer to the rasterizer's pixel buffer, or NULL if the rasterizer
+ * hasn't been initialized. The pixels are in 32-bit XRGB 8888 format, stored in
+ * rows from top to bottom; the buffer's dimensions are those given to
+ * kelpo_rasterizer_software__initialize(). Surfaces use this to present the
+ * rendered image.*/
+const uint32_t* kelpo_rasterizer_software__pixels(void);
+
+/* Selects whether pixels are visited by the SIMD kernel, if the CPU supports
+ * one, or by the scalar loop, overriding the KELPO_SOFTWARE_NO_SIMD environment
+ * variable. Returns 1 if the SIMD kernel is now in use; 0 otherwise. The two
+ * are meant to produce identical images; clients (e.g. tools/golden) can use
+ * this to check that they do.*/
+int kelpo_rasterizer_software__use_simd(const int useSimd);
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * Data and functions shared between the software rasterizer and its
+ * rasterization kernels. Not part of the rasterizer's public interface.
+ *
+ */
+
+#ifndef KELPO_RENDERER_RASTERIZER_SOFTWARE_KERNELS_H
+#define KELPO_RENDERER_RASTERIZER_SOFTWARE_KERNELS_H
+
+#include <kelpo_interface/stdint.h>
+
+/* The side length, in pixels, of the screen tiles into which triangles are
+ * binned. A tile's pixel and depth values fit comfortably in a CPU's L2 cache.*/
+#define KELPO_SOFTWARE_TILE_SIZE 64
+
+/* The side length, in pixels, of the blocks that the SIMD kernels accept or
+ * reject as a whole. Tiles are made up of a whole number of blocks.*/
+#define KELPO_SOFTWARE_BLOCK_SIZE 8
+
+/* The rasterizer's copy of an uploaded texture's pixel data.*/
+struct kelpo_software_texture_s
+{
+    unsigned sideLength;
+    unsigned numMipLevels;
+    uint16_t *mipLevel[9];
+};
+
+/* A linear function of screen XY, for interpolating a vertex attribute across
+ * a triangle.*/
+struct kelpo_software_attribute_plane_s
+{
+    float origin;
+    float dx;
+    float dy;
+};
+
+/* Per-triangle values needed by the rasterizer, computed once per triangle
+ * before its pixels are visited.*/
+struct kelpo_software_triangle_setup_s
+{
+    /* The triangle's bounding rectangle in pixels, clipped to the render target.
+     * Min values are inclusive, max values exclusive. Triangles that cover no
+     * pixels have an empty rectangle.*/
+    int minX, minY, maxX, maxY;
+
+    /* The screen position of the vertex relative to which the attribute planes
+     * are evaluated.*/
+    float originX, originY;
+
+    /* The triangle's edge functions, edge(x, y) = ((a * x) + (b * y) + c), for
+     * pixel coordinates x and y. A pixel is inside the triangle if all three are
+     * non-negative. The coefficients are in units of 1/16 (a and b) and 1/256
+     * (c) pixels, so that for the sub-pixel-snapped vertices every edge value
+     * is an integer, and so exactly representable. The fill rule's tie-breaking
+     * is folded into c.*/
+    double edgeA[3], edgeB[3], edgeC[3];
+
+    /* Interpolated vertex attributes. Texture coordinates are pre-multiplied by
+     * the vertex's W (which is 1/w following the perspective divide), so they
+     * can be interpolated linearly in screen space.*/
+    struct kelpo_software_attribute_plane_s z, w, uw, vw, r, g, b, a;
+
+    /* Will be NULL if the triangle is untextured.*/
+    const struct kelpo_software_texture_s *texture;
+    unsigned mipLevel;
+    int noFiltering;
+    int clamped;
+};
+
+/* A triangle's interpolated attributes at a given pixel.*/
+struct kelpo_software_fragment_s
+{
+    float depth;
+    float w, uw, vw;
+    float r, g, b, a;
+};
+
+/* Depth-tests, textures and writes into the render target the given fragment
+ * of the given triangle at the given pixel.*/
+void kelpo_rasterizer_software__shade_fragment(const struct kelpo_software_triangle_setup_s *const setup,
+                                               const int x,
+                                               const int y,
+                                               const struct kelpo_software_fragment_s *const fragment);
+
+/* Returns 1 if the CPU supports the SSE2 kernel; 0 otherwise.*/
+int kelpo_rasterizer_software_sse2__is_supported(void);
+
+/* Rasterizes the part of the given triangle that lies inside the tile whose
+ * top left pixel is at (tileX, tileY), using SSE2 instructions.*/
+void kelpo_rasterizer_software_sse2__rasterize_triangle(const struct kelpo_software_triangle_setup_s *const setup,
+                                                        const int tileX,
+                                                        const int tileY);
+
+#endif
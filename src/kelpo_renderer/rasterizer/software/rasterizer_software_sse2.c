@@ -0,0 +1,340 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * SSE2 rasterization kernel for Kelpo's software rasterizer.
+ *
+ * Walks a triangle's pixels in 8 x 8 blocks. Each block is first tested as a
+ * whole against the triangle's edges, so that blocks fully outside the triangle
+ * are skipped and blocks fully inside it are filled without per-pixel edge
+ * tests. The pixels of the remaining blocks are edge-tested four at a time.
+ * Depth, 1/w and the other vertex attributes are likewise interpolated for four
+ * pixels at a time, using the same arithmetic as the scalar loop in
+ * rasterizer_software.c.
+ *
+ * This file must be compiled with SSE2 code generation enabled (e.g. -msse2);
+ * otherwise, the kernel reports itself as unsupported.
+ *
+ */
+
+#include <kelpo_renderer/rasterizer/software/rasterizer_software_kernels.h>
+
+#if defined(__SSE2__)
+
+#include <emmintrin.h>
+
+#if defined(__GNUC__) && !defined(__x86_64__)
+    #include <cpuid.h>
+#endif
+
+/* The largest per-pixel edge function step for which a block's edge values are
+ * evaluated in 32-bit integers. Triangles with steeper edges (which would have
+ * to span hundreds of thousands of pixels) are edge-tested in double precision
+ * instead.*/
+#define MAX_INTEGER_EDGE_STEP 16777216.0
+
+/* An attribute plane's coefficients, each broadcast into four lanes.*/
+struct attribute_plane_4_s
+{
+    __m128 origin;
+    __m128 dx;
+    __m128 dy;
+};
+
+/* Evaluates the given attribute plane for four pixels at the given offsets from
+ * the plane's origin vertex. Same order of operations as the scalar loop's
+ * INTERPOLATE().*/
+#define INTERPOLATE_4(plane, offsX, offsY) _mm_add_ps(_mm_add_ps((plane).origin, _mm_mul_ps((plane).dx, (offsX))),\
+                                                      _mm_mul_ps((plane).dy, (offsY)))
+
+/* A triangle's attribute planes, broadcast for four-pixel evaluation.*/
+struct attribute_planes_4_s
+{
+    struct attribute_plane_4_s z, r, g, b, a, w, uw, vw;
+};
+
+static void broadcast_attribute_plane(struct attribute_plane_4_s *const dst,
+                                      const struct kelpo_software_attribute_plane_s *const src)
+{
+    dst->origin = _mm_set1_ps(src->origin);
+    dst->dx = _mm_set1_ps(src->dx);
+    dst->dy = _mm_set1_ps(src->dy);
+
+    return;
+}
+
+int kelpo_rasterizer_software_sse2__is_supported(void)
+{
+    #if defined(__x86_64__)
+        /* SSE2 is part of the x86-64 baseline.*/
+        return 1;
+    #elif defined(__GNUC__)
+        unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        {
+            return 0;
+        }
+
+        return ((edx & bit_SSE2) != 0);
+    #else
+        return 0;
+    #endif
+}
+
+/* Returns the value of the given edge function at the given pixel.*/
+static double edge_value(const struct kelpo_software_triangle_setup_s *const setup,
+                         const unsigned edgeIdx,
+                         const int x,
+                         const int y)
+{
+    return ((setup->edgeA[edgeIdx] * x) + (setup->edgeB[edgeIdx] * y) + setup->edgeC[edgeIdx]);
+}
+
+/* Returns a 4-bit mask of which of the four pixels starting at (x, y) and going
+ * right are inside the triangle, with the edge functions evaluated in double
+ * precision.*/
+static int coverage_mask_double(const struct kelpo_software_triangle_setup_s *const setup,
+                                const int x,
+                                const int y)
+{
+    int lane = 0, mask = 0;
+
+    for (lane = 0; lane < 4; lane++)
+    {
+        if ((edge_value(setup, 0, (x + lane), y) >= 0) &&
+            (edge_value(setup, 1, (x + lane), y) >= 0) &&
+            (edge_value(setup, 2, (x + lane), y) >= 0))
+        {
+            mask |= (1 << lane);
+        }
+    }
+
+    return mask;
+}
+
+/* Rasterizes the pixels of the given block that are inside both the triangle
+ * and the given clip rectangle. 'straddledEdges' is a bit mask of the triangle
+ * edges that cross the block, i.e. against which each pixel's coverage has to
+ * be tested; if it's 0, all of the block's pixels are inside the triangle.*/
+static void rasterize_block(const struct kelpo_software_triangle_setup_s *const setup,
+                            const int blockX,
+                            const int blockY,
+                            const int clipMinX,
+                            const int clipMinY,
+                            const int clipMaxX,
+                            const int clipMaxY,
+                            const int straddledEdges,
+                            const int useIntegerEdges,
+                            const struct attribute_planes_4_s *const planes)
+{
+    int x = 0, y = 0, e = 0;
+    const int minX = ((blockX > clipMinX)? blockX : clipMinX);
+    const int minY = ((blockY > clipMinY)? blockY : clipMinY);
+    const int maxX = (((blockX + KELPO_SOFTWARE_BLOCK_SIZE) < clipMaxX)? (blockX + KELPO_SOFTWARE_BLOCK_SIZE) : clipMaxX);
+    const int maxY = (((blockY + KELPO_SOFTWARE_BLOCK_SIZE) < clipMaxY)? (blockY + KELPO_SOFTWARE_BLOCK_SIZE) : clipMaxY);
+    const int isTextured = (setup->texture != NULL);
+    const __m128i laneOffsets = _mm_set_epi32(3, 2, 1, 0);
+    const __m128 originX = _mm_set1_ps(setup->originX);
+    __m128i edgeRowStart[3];
+    __m128i edgeStepX4[3];
+    __m128i edgeStepY[3];
+
+    /* The edge values of the block's first group of four pixels. The values of
+     * an edge that straddles the block lie between the edge's (negative) minimum
+     * and (non-negative) maximum over the block, so they're small enough to be
+     * stepped through in 32-bit integers (exactly, since they're integers to
+     * begin with). The values of the other edges needn't be, so those edges are
+     * left out of the test, their values held at 0.*/
+    for (e = 0; e < 3; e++)
+    {
+        if (useIntegerEdges && (straddledEdges & (1 << e)))
+        {
+            const int stepX = (int)setup->edgeA[e];
+            const int stepY = (int)setup->edgeB[e];
+            const int startValue = (int)edge_value(setup, e, minX, minY);
+
+            edgeRowStart[e] = _mm_add_epi32(_mm_set1_epi32(startValue),
+                                            _mm_set_epi32((3 * stepX), (2 * stepX), stepX, 0));
+            edgeStepX4[e] = _mm_set1_epi32(4 * stepX);
+            edgeStepY[e] = _mm_set1_epi32(stepY);
+        }
+        else
+        {
+            edgeRowStart[e] = edgeStepX4[e] = edgeStepY[e] = _mm_setzero_si128();
+        }
+    }
+
+    for (y = minY; y < maxY; y++)
+    {
+        const __m128 offsY = _mm_set1_ps((float)y - setup->originY);
+        __m128i edgeValues[3];
+
+        edgeValues[0] = edgeRowStart[0];
+        edgeValues[1] = edgeRowStart[1];
+        edgeValues[2] = edgeRowStart[2];
+
+        for (x = minX; x < maxX; x += 4)
+        {
+            int lane = 0;
+            int mask = ((maxX - x) >= 4)? 0xf : ((1 << (maxX - x)) - 1);
+
+            if (straddledEdges)
+            {
+                if (useIntegerEdges)
+                {
+                    /* A pixel is inside if none of its edge values is negative.*/
+                    const __m128i negatives = _mm_or_si128(_mm_or_si128(edgeValues[0], edgeValues[1]), edgeValues[2]);
+
+                    mask &= ~_mm_movemask_ps(_mm_castsi128_ps(negatives));
+
+                    edgeValues[0] = _mm_add_epi32(edgeValues[0], edgeStepX4[0]);
+                    edgeValues[1] = _mm_add_epi32(edgeValues[1], edgeStepX4[1]);
+                    edgeValues[2] = _mm_add_epi32(edgeValues[2], edgeStepX4[2]);
+                }
+                else
+                {
+                    mask &= coverage_mask_double(setup, x, y);
+                }
+            }
+
+            if (mask)
+            {
+                float depth4[4], r4[4], g4[4], b4[4], a4[4], w4[4], uw4[4], vw4[4];
+                const __m128 offsX = _mm_sub_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(x), laneOffsets)), originX);
+
+                _mm_storeu_ps(depth4, INTERPOLATE_4(planes->z, offsX, offsY));
+                _mm_storeu_ps(r4, INTERPOLATE_4(planes->r, offsX, offsY));
+                _mm_storeu_ps(g4, INTERPOLATE_4(planes->g, offsX, offsY));
+                _mm_storeu_ps(b4, INTERPOLATE_4(planes->b, offsX, offsY));
+                _mm_storeu_ps(a4, INTERPOLATE_4(planes->a, offsX, offsY));
+
+                if (isTextured)
+                {
+                    _mm_storeu_ps(w4, INTERPOLATE_4(planes->w, offsX, offsY));
+                    _mm_storeu_ps(uw4, INTERPOLATE_4(planes->uw, offsX, offsY));
+                    _mm_storeu_ps(vw4, INTERPOLATE_4(planes->vw, offsX, offsY));
+                }
+
+                for (lane = 0; lane < 4; lane++)
+                {
+                    if (mask & (1 << lane))
+                    {
+                        struct kelpo_software_fragment_s fragment;
+
+                        fragment.depth = depth4[lane];
+                        fragment.r = r4[lane];
+                        fragment.g = g4[lane];
+                        fragment.b = b4[lane];
+                        fragment.a = a4[lane];
+
+                        if (isTextured)
+                        {
+                            fragment.w = w4[lane];
+                            fragment.uw = uw4[lane];
+                            fragment.vw = vw4[lane];
+                        }
+
+                        kelpo_rasterizer_software__shade_fragment(setup, (x + lane), y, &fragment);
+                    }
+                }
+            }
+        }
+
+        edgeRowStart[0] = _mm_add_epi32(edgeRowStart[0], edgeStepY[0]);
+        edgeRowStart[1] = _mm_add_epi32(edgeRowStart[1], edgeStepY[1]);
+        edgeRowStart[2] = _mm_add_epi32(edgeRowStart[2], edgeStepY[2]);
+    }
+
+    return;
+}
+
+void kelpo_rasterizer_software_sse2__rasterize_triangle(const struct kelpo_software_triangle_setup_s *const setup,
+                                                        const int tileX,
+                                                        const int tileY)
+{
+    int blockX = 0, blockY = 0, e = 0;
+    int useIntegerEdges = 1;
+    struct attribute_planes_4_s planes;
+    const int blockSpan = (KELPO_SOFTWARE_BLOCK_SIZE - 1);
+    const int minX = ((setup->minX > tileX)? setup->minX : tileX);
+    const int minY = ((setup->minY > tileY)? setup->minY : tileY);
+    const int maxX = ((setup->maxX < (tileX + KELPO_SOFTWARE_TILE_SIZE))? setup->maxX : (tileX + KELPO_SOFTWARE_TILE_SIZE));
+    const int maxY = ((setup->maxY < (tileY + KELPO_SOFTWARE_TILE_SIZE))? setup->maxY : (tileY + KELPO_SOFTWARE_TILE_SIZE));
+
+    for (e = 0; e < 3; e++)
+    {
+        if ((setup->edgeA[e] > MAX_INTEGER_EDGE_STEP) || (setup->edgeA[e] < -MAX_INTEGER_EDGE_STEP) ||
+            (setup->edgeB[e] > MAX_INTEGER_EDGE_STEP) || (setup->edgeB[e] < -MAX_INTEGER_EDGE_STEP))
+        {
+            useIntegerEdges = 0;
+        }
+    }
+
+    broadcast_attribute_plane(&planes.z, &setup->z);
+    broadcast_attribute_plane(&planes.r, &setup->r);
+    broadcast_attribute_plane(&planes.g, &setup->g);
+    broadcast_attribute_plane(&planes.b, &setup->b);
+    broadcast_attribute_plane(&planes.a, &setup->a);
+    broadcast_attribute_plane(&planes.w, &setup->w);
+    broadcast_attribute_plane(&planes.uw, &setup->uw);
+    broadcast_attribute_plane(&planes.vw, &setup->vw);
+
+    /* Blocks are aligned to the block grid, which tiles align with too.*/
+    for (blockY = (minY & ~blockSpan); blockY < maxY; blockY += KELPO_SOFTWARE_BLOCK_SIZE)
+    {
+        for (blockX = (minX & ~blockSpan); blockX < maxX; blockX += KELPO_SOFTWARE_BLOCK_SIZE)
+        {
+            int isOutside = 0;
+            int straddledEdges = 0;
+
+            /* Find the smallest and largest value each edge function takes in
+             * the block; these are at opposite corners of the block.*/
+            for (e = 0; e < 3; e++)
+            {
+                const double stepX = (setup->edgeA[e] * blockSpan);
+                const double stepY = (setup->edgeB[e] * blockSpan);
+                const double corner = edge_value(setup, e, blockX, blockY);
+                const double minValue = (corner + ((stepX < 0)? stepX : 0) + ((stepY < 0)? stepY : 0));
+                const double maxValue = (corner + ((stepX > 0)? stepX : 0) + ((stepY > 0)? stepY : 0));
+
+                if (maxValue < 0)
+                {
+                    isOutside = 1;
+                    break;
+                }
+
+                if (minValue < 0)
+                {
+                    straddledEdges |= (1 << e);
+                }
+            }
+
+            if (!isOutside)
+            {
+                rasterize_block(setup, blockX, blockY, minX, minY, maxX, maxY, straddledEdges, useIntegerEdges, &planes);
+            }
+        }
+    }
+
+    return;
+}
+
+#else
+
+int kelpo_rasterizer_software_sse2__is_supported(void)
+{
+    return 0;
+}
+
+void kelpo_rasterizer_software_sse2__rasterize_triangle(const struct kelpo_software_triangle_setup_s *const setup,
+                                                        const int tileX,
+                                                        const int tileY)
+{
+    (void)setup;
+    (void)tileX;
+    (void)tileY;
+
+    return;
+}
+
+#endif
@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <kelpo_renderer/rasterizer/null/rasterizer_null.h>
+#include <kelpo_renderer/window/offscreen/window_offscreen.h>
+#include <kelpo_interface/interface.h>
+
+static const char RENDERER_NAME[] = "Null";
+static const unsigned RENDERER_VERSION[3] = {KELPO_INTERFACE_VERSION_MAJOR,
+                                             1,   /* Minor.*/
+                                             0};  /* Patch.*/
+
+static int initialize(const unsigned deviceId,
+                      const unsigned screenWidth,
+                      const unsigned screenHeight,
+                      const unsigned screenBPP)
+{
+    if (!kelpo_window__create_window(screenWidth, screenHeight, RENDERER_NAME, NULL))
+    {
+        goto initialization_failed;
+    }
+
+    if (!kelpo_rasterizer_null__initialize())
+    {
+        kelpo_rasterizer_null__release();
+        goto initialization_failed;
+    }
+
+    return 1;
+
+    initialization_failed:
+    kelpo_window__release_window();
+    return 0;
+}
+
+static int release(void)
+{
+    return (kelpo_rasterizer_null__release() &
+            kelpo_window__release_window());
+}
+
+/* There's no surface to display, so flipping is a no-op.*/
+static int flip_surface(void)
+{
+    return 1;
+}
+
+/* Returns 1 on success; 0 on failure.*/
+int export_interface(struct kelpo_interface_s *const interface,
+                     const unsigned interfaceVersion)
+{
+    if (interfaceVersion != RENDERER_VERSION[0])
+    {
+        return 0;
+    }
+
+    interface->window.open = initialize;
+    interface->window.release = release;
+    interface->window.is_open = kelpo_window__is_window_open;
+    interface->window.is_closing = kelpo_window__is_window_closing;
+    interface->window.process_messages = kelpo_window__process_window_messages;
+    interface->window.flip_surface = flip_surface;
+    interface->window.get_handle = kelpo_window__get_window_handle;
+    interface->window.set_message_handler = kelpo_window__set_external_message_handler;
+
+    interface->rasterizer.clear_frame = kelpo_rasterizer_null__clear_frame;
+    interface->rasterizer.draw_triangles = kelpo_rasterizer_null__draw_triangles;
+    interface->rasterizer.upload_texture = kelpo_rasterizer_null__upload_texture;
+    interface->rasterizer.update_texture = kelpo_rasterizer_null__update_texture;
+    interface->rasterizer.unload_textures = kelpo_rasterizer_null__unload_textures;
+    interface->rasterizer.map_vertex_buffer = kelpo_rasterizer_null__map_vertex_buffer;
+    interface->rasterizer.draw_vertex_buffer = kelpo_rasterizer_null__draw_vertex_buffer;
+
+    KELPO_COPY_RENDERER_NAME(interface->metadata.rendererName, RENDERER_NAME);
+    interface->metadata.rendererVersionMajor = RENDERER_VERSION[0];
+    interface->metadata.rendererVersionMinor = RENDERER_VERSION[1];
+    interface->metadata.rendererVersionPatch = RENDERER_VERSION[2];
+
+    return 1;
+}
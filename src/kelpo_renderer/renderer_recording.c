@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <kelpo_renderer/rasterizer/recording/rasterizer_recording.h>
+#include <kelpo_interface/interface.h>
+#include <kelpo_interface/error.h>
+
+static const char RENDERER_NAME[] = "Recording";
+static const unsigned RENDERER_VERSION[3] = {KELPO_INTERFACE_VERSION_MAJOR,
+                                             1,   /* Minor.*/
+                                             0};  /* Patch.*/
+
+/* The renderer whose calls are recorded, and the file they're recorded into,
+ * can be set via these environment variables.*/
+static const char TARGET_RENDERER_ENV_VAR[] = "KELPO_RECORDING_RENDERER";
+static const char TRACE_FILENAME_ENV_VAR[] = "KELPO_RECORDING_FILE";
+static const char DEFAULT_TARGET_RENDERER[] = "software";
+static const char DEFAULT_TRACE_FILENAME[] = "kelpo_recording.trace";
+
+/* The renderer that does the actual rendering. Loaded from its own DLL, whose
+ * interface is separate from the interface through which the program is
+ * calling us.*/
+static const struct kelpo_interface_s *TARGET_RENDERER = NULL;
+
+static int release(void)
+{
+    const int rasterizerReleased = kelpo_rasterizer_recording__release();
+    const int targetReleased = kelpo_release_interface(TARGET_RENDERER);
+
+    TARGET_RENDERER = NULL;
+
+    return (rasterizerReleased & targetReleased);
+}
+
+static int initialize(const unsigned deviceId,
+                      const unsigned screenWidth,
+                      const unsigned screenHeight,
+                      const unsigned screenBPP)
+{
+    const char *targetRendererName = getenv(TARGET_RENDERER_ENV_VAR);
+    const char *traceFilename = getenv(TRACE_FILENAME_ENV_VAR);
+
+    if (!targetRendererName) targetRendererName = DEFAULT_TARGET_RENDERER;
+    if (!traceFilename) traceFilename = DEFAULT_TRACE_FILENAME;
+
+    /* Loading ourselves would give us back this same DLL instance.*/
+    if (strcmp(targetRendererName, "recording") == 0)
+    {
+        kelpo_error(KELPOERR_RENDERER_NOT_AVAILABLE);
+        return 0;
+    }
+
+    if (!kelpo_create_interface(&TARGET_RENDERER, targetRendererName) ||
+        !TARGET_RENDERER->window.open(deviceId, screenWidth, screenHeight, screenBPP) ||
+        !kelpo_rasterizer_recording__initialize(TARGET_RENDERER, traceFilename, screenWidth, screenHeight, screenBPP))
+    {
+        release();
+        return 0;
+    }
+
+    return 1;
+}
+
+static int is_open(void)
+{
+    return (TARGET_RENDERER && TARGET_RENDERER->window.is_open());
+}
+
+static int is_closing(void)
+{
+    return (TARGET_RENDERER && TARGET_RENDERER->window.is_closing());
+}
+
+static int process_messages(void)
+{
+    return (TARGET_RENDERER && TARGET_RENDERER->window.process_messages());
+}
+
+static uint32_t get_handle(void)
+{
+    return (TARGET_RENDERER? TARGET_RENDERER->window.get_handle() : 0);
+}
+
+static int set_message_handler(kelpo_custom_window_message_handler_t *const customHandlerFn)
+{
+    return (TARGET_RENDERER && TARGET_RENDERER->window.set_message_handler(customHandlerFn));
+}
+
+/* Returns 1 on success; 0 on failure.*/
+int export_interface(struct kelpo_interface_s *const interface,
+                     const unsigned interfaceVersion)
+{
+    if (interfaceVersion != RENDERER_VERSION[0])
+    {
+        return 0;
+    }
+
+    interface->window.open = initialize;
+    interface->window.release = release;
+    interface->window.is_open = is_open;
+    interface->window.is_closing = is_closing;
+    interface->window.process_messages = process_messages;
+    interface->window.flip_surface = kelpo_rasterizer_recording__flip_surface;
+    interface->window.get_handle = get_handle;
+    interface->window.set_message_handler = set_message_handler;
+
+    interface->rasterizer.clear_frame = kelpo_rasterizer_recording__clear_frame;
+    interface->rasterizer.draw_triangles = kelpo_rasterizer_recording__draw_triangles;
+    interface->rasterizer.upload_texture = kelpo_rasterizer_recording__upload_texture;
+    interface->rasterizer.update_texture = kelpo_rasterizer_recording__update_texture;
+    interface->rasterizer.unload_textures = kelpo_rasterizer_recording__unload_textures;
+
+    KELPO_COPY_RENDERER_NAME(interface->metadata.rendererName, RENDERER_NAME);
+    interface->metadata.rendererVersionMajor = RENDERER_VERSION[0];
+    interface->metadata.rendererVersionMinor = RENDERER_VERSION[1];
+    interface->metadata.rendererVersionPatch = RENDERER_VERSION[2];
+
+    return 1;
+}
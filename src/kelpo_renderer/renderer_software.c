@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <kelpo_renderer/rasterizer/software/rasterizer_software.h>
+#include <kelpo_interface/interface.h>
+
+/* On Win32, the rendered image is displayed in a window. Elsewhere, it's
+ * presented into a buffer in memory.*/
+#if defined(_WIN32)
+    #include <kelpo_renderer/surface/software/surface_software.h>
+    #include <kelpo_renderer/window/win32/window_win32.h>
+
+    #define SURFACE_WINDOW_MESSAGE_HANDLER kelpo_surface_software__window_message_handler
+    #define CREATE_SURFACE kelpo_surface_software__create_surface
+    #define RELEASE_SURFACE kelpo_surface_software__release_surface
+    #define FLIP_SURFACE kelpo_surface_software__flip_surface
+#else
+    #include <kelpo_renderer/surface/offscreen/surface_offscreen.h>
+    #include <kelpo_renderer/window/offscreen/window_offscreen.h>
+
+    #define SURFACE_WINDOW_MESSAGE_HANDLER NULL
+    #define CREATE_SURFACE kelpo_surface_offscreen__create_surface
+    #define RELEASE_SURFACE kelpo_surface_offscreen__release_surface
+    #define FLIP_SURFACE kelpo_surface_offscreen__flip_surface
+#endif
+
+static const char RENDERER_NAME[] = "Software";
+static const unsigned RENDERER_VERSION[3] = {KELPO_INTERFACE_VERSION_MAJOR,
+                                             1,   /* Minor.*/
+                                             0};  /* Patch.*/
+
+static int initialize(const unsigned deviceId,
+                      const unsigned screenWidth,
+                      const unsigned screenHeight,
+                      const unsigned screenBPP)
+{
+    if (!kelpo_window__create_window(screenWidth, screenHeight, RENDERER_NAME, SURFACE_WINDOW_MESSAGE_HANDLER))
+    {
+        goto initialization_failed;
+    }
+
+    if (!CREATE_SURFACE(screenWidth, screenHeight, screenBPP, 0, deviceId))
+    {
+        RELEASE_SURFACE();
+        goto initialization_failed;
+    }
+
+    if (!kelpo_rasterizer_software__initialize(screenWidth, screenHeight))
+    {
+        kelpo_rasterizer_software__release();
+        RELEASE_SURFACE();
+        goto initialization_failed;
+    }
+
+    return 1;
+
+    initialization_failed:
+    kelpo_window__release_window();
+    return 0;
+}
+
+static int release(void)
+{
+    return (RELEASE_SURFACE() &
+            kelpo_rasterizer_software__release() &
+            kelpo_window__release_window());
+}
+
+/* Returns 1 on success; 0 on failure.*/
+int export_interface(struct kelpo_interface_s *const interface,
+                     const unsigned interfaceVersion)
+{
+    if (interfaceVersion != RENDERER_VERSION[0])
+    {
+        return 0;
+    }
+
+    interface->window.open = initialize;
+    interface->window.release = release;
+    interface->window.is_open = kelpo_window__is_window_open;
+    interface->window.is_closing = kelpo_window__is_window_closing;
+    interface->window.process_messages = kelpo_window__process_window_messages;
+    interface->window.flip_surface = FLIP_SURFACE;
+    interface->window.get_handle = kelpo_window__get_window_handle;
+    interface->window.set_message_handler = kelpo_window__set_external_message_handler;
+
+    interface->rasterizer.clear_frame = kelpo_rasterizer_software__clear_frame;
+    interface->rasterizer.draw_triangles = kelpo_rasterizer_software__draw_triangles;
+    interface->rasterizer.upload_texture = kelpo_rasterizer_software__upload_texture;
+    interface->rasterizer.update_texture = kelpo_rasterizer_software__update_texture;
+    interface->rasterizer.unload_textures = kelpo_rasterizer_software__unload_textures;
+    interface->rasterizer.map_vertex_buffer = kelpo_rasterizer_software__map_vertex_buffer;
+    interface->rasterizer.draw_vertex_buffer = kelpo_rasterizer_software__draw_vertex_buffer;
+
+    KELPO_COPY_RENDERER_NAME(interface->metadata.rendererName, RENDERER_NAME);
+    interface->metadata.rendererVersionMajor = RENDERER_VERSION[0];
+    interface->metadata.rendererVersionMinor = RENDERER_VERSION[1];
+    interface->metadata.rendererVersionPatch = RENDERER_VERSION[2];
+
+    return 1;
+}
@@ -0,0 +1,158 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * Offscreen render surface for Kelpo's software renderer. Presents the software
+ * rasterizer's pixel buffer into a buffer in memory, optionally writing the
+ * presented frames into PPM image files.
+ *
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <kelpo_renderer/surface/offscreen/surface_offscreen.h>
+#include <kelpo_renderer/rasterizer/software/rasterizer_software.h>
+#include <kelpo_interface/error.h>
+
+/* The environment variables through which frame dumping is controlled.*/
+static const char DUMP_INTERVAL_ENV_VAR[] = "KELPO_OFFSCREEN_DUMP_INTERVAL";
+static const char DUMP_PREFIX_ENV_VAR[] = "KELPO_OFFSCREEN_DUMP_PREFIX";
+static const char DEFAULT_DUMP_PREFIX[] = "kelpo_frame_";
+
+static uint32_t *PRESENTED_PIXELS = NULL;
+static unsigned SURFACE_WIDTH = 0;
+static unsigned SURFACE_HEIGHT = 0;
+static unsigned long NUM_FRAMES_PRESENTED = 0;
+
+/* Every DUMP_INTERVAL'th frame is written into a file; or none, if 0.*/
+static unsigned long DUMP_INTERVAL = 0;
+static const char *DUMP_PREFIX = NULL;
+
+/* Writes the presented pixels into a binary (P6) PPM file named after the
+ * given frame index. Returns 1 on success; 0 on failure.*/
+static int dump_frame(const unsigned long frameIdx)
+{
+    const unsigned numPixels = (SURFACE_WIDTH * SURFACE_HEIGHT);
+    unsigned char *const rgb = malloc(numPixels * 3);
+    char *const filename = malloc(strlen(DUMP_PREFIX) + 32);
+    FILE *file = NULL;
+    unsigned i = 0;
+    int writeFailed = 0;
+
+    if (!rgb || !filename)
+    {
+        free(rgb);
+        free(filename);
+        kelpo_error(KELPOERR_OUT_OF_SYSTEM_MEMORY);
+        return 0;
+    }
+
+    sprintf(filename, "%s%06lu.ppm", DUMP_PREFIX, frameIdx);
+
+    for (i = 0; i < numPixels; i++)
+    {
+        rgb[(i * 3) + 0] = ((PRESENTED_PIXELS[i] >> 16) & 0xff);
+        rgb[(i * 3) + 1] = ((PRESENTED_PIXELS[i] >> 8) & 0xff);
+        rgb[(i * 3) + 2] = ((PRESENTED_PIXELS[i] >> 0) & 0xff);
+    }
+
+    if (!(file = fopen(filename, "wb")))
+    {
+        writeFailed = 1;
+    }
+    else
+    {
+        fprintf(file, "P6\n%u %u\n255\n", SURFACE_WIDTH, SURFACE_HEIGHT);
+        fwrite(rgb, 3, numPixels, file);
+        writeFailed = ferror(file);
+        writeFailed |= (fclose(file) != 0);
+    }
+
+    free(rgb);
+    free(filename);
+
+    if (writeFailed)
+    {
+        kelpo_error(KELPOERR_API_CALL_FAILED);
+        return 0;
+    }
+
+    return 1;
+}
+
+int kelpo_surface_offscreen__release_surface(void)
+{
+    free(PRESENTED_PIXELS);
+    PRESENTED_PIXELS = NULL;
+
+    SURFACE_WIDTH = 0;
+    SURFACE_HEIGHT = 0;
+    NUM_FRAMES_PRESENTED = 0;
+
+    return 1;
+}
+
+int kelpo_surface_offscreen__flip_surface(void)
+{
+    const uint32_t *const pixels = kelpo_rasterizer_software__pixels();
+    const unsigned long frameIdx = NUM_FRAMES_PRESENTED++;
+
+    assert(PRESENTED_PIXELS && "Attempting to flip the surface before it has been created.");
+
+    if (!pixels)
+    {
+        kelpo_error(KELPOERR_API_CALL_FAILED);
+        return 0;
+    }
+
+    memcpy(PRESENTED_PIXELS, pixels, (SURFACE_WIDTH * SURFACE_HEIGHT * sizeof(PRESENTED_PIXELS[0])));
+
+    if (DUMP_INTERVAL &&
+        ((frameIdx % DUMP_INTERVAL) == 0) &&
+        !dump_frame(frameIdx))
+    {
+        return 0;
+    }
+
+    return 1;
+}
+
+int kelpo_surface_offscreen__create_surface(const unsigned width,
+                                            const unsigned height,
+                                            const unsigned bpp,
+                                            const int vsyncEnabled,
+                                            const unsigned deviceIdx)
+{
+    const char *const dumpInterval = getenv(DUMP_INTERVAL_ENV_VAR);
+
+    DUMP_INTERVAL = (dumpInterval? strtoul(dumpInterval, NULL, 10) : 0);
+    DUMP_PREFIX = getenv(DUMP_PREFIX_ENV_VAR);
+
+    if (!DUMP_PREFIX)
+    {
+        DUMP_PREFIX = DEFAULT_DUMP_PREFIX;
+    }
+
+    if (!(PRESENTED_PIXELS = calloc((width * height), sizeof(PRESENTED_PIXELS[0]))))
+    {
+        kelpo_error(KELPOERR_OUT_OF_SYSTEM_MEMORY);
+        return 0;
+    }
+
+    SURFACE_WIDTH = width;
+    SURFACE_HEIGHT = height;
+    NUM_FRAMES_PRESENTED = 0;
+
+    return 1;
+}
+
+const uint32_t* kelpo_surface_offscreen__pixels(void)
+{
+    return PRESENTED_PIXELS;
+}
+
+unsigned long kelpo_surface_offscreen__frame_count(void)
+{
+    return NUM_FRAMES_PRESENTED;
+}
@@ -0,0 +1,43 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * Offscreen render surface for Kelpo's software renderer. Presents the software
+ * rasterizer's pixel buffer into a buffer in memory rather than on screen, for
+ * rendering without a display.
+ *
+ * Presented frames can also be written into PPM image files: set the
+ * KELPO_OFFSCREEN_DUMP_INTERVAL environment variable to N to write every Nth
+ * frame (starting with the first one). The files are named by the frame's
+ * index, with the prefix given in KELPO_OFFSCREEN_DUMP_PREFIX (by default,
+ * "kelpo_frame_"); e.g. "kelpo_frame_000042.ppm".
+ *
+ * The renderer DLL exports kelpo_surface_offscreen__pixels(), which clients can
+ * look up with kelpo_renderer_function() to read the presented frame.
+ *
+ */
+
+#ifndef KELPO_RENDERER_SURFACE_OFFSCREEN_SURFACE_OFFSCREEN_H
+#define KELPO_RENDERER_SURFACE_OFFSCREEN_SURFACE_OFFSCREEN_H
+
+#include <kelpo_interface/stdint.h>
+
+int kelpo_surface_offscreen__release_surface(void);
+
+int kelpo_surface_offscreen__flip_surface(void);
+
+int kelpo_surface_offscreen__create_surface(const unsigned width,
+                                            const unsigned height,
+                                            const unsigned bpp,
+                                            const int vsyncEnabled,
+                                            const unsigned deviceIdx);
+
+/* Returns a pointer to the most recently presented frame's pixels, or NULL if
+ * the surface hasn't been created. The pixels are in the same format as the
+ * software rasterizer's (see kelpo_rasterizer_software__pixels()), and remain
+ * unchanged until the next flip.*/
+const uint32_t* kelpo_surface_offscreen__pixels(void);
+
+/* Returns the number of frames presented since the surface was created.*/
+unsigned long kelpo_surface_offscreen__frame_count(void);
+
+#endif
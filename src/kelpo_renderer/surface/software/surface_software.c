@@ -0,0 +1,106 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ * 
+ * Win32 GDI render surface for Kelpo's software renderer. Presents the software
+ * rasterizer's pixel buffer in the renderer's window.
+ * 
+ */
+
+#include <assert.h>
+#include <string.h>
+#include <kelpo_renderer/surface/software/surface_software.h>
+#include <kelpo_renderer/rasterizer/software/rasterizer_software.h>
+#include <kelpo_renderer/window/win32/window_win32.h>
+#include <kelpo_interface/error.h>
+
+#include <windows.h>
+
+static HDC WINDOW_DC = 0;
+static HWND WINDOW_HANDLE = 0;
+static unsigned SURFACE_WIDTH = 0;
+static unsigned SURFACE_HEIGHT = 0;
+
+/* Describes the rasterizer's pixel buffer to GDI.*/
+static BITMAPINFO PIXEL_BUFFER_INFO;
+
+int kelpo_surface_software__release_surface(void)
+{
+    if (WINDOW_DC &&
+        !ReleaseDC(WINDOW_HANDLE, WINDOW_DC))
+    {
+        kelpo_error(KELPOERR_API_CALL_FAILED);
+        return 0;
+    }
+
+    WINDOW_DC = 0;
+    WINDOW_HANDLE = 0;
+
+    return 1;
+}
+
+int kelpo_surface_software__flip_surface(void)
+{
+    const uint32_t *const pixels = kelpo_rasterizer_software__pixels();
+
+    assert(WINDOW_DC && "Attempting to flip the surface before it has been created.");
+
+    if (!pixels ||
+        !SetDIBitsToDevice(WINDOW_DC,
+                           0, 0,
+                           SURFACE_WIDTH, SURFACE_HEIGHT,
+                           0, 0,
+                           0, SURFACE_HEIGHT,
+                           pixels,
+                           &PIXEL_BUFFER_INFO,
+                           DIB_RGB_COLORS))
+    {
+        kelpo_error(KELPOERR_API_CALL_FAILED);
+        return 0;
+    }
+
+    return 1;
+}
+
+LRESULT kelpo_surface_software__window_message_handler(HWND windowHandle, UINT message, WPARAM wParam, LPARAM lParam)
+{
+    switch (message)
+    {
+        default: break;
+    }
+
+    return 0;
+}
+
+int kelpo_surface_software__create_surface(const unsigned width,
+                                           const unsigned height,
+                                           const unsigned bpp,
+                                           const int vsyncEnabled,
+                                           const unsigned deviceIdx)
+{
+    SURFACE_WIDTH = width;
+    SURFACE_HEIGHT = height;
+
+    /* The rasterizer's pixels are 32-bit XRGB, stored top to bottom (hence the
+     * negative height).*/
+    memset(&PIXEL_BUFFER_INFO, 0, sizeof(PIXEL_BUFFER_INFO));
+    PIXEL_BUFFER_INFO.bmiHeader.biSize = sizeof(PIXEL_BUFFER_INFO.bmiHeader);
+    PIXEL_BUFFER_INFO.bmiHeader.biWidth = width;
+    PIXEL_BUFFER_INFO.bmiHeader.biHeight = -(LONG)height;
+    PIXEL_BUFFER_INFO.bmiHeader.biPlanes = 1;
+    PIXEL_BUFFER_INFO.bmiHeader.biBitCount = 32;
+    PIXEL_BUFFER_INFO.bmiHeader.biCompression = BI_RGB;
+
+    if (!(WINDOW_HANDLE = (HWND)kelpo_window__get_window_handle()) ||
+        !(WINDOW_DC = GetDC(WINDOW_HANDLE)))
+    {
+        kelpo_error(KELPOERR_API_CALL_FAILED);
+        return 0;
+    }
+
+    ShowWindow(WINDOW_HANDLE, SW_SHOW);
+    SetForegroundWindow(WINDOW_HANDLE);
+    SetFocus(WINDOW_HANDLE);
+    UpdateWindow(WINDOW_HANDLE);
+
+    return 1;
+}
@@ -0,0 +1,25 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ * 
+ * Win32 GDI render surface for Kelpo's software renderer.
+ * 
+ */
+
+#ifndef KELPO_RENDERER_SURFACE_SOFTWARE_SURFACE_SOFTWARE_H
+#define KELPO_RENDERER_SURFACE_SOFTWARE_SURFACE_SOFTWARE_H
+
+#include <windef.h>
+
+LRESULT kelpo_surface_software__window_message_handler(HWND windowHandle, UINT message, WPARAM wParam, LPARAM lParam);
+
+int kelpo_surface_software__release_surface(void);
+
+int kelpo_surface_software__flip_surface(void);
+
+int kelpo_surface_software__create_surface(const unsigned width,
+                                           const unsigned height,
+                                           const unsigned bpp,
+                                           const int vsyncEnabled,
+                                           const unsigned deviceIdx);
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * A stand-in for a window, for renderers that don't display their output on
+ * screen.
+ *
+ */
+
+#include <kelpo_renderer/window/offscreen/window_offscreen.h>
+
+static unsigned WINDOW_WIDTH = 0;
+static unsigned WINDOW_HEIGHT = 0;
+static int DOES_WINDOW_EXIST = 0;
+
+int kelpo_window__is_window_open(void)
+{
+    return DOES_WINDOW_EXIST;
+}
+
+int kelpo_window__is_window_closing(void)
+{
+    /* There's no user interface through which the window could be closed.*/
+    return 0;
+}
+
+uint32_t kelpo_window__get_window_handle(void)
+{
+    return 0;
+}
+
+unsigned kelpo_window__width(void)
+{
+    return WINDOW_WIDTH;
+}
+
+unsigned kelpo_window__height(void)
+{
+    return WINDOW_HEIGHT;
+}
+
+int kelpo_window__set_external_message_handler(kelpo_custom_window_message_handler_t *const messageHandler)
+{
+    /* There are no window messages to pass on.*/
+    return 1;
+}
+
+int kelpo_window__release_window(void)
+{
+    WINDOW_WIDTH = 0;
+    WINDOW_HEIGHT = 0;
+    DOES_WINDOW_EXIST = 0;
+
+    return 1;
+}
+
+int kelpo_window__create_window(const unsigned width,
+                                const unsigned height,
+                                const char *const title,
+                                kelpo_custom_window_message_handler_t *const messageHandler)
+{
+    WINDOW_WIDTH = width;
+    WINDOW_HEIGHT = height;
+    DOES_WINDOW_EXIST = 1;
+
+    return 1;
+}
+
+int kelpo_window__process_window_messages(void)
+{
+    return 1;
+}
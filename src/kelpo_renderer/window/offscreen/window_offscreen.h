@@ -0,0 +1,38 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * A stand-in for a window, for renderers that don't display their output on
+ * screen. Provides the same functions as the Win32 window, but creates no
+ * OS window and receives no window messages.
+ *
+ */
+
+#ifndef KELPO_RENDERER_WINDOW_OFFSCREEN_WINDOW_OFFSCREEN_H
+#define KELPO_RENDERER_WINDOW_OFFSCREEN_WINDOW_OFFSCREEN_H
+
+#include <kelpo_interface/stdint.h>
+#include <kelpo_interface/interface.h>
+
+/* Always returns 0, as there is no OS window.*/
+uint32_t kelpo_window__get_window_handle(void);
+
+int kelpo_window__set_external_message_handler(kelpo_custom_window_message_handler_t *const messageHandler);
+
+int kelpo_window__create_window(const unsigned width,
+                                const unsigned height,
+                                const char *const title,
+                                kelpo_custom_window_message_handler_t *const messageHandler);
+
+int kelpo_window__release_window(void);
+
+int kelpo_window__process_window_messages(void);
+
+int kelpo_window__is_window_open(void);
+
+int kelpo_window__is_window_closing(void);
+
+/* Returns the window's resolution, as given to kelpo_window__create_window().*/
+unsigned kelpo_window__width(void);
+unsigned kelpo_window__height(void);
+
+#endif
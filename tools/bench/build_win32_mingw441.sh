@@ -0,0 +1,56 @@
+# Build Kelpo's benchmark tool for Win32 using TDM-GCC (MinGW) 4.4.1 via Wine in Linux.
+# Note that this will place the executable under Kelpo's root bin/ directory.
+
+MINGW441_PATH=~/compi/mingw441
+
+OUTPUT_FILE="../../bin/kelpo_bench.exe"
+
+# The vertex stream's SIMD kernels are compiled separately with SSE code
+# generation enabled, and are only called on CPUs that support it. Win32 only
+# guarantees 4-byte stack alignment, so the SSE code realigns its stack.
+SSE_SRC_FILE="../../src/kelpo_auxiliary/vertex_stream_sse.c"
+SSE_OBJECT_FILE="../../bin/vertex_stream_sse.o"
+
+SRC_FILES="
+src/main.c
+../../examples/common_src/default_window_message_handler.c
+../../src/kelpo_auxiliary/triangle_preparer.c
+../../src/kelpo_auxiliary/bounding_volume.c
+../../src/kelpo_auxiliary/triangle_bvh.c
+../../src/kelpo_auxiliary/triangle_sorter.c
+../../src/kelpo_auxiliary/triangle_submitter.c
+../../src/kelpo_auxiliary/mesh_simplifier.c
+../../src/kelpo_auxiliary/mesh_lod.c
+../../src/kelpo_auxiliary/thread_pool.c
+../../src/kelpo_auxiliary/matrix_44.c
+../../src/kelpo_auxiliary/vector_3.c
+../../src/kelpo_auxiliary/generic_stack.c
+../../src/kelpo_auxiliary/indexed_mesh.c
+../../src/kelpo_auxiliary/vertex_stream.c
+../../src/kelpo_auxiliary/triangle_clipper.c
+../../src/kelpo_auxiliary/load_kac_1_0_mesh.c
+../../src/kelpo_auxiliary/import_kac_1_0.c
+../../src/kelpo_auxiliary/text_mesh.c
+../../src/kelpo_auxiliary/clock.c
+../../src/kelpo_auxiliary/profiler.c
+../../src/kelpo_interface/interface.c
+../../src/kelpo_interface/error.c
+"
+
+BUILD_OPTIONS="
+-nostdinc
+-g
+-O2
+-std=c89
+-pedantic
+-Wall
+-DKELPOA_PROFILE
+-march=pentium
+-I../../src/
+-isystem $MINGW441_PATH/lib/gcc/mingw32/4.4.1/include
+-isystem $MINGW441_PATH/include
+"
+
+wine "$MINGW441_PATH/bin/gcc.exe" $BUILD_OPTIONS -msse -mstackrealign -c -o $SSE_OBJECT_FILE $SSE_SRC_FILE
+wine "$MINGW441_PATH/bin/gcc.exe" $BUILD_OPTIONS -o $OUTPUT_FILE $SRC_FILES $SSE_OBJECT_FILE -lm
+rm -f $SSE_OBJECT_FILE
@@ -0,0 +1,1013 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * Renders a fixed number of frames of scenes modeled after Kelpo's render
+ * examples, timing each stage of the frame, and prints the timings as JSON.
+ * Scene animation advances by a fixed amount per frame rather than with user
+ * input or wall time, so that every run renders the same frames.
+ *
+ * By default, renders with the null renderer, i.e. measures the CPU-side cost
+ * of a frame without displaying anything.
+ *
+ * Usage: kelpo_bench [-r renderer] [-n number of frames] [-s scene] [-o output file]
+ *                    [-w width] [-h height] [-b bpp] [-d device] [-p profile file]
+ *                    [-m mesh type] [-x transform] [-g guard band] [-c backface culling]
+ *                    [-l number of LOD levels] [-i number of instances] [-k sort keys]
+ *                    [-u submission]
+ *
+ * The mesh type is "flat" (the default), "indexed" or "stream", and selects
+ * whether the scenes' meshes are loaded and transformed as flat triangle lists,
+ * as indexed meshes (see kelpo_auxiliary/indexed_mesh.h), or as flat triangle
+ * lists whose vertices are transformed in a structure-of-arrays vertex stream
+ * (see kelpo_auxiliary/vertex_stream.h) and projected from it with
+ * kelpoa_triprepr__project_vertex_stream_to_screen(). The transform is
+ * "separate" (the default), "fused" or "instanced", and selects whether the
+ * meshes are duplicated, rotated, translated and projected in separate passes,
+ * or transformed and projected in one pass with a model matrix. With the fused
+ * transform, the duplicate stage does nothing and the rotate_translate stage
+ * only builds the model matrix. The fused transform can't be combined with the
+ * stream mesh type.
+ *
+ * The scenes' meshes can be drawn several times, as instances laid out in a
+ * grid (by default, 1 instance). With the fused transform, each instance is
+ * projected with a call of its own; the instanced transform is as the fused
+ * one, but projects all instances with one call to
+ * kelpoa_triprepr__transform_and_project_triangle_instances(), and is only for
+ * the flat mesh type. More than one instance needs either of them.
+ *
+ * The guard band is passed to kelpoa_triprepr__set_guard_band(); by default,
+ * 1 (no guard band). Backface culling is "normal" (the default), "area" or
+ * "plane", and is passed to kelpoa_triprepr__set_backface_cull_mode() as the
+ * corresponding KELPOA_TRIPREPR_CULL_BY_* mode.
+ *
+ * With more than one LOD level (by default, 1), the indexed mesh type's meshes
+ * get a chain of that many levels of detail when they're loaded (see
+ * kelpo_auxiliary/mesh_lod.h), and each frame renders the level selected by the
+ * mesh's size on the screen. The duplicate stage then includes selecting the
+ * level. LOD levels can't be combined with more than one instance.
+ *
+ * The sort keys are "none" (the default), "texture", "depth" or "texture+depth".
+ * Other than with "none", the screen space triangles (including the text
+ * overlay) are sorted with kelpoa_trisortr__sort() before they're drawn, in the
+ * sort stage: grouped by texture, ordered front to back, or both.
+ *
+ * The submission is "triangles" (the default) or "direct", and selects whether
+ * the draw stage passes the screen space triangles to the renderer's
+ * draw_triangles(), or writes their vertices directly into the renderer's
+ * native vertex format with kelpoa_trisubmr__draw_triangles(). The direct
+ * submission needs a renderer that provides map_vertex_buffer(), i.e. the null
+ * or the software renderer.
+ *
+ * If a profile file is given, the profiler zones recorded during the run are
+ * written into it as a Chrome trace (see kelpo_auxiliary/profiler.h). If the
+ * renderer was built with profiling, its zones are included as well.
+ *
+ * The scenes expect their assets (apricot.kac, cube.kac, sample-font.raw) in
+ * the working directory.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <math.h>
+#include <kelpo_interface/polygon/triangle/triangle.h>
+#include <kelpo_auxiliary/load_kac_1_0_mesh.h>
+#include <kelpo_auxiliary/triangle_preparer.h>
+#include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/indexed_mesh.h>
+#include <kelpo_auxiliary/bounding_volume.h>
+#include <kelpo_auxiliary/mesh_lod.h>
+#include <kelpo_auxiliary/triangle_sorter.h>
+#include <kelpo_auxiliary/triangle_submitter.h>
+#include <kelpo_auxiliary/vertex_stream.h>
+#include <kelpo_auxiliary/matrix_44.h>
+#include <kelpo_auxiliary/text_mesh.h>
+#include <kelpo_auxiliary/clock.h>
+#include <kelpo_auxiliary/profiler.h>
+#include <kelpo_auxiliary/misc.h>
+#include <kelpo_interface/interface.h>
+#include <kelpo_interface/error.h>
+#include <kelpo_renderer/rasterizer/null/rasterizer_null.h>
+#include "../../../examples/common_src/default_window_message_handler.h"
+
+enum scene_e
+{
+    SCENE_HIGH_POLYCOUNT_MODEL,
+    SCENE_MOUSE_ROTATING_CUBE,
+    SCENE_TEXTURE_PAINTING,
+    NUM_SCENES
+};
+
+static const char *const SCENE_NAMES[NUM_SCENES] = {"high_polycount_model",
+                                                    "mouse_rotating_cube",
+                                                    "texture_painting"};
+
+static const char *const SCENE_MESH_FILENAMES[NUM_SCENES] = {"apricot.kac",
+                                                             "cube.kac",
+                                                             "cube.kac"};
+
+/* The ways in which the scenes' meshes can be stored and transformed.*/
+enum mesh_type_e
+{
+    MESH_TYPE_FLAT,
+    MESH_TYPE_INDEXED,
+    MESH_TYPE_STREAM,
+    NUM_MESH_TYPES
+};
+
+static const char *const MESH_TYPE_NAMES[NUM_MESH_TYPES] = {"flat",
+                                                            "indexed",
+                                                            "stream"};
+
+/* The timed stages of a frame.*/
+enum stage_e
+{
+    STAGE_DUPLICATE,
+    STAGE_ROTATE_TRANSLATE,
+    STAGE_PROJECT_CLIP,
+    STAGE_TEXT_MESH,
+    STAGE_SORT,
+    STAGE_TEXTURE_UPDATE,
+    STAGE_DRAW,
+    STAGE_FLIP,
+    NUM_STAGES
+};
+
+static const char *const STAGE_NAMES[NUM_STAGES] = {"duplicate",
+                                                    "rotate_translate",
+                                                    "project_clip",
+                                                    "text_mesh",
+                                                    "sort",
+                                                    "texture_update",
+                                                    "draw",
+                                                    "flip"};
+
+/* The command-line names of the triangle preparer's backface culling modes,
+ * indexed by enum kelpoa_triprepr_backface_cull_mode_e.*/
+static const char *const CULL_MODE_NAMES[] = {"normal",
+                                              "area",
+                                              "plane"};
+
+#define NUM_CULL_MODES (sizeof(CULL_MODE_NAMES) / sizeof(CULL_MODE_NAMES[0]))
+
+/* The command-line names of the triangle sorter's keys (see
+ * kelpoa_trisortr__sort()).*/
+static const struct
+{
+    const char *name;
+    unsigned keys;
+} SORT_KEYS[] = {{"none", 0},
+                 {"texture", KELPOA_TRISORTR_KEY_TEXTURE},
+                 {"depth", KELPOA_TRISORTR_KEY_DEPTH},
+                 {"texture+depth", (KELPOA_TRISORTR_KEY_TEXTURE | KELPOA_TRISORTR_KEY_DEPTH)}};
+
+#define NUM_SORT_KEYS (sizeof(SORT_KEYS) / sizeof(SORT_KEYS[0]))
+
+/* Benchmark options.*/
+static struct
+{
+    const char *rendererName;
+    const char *sceneName; /* If NULL, all scenes will be run.*/
+    const char *outputFilename; /* If NULL, results are printed into stdout.*/
+    const char *profileFilename; /* If NULL, no profile is written.*/
+    unsigned numFrames;
+    unsigned deviceIdx;
+    unsigned width;
+    unsigned height;
+    unsigned bpp;
+    enum mesh_type_e meshType;
+    int fusedTransform;
+    int instancedTransform; /* Implies fusedTransform.*/
+    float guardBand;
+    unsigned cullMode;
+    unsigned numLodLevels;
+    unsigned numInstances;
+    unsigned sortKeys; /* An index to SORT_KEYS.*/
+    int directSubmission;
+} OPTIONS = {"null", NULL, NULL, NULL, 500, 0, 1920, 1080, 32, MESH_TYPE_FLAT, 0, 0, 1, KELPOA_TRIPREPR_CULL_BY_VERTEX_NORMAL, 1, 1, 0, 0};
+
+/* Per-frame timings, in nanoseconds, of the current scene. Has NUM_STAGES
+ * arrays of OPTIONS.numFrames elements each, followed by one such array for
+ * the frames' total times.*/
+static double *TIMINGS = NULL;
+
+/* Returns the time, in nanoseconds, elapsed since the given start time, and
+ * sets the start time to the current time.*/
+static double lap(double *const startTime)
+{
+    const double now = kelpoa_clock__nanoseconds();
+    const double elapsed = (now - *startTime);
+
+    *startTime = now;
+
+    return elapsed;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    const double x = *(const double*)a;
+    const double y = *(const double*)b;
+
+    return ((x > y) - (x < y));
+}
+
+/* Generates mipmaps for the given texture of its base mip level down to 1 x 1.
+ * Same as in the texture_painting example.*/
+static void regenerate_mipmaps_for_texture(struct kelpo_polygon_texture_s *const texture)
+{
+    unsigned m = 0;
+
+    for (m = 1; m < texture->numMipLevels; m++)
+    {
+        unsigned x = 0;
+        unsigned y = 0;
+        const unsigned mipLevelSideLength = (texture->width >> m);
+        const unsigned minification = (texture->width / mipLevelSideLength);
+
+        /* Simple nearest neighbor downscaling from the base mip level.*/
+        for (y = 0; y < mipLevelSideLength; y++)
+        {
+            for (x = 0; x < mipLevelSideLength; x++)
+            {
+                const unsigned dstIdx = x + y * mipLevelSideLength;
+                const unsigned srcIdx = (x * minification) + (y * minification) * texture->width;
+                texture->mipLevel[m][dstIdx] = texture->mipLevel[0][srcIdx];
+            }
+        }
+    }
+
+    return;
+}
+
+/* Prints as JSON the minimum, median and 99th percentile of the given timings,
+ * in milliseconds. Sorts the timings.*/
+static void print_timing_stats(FILE *const dst,
+                               double *const timings,
+                               const unsigned numTimings)
+{
+    const unsigned p99Idx = ((unsigned)ceil(numTimings * 0.99) - 1);
+
+    qsort(timings, numTimings, sizeof(*timings), compare_doubles);
+
+    fprintf(dst, "{\"min_ms\": %.6f, \"median_ms\": %.6f, \"p99_ms\": %.6f}",
+            (timings[0] / 1000000.0),
+            (timings[numTimings / 2] / 1000000.0),
+            (timings[p99Idx] / 1000000.0));
+
+    return;
+}
+
+/* Gives the rotation and translation of the given scene's mesh on the given
+ * frame. The animation of each scene follows that of the corresponding example
+ * program; with the mouse_rotating_cube's mouse motion replaced by a fixed
+ * rotation per frame.*/
+static void get_scene_transform(const enum scene_e scene,
+                                const uint32_t frameIdx,
+                                float *const rotation,
+                                float *const translation)
+{
+    rotation[0] = rotation[1] = rotation[2] = 0;
+    translation[0] = translation[1] = translation[2] = 0;
+
+    switch (scene)
+    {
+        case SCENE_HIGH_POLYCOUNT_MODEL:
+        {
+            rotation[1] = (frameIdx * 0.01);
+            translation[1] = -2.5;
+            translation[2] = 8.5;
+            break;
+        }
+        case SCENE_MOUSE_ROTATING_CUBE:
+        {
+            rotation[0] = (frameIdx * 0.0045);
+            rotation[1] = (frameIdx * 0.008);
+            translation[2] = 4.7;
+            break;
+        }
+        case SCENE_TEXTURE_PAINTING:
+        {
+            rotation[0] = (frameIdx * 0.0035);
+            rotation[1] = (frameIdx * 0.006);
+            rotation[2] = (frameIdx * 0.0035);
+            translation[2] = 4.7;
+            break;
+        }
+        default: assert(0 && "Unknown scene."); break;
+    }
+
+    return;
+}
+
+/* Renders the given scene for the benchmark's number of frames, and prints its
+ * timings as a JSON object. Returns 1 on success; 0 on failure.*/
+static int run_scene(const enum scene_e scene,
+                     const struct kelpo_interface_s *const kelpo,
+                     struct kelpo_polygon_texture_s *const fontTexture,
+                     FILE *const dst)
+{
+    uint32_t numTextures = 0;
+    struct kelpo_polygon_texture_s *textures = NULL;
+    struct kelpoa_generic_stack_s *triangles = kelpoa_generic_stack__create(1, sizeof(struct kelpo_polygon_triangle_s));
+    struct kelpoa_generic_stack_s *worldSpaceTriangles = kelpoa_generic_stack__create(1, sizeof(struct kelpo_polygon_triangle_s));
+    struct kelpoa_generic_stack_s *screenSpaceTriangles = kelpoa_generic_stack__create(1, sizeof(struct kelpo_polygon_triangle_s));
+    struct kelpoa_indexed_mesh_s *mesh = kelpoa_indexed_mesh__create();
+    struct kelpoa_indexed_mesh_s *worldSpaceMesh = kelpoa_indexed_mesh__create();
+    struct kelpoa_indexed_mesh_s *frameMesh = mesh;
+    struct kelpoa_mesh_lod_s *lod = NULL;
+    unsigned long lodLevelSum = 0;
+    struct kelpoa_matrix44_s *const modelMatrices = (struct kelpoa_matrix44_s*)malloc(OPTIONS.numInstances * sizeof(struct kelpoa_matrix44_s));
+    float instanceSpacing = 0;
+    struct kelpoa_vertex_stream_s *meshStream = kelpoa_vertex_stream__create(1);
+    struct kelpoa_vertex_stream_s *worldSpaceStream = kelpoa_vertex_stream__create(1);
+    struct kelpoa_bounding_volume_s triangleBounds;
+    struct kelpoa_matrix44_s clipSpaceMatrix;
+    uint32_t numMeshTriangles = 0;
+    struct kelpoa_matrix44_s screenSpaceMatrix;
+    unsigned long numScreenTriangles = 0;
+    const kelpo_rasterizer_null_counters_fn get_null_counters = (kelpo_rasterizer_null_counters_fn)kelpo_renderer_function(kelpo, "kelpo_rasterizer_null__counters");
+    const unsigned long numInitialBatchBreaks = (get_null_counters? get_null_counters()->numTextureBatchBreaks : 0);
+    int returnValue = 0;
+    uint32_t i = 0;
+
+    assert(modelMatrices && "Failed to allocate memory for the instances' model matrices.");
+
+    /* Load the scene's assets and send them to Kelpo. Each scene starts with
+     * no textures uploaded.*/
+    {
+        if (!((OPTIONS.meshType == MESH_TYPE_INDEXED)
+              ? kelpoa_load_kac10_indexed_mesh(SCENE_MESH_FILENAMES[scene], mesh, &textures, &numTextures)
+              : kelpoa_load_kac10_mesh(SCENE_MESH_FILENAMES[scene], triangles, &textures, &numTextures)) ||
+            !(numMeshTriangles = ((OPTIONS.meshType == MESH_TYPE_INDEXED)? mesh->triangles->count : triangles->count)))
+        {
+            fprintf(stderr, "Failed to load \"%s\".\n", SCENE_MESH_FILENAMES[scene]);
+            goto cleanup;
+        }
+
+        if (OPTIONS.meshType != MESH_TYPE_INDEXED)
+        {
+            kelpoa_bounding_volume__of_triangles(&triangleBounds, triangles);
+        }
+
+        if (OPTIONS.meshType == MESH_TYPE_STREAM)
+        {
+            kelpoa_vertex_stream__from_triangles(meshStream, triangles);
+        }
+
+        if ((OPTIONS.meshType == MESH_TYPE_INDEXED) &&
+            (OPTIONS.numLodLevels > 1))
+        {
+            lod = kelpoa_mesh_lod__create(mesh, OPTIONS.numLodLevels);
+        }
+
+        /* Instances are spaced so that their bounding spheres don't overlap.*/
+        instanceSpacing = (2 * ((OPTIONS.meshType == MESH_TYPE_INDEXED)? mesh->bounds.radius : triangleBounds.radius));
+
+        fontTexture->apiId = 0;
+        fontTexture->apiAuxData = NULL;
+
+        if (!kelpo->rasterizer.unload_textures() ||
+            !kelpo->rasterizer.upload_texture(fontTexture))
+        {
+            fprintf(stderr, "Failed to transfer asset data to Kelpo.\n");
+            goto cleanup;
+        }
+
+        for (i = 0; i < numTextures; i++)
+        {
+            if (!kelpo->rasterizer.upload_texture(&textures[i]))
+            {
+                fprintf(stderr, "Failed to transfer asset data to Kelpo.\n");
+                goto cleanup;
+            }
+        }
+    }
+
+    kelpoa_matrix44__make_clip_space_matrix(&clipSpaceMatrix,
+                                            KELPOA_DEG_TO_RAD(60),
+                                            (OPTIONS.width / (float)OPTIONS.height),
+                                            0.1, 100);
+
+    kelpoa_matrix44__make_screen_space_matrix(&screenSpaceMatrix,
+                                              (OPTIONS.width / 2.0f),
+                                              (OPTIONS.height / 2.0f));
+
+    /* Render the frames.*/
+    for (i = 0; i < OPTIONS.numFrames; i++)
+    {
+        double stageTimes[NUM_STAGES + 1];
+        unsigned n = 0;
+        double lapStartTime = kelpoa_clock__nanoseconds();
+        unsigned s = 0;
+
+        {
+            kelpoa_generic_stack__clear(screenSpaceTriangles);
+
+            if (lod)
+            {
+                float rotation[3];
+                float translation[3];
+                struct kelpoa_matrix44_s lodModelMatrix;
+                unsigned level = 0;
+
+                get_scene_transform(scene, i, rotation, translation);
+                kelpoa_matrix44__make_model_matrix(&lodModelMatrix,
+                                                   rotation[0], rotation[1], rotation[2],
+                                                   translation[0], translation[1], translation[2]);
+
+                level = kelpoa_mesh_lod__select_level(lod, &lodModelMatrix, &clipSpaceMatrix, OPTIONS.height);
+                frameMesh = lod->levels[level];
+                lodLevelSum += level;
+            }
+
+            /* The fused transform reads the mesh directly, without a copy.*/
+            if (!OPTIONS.fusedTransform &&
+                (OPTIONS.meshType == MESH_TYPE_INDEXED))
+            {
+                kelpoa_triprepr__duplicate_indexed_mesh(frameMesh, worldSpaceMesh);
+            }
+            else if (OPTIONS.meshType == MESH_TYPE_STREAM)
+            {
+                kelpoa_vertex_stream__copy(meshStream, worldSpaceStream);
+            }
+            else if (!OPTIONS.fusedTransform)
+            {
+                kelpoa_generic_stack__clear(worldSpaceTriangles);
+                kelpoa_triprepr__duplicate_triangles(triangles, worldSpaceTriangles);
+            }
+        }
+        stageTimes[STAGE_DUPLICATE] = lap(&lapStartTime);
+
+        {
+            float rotation[3];
+            float translation[3];
+
+            get_scene_transform(scene, i, rotation, translation);
+
+            if (OPTIONS.fusedTransform)
+            {
+                /* The instances are laid out in a grid that extends away from
+                 * the camera, centered horizontally on the scene's mesh.*/
+                const unsigned numColumns = ceil(sqrt(OPTIONS.numInstances));
+
+                for (n = 0; n < OPTIONS.numInstances; n++)
+                {
+                    const float offsetX = (((n % numColumns) - ((numColumns - 1) / 2.0f)) * instanceSpacing);
+                    const float offsetZ = ((n / numColumns) * instanceSpacing);
+
+                    kelpoa_matrix44__make_model_matrix(&modelMatrices[n],
+                                                       rotation[0], rotation[1], rotation[2],
+                                                       (translation[0] + offsetX), translation[1], (translation[2] + offsetZ));
+                }
+            }
+            else if (OPTIONS.meshType == MESH_TYPE_STREAM)
+            {
+                struct kelpoa_matrix44_s rotationMatrix;
+                struct kelpoa_matrix44_s translationMatrix;
+
+                kelpoa_matrix44__make_rotation_matrix(&rotationMatrix, rotation[0], rotation[1], rotation[2]);
+                kelpoa_matrix44__make_translation_matrix(&translationMatrix, translation[0], translation[1], translation[2]);
+
+                kelpoa_vertex_stream__transform(worldSpaceStream, &rotationMatrix);
+                kelpoa_vertex_stream__transform_normals(worldSpaceStream, &rotationMatrix);
+                kelpoa_vertex_stream__transform(worldSpaceStream, &translationMatrix);
+            }
+            else if (OPTIONS.meshType == MESH_TYPE_INDEXED)
+            {
+                kelpoa_triprepr__rotate_indexed_mesh(worldSpaceMesh, rotation[0], rotation[1], rotation[2]);
+                kelpoa_triprepr__translate_indexed_mesh(worldSpaceMesh, translation[0], translation[1], translation[2]);
+            }
+            else
+            {
+                kelpoa_triprepr__rotate_triangles(worldSpaceTriangles, rotation[0], rotation[1], rotation[2]);
+                kelpoa_triprepr__translate_triangles(worldSpaceTriangles, translation[0], translation[1], translation[2]);
+            }
+        }
+        stageTimes[STAGE_ROTATE_TRANSLATE] = lap(&lapStartTime);
+
+        {
+            if (OPTIONS.instancedTransform)
+            {
+                kelpoa_triprepr__transform_and_project_triangle_instances(triangles,
+                                                                          screenSpaceTriangles,
+                                                                          &triangleBounds,
+                                                                          modelMatrices,
+                                                                          OPTIONS.numInstances,
+                                                                          &clipSpaceMatrix,
+                                                                          &screenSpaceMatrix,
+                                                                          0.1, 100, 1);
+            }
+            else if (OPTIONS.fusedTransform && (OPTIONS.meshType == MESH_TYPE_INDEXED))
+            {
+                for (n = 0; n < OPTIONS.numInstances; n++)
+                {
+                    kelpoa_triprepr__transform_and_project_indexed_mesh(frameMesh,
+                                                                        screenSpaceTriangles,
+                                                                        &modelMatrices[n],
+                                                                        &clipSpaceMatrix,
+                                                                        &screenSpaceMatrix,
+                                                                        0.1, 100, 1);
+                }
+            }
+            else if (OPTIONS.fusedTransform)
+            {
+                for (n = 0; n < OPTIONS.numInstances; n++)
+                {
+                    kelpoa_triprepr__transform_and_project_triangles(triangles,
+                                                                     screenSpaceTriangles,
+                                                                     &triangleBounds,
+                                                                     &modelMatrices[n],
+                                                                     &clipSpaceMatrix,
+                                                                     &screenSpaceMatrix,
+                                                                     0.1, 100, 1);
+                }
+            }
+            else if (OPTIONS.meshType == MESH_TYPE_STREAM)
+            {
+                kelpoa_triprepr__project_vertex_stream_to_screen(worldSpaceStream,
+                                                                 triangles,
+                                                                 screenSpaceTriangles,
+                                                                 &clipSpaceMatrix,
+                                                                 &screenSpaceMatrix,
+                                                                 0.1, 100, 1);
+            }
+            else if (OPTIONS.meshType == MESH_TYPE_INDEXED)
+            {
+                kelpoa_triprepr__project_indexed_mesh_to_screen(worldSpaceMesh,
+                                                                screenSpaceTriangles,
+                                                                &clipSpaceMatrix,
+                                                                &screenSpaceMatrix,
+                                                                0.1, 100, 1);
+            }
+            else
+            {
+                kelpoa_triprepr__project_triangles_to_screen(worldSpaceTriangles,
+                                                             screenSpaceTriangles,
+                                                             &clipSpaceMatrix,
+                                                             &screenSpaceMatrix,
+                                                             0.1, 100, 1);
+            }
+
+            numScreenTriangles += screenSpaceTriangles->count;
+        }
+        stageTimes[STAGE_PROJECT_CLIP] = lap(&lapStartTime);
+
+        {
+            char frameTimeString[30];
+            char polyString[50];
+            const unsigned numScreenPolys = screenSpaceTriangles->count;
+            const unsigned numWorldPolys = (OPTIONS.numInstances * ((OPTIONS.meshType == MESH_TYPE_INDEXED)? frameMesh->triangles->count : numMeshTriangles));
+            const double prevFrameTime = (i? (TIMINGS[(NUM_STAGES * OPTIONS.numFrames) + i - 1] / 1000000.0) : 0);
+
+            sprintf(frameTimeString, "Frame: %.2f ms", ((prevFrameTime > 9999)? 9999 : prevFrameTime));
+            sprintf(polyString, "Polygons: %d/%d", ((numScreenPolys > 9999999)? 9999999 : numScreenPolys),
+                                                   ((numWorldPolys > 9999999)? 9999999 : numWorldPolys));
+
+            kelpoa_text_mesh__print(screenSpaceTriangles, kelpo->metadata.rendererName, 25, 30, 255, 255, 255, 1);
+            kelpoa_text_mesh__print(screenSpaceTriangles, polyString, 25, 60, 200, 200, 200, 1);
+            kelpoa_text_mesh__print(screenSpaceTriangles, frameTimeString, 25, 90, 200, 200, 200, 1);
+
+            if (scene == SCENE_MOUSE_ROTATING_CUBE)
+            {
+                const float infoStringScale = 1.3;
+                const char infoString1[] = "Mouse rotates";
+                const char infoString2[] = "Up/down arrows zoom";
+                const unsigned infoString1PixelLen = (strlen(infoString1) * infoStringScale * kelpoa_text_mesh__character_width());
+                const unsigned infoString2PixelLen = (strlen(infoString2) * infoStringScale * kelpoa_text_mesh__character_width());
+
+                kelpoa_text_mesh__print(screenSpaceTriangles,
+                                        infoString1,
+                                        ((OPTIONS.width / 2) - (infoString1PixelLen / 2)),
+                                        (OPTIONS.height - 100 - 10 - kelpoa_text_mesh__character_height()),
+                                        255, 255, 0, infoStringScale);
+
+                kelpoa_text_mesh__print(screenSpaceTriangles,
+                                        infoString2,
+                                        ((OPTIONS.width / 2) - (infoString2PixelLen / 2)),
+                                        (OPTIONS.height - 100),
+                                        255, 255, 0, infoStringScale);
+            }
+        }
+        stageTimes[STAGE_TEXT_MESH] = lap(&lapStartTime);
+
+        {
+            kelpoa_trisortr__sort(screenSpaceTriangles, SORT_KEYS[OPTIONS.sortKeys].keys);
+        }
+        stageTimes[STAGE_SORT] = lap(&lapStartTime);
+
+        /* Paint a pixel per frame onto the cube's texture, as in the example.*/
+        {
+            if ((scene == SCENE_TEXTURE_PAINTING) &&
+                numTextures &&
+                (textures[0].width >= 128))
+            {
+                const unsigned angle = ((i * 4) % 360);
+                const unsigned radius = (50 - (((i * 4) / 360) % 50));
+                const int offset = (radius * 1.25);
+                const int x = (radius * cos(angle * (M_PI / 180)));
+                const int y = (radius * sin(angle * (M_PI / 180)));
+
+                textures[0].mipLevel[0][(offset + x) + (offset + y) * textures[0].width] = 0xffff;
+                regenerate_mipmaps_for_texture(&textures[0]);
+
+                if (!kelpo->rasterizer.update_texture(&textures[0]))
+                {
+                    fprintf(stderr, "Failed to update Kelpo's texture data.\n");
+                    goto cleanup;
+                }
+            }
+        }
+        stageTimes[STAGE_TEXTURE_UPDATE] = lap(&lapStartTime);
+
+        {
+            kelpo->rasterizer.clear_frame();
+
+            if (OPTIONS.directSubmission)
+            {
+                kelpoa_trisubmr__draw_triangles(kelpo, screenSpaceTriangles);
+            }
+            else
+            {
+                kelpo->rasterizer.draw_triangles(screenSpaceTriangles->data, screenSpaceTriangles->count);
+            }
+        }
+        stageTimes[STAGE_DRAW] = lap(&lapStartTime);
+
+        {
+            kelpo->window.flip_surface();
+        }
+        stageTimes[STAGE_FLIP] = lap(&lapStartTime);
+
+        stageTimes[NUM_STAGES] = 0;
+
+        for (s = 0; s < NUM_STAGES; s++)
+        {
+            TIMINGS[(s * OPTIONS.numFrames) + i] = stageTimes[s];
+            stageTimes[NUM_STAGES] += stageTimes[s];
+        }
+
+        TIMINGS[(NUM_STAGES * OPTIONS.numFrames) + i] = stageTimes[NUM_STAGES];
+
+        KELPOA_PROF_END_FRAME();
+
+        kelpo->window.process_messages();
+
+        if (kelpo_error_peek() != KELPOERR_ALL_GOOD)
+        {
+            fprintf(stderr, "Kelpo has reported an error.\n");
+            goto cleanup;
+        }
+    }
+
+    /* Print the scene's results.*/
+    {
+        unsigned s = 0;
+
+        fprintf(dst, "    {\n");
+        fprintf(dst, "      \"name\": \"%s\",\n", SCENE_NAMES[scene]);
+        fprintf(dst, "      \"triangles\": %lu,\n", (unsigned long)numMeshTriangles);
+
+        if (OPTIONS.meshType == MESH_TYPE_INDEXED)
+        {
+            fprintf(dst, "      \"vertices\": %lu,\n", (unsigned long)mesh->vertices->count);
+        }
+
+        if (lod)
+        {
+            fprintf(dst, "      \"lod_levels\": %u,\n", lod->numLevels);
+            fprintf(dst, "      \"mean_lod_level\": %.2f,\n", (lodLevelSum / (double)OPTIONS.numFrames));
+        }
+
+        fprintf(dst, "      \"mean_screen_triangles\": %.1f,\n", (numScreenTriangles / (double)OPTIONS.numFrames));
+
+        /* The null renderer counts how often the drawn triangles' texture
+         * changes, i.e. how many extra batches a real renderer would issue.*/
+        if (get_null_counters)
+        {
+            fprintf(dst, "      \"mean_texture_batch_breaks\": %.1f,\n", ((get_null_counters()->numTextureBatchBreaks - numInitialBatchBreaks) / (double)OPTIONS.numFrames));
+        }
+        fprintf(dst, "      \"stages\": {\n");
+
+        for (s = 0; s < NUM_STAGES; s++)
+        {
+            fprintf(dst, "        \"%s\": ", STAGE_NAMES[s]);
+            print_timing_stats(dst, &TIMINGS[s * OPTIONS.numFrames], OPTIONS.numFrames);
+            fprintf(dst, ",\n");
+        }
+
+        fprintf(dst, "        \"frame\": ");
+        print_timing_stats(dst, &TIMINGS[NUM_STAGES * OPTIONS.numFrames], OPTIONS.numFrames);
+        fprintf(dst, "\n      }\n");
+        fprintf(dst, "    }");
+    }
+
+    returnValue = 1;
+
+    cleanup:
+
+    for (i = 0; i < numTextures; i++)
+    {
+        uint32_t m = 0;
+
+        for (m = 0; m < textures[i].numMipLevels; m++)
+        {
+            free(textures[i].mipLevel[m]);
+        }
+    }
+
+    free(textures);
+    kelpoa_generic_stack__free(triangles);
+    kelpoa_generic_stack__free(worldSpaceTriangles);
+    kelpoa_generic_stack__free(screenSpaceTriangles);
+    free(modelMatrices);
+    kelpoa_mesh_lod__free(lod);
+    kelpoa_indexed_mesh__free(mesh);
+    kelpoa_indexed_mesh__free(worldSpaceMesh);
+    kelpoa_vertex_stream__free(meshStream);
+    kelpoa_vertex_stream__free(worldSpaceStream);
+
+    return returnValue;
+}
+
+static void print_renderer_name(const char *const rendererName)
+{
+    fprintf(stderr, " %s", rendererName);
+
+    return;
+}
+
+static int parse_options(const int argc, char *const argv[])
+{
+    int i = 0;
+
+    for (i = 1; i < argc; i++)
+    {
+        const char *const arg = ((i + 1) < argc)? argv[i + 1] : NULL;
+
+        if ((strlen(argv[i]) != 2) ||
+            (argv[i][0] != '-') ||
+            !arg)
+        {
+            return 0;
+        }
+
+        switch (argv[i++][1])
+        {
+            case 'r': OPTIONS.rendererName = arg; break;
+            case 's': OPTIONS.sceneName = arg; break;
+            case 'o': OPTIONS.outputFilename = arg; break;
+            case 'p': OPTIONS.profileFilename = arg; break;
+            case 'n': OPTIONS.numFrames = strtoul(arg, NULL, 10); break;
+            case 'w': OPTIONS.width = strtoul(arg, NULL, 10); break;
+            case 'h': OPTIONS.height = strtoul(arg, NULL, 10); break;
+            case 'b': OPTIONS.bpp = strtoul(arg, NULL, 10); break;
+            case 'g': OPTIONS.guardBand = strtod(arg, NULL); break;
+            case 'l': OPTIONS.numLodLevels = strtoul(arg, NULL, 10); break;
+            case 'i': OPTIONS.numInstances = strtoul(arg, NULL, 10); break;
+            case 'x':
+            {
+                OPTIONS.instancedTransform = (strcmp(arg, "instanced") == 0);
+                OPTIONS.fusedTransform = (OPTIONS.instancedTransform || (strcmp(arg, "fused") == 0));
+
+                if (!OPTIONS.fusedTransform &&
+                    (strcmp(arg, "separate") != 0))
+                {
+                    return 0;
+                }
+
+                break;
+            }
+            case 'u':
+            {
+                OPTIONS.directSubmission = (strcmp(arg, "direct") == 0);
+
+                if (!OPTIONS.directSubmission &&
+                    (strcmp(arg, "triangles") != 0))
+                {
+                    return 0;
+                }
+
+                break;
+            }
+            case 'k':
+            {
+                for (OPTIONS.sortKeys = 0; OPTIONS.sortKeys < NUM_SORT_KEYS; OPTIONS.sortKeys++)
+                {
+                    if (strcmp(arg, SORT_KEYS[OPTIONS.sortKeys].name) == 0)
+                    {
+                        break;
+                    }
+                }
+
+                if (OPTIONS.sortKeys == NUM_SORT_KEYS)
+                {
+                    return 0;
+                }
+
+                break;
+            }
+            case 'c':
+            {
+                for (OPTIONS.cullMode = 0; OPTIONS.cullMode < NUM_CULL_MODES; OPTIONS.cullMode++)
+                {
+                    if (strcmp(arg, CULL_MODE_NAMES[OPTIONS.cullMode]) == 0)
+                    {
+                        break;
+                    }
+                }
+
+                if (OPTIONS.cullMode == NUM_CULL_MODES)
+                {
+                    return 0;
+                }
+
+                break;
+            }
+            case 'm':
+            {
+                for (OPTIONS.meshType = 0; OPTIONS.meshType < NUM_MESH_TYPES; OPTIONS.meshType++)
+                {
+                    if (strcmp(arg, MESH_TYPE_NAMES[OPTIONS.meshType]) == 0)
+                    {
+                        break;
+                    }
+                }
+
+                if (OPTIONS.meshType == NUM_MESH_TYPES)
+                {
+                    return 0;
+                }
+
+                break;
+            }
+            case 'd':
+            {
+                /* The device index is expected to be 1-indexed (device #1 is 1).*/
+                OPTIONS.deviceIdx = strtoul(arg, NULL, 10);
+                OPTIONS.deviceIdx -= (OPTIONS.deviceIdx > 0);
+                break;
+            }
+            default: return 0;
+        }
+    }
+
+    return (OPTIONS.numFrames && OPTIONS.width && OPTIONS.height && OPTIONS.bpp &&
+            (OPTIONS.guardBand >= 1) &&
+            (OPTIONS.numLodLevels >= 1) &&
+            ((OPTIONS.numLodLevels == 1) || (OPTIONS.meshType == MESH_TYPE_INDEXED)) &&
+            (OPTIONS.numInstances >= 1) &&
+            ((OPTIONS.numInstances == 1) || OPTIONS.fusedTransform) &&
+            ((OPTIONS.numInstances == 1) || (OPTIONS.numLodLevels == 1)) &&
+            !(OPTIONS.instancedTransform && (OPTIONS.meshType != MESH_TYPE_FLAT)) &&
+            !(OPTIONS.fusedTransform && (OPTIONS.meshType == MESH_TYPE_STREAM)));
+}
+
+int main(int argc, char *argv[])
+{
+    const struct kelpo_interface_s *kelpo = NULL;
+    struct kelpo_polygon_texture_s *fontTexture = NULL;
+    FILE *dst = stdout;
+    int returnValue = EXIT_FAILURE;
+
+    if (!parse_options(argc, argv))
+    {
+        fprintf(stderr, "Usage: %s [-r renderer] [-n number of frames] [-s scene] [-o output file]\n"
+                        "       [-w width] [-h height] [-b bpp] [-d device] [-p profile file]\n"
+                        "       [-m mesh type] [-x transform] [-g guard band] [-c backface culling]\n"
+                        "       [-l number of LOD levels] [-i number of instances] [-k sort keys]\n"
+                        "       [-u submission]\n", argv[0]);
+        goto cleanup;
+    }
+
+    if (OPTIONS.outputFilename &&
+        !(dst = fopen(OPTIONS.outputFilename, "w")))
+    {
+        fprintf(stderr, "Failed to open \"%s\" for writing.\n", OPTIONS.outputFilename);
+        dst = NULL;
+        goto cleanup;
+    }
+
+    if (!(TIMINGS = (double*)malloc((NUM_STAGES + 1) * OPTIONS.numFrames * sizeof(*TIMINGS))))
+    {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        goto cleanup;
+    }
+
+    if (!kelpo_create_interface(&kelpo, OPTIONS.rendererName))
+    {
+        fprintf(stderr, "Failed to load the \"%s\" renderer. Available renderers:", OPTIONS.rendererName);
+        kelpo_enumerate_renderers(print_renderer_name);
+        fprintf(stderr, "\n");
+        goto cleanup;
+    }
+
+    if (!kelpo->window.open(OPTIONS.deviceIdx, OPTIONS.width, OPTIONS.height, OPTIONS.bpp) ||
+        !kelpo->window.set_message_handler(default_window_message_handler))
+    {
+        fprintf(stderr, "Failed to initialize Kelpo.\n");
+        goto cleanup;
+    }
+
+    if (OPTIONS.directSubmission &&
+        !kelpoa_trisubmr__is_direct(kelpo))
+    {
+        fprintf(stderr, "The \"%s\" renderer doesn't support direct submission.\n", kelpo->metadata.rendererName);
+        goto cleanup;
+    }
+
+    /* The font's pixels are kept in memory, since each scene uploads it anew.*/
+    fontTexture = kelpoa_text_mesh__create_font();
+
+    kelpoa_triprepr__set_guard_band(OPTIONS.guardBand);
+    kelpoa_triprepr__set_backface_cull_mode((enum kelpoa_triprepr_backface_cull_mode_e)OPTIONS.cullMode);
+
+    /* Run the scenes.*/
+    {
+        unsigned scene = 0;
+        unsigned numScenesRun = 0;
+
+        fprintf(dst, "{\n");
+        fprintf(dst, "  \"renderer\": \"%s\",\n", kelpo->metadata.rendererName);
+        fprintf(dst, "  \"width\": %u,\n", OPTIONS.width);
+        fprintf(dst, "  \"height\": %u,\n", OPTIONS.height);
+        fprintf(dst, "  \"bpp\": %u,\n", OPTIONS.bpp);
+        fprintf(dst, "  \"frames\": %u,\n", OPTIONS.numFrames);
+        fprintf(dst, "  \"mesh\": \"%s\",\n", MESH_TYPE_NAMES[OPTIONS.meshType]);
+        fprintf(dst, "  \"transform\": \"%s\",\n", (OPTIONS.instancedTransform? "instanced" : OPTIONS.fusedTransform? "fused" : "separate"));
+        fprintf(dst, "  \"instances\": %u,\n", OPTIONS.numInstances);
+        fprintf(dst, "  \"guard_band\": %g,\n", OPTIONS.guardBand);
+        fprintf(dst, "  \"backface_culling\": \"%s\",\n", CULL_MODE_NAMES[OPTIONS.cullMode]);
+        fprintf(dst, "  \"sort_keys\": \"%s\",\n", SORT_KEYS[OPTIONS.sortKeys].name);
+        fprintf(dst, "  \"submission\": \"%s\",\n", (OPTIONS.directSubmission? "direct" : "triangles"));
+        fprintf(dst, "  \"scenes\": [\n");
+
+        for (scene = 0; scene < NUM_SCENES; scene++)
+        {
+            if (OPTIONS.sceneName &&
+                (strcmp(OPTIONS.sceneName, SCENE_NAMES[scene]) != 0))
+            {
+                continue;
+            }
+
+            if (numScenesRun++)
+            {
+                fprintf(dst, ",\n");
+            }
+
+            if (!run_scene((enum scene_e)scene, kelpo, fontTexture, dst))
+            {
+                goto cleanup;
+            }
+        }
+
+        fprintf(dst, "\n  ]\n");
+        fprintf(dst, "}\n");
+
+        if (!numScenesRun)
+        {
+            fprintf(stderr, "Unknown scene \"%s\".\n", OPTIONS.sceneName);
+            goto cleanup;
+        }
+    }
+
+    /* Write the profile, appending to it the renderer's own zones, if any.*/
+    if (OPTIONS.profileFilename)
+    {
+        const kelpoa_prof_write_chrome_trace_fn write_renderer_trace =
+            (kelpoa_prof_write_chrome_trace_fn)kelpo_renderer_function(kelpo, "kelpoa_prof__write_chrome_trace");
+
+        if (!kelpoa_prof__write_chrome_trace(OPTIONS.profileFilename, 0) ||
+            (write_renderer_trace && !write_renderer_trace(OPTIONS.profileFilename, 1)))
+        {
+            fprintf(stderr, "Failed to write the profile.\n");
+            goto cleanup;
+        }
+    }
+
+    returnValue = EXIT_SUCCESS;
+
+    cleanup:
+
+    if (fontTexture)
+    {
+        free(fontTexture->mipLevel[0]);
+        free(fontTexture);
+    }
+
+    free(TIMINGS);
+
+    if (dst && (dst != stdout))
+    {
+        fclose(dst);
+    }
+
+    if (!kelpo_release_interface(kelpo))
+    {
+        fprintf(stderr, "Failed to release Kelpo.\n");
+        returnValue = EXIT_FAILURE;
+    }
+
+    return returnValue;
+}
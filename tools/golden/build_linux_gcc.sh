@@ -0,0 +1,39 @@
+# Build Kelpo's golden image test tool for Linux using the system's GCC.
+# Note that this will place the executable under Kelpo's root bin/ directory.
+
+OUTPUT_FILE="../../bin/kelpo_golden"
+
+SRC_FILES="
+src/main.c
+../../examples/common_src/default_window_message_handler.c
+../../src/kelpo_auxiliary/triangle_preparer.c
+../../src/kelpo_auxiliary/bounding_volume.c
+../../src/kelpo_auxiliary/triangle_bvh.c
+../../src/kelpo_auxiliary/triangle_sorter.c
+../../src/kelpo_auxiliary/triangle_submitter.c
+../../src/kelpo_auxiliary/thread_pool.c
+../../src/kelpo_auxiliary/matrix_44.c
+../../src/kelpo_auxiliary/vector_3.c
+../../src/kelpo_auxiliary/generic_stack.c
+../../src/kelpo_auxiliary/indexed_mesh.c
+../../src/kelpo_auxiliary/vertex_stream.c
+../../src/kelpo_auxiliary/vertex_stream_sse.c
+../../src/kelpo_auxiliary/triangle_clipper.c
+../../src/kelpo_auxiliary/load_kac_1_0_mesh.c
+../../src/kelpo_auxiliary/import_kac_1_0.c
+../../src/kelpo_auxiliary/text_mesh.c
+../../src/kelpo_auxiliary/clock.c
+../../src/kelpo_interface/interface.c
+../../src/kelpo_interface/error.c
+"
+
+BUILD_OPTIONS="
+-g
+-O2
+-std=c89
+-pedantic
+-Wall
+-I../../src/
+"
+
+gcc $BUILD_OPTIONS -o $OUTPUT_FILE $SRC_FILES -lm -lpthread -ldl
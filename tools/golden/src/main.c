@@ -0,0 +1,917 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * Renders a set of fixed scenes with the software renderer and compares each
+ * rendered image against a stored reference ("golden") image, reporting for
+ * each scene whether it matched and how long its frames took to prepare and to
+ * draw. Meant to be run before and after changes to the triangle preparer,
+ * clipper or rasterizer, to catch changes in their output and in their speed.
+ *
+ * Usage: kelpo_golden [-d reference directory] [-u] [-s scene] [-n number of frames]
+ *                     [-t channel tolerance] [-p max. percent of differing pixels]
+ *                     [-r renderer] [-m mesh type] [-x transform] [-g guard band]
+ *                     [-c backface culling] [-k sort keys] [-v submission]
+ *
+ * With -u, the rendered images are written into the reference directory (by
+ * default, "../tools/golden/golden", i.e. tools/golden/golden/ when run from
+ * Kelpo's bin/ directory) as the new reference images, rather than being
+ * compared against them. Otherwise, a scene fails if more than the given percentage of
+ * its pixels (by default, 0.1) differ from the reference by more than the given
+ * amount (by default, 8 out of 255) in some color channel; and the rendered
+ * image is written next to the reference with a ".fail.ppm" suffix.
+ *
+ * The mesh type is "flat" (the default), "indexed" or "stream", and selects
+ * whether the scenes' meshes are loaded and transformed as flat triangle lists,
+ * as indexed meshes (see kelpo_auxiliary/indexed_mesh.h), or as flat triangle
+ * lists whose vertices are transformed and projected in a vertex stream (see
+ * kelpo_auxiliary/vertex_stream.h). All should produce the same images. The
+ * stream mesh type can't be combined with the fused transform. The transform is "separate" (the default) or "fused", and
+ * selects whether the mesh is duplicated, rotated, translated and projected in
+ * separate passes, or transformed and projected in one pass with a model
+ * matrix. The fused transform's rounding differs slightly from the separate
+ * passes', so its images aren't expected to match the references exactly.
+ * The guard band is passed to kelpoa_triprepr__set_guard_band(); by default, 1
+ * (no guard band). Triangles that the guard band spares from clipping are
+ * interpolated across slightly differently, so neither are images rendered with
+ * a guard band expected to match exactly. Backface culling is "normal" (the
+ * default), "area" or "plane", and selects the triangle preparer's backface
+ * culling mode (see kelpoa_triprepr__set_backface_cull_mode()). The modes can
+ * disagree on triangles seen nearly edge-on, so only "normal" is expected to
+ * match the references exactly. The sort keys are "none" (the default),
+ * "texture", "depth" or "texture+depth", and select how kelpoa_trisortr__sort()
+ * reorders the screen space triangles before they're drawn; the depth buffer
+ * resolves the overlaps, so sorted images should match the references. The
+ * submission is "triangles" (the default) or "direct", and selects whether the
+ * screen space triangles are drawn with the renderer's draw_triangles(), or
+ * written into its vertex buffer with kelpoa_trisubmr__draw_triangles(); both
+ * should produce the same images.
+ *
+ * When the software renderer visits pixels with its SIMD kernel, each scene's
+ * last frame is also drawn with the renderer's scalar loop (see
+ * kelpo_rasterizer_software__use_simd()), and the scene fails if the two images
+ * differ in any pixel. The large_triangles scene's triangles extend tens of
+ * thousands of pixels past the screen, for the edge function values that the
+ * two compute with to be large.
+ *
+ * The reference images depend on the compiler's floating-point code generation
+ * (e.g. x87 vs. SSE), so they should be created with the same build of Kelpo
+ * that they'll be compared against, and the tolerance loosened when comparing
+ * across builds. The references in tools/golden/golden/ were created with the
+ * Linux build (build_linux_renderers.sh and build_linux_gcc.sh) by GCC 12.2 on
+ * x86-64. Don't update them with -u until the change in the images has been
+ * examined and found intended.
+ *
+ * The renderer must export kelpo_rasterizer_software__pixels(), as the software
+ * renderer does. The scenes expect their assets (apricot.kac, cube.kac,
+ * sample-font.raw) in the working directory; the meshes can be copied from the
+ * examples' bin/ directories.
+ *
+ * Returns EXIT_SUCCESS if all scenes passed; EXIT_FAILURE otherwise.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <kelpo_interface/polygon/triangle/triangle.h>
+#include <kelpo_auxiliary/load_kac_1_0_mesh.h>
+#include <kelpo_auxiliary/triangle_preparer.h>
+#include <kelpo_auxiliary/generic_stack.h>
+#include <kelpo_auxiliary/indexed_mesh.h>
+#include <kelpo_auxiliary/vertex_stream.h>
+#include <kelpo_auxiliary/triangle_sorter.h>
+#include <kelpo_auxiliary/triangle_submitter.h>
+#include <kelpo_auxiliary/bounding_volume.h>
+#include <kelpo_auxiliary/matrix_44.h>
+#include <kelpo_auxiliary/text_mesh.h>
+#include <kelpo_auxiliary/clock.h>
+#include <kelpo_auxiliary/misc.h>
+#include <kelpo_interface/interface.h>
+#include <kelpo_interface/error.h>
+#include "../../../examples/common_src/default_window_message_handler.h"
+
+enum scene_e
+{
+    SCENE_TEXTURED_CUBE,
+    SCENE_APRICOT,
+    SCENE_NEAR_PLANE_CLIP,
+    SCENE_TEXT_OVERLAY,
+    SCENE_LARGE_TRIANGLES,
+    NUM_SCENES
+};
+
+static const char *const SCENE_NAMES[NUM_SCENES] = {"textured_cube",
+                                                    "apricot",
+                                                    "near_plane_clip",
+                                                    "text_overlay",
+                                                    "large_triangles"};
+
+/* NULL if the scene has no mesh.*/
+static const char *const SCENE_MESH_FILENAMES[NUM_SCENES] = {"cube.kac",
+                                                             "apricot.kac",
+                                                             "cube.kac",
+                                                             NULL,
+                                                             NULL};
+
+/* The rotation and translation applied to each scene's mesh, in world space.
+ * The near_plane_clip scene's cube is moved close enough to the camera that its
+ * front triangles cross the near plane and get clipped.*/
+static const float SCENE_ROTATIONS[NUM_SCENES][3] = {{0.5, 0.8, 0.2},
+                                                     {0, 1.0, 0},
+                                                     {0.6, 0.8, 0},
+                                                     {0, 0, 0},
+                                                     {0, 0, 0}};
+
+static const float SCENE_TRANSLATIONS[NUM_SCENES][3] = {{0, 0, 4.7},
+                                                        {0, -2.5, 8.5},
+                                                        {0.8, 0.3, 1.6},
+                                                        {0, 0, 0},
+                                                        {0, 0, 0}};
+
+/* The large_triangles scene's triangles, in screen space: the XY coordinates
+ * of each vertex, followed by its depth and RGB color.*/
+static const float LARGE_TRIANGLES[][3][6] = {{{0, 100.3, 0.5, 255, 0, 0},
+                                               {20000, 100.3, 0.5, 0, 255, 0},
+                                               {10000, 30000, 0.5, 0, 0, 255}},
+                                              {{-30000, 200.5, 0.6, 255, 255, 0},
+                                               {30000, 200.5, 0.6, 0, 255, 255},
+                                               {0, -60000, 0.6, 255, 0, 255}}};
+
+#define NUM_LARGE_TRIANGLES (sizeof(LARGE_TRIANGLES) / sizeof(LARGE_TRIANGLES[0]))
+
+enum mesh_type_e
+{
+    MESH_TYPE_FLAT,
+    MESH_TYPE_INDEXED,
+    MESH_TYPE_STREAM,
+    NUM_MESH_TYPES
+};
+
+static const char *const MESH_TYPE_NAMES[NUM_MESH_TYPES] = {"flat",
+                                                            "indexed",
+                                                            "stream"};
+
+/* The command-line names of the triangle preparer's backface culling modes,
+ * indexed by enum kelpoa_triprepr_backface_cull_mode_e.*/
+static const char *const CULL_MODE_NAMES[] = {"normal",
+                                              "area",
+                                              "plane"};
+
+#define NUM_CULL_MODES (sizeof(CULL_MODE_NAMES) / sizeof(CULL_MODE_NAMES[0]))
+
+/* The command-line names of the triangle sorter's keys (see
+ * kelpoa_trisortr__sort()).*/
+static const struct
+{
+    const char *name;
+    unsigned keys;
+} SORT_KEYS[] = {{"none", 0},
+                 {"texture", KELPOA_TRISORTR_KEY_TEXTURE},
+                 {"depth", KELPOA_TRISORTR_KEY_DEPTH},
+                 {"texture+depth", (KELPOA_TRISORTR_KEY_TEXTURE | KELPOA_TRISORTR_KEY_DEPTH)}};
+
+#define NUM_SORT_KEYS (sizeof(SORT_KEYS) / sizeof(SORT_KEYS[0]))
+
+/* The resolution at which the scenes are rendered. Reference images of another
+ * resolution never match.*/
+static const unsigned SCREEN_WIDTH = 640;
+static const unsigned SCREEN_HEIGHT = 480;
+
+static const float Z_NEAR = 0.1;
+static const float Z_FAR = 100;
+
+/* Test options.*/
+static struct
+{
+    const char *rendererName;
+    const char *referenceDirectory;
+    const char *sceneName; /* If NULL, all scenes will be run.*/
+    int updateReferences;
+    unsigned numFrames;
+    unsigned channelTolerance;
+    double maxDifferingPixelsPercent;
+    unsigned meshType; /* One of enum mesh_type_e.*/
+    int fusedTransform;
+    float guardBand;
+    unsigned cullMode;
+    unsigned sortKeys; /* An index to SORT_KEYS.*/
+    int directSubmission;
+} OPTIONS = {"software", "../tools/golden/golden", NULL, 0, 20, 8, 0.1, MESH_TYPE_FLAT, 0, 1, KELPOA_TRIPREPR_CULL_BY_VERTEX_NORMAL, 0, 0};
+
+/* The rendered frame's pixels, in 32-bit XRGB 8888 format.*/
+typedef const uint32_t* (*get_pixels_fn_t)(void);
+
+/* Selects the software renderer's SIMD kernel or its scalar loop.*/
+typedef int (*use_simd_fn_t)(const int useSimd);
+
+static int compare_doubles(const void *a, const void *b)
+{
+    const double x = *(const double*)a;
+    const double y = *(const double*)b;
+
+    return ((x > y) - (x < y));
+}
+
+/* Returns the median of the given timings, in milliseconds. Sorts the timings.*/
+static double median_ms(double *const timings, const unsigned numTimings)
+{
+    qsort(timings, numTimings, sizeof(*timings), compare_doubles);
+
+    return (timings[numTimings / 2] / 1000000.0);
+}
+
+/* Writes the given XRGB pixels into a binary (P6) PPM file. Returns 1 on
+ * success; 0 on failure.*/
+static int write_ppm(const char *const filename,
+                     const uint32_t *const pixels,
+                     const unsigned width,
+                     const unsigned height)
+{
+    FILE *const file = fopen(filename, "wb");
+    unsigned i = 0;
+    int writeFailed = 0;
+
+    if (!file)
+    {
+        fprintf(stderr, "Failed to open \"%s\" for writing.\n", filename);
+        return 0;
+    }
+
+    fprintf(file, "P6\n%u %u\n255\n", width, height);
+
+    for (i = 0; i < (width * height); i++)
+    {
+        fputc(((pixels[i] >> 16) & 0xff), file);
+        fputc(((pixels[i] >> 8) & 0xff), file);
+        fputc(((pixels[i] >> 0) & 0xff), file);
+    }
+
+    writeFailed = ferror(file);
+
+    if ((fclose(file) != 0) ||
+        writeFailed)
+    {
+        fprintf(stderr, "Failed to write into \"%s\".\n", filename);
+        return 0;
+    }
+
+    return 1;
+}
+
+/* Reads a binary (P6) PPM file of the given resolution into the given buffer
+ * of XRGB pixels. Returns 1 on success; 0 on failure.*/
+static int read_ppm(const char *const filename,
+                    uint32_t *const dstPixels,
+                    const unsigned width,
+                    const unsigned height)
+{
+    FILE *const file = fopen(filename, "rb");
+    unsigned fileWidth = 0, fileHeight = 0, maxValue = 0;
+    unsigned i = 0;
+    int returnValue = 0;
+
+    if (!file)
+    {
+        fprintf(stderr, "Failed to open \"%s\". Reference images can be created with -u.\n", filename);
+        return 0;
+    }
+
+    /* The header is followed by a single whitespace character.*/
+    if ((fscanf(file, "P6 %u %u %u", &fileWidth, &fileHeight, &maxValue) != 3) ||
+        (fgetc(file) == EOF) ||
+        (maxValue != 255))
+    {
+        fprintf(stderr, "\"%s\" isn't a supported PPM file.\n", filename);
+        goto done;
+    }
+
+    if ((fileWidth != width) ||
+        (fileHeight != height))
+    {
+        fprintf(stderr, "\"%s\" is %u x %u; expected %u x %u.\n", filename, fileWidth, fileHeight, width, height);
+        goto done;
+    }
+
+    for (i = 0; i < (width * height); i++)
+    {
+        const int r = fgetc(file);
+        const int g = fgetc(file);
+        const int b = fgetc(file);
+
+        if (b == EOF)
+        {
+            fprintf(stderr, "\"%s\" is truncated.\n", filename);
+            goto done;
+        }
+
+        dstPixels[i] = (((uint32_t)r << 16) | ((uint32_t)g << 8) | (uint32_t)b);
+    }
+
+    returnValue = 1;
+
+    done:
+    fclose(file);
+    return returnValue;
+}
+
+/* Returns the number of pixels in which some color channel differs between the
+ * two images by more than the given tolerance.*/
+static unsigned long count_differing_pixels(const uint32_t *const pixels,
+                                            const uint32_t *const referencePixels,
+                                            const unsigned numPixels,
+                                            const unsigned channelTolerance)
+{
+    unsigned long numDiffering = 0;
+    unsigned i = 0;
+
+    for (i = 0; i < numPixels; i++)
+    {
+        unsigned shift = 0;
+
+        for (shift = 0; shift <= 16; shift += 8)
+        {
+            const int channel = ((pixels[i] >> shift) & 0xff);
+            const int referenceChannel = ((referencePixels[i] >> shift) & 0xff);
+
+            if ((unsigned)abs(channel - referenceChannel) > channelTolerance)
+            {
+                numDiffering++;
+                break;
+            }
+        }
+    }
+
+    return numDiffering;
+}
+
+/* Transforms the scene's mesh into screen space and adds the scene's text,
+ * placing the resulting triangles in 'screenSpaceTriangles'. The mesh is
+ * 'triangles' (enclosed by 'triangleBounds'), or 'mesh' if the options ask for
+ * an indexed mesh; and for the stream mesh type, 'meshStream' holds the
+ * vertices of 'triangles'.*/
+static void prepare_frame(const enum scene_e scene,
+                          const struct kelpoa_generic_stack_s *const triangles,
+                          const struct kelpoa_bounding_volume_s *const triangleBounds,
+                          struct kelpoa_indexed_mesh_s *const mesh,
+                          const struct kelpoa_vertex_stream_s *const meshStream,
+                          struct kelpoa_generic_stack_s *const worldSpaceTriangles,
+                          struct kelpoa_indexed_mesh_s *const worldSpaceMesh,
+                          struct kelpoa_vertex_stream_s *const worldSpaceStream,
+                          struct kelpoa_generic_stack_s *const screenSpaceTriangles,
+                          const struct kelpoa_matrix44_s *const clipSpaceMatrix,
+                          const struct kelpoa_matrix44_s *const screenSpaceMatrix)
+{
+    const float *const rotation = SCENE_ROTATIONS[scene];
+    const float *const translation = SCENE_TRANSLATIONS[scene];
+
+    kelpoa_generic_stack__clear(screenSpaceTriangles);
+
+    if (OPTIONS.fusedTransform)
+    {
+        struct kelpoa_matrix44_s modelMatrix;
+
+        kelpoa_matrix44__make_model_matrix(&modelMatrix,
+                                           rotation[0], rotation[1], rotation[2],
+                                           translation[0], translation[1], translation[2]);
+
+        if (OPTIONS.meshType == MESH_TYPE_INDEXED)
+        {
+            kelpoa_triprepr__transform_and_project_indexed_mesh(mesh,
+                                                                screenSpaceTriangles,
+                                                                &modelMatrix,
+                                                                clipSpaceMatrix,
+                                                                screenSpaceMatrix,
+                                                                Z_NEAR, Z_FAR, 1);
+        }
+        else
+        {
+            kelpoa_triprepr__transform_and_project_triangles(triangles,
+                                                             screenSpaceTriangles,
+                                                             triangleBounds,
+                                                             &modelMatrix,
+                                                             clipSpaceMatrix,
+                                                             screenSpaceMatrix,
+                                                             Z_NEAR, Z_FAR, 1);
+        }
+    }
+    else if (OPTIONS.meshType == MESH_TYPE_INDEXED)
+    {
+        kelpoa_triprepr__duplicate_indexed_mesh(mesh, worldSpaceMesh);
+        kelpoa_triprepr__rotate_indexed_mesh(worldSpaceMesh, rotation[0], rotation[1], rotation[2]);
+        kelpoa_triprepr__translate_indexed_mesh(worldSpaceMesh, translation[0], translation[1], translation[2]);
+        kelpoa_triprepr__project_indexed_mesh_to_screen(worldSpaceMesh,
+                                                        screenSpaceTriangles,
+                                                        clipSpaceMatrix,
+                                                        screenSpaceMatrix,
+                                                        Z_NEAR, Z_FAR, 1);
+    }
+    else if (OPTIONS.meshType == MESH_TYPE_STREAM)
+    {
+        struct kelpoa_matrix44_s rotationMatrix;
+        struct kelpoa_matrix44_s translationMatrix;
+
+        kelpoa_matrix44__make_rotation_matrix(&rotationMatrix, rotation[0], rotation[1], rotation[2]);
+        kelpoa_matrix44__make_translation_matrix(&translationMatrix, translation[0], translation[1], translation[2]);
+
+        kelpoa_vertex_stream__copy(meshStream, worldSpaceStream);
+        kelpoa_vertex_stream__transform(worldSpaceStream, &rotationMatrix);
+        kelpoa_vertex_stream__transform_normals(worldSpaceStream, &rotationMatrix);
+        kelpoa_vertex_stream__transform(worldSpaceStream, &translationMatrix);
+        kelpoa_triprepr__project_vertex_stream_to_screen(worldSpaceStream,
+                                                         triangles,
+                                                         screenSpaceTriangles,
+                                                         clipSpaceMatrix,
+                                                         screenSpaceMatrix,
+                                                         Z_NEAR, Z_FAR, 1);
+    }
+    else
+    {
+        kelpoa_generic_stack__clear(worldSpaceTriangles);
+        kelpoa_triprepr__duplicate_triangles(triangles, worldSpaceTriangles);
+        kelpoa_triprepr__rotate_triangles(worldSpaceTriangles, rotation[0], rotation[1], rotation[2]);
+        kelpoa_triprepr__translate_triangles(worldSpaceTriangles, translation[0], translation[1], translation[2]);
+        kelpoa_triprepr__project_triangles_to_screen(worldSpaceTriangles,
+                                                     screenSpaceTriangles,
+                                                     clipSpaceMatrix,
+                                                     screenSpaceMatrix,
+                                                     Z_NEAR, Z_FAR, 1);
+    }
+
+    if (scene == SCENE_TEXT_OVERLAY)
+    {
+        kelpoa_text_mesh__print(screenSpaceTriangles, "Kelpo", 25, 30, 255, 255, 255, 1);
+        kelpoa_text_mesh__print(screenSpaceTriangles, "Golden image 0123456789", 25, 60, 200, 200, 200, 1);
+        kelpoa_text_mesh__print(screenSpaceTriangles, "Scaled text", 25, 120, 255, 255, 0, 2.5);
+        kelpoa_text_mesh__print(screenSpaceTriangles, "!\"#$%&'()*+,-./:;<=>?@[]", 25, 220, 100, 200, 255, 1.3);
+    }
+
+    if (scene == SCENE_LARGE_TRIANGLES)
+    {
+        unsigned t = 0, v = 0;
+
+        for (t = 0; t < NUM_LARGE_TRIANGLES; t++)
+        {
+            struct kelpo_polygon_triangle_s triangle;
+
+            memset(&triangle, 0, sizeof(triangle));
+
+            for (v = 0; v < 3; v++)
+            {
+                triangle.vertex[v].x = LARGE_TRIANGLES[t][v][0];
+                triangle.vertex[v].y = LARGE_TRIANGLES[t][v][1];
+                triangle.vertex[v].z = LARGE_TRIANGLES[t][v][2];
+                triangle.vertex[v].w = 1;
+                triangle.vertex[v].r = LARGE_TRIANGLES[t][v][3];
+                triangle.vertex[v].g = LARGE_TRIANGLES[t][v][4];
+                triangle.vertex[v].b = LARGE_TRIANGLES[t][v][5];
+                triangle.vertex[v].a = 255;
+            }
+
+            kelpoa_generic_stack__push_copy(screenSpaceTriangles, &triangle);
+        }
+    }
+
+    kelpoa_trisortr__sort(screenSpaceTriangles, SORT_KEYS[OPTIONS.sortKeys].keys);
+
+    return;
+}
+
+/* Renders the given scene for the number of frames given in the options, and
+ * compares (or, with -u, saves) the last frame. If 'use_simd' isn't NULL, the
+ * last frame is also compared against the same frame drawn with the scalar
+ * loop. Prints the scene's result. Returns 1 if the scene passed; 0 otherwise.*/
+/* Draws the given screen space triangles with the given renderer, as selected
+ * by the submission option. Returns 1 on success; 0 on failure.*/
+static int draw_triangles(const struct kelpo_interface_s *const kelpo,
+                          struct kelpoa_generic_stack_s *const screenSpaceTriangles)
+{
+    return (OPTIONS.directSubmission
+            ? kelpoa_trisubmr__draw_triangles(kelpo, screenSpaceTriangles)
+            : kelpo->rasterizer.draw_triangles(screenSpaceTriangles->data, screenSpaceTriangles->count));
+}
+
+static int run_scene(const enum scene_e scene,
+                     const struct kelpo_interface_s *const kelpo,
+                     struct kelpo_polygon_texture_s *const fontTexture,
+                     const get_pixels_fn_t get_pixels,
+                     const use_simd_fn_t use_simd)
+{
+    const unsigned numPixels = (SCREEN_WIDTH * SCREEN_HEIGHT);
+    uint32_t numTextures = 0;
+    struct kelpo_polygon_texture_s *textures = NULL;
+    struct kelpoa_generic_stack_s *triangles = kelpoa_generic_stack__create(1, sizeof(struct kelpo_polygon_triangle_s));
+    struct kelpoa_generic_stack_s *worldSpaceTriangles = kelpoa_generic_stack__create(1, sizeof(struct kelpo_polygon_triangle_s));
+    struct kelpoa_generic_stack_s *screenSpaceTriangles = kelpoa_generic_stack__create(1, sizeof(struct kelpo_polygon_triangle_s));
+    struct kelpoa_indexed_mesh_s *mesh = kelpoa_indexed_mesh__create();
+    struct kelpoa_indexed_mesh_s *worldSpaceMesh = kelpoa_indexed_mesh__create();
+    struct kelpoa_vertex_stream_s *meshStream = kelpoa_vertex_stream__create(1);
+    struct kelpoa_vertex_stream_s *worldSpaceStream = kelpoa_vertex_stream__create(1);
+    struct kelpoa_bounding_volume_s triangleBounds;
+    double *const prepareTimes = (double*)malloc(OPTIONS.numFrames * sizeof(double));
+    double *const drawTimes = (double*)malloc(OPTIONS.numFrames * sizeof(double));
+    uint32_t *const referencePixels = (uint32_t*)malloc(numPixels * sizeof(uint32_t));
+    uint32_t *const scalarPixels = (uint32_t*)malloc(numPixels * sizeof(uint32_t));
+    unsigned long numDifferingFromScalar = 0;
+    char *const referenceFilename = (char*)malloc(strlen(OPTIONS.referenceDirectory) + strlen(SCENE_NAMES[scene]) + 16);
+    struct kelpoa_matrix44_s clipSpaceMatrix;
+    struct kelpoa_matrix44_s screenSpaceMatrix;
+    int returnValue = 0;
+    uint32_t i = 0;
+
+    if (!prepareTimes || !drawTimes || !referencePixels || !scalarPixels || !referenceFilename)
+    {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        goto cleanup;
+    }
+
+    sprintf(referenceFilename, "%s/%s.ppm", OPTIONS.referenceDirectory, SCENE_NAMES[scene]);
+
+    /* Load the scene's assets and send them to Kelpo. Each scene starts with
+     * no textures uploaded.*/
+    {
+        kelpoa_bounding_volume__clear(&triangleBounds);
+
+        if (SCENE_MESH_FILENAMES[scene] &&
+            ((OPTIONS.meshType == MESH_TYPE_INDEXED)
+             ? (!kelpoa_load_kac10_indexed_mesh(SCENE_MESH_FILENAMES[scene], mesh, &textures, &numTextures) ||
+                !mesh->triangles->count)
+             : (!kelpoa_load_kac10_mesh(SCENE_MESH_FILENAMES[scene], triangles, &textures, &numTextures) ||
+                !triangles->count)))
+        {
+            fprintf(stderr, "Failed to load \"%s\".\n", SCENE_MESH_FILENAMES[scene]);
+            goto cleanup;
+        }
+
+        if (SCENE_MESH_FILENAMES[scene] &&
+            (OPTIONS.meshType != MESH_TYPE_INDEXED))
+        {
+            kelpoa_bounding_volume__of_triangles(&triangleBounds, triangles);
+        }
+
+        if (OPTIONS.meshType == MESH_TYPE_STREAM)
+        {
+            kelpoa_vertex_stream__from_triangles(meshStream, triangles);
+        }
+
+        fontTexture->apiId = 0;
+        fontTexture->apiAuxData = NULL;
+
+        if (!kelpo->rasterizer.unload_textures() ||
+            !kelpo->rasterizer.upload_texture(fontTexture))
+        {
+            fprintf(stderr, "Failed to transfer asset data to Kelpo.\n");
+            goto cleanup;
+        }
+
+        for (i = 0; i < numTextures; i++)
+        {
+            if (!kelpo->rasterizer.upload_texture(&textures[i]))
+            {
+                fprintf(stderr, "Failed to transfer asset data to Kelpo.\n");
+                goto cleanup;
+            }
+        }
+    }
+
+    kelpoa_matrix44__make_clip_space_matrix(&clipSpaceMatrix,
+                                            KELPOA_DEG_TO_RAD(60),
+                                            (SCREEN_WIDTH / (float)SCREEN_HEIGHT),
+                                            Z_NEAR, Z_FAR);
+
+    kelpoa_matrix44__make_screen_space_matrix(&screenSpaceMatrix,
+                                              (SCREEN_WIDTH / 2.0f),
+                                              (SCREEN_HEIGHT / 2.0f));
+
+    /* Every frame of the scene is identical; rendering several of them gives
+     * steadier timings.*/
+    for (i = 0; i < OPTIONS.numFrames; i++)
+    {
+        double startTime = kelpoa_clock__nanoseconds();
+
+        prepare_frame(scene, triangles, &triangleBounds, mesh, meshStream, worldSpaceTriangles, worldSpaceMesh, worldSpaceStream,
+                      screenSpaceTriangles, &clipSpaceMatrix, &screenSpaceMatrix);
+
+        prepareTimes[i] = (kelpoa_clock__nanoseconds() - startTime);
+        startTime = kelpoa_clock__nanoseconds();
+
+        kelpo->rasterizer.clear_frame();
+        draw_triangles(kelpo, screenSpaceTriangles);
+        kelpo->window.flip_surface();
+
+        drawTimes[i] = (kelpoa_clock__nanoseconds() - startTime);
+
+        kelpo->window.process_messages();
+
+        if (kelpo_error_peek() != KELPOERR_ALL_GOOD)
+        {
+            fprintf(stderr, "Kelpo has reported an error.\n");
+            goto cleanup;
+        }
+    }
+
+    /* Draw the last frame with the scalar loop, and then again with the SIMD
+     * kernel, leaving the latter's image to be checked below.*/
+    if (use_simd)
+    {
+        use_simd(0);
+        kelpo->rasterizer.clear_frame();
+        draw_triangles(kelpo, screenSpaceTriangles);
+        memcpy(scalarPixels, get_pixels(), (numPixels * sizeof(uint32_t)));
+
+        use_simd(1);
+        kelpo->rasterizer.clear_frame();
+        draw_triangles(kelpo, screenSpaceTriangles);
+        numDifferingFromScalar = count_differing_pixels(get_pixels(), scalarPixels, numPixels, 0);
+    }
+
+    /* Check the last frame against the reference image; or, with -u, make it
+     * the new reference image.*/
+    if (OPTIONS.updateReferences)
+    {
+        if (!write_ppm(referenceFilename, get_pixels(), SCREEN_WIDTH, SCREEN_HEIGHT))
+        {
+            goto cleanup;
+        }
+
+        printf("%-16s UPDATED", SCENE_NAMES[scene]);
+        returnValue = (numDifferingFromScalar == 0);
+    }
+    else
+    {
+        const unsigned long numDiffering = (read_ppm(referenceFilename, referencePixels, SCREEN_WIDTH, SCREEN_HEIGHT)
+                                            ? count_differing_pixels(get_pixels(), referencePixels, numPixels, OPTIONS.channelTolerance)
+                                            : numPixels);
+
+        returnValue = ((((numDiffering * 100.0) / numPixels) <= OPTIONS.maxDifferingPixelsPercent) &&
+                       (numDifferingFromScalar == 0));
+
+        printf("%-16s %s  %lu/%u pixels differ", SCENE_NAMES[scene], (returnValue? "PASS" : "FAIL"), numDiffering, numPixels);
+
+        if (!returnValue)
+        {
+            strcpy(&referenceFilename[strlen(referenceFilename) - strlen(".ppm")], ".fail.ppm");
+            write_ppm(referenceFilename, get_pixels(), SCREEN_WIDTH, SCREEN_HEIGHT);
+        }
+    }
+
+    if (use_simd)
+    {
+        printf(", %lu from the scalar loop's", numDifferingFromScalar);
+    }
+
+    printf("  (%lu triangles; prepare %.3f ms, draw %.3f ms)\n",
+           (unsigned long)screenSpaceTriangles->count,
+           median_ms(prepareTimes, OPTIONS.numFrames),
+           median_ms(drawTimes, OPTIONS.numFrames));
+
+    cleanup:
+
+    for (i = 0; i < numTextures; i++)
+    {
+        uint32_t m = 0;
+
+        for (m = 0; m < textures[i].numMipLevels; m++)
+        {
+            free(textures[i].mipLevel[m]);
+        }
+    }
+
+    free(textures);
+    free(prepareTimes);
+    free(drawTimes);
+    free(referencePixels);
+    free(scalarPixels);
+    free(referenceFilename);
+    kelpoa_generic_stack__free(triangles);
+    kelpoa_generic_stack__free(worldSpaceTriangles);
+    kelpoa_generic_stack__free(screenSpaceTriangles);
+    kelpoa_indexed_mesh__free(mesh);
+    kelpoa_indexed_mesh__free(worldSpaceMesh);
+    kelpoa_vertex_stream__free(meshStream);
+    kelpoa_vertex_stream__free(worldSpaceStream);
+
+    return returnValue;
+}
+
+static int parse_options(const int argc, char *const argv[])
+{
+    int i = 0;
+
+    for (i = 1; i < argc; i++)
+    {
+        const char *const arg = ((i + 1) < argc)? argv[i + 1] : NULL;
+
+        if ((strlen(argv[i]) != 2) ||
+            (argv[i][0] != '-'))
+        {
+            return 0;
+        }
+
+        /* The only option that takes no argument.*/
+        if (argv[i][1] == 'u')
+        {
+            OPTIONS.updateReferences = 1;
+            continue;
+        }
+
+        if (!arg)
+        {
+            return 0;
+        }
+
+        switch (argv[i++][1])
+        {
+            case 'r': OPTIONS.rendererName = arg; break;
+            case 'd': OPTIONS.referenceDirectory = arg; break;
+            case 's': OPTIONS.sceneName = arg; break;
+            case 'n': OPTIONS.numFrames = strtoul(arg, NULL, 10); break;
+            case 't': OPTIONS.channelTolerance = strtoul(arg, NULL, 10); break;
+            case 'p': OPTIONS.maxDifferingPixelsPercent = strtod(arg, NULL); break;
+            case 'g': OPTIONS.guardBand = strtod(arg, NULL); break;
+            case 'x':
+            {
+                OPTIONS.fusedTransform = (strcmp(arg, "fused") == 0);
+
+                if (!OPTIONS.fusedTransform &&
+                    (strcmp(arg, "separate") != 0))
+                {
+                    return 0;
+                }
+
+                break;
+            }
+            case 'k':
+            {
+                for (OPTIONS.sortKeys = 0; OPTIONS.sortKeys < NUM_SORT_KEYS; OPTIONS.sortKeys++)
+                {
+                    if (strcmp(arg, SORT_KEYS[OPTIONS.sortKeys].name) == 0)
+                    {
+                        break;
+                    }
+                }
+
+                if (OPTIONS.sortKeys == NUM_SORT_KEYS)
+                {
+                    return 0;
+                }
+
+                break;
+            }
+            case 'c':
+            {
+                for (OPTIONS.cullMode = 0; OPTIONS.cullMode < NUM_CULL_MODES; OPTIONS.cullMode++)
+                {
+                    if (strcmp(arg, CULL_MODE_NAMES[OPTIONS.cullMode]) == 0)
+                    {
+                        break;
+                    }
+                }
+
+                if (OPTIONS.cullMode == NUM_CULL_MODES)
+                {
+                    return 0;
+                }
+
+                break;
+            }
+            case 'v':
+            {
+                OPTIONS.directSubmission = (strcmp(arg, "direct") == 0);
+
+                if (!OPTIONS.directSubmission &&
+                    (strcmp(arg, "triangles") != 0))
+                {
+                    return 0;
+                }
+
+                break;
+            }
+            case 'm':
+            {
+                for (OPTIONS.meshType = 0; OPTIONS.meshType < NUM_MESH_TYPES; OPTIONS.meshType++)
+                {
+                    if (strcmp(arg, MESH_TYPE_NAMES[OPTIONS.meshType]) == 0)
+                    {
+                        break;
+                    }
+                }
+
+                if (OPTIONS.meshType == NUM_MESH_TYPES)
+                {
+                    return 0;
+                }
+
+                break;
+            }
+            default: return 0;
+        }
+    }
+
+    return ((OPTIONS.numFrames > 0) &&
+            (OPTIONS.guardBand >= 1) &&
+            !(OPTIONS.fusedTransform && (OPTIONS.meshType == MESH_TYPE_STREAM)));
+}
+
+int main(int argc, char *argv[])
+{
+    const struct kelpo_interface_s *kelpo = NULL;
+    struct kelpo_polygon_texture_s *fontTexture = NULL;
+    get_pixels_fn_t get_pixels = NULL;
+    use_simd_fn_t use_simd = NULL;
+    int returnValue = EXIT_FAILURE;
+
+    if (!parse_options(argc, argv))
+    {
+        fprintf(stderr, "Usage: %s [-d reference directory] [-u] [-s scene] [-n number of frames]\n"
+                        "       [-t channel tolerance] [-p max. percent of differing pixels]\n"
+                        "       [-r renderer] [-m mesh type] [-x transform] [-g guard band]\n"
+                        "       [-c backface culling] [-k sort keys] [-v submission]\n", argv[0]);
+        goto cleanup;
+    }
+
+    if (!kelpo_create_interface(&kelpo, OPTIONS.rendererName) ||
+        !kelpo->window.open(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32) ||
+        !kelpo->window.set_message_handler(default_window_message_handler))
+    {
+        fprintf(stderr, "Failed to initialize Kelpo.\n");
+        goto cleanup;
+    }
+
+    if (!(get_pixels = (get_pixels_fn_t)kelpo_renderer_function(kelpo, "kelpo_rasterizer_software__pixels")))
+    {
+        fprintf(stderr, "The renderer doesn't provide access to its pixels.\n");
+        goto cleanup;
+    }
+
+    if (OPTIONS.directSubmission &&
+        !kelpoa_trisubmr__is_direct(kelpo))
+    {
+        fprintf(stderr, "The \"%s\" renderer doesn't support direct submission.\n", kelpo->metadata.rendererName);
+        goto cleanup;
+    }
+
+    /* Compare against the scalar loop only if the SIMD kernel is in use, and
+     * hasn't been disabled via KELPO_SOFTWARE_NO_SIMD.*/
+    if ((use_simd = (use_simd_fn_t)kelpo_renderer_function(kelpo, "kelpo_rasterizer_software__use_simd")) &&
+        (getenv("KELPO_SOFTWARE_NO_SIMD") || !use_simd(1)))
+    {
+        use_simd = NULL;
+    }
+
+    /* The font's pixels are kept in memory, since each scene uploads it anew.*/
+    fontTexture = kelpoa_text_mesh__create_font();
+
+    kelpoa_triprepr__set_guard_band(OPTIONS.guardBand);
+    kelpoa_triprepr__set_backface_cull_mode((enum kelpoa_triprepr_backface_cull_mode_e)OPTIONS.cullMode);
+
+    /* Run the scenes.*/
+    {
+        unsigned scene = 0;
+        unsigned numScenesRun = 0;
+        unsigned numScenesPassed = 0;
+
+        for (scene = 0; scene < NUM_SCENES; scene++)
+        {
+            if (OPTIONS.sceneName &&
+                (strcmp(OPTIONS.sceneName, SCENE_NAMES[scene]) != 0))
+            {
+                continue;
+            }
+
+            numScenesRun++;
+            numScenesPassed += run_scene((enum scene_e)scene, kelpo, fontTexture, get_pixels, use_simd);
+        }
+
+        if (!numScenesRun)
+        {
+            fprintf(stderr, "Unknown scene \"%s\".\n", OPTIONS.sceneName);
+            goto cleanup;
+        }
+
+        printf("%u/%u scenes passed.\n", numScenesPassed, numScenesRun);
+
+        if (numScenesPassed != numScenesRun)
+        {
+            goto cleanup;
+        }
+    }
+
+    returnValue = EXIT_SUCCESS;
+
+    cleanup:
+
+    if (fontTexture)
+    {
+        free(fontTexture->mipLevel[0]);
+        free(fontTexture);
+    }
+
+    if (!kelpo_release_interface(kelpo))
+    {
+        fprintf(stderr, "Failed to release Kelpo.\n");
+        returnValue = EXIT_FAILURE;
+    }
+
+    return returnValue;
+}
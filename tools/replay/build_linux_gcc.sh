@@ -0,0 +1,24 @@
+# Build Kelpo's trace replay tool for Linux using the system's GCC.
+# Note that this will place the executable under Kelpo's root bin/ directory.
+
+OUTPUT_FILE="../../bin/kelpo_replay"
+
+SRC_FILES="
+src/main.c
+../../examples/common_src/default_window_message_handler.c
+../../src/kelpo_auxiliary/command_trace.c
+../../src/kelpo_auxiliary/clock.c
+../../src/kelpo_interface/interface.c
+../../src/kelpo_interface/error.c
+"
+
+BUILD_OPTIONS="
+-g
+-O2
+-std=c89
+-pedantic
+-Wall
+-I../../src/
+"
+
+gcc $BUILD_OPTIONS -o $OUTPUT_FILE $SRC_FILES -ldl
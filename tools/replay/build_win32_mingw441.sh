@@ -0,0 +1,30 @@
+# Build Kelpo's trace replay tool for Win32 using TDM-GCC (MinGW) 4.4.1 via Wine in Linux.
+# Note that this will place the executable under Kelpo's root bin/ directory.
+
+MINGW441_PATH=~/compi/mingw441
+
+OUTPUT_FILE="../../bin/kelpo_replay.exe"
+
+SRC_FILES="
+src/main.c
+../../examples/common_src/default_window_message_handler.c
+../../src/kelpo_auxiliary/command_trace.c
+../../src/kelpo_auxiliary/clock.c
+../../src/kelpo_interface/interface.c
+../../src/kelpo_interface/error.c
+"
+
+BUILD_OPTIONS="
+-nostdinc
+-g
+-O2
+-std=c89
+-pedantic
+-Wall
+-march=pentium
+-I../../src/
+-isystem $MINGW441_PATH/lib/gcc/mingw32/4.4.1/include
+-isystem $MINGW441_PATH/include
+"
+
+wine "$MINGW441_PATH/bin/gcc.exe" $BUILD_OPTIONS -o $OUTPUT_FILE $SRC_FILES
@@ -0,0 +1,179 @@
+/*
+ * 2021 Tarpeeksi Hyvae Soft
+ *
+ * Replays a command trace recorded with Kelpo's recording renderer, issuing
+ * its commands to a given Kelpo renderer as fast as the renderer accepts them,
+ * and reports how long the replay took.
+ *
+ * Usage: kelpo_replay <trace file> [-r renderer] [-l number of loops] [-d device]
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <kelpo_auxiliary/command_trace.h>
+#include <kelpo_auxiliary/clock.h>
+#include <kelpo_interface/interface.h>
+#include <kelpo_interface/error.h>
+#include "../../../examples/common_src/default_window_message_handler.h"
+
+static int compare_doubles(const void *a, const void *b)
+{
+    const double x = *(const double*)a;
+    const double y = *(const double*)b;
+
+    return ((x > y) - (x < y));
+}
+
+int main(int argc, char *argv[])
+{
+    const struct kelpo_interface_s *kelpo = NULL;
+    struct kelpoa_cmdtrace_s *trace = NULL;
+    double *frameTimes = NULL;
+    unsigned long numFramesReplayed = 0;
+    int returnValue = EXIT_FAILURE;
+
+    /* Replay options. The trace filename is the only non-option argument.*/
+    const char *traceFilename = NULL;
+    const char *rendererName = "opengl_1_1";
+    unsigned numLoops = 1;
+    unsigned deviceIdx = 0;
+
+    {
+        int i = 0;
+
+        for (i = 1; i < argc; i++)
+        {
+            if ((strcmp(argv[i], "-r") == 0) && ((i + 1) < argc))
+            {
+                rendererName = argv[++i];
+            }
+            else if ((strcmp(argv[i], "-l") == 0) && ((i + 1) < argc))
+            {
+                numLoops = strtoul(argv[++i], NULL, 10);
+            }
+            else if ((strcmp(argv[i], "-d") == 0) && ((i + 1) < argc))
+            {
+                /* The device index is expected to be 1-indexed (device #1 is 1).*/
+                deviceIdx = strtoul(argv[++i], NULL, 10);
+                deviceIdx -= (deviceIdx > 0);
+            }
+            else
+            {
+                traceFilename = argv[i];
+            }
+        }
+
+        if (!traceFilename || !numLoops)
+        {
+            fprintf(stderr, "Usage: %s <trace file> [-r renderer] [-l number of loops] [-d device]\n", argv[0]);
+            goto cleanup;
+        }
+    }
+
+    if (!(trace = kelpoa_cmdtrace__load(traceFilename)))
+    {
+        fprintf(stderr, "Failed to load the trace.\n");
+        goto cleanup;
+    }
+
+    if (!trace->numFrames)
+    {
+        fprintf(stderr, "The trace has no frames to replay.\n");
+        goto cleanup;
+    }
+
+    if (!(frameTimes = (double*)malloc(trace->numFrames * numLoops * sizeof(*frameTimes))))
+    {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        goto cleanup;
+    }
+
+    if (!kelpo_create_interface(&kelpo, rendererName) ||
+        !kelpo->window.open(deviceIdx, trace->screenWidth, trace->screenHeight, trace->screenBPP) ||
+        !kelpo->window.set_message_handler(default_window_message_handler))
+    {
+        fprintf(stderr, "Failed to initialize Kelpo.\n");
+        goto cleanup;
+    }
+
+    /* Replay the trace.*/
+    {
+        unsigned loop = 0;
+        uint32_t f = 0;
+
+        for (loop = 0; loop < numLoops; loop++)
+        {
+            /* Each replay of the trace uploads its textures anew.*/
+            if (loop > 0)
+            {
+                kelpo->rasterizer.unload_textures();
+            }
+
+            for (f = 0; f < trace->numFrames; f++)
+            {
+                const double startTime = kelpoa_clock__nanoseconds();
+
+                if (!kelpoa_cmdtrace__replay_frame(trace, kelpo, f))
+                {
+                    fprintf(stderr, "Kelpo has reported an error.\n");
+                    goto cleanup;
+                }
+
+                frameTimes[numFramesReplayed++] = (kelpoa_clock__nanoseconds() - startTime);
+
+                kelpo->window.process_messages();
+
+                if (kelpo->window.is_closing())
+                {
+                    goto replay_finished;
+                }
+            }
+        }
+
+        replay_finished:;
+    }
+
+    /* Report the replay's timings.*/
+    {
+        unsigned long i = 0;
+        double totalTime = 0;
+
+        for (i = 0; i < numFramesReplayed; i++)
+        {
+            totalTime += frameTimes[i];
+        }
+
+        qsort(frameTimes, numFramesReplayed, sizeof(*frameTimes), compare_doubles);
+
+        printf("Renderer:  %s\n", kelpo->metadata.rendererName);
+        printf("Trace:     %s (%u x %u x %u, %lu frames, %lu triangles)\n",
+               traceFilename, trace->screenWidth, trace->screenHeight, trace->screenBPP,
+               (unsigned long)trace->numFrames, trace->numTrianglesDrawn);
+        printf("Replayed:  %lu frames in %.3f s (%.1f FPS, %.0f triangles/s)\n",
+               numFramesReplayed,
+               (totalTime / 1000000000.0),
+               (numFramesReplayed / (totalTime / 1000000000.0)),
+               ((trace->numTrianglesDrawn * (numFramesReplayed / (double)trace->numFrames)) / (totalTime / 1000000000.0)));
+        printf("Frame time (ms): min %.3f, median %.3f, max %.3f\n",
+               (frameTimes[0] / 1000000.0),
+               (frameTimes[numFramesReplayed / 2] / 1000000.0),
+               (frameTimes[numFramesReplayed - 1] / 1000000.0));
+    }
+
+    returnValue = EXIT_SUCCESS;
+
+    cleanup:
+
+    free(frameTimes);
+    kelpoa_cmdtrace__free(trace);
+
+    if (!kelpo_release_interface(kelpo))
+    {
+        fprintf(stderr, "Failed to release Kelpo.\n");
+        returnValue = EXIT_FAILURE;
+    }
+
+    return returnValue;
+}